@@ -0,0 +1,570 @@
+/**
+ *@file 3ds.h
+ *@brief Host stand-in for the parts of libctru used by the GPU test framework.
+ *
+ * Only declares what the sources in source/ actually call, with the signatures of the libctru the
+ * framework is written against. The implementation lives in ctru_host.c.
+ * Pointers handed to the GPU must live in the emulated linear heap or VRAM, which are mapped at their
+ * real 3DS addresses so that the (u32) casts done everywhere in the framework keep working on a 64bit host.
+ */
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <3ds/types.h>
+
+/*---------------------------------------------------------------------------------
+ * os / svc
+ *-------------------------------------------------------------------------------*/
+#define SYSCLOCK_ARM11 268111856
+#define TICKS_PER_MSEC 268111.856
+
+#define OS_VRAM_VADDR   0x1F000000
+#define OS_VRAM_SIZE    0x00600000
+#define OS_LINEAR_VADDR 0x14000000
+#define OS_LINEAR_SIZE  0x04000000
+
+u32 osConvertVirtToPhys(u32 vaddr);
+u64 osGetTime(void);
+float osGet3DSliderState(void);
+
+u64 svcGetSystemTick(void);
+void svcSleepThread(s64 ns);
+Result svcCreateThread(Handle* thread, ThreadFunc entrypoint, u32 arg, u32* stack_top, s32 thread_priority, s32 processor_id);
+void svcExitThread(void) __attribute__((noreturn));
+Result svcCreateEvent(Handle* event, u8 reset_type);
+Result svcSignalEvent(Handle handle);
+Result svcClearEvent(Handle handle);
+Result svcWaitSynchronization(Handle handle, s64 nanoseconds);
+Result svcCloseHandle(Handle handle);
+Result svcGetThreadPriority(s32 *out, Handle handle);
+
+#define CUR_THREAD_HANDLE 0xFFFF8000
+
+/*---------------------------------------------------------------------------------
+ * linear heap
+ *-------------------------------------------------------------------------------*/
+void* linearAlloc(size_t size);
+void* linearMemAlign(size_t size, size_t alignment);
+void linearFree(void* mem);
+u32 linearSpaceFree(void);
+
+/*---------------------------------------------------------------------------------
+ * services
+ *-------------------------------------------------------------------------------*/
+Result srvInit(void);
+void srvExit(void);
+Result aptInit(void);
+void aptExit(void);
+bool aptMainLoop(void);
+Result sdmcInit(void);
+Result sdmcExit(void);
+
+/*---------------------------------------------------------------------------------
+ * hid
+ *-------------------------------------------------------------------------------*/
+enum
+{
+	KEY_A       = BIT(0),
+	KEY_B       = BIT(1),
+	KEY_SELECT  = BIT(2),
+	KEY_START   = BIT(3),
+	KEY_DRIGHT  = BIT(4),
+	KEY_DLEFT   = BIT(5),
+	KEY_DUP     = BIT(6),
+	KEY_DDOWN   = BIT(7),
+	KEY_R       = BIT(8),
+	KEY_L       = BIT(9),
+	KEY_X       = BIT(10),
+	KEY_Y       = BIT(11),
+	KEY_UP    = KEY_DUP,
+	KEY_DOWN  = KEY_DDOWN,
+	KEY_LEFT  = KEY_DLEFT,
+	KEY_RIGHT = KEY_DRIGHT,
+};
+
+Result hidInit(u32* sharedMem);
+void hidExit(void);
+void hidScanInput(void);
+u32 keysDown(void);
+u32 keysHeld(void);
+u32 keysUp(void);
+
+/*---------------------------------------------------------------------------------
+ * gfx / console
+ *-------------------------------------------------------------------------------*/
+typedef enum
+{
+	GFX_TOP = 0,
+	GFX_BOTTOM = 1
+}gfxScreen_t;
+
+typedef enum
+{
+	GFX_LEFT = 0,
+	GFX_RIGHT = 1,
+}gfx3dSide_t;
+
+void gfxInitDefault(void);
+void gfxExit(void);
+void gfxSet3D(bool enable);
+u8* gfxGetFramebuffer(gfxScreen_t screen, gfx3dSide_t side, u16* width, u16* height);
+void gfxFlushBuffers(void);
+void gfxSwapBuffers(void);
+void gfxSwapBuffersGpu(void);
+
+typedef struct PrintConsole PrintConsole;
+PrintConsole* consoleInit(gfxScreen_t screen, PrintConsole* console);
+void consoleClear(void);
+
+/*---------------------------------------------------------------------------------
+ * gsp / gx
+ *-------------------------------------------------------------------------------*/
+typedef enum
+{
+	GSPEVENT_PSC0 = 0,
+	GSPEVENT_PSC1,
+	GSPEVENT_VBlank0,
+	GSPEVENT_VBlank1,
+	GSPEVENT_PPF,
+	GSPEVENT_P3D,
+	GSPEVENT_DMA,
+
+	GSPEVENT_MAX,
+}GSP_Event;
+
+void gspWaitForEvent(GSP_Event id, bool nextEvent);
+#define gspWaitForPSC0() gspWaitForEvent(GSPEVENT_PSC0, false)
+#define gspWaitForPSC1() gspWaitForEvent(GSPEVENT_PSC1, false)
+#define gspWaitForVBlank() gspWaitForVBlank0()
+#define gspWaitForVBlank0() gspWaitForEvent(GSPEVENT_VBlank0, true)
+#define gspWaitForVBlank1() gspWaitForEvent(GSPEVENT_VBlank1, true)
+#define gspWaitForPPF() gspWaitForEvent(GSPEVENT_PPF, false)
+#define gspWaitForP3D() gspWaitForEvent(GSPEVENT_P3D, false)
+#define gspWaitForDMA() gspWaitForEvent(GSPEVENT_DMA, false)
+
+Result GX_RequestDma(u32* gxbuf, u32* src, u32* dst, u32 length);
+Result GX_SetCommandList_Last(u32* gxbuf, u32* buf0a, u32 buf0s, u8 flags);
+Result GX_SetMemoryFill(u32* gxbuf, u32* buf0a, u32 buf0v, u32* buf0e, u16 width0, u32* buf1a, u32 buf1v, u32* buf1e, u16 width1);
+Result GX_SetDisplayTransfer(u32* gxbuf, u32* inadr, u32 indim, u32* outadr, u32 outdim, u32 flags);
+Result GX_SetTextureCopy(u32* gxbuf, u32* inadr, u32 indim, u32* outadr, u32 outdim, u32 size, u32 flags);
+Result GX_SetCommandList_First(u32* gxbuf, u32* buf0a, u32 buf0s, u32* buf1a, u32 buf1s, u32* buf2a, u32 buf2s);
+
+Result GSPGPU_FlushDataCache(Handle *handle, u8* adr, u32 size);
+Result GSPGPU_InvalidateDataCache(Handle* handle, u32 adr, u32 size);
+
+/*---------------------------------------------------------------------------------
+ * gpu
+ *-------------------------------------------------------------------------------*/
+#define GPUREG_0000 0x0000
+#define GPUREG_FINALIZE 0x0010
+#define GPUREG_0040 0x0040
+#define GPUREG_0041 0x0041
+#define GPUREG_0042 0x0042
+#define GPUREG_0043 0x0043
+#define GPUREG_0044 0x0044
+#define GPUREG_004D 0x004D
+#define GPUREG_004E 0x004E
+#define GPUREG_004F 0x004F
+#define GPUREG_0050 0x0050
+#define GPUREG_0062 0x0062
+#define GPUREG_0063 0x0063
+#define GPUREG_0065 0x0065
+#define GPUREG_0066 0x0066
+#define GPUREG_0067 0x0067
+#define GPUREG_0068 0x0068
+#define GPUREG_006D 0x006D
+#define GPUREG_006E 0x006E
+#define GPUREG_006F 0x006F
+#define GPUREG_0080 0x0080
+#define GPUREG_00C0 0x00C0
+#define GPUREG_00E0 0x00E0
+#define GPUREG_00FD 0x00FD
+#define GPUREG_0100 0x0100
+#define GPUREG_0101 0x0101
+#define GPUREG_0102 0x0102
+#define GPUREG_0103 0x0103
+#define GPUREG_0104 0x0104
+#define GPUREG_0105 0x0105
+#define GPUREG_0106 0x0106
+#define GPUREG_0107 0x0107
+#define GPUREG_0110 0x0110
+#define GPUREG_0111 0x0111
+#define GPUREG_0112 0x0112
+#define GPUREG_0113 0x0113
+#define GPUREG_0114 0x0114
+#define GPUREG_0115 0x0115
+#define GPUREG_0116 0x0116
+#define GPUREG_0117 0x0117
+#define GPUREG_0118 0x0118
+#define GPUREG_011B 0x011B
+#define GPUREG_011C 0x011C
+#define GPUREG_011D 0x011D
+#define GPUREG_011E 0x011E
+#define GPUREG_ATTRIBBUFFERS_LOC 0x0200
+#define GPUREG_ATTRIBBUFFERS_FORMAT_LOW 0x0201
+#define GPUREG_ATTRIBBUFFERS_FORMAT_HIGH 0x0202
+#define GPUREG_ATTRIBBUFFER0_CONFIG0 0x0203
+#define GPUREG_INDEXBUFFER_CONFIG 0x0227
+#define GPUREG_NUMVERTICES 0x0228
+#define GPUREG_022A 0x022A
+#define GPUREG_DRAWARRAYS 0x022E
+#define GPUREG_DRAWELEMENTS 0x022F
+#define GPUREG_0231 0x0231
+#define GPUREG_FIXEDATTRIB_INDEX 0x0232
+#define GPUREG_FIXEDATTRIB_DATA0 0x0233
+#define GPUREG_0242 0x0242
+#define GPUREG_0244 0x0244
+#define GPUREG_0245 0x0245
+#define GPUREG_0253 0x0253
+#define GPUREG_PRIMITIVE_CONFIG 0x025E
+#define GPUREG_RESTART_PRIMITIVE 0x025F
+#define GPUREG_GSH_BOOLUNIFORM 0x0280
+#define GPUREG_GSH_FLOATUNIFORM_CONFIG 0x0290
+#define GPUREG_GSH_FLOATUNIFORM_DATA 0x0291
+#define GPUREG_VSH_BOOLUNIFORM 0x02B0
+#define GPUREG_VSH_INTUNIFORM_I0 0x02B1
+#define GPUREG_VSH_INPUTBUFFER_CONFIG 0x02B9
+#define GPUREG_VSH_ENTRYPOINT 0x02BA
+#define GPUREG_VSH_ATTRIBUTES_PERMUTATION_LOW 0x02BB
+#define GPUREG_VSH_ATTRIBUTES_PERMUTATION_HIGH 0x02BC
+#define GPUREG_VSH_OUTMAP_MASK 0x02BD
+#define GPUREG_VSH_CODETRANSFER_END 0x02BF
+#define GPUREG_VSH_FLOATUNIFORM_CONFIG 0x02C0
+#define GPUREG_VSH_FLOATUNIFORM_DATA 0x02C1
+#define GPUREG_VSH_CODETRANSFER_CONFIG 0x02CB
+#define GPUREG_VSH_CODETRANSFER_DATA 0x02CC
+#define GPUREG_VSH_OPDESCS_CONFIG 0x02D5
+#define GPUREG_VSH_OPDESCS_DATA 0x02D6
+
+typedef enum
+{
+	GPU_NEAREST = 0x0,
+	GPU_LINEAR = 0x1,
+}GPU_TEXTURE_FILTER_PARAM;
+
+typedef enum
+{
+	GPU_CLAMP_TO_EDGE = 0x0,
+	GPU_REPEAT = 0x2,
+}GPU_TEXTURE_WRAP_PARAM;
+
+#define GPU_TEXTURE_MAG_FILTER(v) (((v)&0x1)<<1)
+#define GPU_TEXTURE_MIN_FILTER(v) (((v)&0x1)<<2)
+#define GPU_TEXTURE_WRAP_S(v) (((v)&0x3)<<8)
+#define GPU_TEXTURE_WRAP_T(v) (((v)&0x3)<<12)
+
+typedef enum
+{
+	GPU_TEXUNIT0 = 0x1,
+	GPU_TEXUNIT1 = 0x2,
+	GPU_TEXUNIT2 = 0x4
+}GPU_TEXUNIT;
+
+typedef enum
+{
+	GPU_RGBA8=0x0,
+	GPU_RGB8=0x1,
+	GPU_RGBA5551=0x2,
+	GPU_RGB565=0x3,
+	GPU_RGBA4=0x4,
+	GPU_LA8=0x5,
+	GPU_HILO8=0x6,
+	GPU_L8=0x7,
+	GPU_A8=0x8,
+	GPU_LA4=0x9,
+	GPU_L4=0xA,
+	GPU_ETC1=0xB,
+	GPU_ETC1A4=0xC
+}GPU_TEXCOLOR;
+
+typedef enum
+{
+	GPU_NEVER = 0,
+	GPU_ALWAYS = 1,
+	GPU_EQUAL = 2,
+	GPU_NOTEQUAL = 3,
+	GPU_LESS = 4,
+	GPU_LEQUAL = 5,
+	GPU_GREATER = 6,
+	GPU_GEQUAL = 7
+}GPU_TESTFUNC;
+
+typedef enum
+{
+	GPU_SCISSOR_DISABLE = 0,
+	GPU_SCISSOR_INVERT = 1,
+	GPU_SCISSOR_NORMAL = 3,
+}GPU_SCISSORMODE;
+
+typedef enum
+{
+	GPU_KEEP = 0,
+	GPU_AND_NOT = 1,
+	GPU_XOR = 5,
+}GPU_STENCILOP;
+
+typedef enum
+{
+	GPU_WRITE_RED = 0x01,
+	GPU_WRITE_GREEN = 0x02,
+	GPU_WRITE_BLUE = 0x04,
+	GPU_WRITE_ALPHA = 0x08,
+	GPU_WRITE_DEPTH = 0x10,
+
+	GPU_WRITE_COLOR = 0x0F,
+	GPU_WRITE_ALL = 0x1F
+}GPU_WRITEMASK;
+
+typedef enum
+{
+	GPU_BLEND_ADD = 0,
+	GPU_BLEND_SUBTRACT = 1,
+	GPU_BLEND_REVERSE_SUBTRACT = 2,
+	GPU_BLEND_MIN = 3,
+	GPU_BLEND_MAX = 4
+}GPU_BLENDEQUATION;
+
+typedef enum
+{
+	GPU_ZERO = 0,
+	GPU_ONE = 1,
+	GPU_SRC_COLOR = 2,
+	GPU_ONE_MINUS_SRC_COLOR = 3,
+	GPU_DST_COLOR = 4,
+	GPU_ONE_MINUS_DST_COLOR = 5,
+	GPU_SRC_ALPHA = 6,
+	GPU_ONE_MINUS_SRC_ALPHA = 7,
+	GPU_DST_ALPHA = 8,
+	GPU_ONE_MINUS_DST_ALPHA = 9,
+	GPU_CONSTANT_COLOR = 10,
+	GPU_ONE_MINUS_CONSTANT_COLOR = 11,
+	GPU_CONSTANT_ALPHA = 12,
+	GPU_ONE_MINUS_CONSTANT_ALPHA = 13,
+	GPU_SRC_ALPHA_SATURATE = 14
+}GPU_BLENDFACTOR;
+
+typedef enum
+{
+	GPU_LOGICOP_CLEAR = 0,
+	GPU_LOGICOP_COPY = 3,
+}GPU_LOGICOP;
+
+typedef enum
+{
+	GPU_BYTE = 0,
+	GPU_UNSIGNED_BYTE = 1,
+	GPU_SHORT = 2,
+	GPU_FLOAT = 3
+}GPU_FORMATS;
+
+typedef enum
+{
+	GPU_CULL_NONE = 0,
+	GPU_CULL_FRONT_CCW = 1,
+	GPU_CULL_BACK_CCW = 2
+}GPU_CULLMODE;
+
+#define GPU_ATTRIBFMT(i, n, f) (((((n)-1)<<2)|((f)&3))<<((i)*4))
+
+typedef enum
+{
+	GPU_PRIMARY_COLOR = 0x00,
+	GPU_TEXTURE0 = 0x03,
+	GPU_TEXTURE1 = 0x04,
+	GPU_TEXTURE2 = 0x05,
+	GPU_TEXTURE3 = 0x06,
+	GPU_CONSTANT = 0x0E,
+	GPU_PREVIOUS = 0x0F,
+}GPU_TEVSRC;
+
+typedef enum
+{
+	GPU_REPLACE = 0x00,
+	GPU_MODULATE = 0x01,
+	GPU_ADD = 0x02,
+	GPU_ADD_SIGNED = 0x03,
+	GPU_INTERPOLATE = 0x04,
+	GPU_SUBTRACT = 0x05,
+	GPU_DOT3_RGB = 0x06
+}GPU_COMBINEFUNC;
+
+#define GPU_TEVSOURCES(a,b,c) (((a))|((b)<<4)|((c)<<8))
+#define GPU_TEVOPERANDS(a,b,c) (((a))|((b)<<4)|((c)<<8))
+
+typedef enum
+{
+	GPU_TRIANGLES = 0x0000,
+	GPU_TRIANGLE_STRIP = 0x0100,
+	GPU_TRIANGLE_FAN = 0x0200,
+	GPU_UNKPRIM = 0x0300
+}GPU_Primitive_t;
+
+typedef enum
+{
+	GPU_VERTEX_SHADER=0x0,
+	GPU_GEOMETRY_SHADER=0x1
+}GPU_SHADER_TYPE;
+
+void GPU_Init(Handle *gsphandle);
+void GPU_Reset(u32* gxbuf, u32* gpuBuf, u32 gpuBufSize);
+
+void GPUCMD_SetBuffer(u32* adr, u32 size, u32 offset);
+void GPUCMD_SetBufferOffset(u32 offset);
+void GPUCMD_GetBuffer(u32** adr, u32* size, u32* offset);
+void GPUCMD_AddRawCommands(u32* cmd, u32 size);
+void GPUCMD_Run(u32* gxbuf);
+void GPUCMD_FlushAndRun(u32* gxbuf);
+void GPUCMD_Add(u32 header, u32* param, u32 paramlength);
+void GPUCMD_Finalize(void);
+
+#define GPUCMD_AddSingleParam(header, param) GPUCMD_Add((header), (u32[]){(u32)(param)}, 1)
+
+#define GPUCMD_AddMaskedWrite(reg, mask, val) GPUCMD_AddSingleParam((((mask)&0xF)<<16)|((reg)&0x3FF), (val))
+#define GPUCMD_AddWrite(reg, val) GPUCMD_AddMaskedWrite((reg), 0xF, (val))
+#define GPUCMD_AddMaskedWrites(reg, mask, vals, num) GPUCMD_Add((((mask)&0xF)<<16)|((reg)&0x3FF), (vals), (num))
+#define GPUCMD_AddWrites(reg, vals, num) GPUCMD_AddMaskedWrites((reg), 0xF, (vals), (num))
+#define GPUCMD_AddMaskedIncrementalWrites(reg, mask, vals, num) GPUCMD_Add(0x80000000|(((mask)&0xF)<<16)|((reg)&0x3FF), (vals), (num))
+#define GPUCMD_AddIncrementalWrites(reg, vals, num) GPUCMD_AddMaskedIncrementalWrites((reg), 0xF, (vals), (num))
+
+u32 f32tof24(float f);
+u32 computeInvValue(u32 val);
+u32 f32tof31(float f);
+
+void GPU_SetFloatUniform(GPU_SHADER_TYPE type, u32 startreg, u32* data, u32 numreg);
+
+void GPU_SetViewport(u32* depthBuffer, u32* colorBuffer, u32 x, u32 y, u32 w, u32 h);
+void GPU_SetScissorTest(GPU_SCISSORMODE mode, u32 x, u32 y, u32 w, u32 h);
+void GPU_DepthMap(float zScale, float zOffset);
+void GPU_SetAlphaTest(bool enable, GPU_TESTFUNC function, u8 ref);
+void GPU_SetDepthTestAndWriteMask(bool enable, GPU_TESTFUNC function, GPU_WRITEMASK writemask);
+void GPU_SetStencilTest(bool enable, GPU_TESTFUNC function, u8 ref, u8 mask, u8 replace);
+void GPU_SetStencilOp(GPU_STENCILOP sfail, GPU_STENCILOP dfail, GPU_STENCILOP pass);
+void GPU_SetFaceCulling(GPU_CULLMODE mode);
+void GPU_SetAlphaBlending(GPU_BLENDEQUATION colorEquation, GPU_BLENDEQUATION alphaEquation,
+	GPU_BLENDFACTOR colorSrc, GPU_BLENDFACTOR colorDst,
+	GPU_BLENDFACTOR alphaSrc, GPU_BLENDFACTOR alphaDst);
+void GPU_SetColorLogicOp(GPU_LOGICOP op);
+void GPU_SetBlendingColor(u8 r, u8 g, u8 b, u8 a);
+void GPU_SetAttributeBuffers(u8 totalAttributes, u32* baseAddress, u64 attributeFormats, u16 attributeMask, u64 attributePermutation, u8 numBuffers, u32 bufferOffsets[], u64 bufferPermutations[], u8 bufferNumAttributes[]);
+void GPU_SetTextureEnable(GPU_TEXUNIT units);
+void GPU_SetTexture(GPU_TEXUNIT unit, u32* data, u16 width, u16 height, u32 param, GPU_TEXCOLOR colorType);
+void GPU_SetTexEnv(u8 id, u16 rgbSources, u16 alphaSources, u16 rgbOperands, u16 alphaOperands, GPU_COMBINEFUNC rgbCombine, GPU_COMBINEFUNC alphaCombine, u32 constantColor);
+void GPU_DrawArray(GPU_Primitive_t primitive, u32 n);
+void GPU_DrawElements(GPU_Primitive_t primitive, u32* indexArray, u32 n);
+void GPU_FinishDrawing(void);
+void GPU_SetShaderOutmap(u32 outmapData[8]);
+void GPU_SendShaderCode(GPU_SHADER_TYPE type, u32* data, u16 offset, u16 length);
+void GPU_SendOperandDescriptors(GPU_SHADER_TYPE type, u32* data, u16 offset, u16 length);
+
+/*---------------------------------------------------------------------------------
+ * shaders
+ *-------------------------------------------------------------------------------*/
+typedef enum{
+	VERTEX_SHDR=GPU_VERTEX_SHADER,
+	GEOMETRY_SHDR=GPU_GEOMETRY_SHADER
+}DVLE_type;
+
+typedef enum{
+	DVLE_CONST_BOOL=0x0,
+	DVLE_CONST_u8=0x1,
+	DVLE_CONST_FLOAT24=0x2,
+}DVLE_constantType;
+
+typedef enum{
+	RESULT_POSITION = 0x0,
+	RESULT_NORMALQUAT = 0x1,
+	RESULT_COLOR = 0x2,
+	RESULT_TEXCOORD0 = 0x3,
+	RESULT_TEXCOORD0W = 0x4,
+	RESULT_TEXCOORD1 = 0x5,
+	RESULT_TEXCOORD2 = 0x6,
+	RESULT_VIEW = 0x8
+}DVLE_outputAttribute_t;
+
+typedef struct{
+	u32 codeSize;
+	u32* codeData;
+	u32 opdescSize;
+	u32* opcdescData;
+}DVLP_s;
+
+typedef struct{
+	u16 type;
+	u16 id;
+	u32 data[4];
+}DVLE_constEntry_s;
+
+typedef struct{
+	u16 type;
+	u16 regID;
+	u8 mask;
+	u8 unk[3];
+}DVLE_outEntry_s;
+
+typedef struct{
+	u32 symbolOffset;
+	u16 startReg;
+	u16 endReg;
+}DVLE_uniformEntry_s;
+
+typedef struct{
+	DVLE_type type;
+	DVLP_s* dvlp;
+	u32 mainOffset, endmainOffset;
+	u32 constTableSize;
+	DVLE_constEntry_s* constTableData;
+	u32 outTableSize;
+	DVLE_outEntry_s* outTableData;
+	u32 uniformTableSize;
+	DVLE_uniformEntry_s* uniformTableData;
+	char* symbolTableData;
+	u8 outmapMask;
+	u32 outmapData[8];
+}DVLE_s;
+
+typedef struct{
+	u32 numDVLE;
+	DVLP_s DVLP;
+	DVLE_s* DVLE;
+}DVLB_s;
+
+DVLB_s* DVLB_ParseFile(u32* shbinData, u32 shbinSize);
+void DVLB_Free(DVLB_s* dvlb);
+s8 DVLE_GetUniformRegister(DVLE_s* dvle, const char* name);
+
+typedef struct
+{
+	u32 id;
+	u32 data[3];
+}float24Uniform_s;
+
+typedef struct
+{
+	DVLE_s* dvle;
+	float24Uniform_s* float24Uniforms;
+	u8 numFloat24Uniforms;
+}shaderInstance_s;
+
+typedef struct
+{
+	shaderInstance_s* vertexShader;
+	shaderInstance_s* geometryShader;
+	u8 geometryShaderInputStride;
+}shaderProgram_s;
+
+Result shaderInstanceInit(shaderInstance_s* si, DVLE_s* dvle);
+Result shaderInstanceFree(shaderInstance_s* si);
+Result shaderInstanceGetUniformLocation(shaderInstance_s* si, const char* name);
+
+Result shaderProgramInit(shaderProgram_s* sp);
+Result shaderProgramFree(shaderProgram_s* sp);
+Result shaderProgramSetVsh(shaderProgram_s* sp, DVLE_s* dvle);
+Result shaderProgramSetGsh(shaderProgram_s* sp, DVLE_s* dvle, u8 stride);
+Result shaderProgramUse(shaderProgram_s* sp);
+
+#ifdef __cplusplus
+}
+#endif
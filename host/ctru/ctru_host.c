@@ -0,0 +1,1223 @@
+/**
+ *@file ctru_host.c
+ *@author Lectem
+ *@date 17/10/2026
+ *
+ * Host stand-in for libctru, so that the sources of source/ can be built and profiled on Linux.
+ *
+ * The linear heap and the VRAM are mapped at their 3DS virtual addresses, which keeps every pointer
+ * below 4GB: the framework casts pointers to u32 all the time (osConvertVirtToPhys, GPU_SetViewport...).
+ * The GPU_* functions write the same registers as libctru so that the recorded command lists look like
+ * the real ones, see http://3dbrew.org/wiki/GPU_Commands
+ */
+#define _GNU_SOURCE
+#include "ctru_host.h"
+
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+
+#define LINEAR_PADDR 0x20000000
+#define VRAM_PADDR   0x18000000
+
+#define RES_TIMEOUT 0x09401BFE
+
+static ctru_host_stats stats;
+
+/*---------------------------------------------------------------------------------
+ * Memory
+ *-------------------------------------------------------------------------------*/
+
+#define MAX_BLOCKS 4096
+
+typedef struct
+{
+    u32 addr, size;
+    bool used;
+} heap_block;
+
+static heap_block blocks[MAX_BLOCKS];
+static int numBlocks = 0;
+static pthread_mutex_t heapLock = PTHREAD_MUTEX_INITIALIZER;
+
+static void map_fixed(u32 addr, u32 size)
+{
+    void* p = mmap((void*)(uintptr_t)addr, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if(p != (void*)(uintptr_t)addr)
+    {
+        fprintf(stderr, "ctru_host: couldn't map %08x-%08x (%s)\n", addr, addr + size, strerror(errno));
+        abort();
+    }
+}
+
+__attribute__((constructor))
+static void memory_init(void)
+{
+    map_fixed(OS_LINEAR_VADDR, OS_LINEAR_SIZE);
+    map_fixed(OS_VRAM_VADDR, OS_VRAM_SIZE);
+    blocks[0] = (heap_block){OS_LINEAR_VADDR, OS_LINEAR_SIZE, false};
+    numBlocks = 1;
+}
+
+void* linearMemAlign(size_t size, size_t alignment)
+{
+    void* res = NULL;
+    int i;
+    if(alignment < 0x80)alignment = 0x80; //Same minimum alignment as libctru
+    size = (size + 0x7F) & ~0x7F;
+    pthread_mutex_lock(&heapLock);
+    for(i = 0; i < numBlocks && !res; ++i)
+    {
+        heap_block* b = &blocks[i];
+        u32 start = (b->addr + alignment - 1) & ~(alignment - 1);
+        if(b->used || start + size > b->addr + b->size || numBlocks + 2 > MAX_BLOCKS)continue;
+
+        //Split into [free padding][used][free remainder]
+        u32 padding = start - b->addr;
+        u32 remainder = b->addr + b->size - (start + size);
+        if(padding)
+        {
+            memmove(&blocks[i + 1], &blocks[i], (numBlocks - i) * sizeof(heap_block));
+            numBlocks++;
+            blocks[i].size = padding;
+            b = &blocks[++i];
+            b->addr = start;
+            b->size -= padding;
+        }
+        if(remainder)
+        {
+            memmove(&blocks[i + 1], &blocks[i], (numBlocks - i) * sizeof(heap_block));
+            numBlocks++;
+            blocks[i + 1] = (heap_block){start + size, remainder, false};
+            b->size = size;
+        }
+        b->used = true;
+        res = (void*)(uintptr_t)start;
+    }
+    pthread_mutex_unlock(&heapLock);
+    return res;
+}
+
+void* linearAlloc(size_t size)
+{
+    return linearMemAlign(size, 0x80);
+}
+
+void linearFree(void* mem)
+{
+    u32 addr = (u32)(uintptr_t)mem;
+    int i;
+    pthread_mutex_lock(&heapLock);
+    for(i = 0; i < numBlocks; ++i)
+    {
+        if(blocks[i].addr != addr || !blocks[i].used)continue;
+        blocks[i].used = false;
+        if(i + 1 < numBlocks && !blocks[i + 1].used)
+        {
+            blocks[i].size += blocks[i + 1].size;
+            memmove(&blocks[i + 1], &blocks[i + 2], (numBlocks - i - 2) * sizeof(heap_block));
+            numBlocks--;
+        }
+        if(i > 0 && !blocks[i - 1].used)
+        {
+            blocks[i - 1].size += blocks[i].size;
+            memmove(&blocks[i], &blocks[i + 1], (numBlocks - i - 1) * sizeof(heap_block));
+            numBlocks--;
+        }
+        break;
+    }
+    pthread_mutex_unlock(&heapLock);
+}
+
+u32 linearSpaceFree(void)
+{
+    u32 total = 0;
+    int i;
+    pthread_mutex_lock(&heapLock);
+    for(i = 0; i < numBlocks; ++i)if(!blocks[i].used)total += blocks[i].size;
+    pthread_mutex_unlock(&heapLock);
+    return total;
+}
+
+u32 osConvertVirtToPhys(u32 vaddr)
+{
+    if(vaddr >= OS_LINEAR_VADDR && vaddr < OS_LINEAR_VADDR + OS_LINEAR_SIZE)return vaddr - OS_LINEAR_VADDR + LINEAR_PADDR;
+    if(vaddr >= OS_VRAM_VADDR && vaddr < OS_VRAM_VADDR + OS_VRAM_SIZE)return vaddr - OS_VRAM_VADDR + VRAM_PADDR;
+    return 0;
+}
+
+void* ctruHostPhysToVirt(u32 paddr)
+{
+    if(paddr >= LINEAR_PADDR && paddr < LINEAR_PADDR + OS_LINEAR_SIZE)return (void*)(uintptr_t)(paddr - LINEAR_PADDR + OS_LINEAR_VADDR);
+    if(paddr >= VRAM_PADDR && paddr < VRAM_PADDR + OS_VRAM_SIZE)return (void*)(uintptr_t)(paddr - VRAM_PADDR + OS_VRAM_VADDR);
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------------
+ * svc
+ *-------------------------------------------------------------------------------*/
+
+#define MAX_HANDLES 256
+#define HANDLE_BASE 0x100
+
+enum
+{
+    HANDLE_FREE,
+    HANDLE_THREAD,
+    HANDLE_EVENT,
+};
+
+typedef struct
+{
+    int type;
+    pthread_t thread;
+    ThreadFunc entry;
+    u32 arg;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool signaled;
+    u8 resetType;   ///< 0: oneshot, 1: sticky
+} host_handle;
+
+static host_handle handles[MAX_HANDLES];
+static pthread_mutex_t handlesLock = PTHREAD_MUTEX_INITIALIZER;
+
+static host_handle* get_handle(Handle h)
+{
+    if(h < HANDLE_BASE || h >= HANDLE_BASE + MAX_HANDLES)return NULL;
+    host_handle* hh = &handles[h - HANDLE_BASE];
+    return hh->type == HANDLE_FREE ? NULL : hh;
+}
+
+static Handle new_handle(int type)
+{
+    int i;
+    pthread_mutex_lock(&handlesLock);
+    for(i = 0; i < MAX_HANDLES; ++i)
+    {
+        if(handles[i].type != HANDLE_FREE)continue;
+        memset(&handles[i], 0, sizeof(handles[i]));
+        handles[i].type = type;
+        pthread_mutex_init(&handles[i].lock, NULL);
+        pthread_cond_init(&handles[i].cond, NULL);
+        pthread_mutex_unlock(&handlesLock);
+        return HANDLE_BASE + i;
+    }
+    pthread_mutex_unlock(&handlesLock);
+    return 0;
+}
+
+u64 svcGetSystemTick(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * SYSCLOCK_ARM11 + (u64)ts.tv_nsec * SYSCLOCK_ARM11 / 1000000000ull;
+}
+
+u64 osGetTime(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (u64)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+float osGet3DSliderState(void)
+{
+    //All the way up, so that stereo frames have some parallax
+    return 1.0f;
+}
+
+void svcSleepThread(s64 ns)
+{
+    struct timespec ts = {ns / 1000000000, ns % 1000000000};
+    nanosleep(&ts, NULL);
+}
+
+static void* thread_entry(void* arg)
+{
+    host_handle* h = arg;
+    h->entry(h->arg);
+    return NULL;
+}
+
+Result svcCreateThread(Handle* thread, ThreadFunc entrypoint, u32 arg, u32* stack_top, s32 thread_priority, s32 processor_id)
+{
+    Handle h = new_handle(HANDLE_THREAD);
+    host_handle* hh = get_handle(h);
+    if(!hh)return -1;
+    hh->entry = entrypoint;
+    hh->arg = arg;
+    if(pthread_create(&hh->thread, NULL, thread_entry, hh))
+    {
+        hh->type = HANDLE_FREE;
+        return -1;
+    }
+    *thread = h;
+    return 0;
+}
+
+void svcExitThread(void)
+{
+    pthread_exit(NULL);
+}
+
+Result svcCreateEvent(Handle* event, u8 reset_type)
+{
+    Handle h = new_handle(HANDLE_EVENT);
+    host_handle* hh = get_handle(h);
+    if(!hh)return -1;
+    hh->resetType = reset_type;
+    *event = h;
+    return 0;
+}
+
+Result svcSignalEvent(Handle handle)
+{
+    host_handle* hh = get_handle(handle);
+    if(!hh || hh->type != HANDLE_EVENT)return -1;
+    pthread_mutex_lock(&hh->lock);
+    hh->signaled = true;
+    pthread_cond_broadcast(&hh->cond);
+    pthread_mutex_unlock(&hh->lock);
+    return 0;
+}
+
+Result svcClearEvent(Handle handle)
+{
+    host_handle* hh = get_handle(handle);
+    if(!hh || hh->type != HANDLE_EVENT)return -1;
+    pthread_mutex_lock(&hh->lock);
+    hh->signaled = false;
+    pthread_mutex_unlock(&hh->lock);
+    return 0;
+}
+
+Result svcWaitSynchronization(Handle handle, s64 nanoseconds)
+{
+    host_handle* hh = get_handle(handle);
+    Result res = 0;
+    if(!hh)return -1;
+    if(hh->type == HANDLE_THREAD)
+    {
+        pthread_join(hh->thread, NULL);
+        return 0;
+    }
+
+    pthread_mutex_lock(&hh->lock);
+    if(nanoseconds < 0)
+    {
+        while(!hh->signaled)pthread_cond_wait(&hh->cond, &hh->lock);
+    }
+    else
+    {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += nanoseconds / 1000000000;
+        deadline.tv_nsec += nanoseconds % 1000000000;
+        if(deadline.tv_nsec >= 1000000000)
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+        while(!hh->signaled && res == 0)
+        {
+            if(pthread_cond_timedwait(&hh->cond, &hh->lock, &deadline) == ETIMEDOUT)res = RES_TIMEOUT;
+        }
+    }
+    if(hh->signaled && hh->resetType == 0)hh->signaled = false;
+    pthread_mutex_unlock(&hh->lock);
+    return res;
+}
+
+Result svcCloseHandle(Handle handle)
+{
+    host_handle* hh = get_handle(handle);
+    if(!hh)return -1;
+    if(hh->type == HANDLE_THREAD)pthread_detach(hh->thread);
+    pthread_mutex_destroy(&hh->lock);
+    pthread_cond_destroy(&hh->cond);
+    hh->type = HANDLE_FREE;
+    return 0;
+}
+
+Result svcGetThreadPriority(s32* out, Handle handle)
+{
+    *out = 0x30;
+    return 0;
+}
+
+/*---------------------------------------------------------------------------------
+ * Services, input
+ *-------------------------------------------------------------------------------*/
+
+static u32 maxFrames = 120;
+static const char* keyScript = NULL;
+static u32 kDown = 0, kHeld = 0, kUp = 0;
+
+Result srvInit(void)
+{
+    const char* frames = getenv("GPUTEST_FRAMES");
+    if(frames)maxFrames = strtoul(frames, NULL, 0);
+    keyScript = getenv("GPUTEST_KEYS");
+    return 0;
+}
+
+void srvExit(void){}
+Result aptInit(void){ return 0; }
+void aptExit(void){}
+Result sdmcInit(void){ return 0; }
+Result sdmcExit(void){ return 0; }
+
+bool aptMainLoop(void)
+{
+    return stats.frames < maxFrames;
+}
+
+static u32 parse_keys(const char* s, size_t len)
+{
+    static const struct { const char* name; u32 key; } names[] = {
+            {"A", KEY_A}, {"B", KEY_B}, {"X", KEY_X}, {"Y", KEY_Y}, {"L", KEY_L}, {"R", KEY_R},
+            {"START", KEY_START}, {"SELECT", KEY_SELECT},
+            {"UP", KEY_UP}, {"DOWN", KEY_DOWN}, {"LEFT", KEY_LEFT}, {"RIGHT", KEY_RIGHT},
+    };
+    u32 keys = 0;
+    while(len)
+    {
+        size_t n = 0, i;
+        while(n < len && s[n] != '+')n++;
+        for(i = 0; i < sizeof(names) / sizeof(names[0]); ++i)
+        {
+            if(strlen(names[i].name) == n && !strncmp(names[i].name, s, n))keys |= names[i].key;
+        }
+        s += n;
+        len -= n;
+        if(len){ s++; len--; }
+    }
+    return keys;
+}
+
+/**
+* Keys scripted for the given frame in GPUTEST_KEYS ("frame:KEY+KEY,frame:KEY...").
+*/
+static u32 scripted_keys(u32 frame)
+{
+    const char* p = keyScript;
+    u32 keys = 0;
+    while(p && *p)
+    {
+        char* end;
+        unsigned long f = strtoul(p, &end, 10);
+        const char* entryEnd = strchr(p, ',');
+        if(!entryEnd)entryEnd = p + strlen(p);
+        if(*end == ':' && f == frame)keys |= parse_keys(end + 1, entryEnd - end - 1);
+        p = *entryEnd ? entryEnd + 1 : entryEnd;
+    }
+    return keys;
+}
+
+Result hidInit(u32* sharedMem){ return 0; }
+void hidExit(void){}
+
+void hidScanInput(void)
+{
+    u32 keys = scripted_keys(++stats.frames);
+    kDown = keys & ~kHeld;
+    kUp = kHeld & ~keys;
+    kHeld = keys;
+}
+
+u32 keysDown(void){ return kDown; }
+u32 keysHeld(void){ return kHeld; }
+u32 keysUp(void){ return kUp; }
+
+/*---------------------------------------------------------------------------------
+ * gfx
+ *-------------------------------------------------------------------------------*/
+
+static u8* framebuffers[2][2];
+
+void gfxInitDefault(void)
+{
+    //Top screen 400x240 and bottom screen 320x240, both BGR8 like the default libctru setup
+    framebuffers[GFX_TOP][GFX_LEFT] = linearAlloc(400 * 240 * 3);
+    framebuffers[GFX_TOP][GFX_RIGHT] = linearAlloc(400 * 240 * 3);
+    framebuffers[GFX_BOTTOM][GFX_LEFT] = linearAlloc(320 * 240 * 3);
+    framebuffers[GFX_BOTTOM][GFX_RIGHT] = framebuffers[GFX_BOTTOM][GFX_LEFT];
+}
+
+void gfxExit(void)
+{
+    int i;
+    if(!getenv("GPUTEST_QUIET"))
+    {
+        fprintf(stderr, "ctru_host: %u frames, %u command lists (%.1f words per list), %u fills, %u transfers\n",
+                stats.frames, stats.submissions,
+                stats.submissions ? (double)stats.commandWords / stats.submissions : 0.0,
+                stats.memoryFills, stats.displayTransfers);
+    }
+    for(i = 0; i < 3; ++i)
+    {
+        u8* fb = framebuffers[i / 2][i % 2];
+        if(fb)linearFree(fb);
+    }
+    memset(framebuffers, 0, sizeof(framebuffers));
+}
+
+void gfxSet3D(bool enable){}
+
+u8* gfxGetFramebuffer(gfxScreen_t screen, gfx3dSide_t side, u16* width, u16* height)
+{
+    if(width)*width = 240;
+    if(height)*height = screen == GFX_TOP ? 400 : 320;
+    return framebuffers[screen & 1][side & 1];
+}
+
+void gfxFlushBuffers(void){}
+void gfxSwapBuffers(void){}
+void gfxSwapBuffersGpu(void){}
+
+PrintConsole* consoleInit(gfxScreen_t screen, PrintConsole* console){ return console; }
+void consoleClear(void){}
+
+/*---------------------------------------------------------------------------------
+ * GX
+ *-------------------------------------------------------------------------------*/
+
+void gspWaitForEvent(GSP_Event id, bool nextEvent)
+{
+    //Everything is executed synchronously, so every event already happened
+    if(id < GSPEVENT_MAX)stats.eventWaits[id]++;
+}
+
+Result GSPGPU_FlushDataCache(Handle* handle, u8* adr, u32 size){ return 0; }
+Result GSPGPU_InvalidateDataCache(Handle* handle, u32 adr, u32 size){ return 0; }
+
+Result GX_RequestDma(u32* gxbuf, u32* src, u32* dst, u32 length)
+{
+    memmove(dst, src, length);
+    return 0;
+}
+
+static void fill(u32* start, u32* end, u32 value, u16 control)
+{
+    u8* p = (u8*)start;
+    u8* e = (u8*)end;
+    if(!start || !(control & 1))return;
+    switch((control >> 8) & 3)
+    {
+        case 0: //16 bits
+            for(; p + 2 <= e; p += 2)memcpy(p, &value, 2);
+            break;
+        case 1: //24 bits
+            for(; p + 3 <= e; p += 3)memcpy(p, &value, 3);
+            break;
+        default: //32 bits
+            for(; p + 4 <= e; p += 4)memcpy(p, &value, 4);
+            break;
+    }
+}
+
+Result GX_SetMemoryFill(u32* gxbuf, u32* buf0a, u32 buf0v, u32* buf0e, u16 width0, u32* buf1a, u32 buf1v, u32* buf1e, u16 width1)
+{
+    stats.memoryFills++;
+    fill(buf0a, buf0e, buf0v, width0);
+    fill(buf1a, buf1e, buf1v, width1);
+    return 0;
+}
+
+static inline u32 tiled_offset(u32 x, u32 y, u32 width)
+{
+    u32 morton = (x & 1) | ((y & 1) << 1) | ((x & 2) << 1) | ((y & 2) << 2) | ((x & 4) << 2) | ((y & 4) << 3);
+    return ((y >> 3) * (width >> 3) + (x >> 3)) * 64 + morton;
+}
+
+static const u8 transfer_bpp[8] = {4, 3, 2, 2, 2, 4, 4, 4};
+
+//Pixels are handled as (r,g,b,a) in the low to high bytes
+static u32 read_pixel(const u8* p, int format)
+{
+    u16 v;
+    switch(format)
+    {
+        case 0: return (u32)p[3] | (p[2] << 8) | (p[1] << 16) | ((u32)p[0] << 24); //RGBA8 is stored ABGR
+        case 1: return (u32)p[2] | (p[1] << 8) | (p[0] << 16) | 0xFF000000;       //RGB8 is stored BGR
+        case 2:
+            v = p[0] | (p[1] << 8);
+            return ((v >> 11) * 255 / 31) | ((((v >> 5) & 0x3F) * 255 / 63) << 8) | (((v & 0x1F) * 255 / 31) << 16) | 0xFF000000;
+        case 3:
+            v = p[0] | (p[1] << 8);
+            return ((v >> 11) * 255 / 31) | ((((v >> 6) & 0x1F) * 255 / 31) << 8) | ((((v >> 1) & 0x1F) * 255 / 31) << 16) | ((v & 1) ? 0xFF000000 : 0);
+        default:
+            v = p[0] | (p[1] << 8);
+            return ((v >> 12) * 0x11) | ((((v >> 8) & 0xF) * 0x11) << 8) | ((((v >> 4) & 0xF) * 0x11) << 16) | ((u32)((v & 0xF) * 0x11) << 24);
+    }
+}
+
+static void write_pixel(u8* p, int format, u32 c)
+{
+    u32 r = c & 0xFF, g = (c >> 8) & 0xFF, b = (c >> 16) & 0xFF, a = c >> 24;
+    u16 v;
+    switch(format)
+    {
+        case 0: p[0] = a; p[1] = b; p[2] = g; p[3] = r; return;
+        case 1: p[0] = b; p[1] = g; p[2] = r; return;
+        case 2: v = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3); break;
+        case 3: v = ((r >> 3) << 11) | ((g >> 3) << 6) | ((b >> 3) << 1) | (a >> 7); break;
+        default: v = ((r >> 4) << 12) | ((g >> 4) << 8) | ((b >> 4) << 4) | (a >> 4); break;
+    }
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+Result GX_SetDisplayTransfer(u32* gxbuf, u32* inadr, u32 indim, u32* outadr, u32 outdim, u32 flags)
+{
+    u32 inW = indim & 0xFFFF, inH = indim >> 16;
+    u32 outW = outdim & 0xFFFF, outH = outdim >> 16;
+    int inFmt = (flags >> 8) & 7, outFmt = (flags >> 12) & 7;
+    int scale = (flags >> 24) & 3; //0: none, 1: 2x1, 2: 2x2
+    bool flip = flags & 1;
+    bool toTiled = flags & 2;
+    u32 sx = scale ? 2 : 1, sy = scale == 2 ? 2 : 1;
+    u32 x, y, i, j;
+    //The output dimensions are given before the downscale
+    outW /= sx;
+    outH /= sy;
+
+    stats.displayTransfers++;
+    if(!inadr || !outadr)return 0;
+    for(y = 0; y < outH && y * sy < inH; ++y)
+    {
+        for(x = 0; x < outW && x * sx < inW; ++x)
+        {
+            u32 sum[4] = {0, 0, 0, 0};
+            for(j = 0; j < sy; ++j)for(i = 0; i < sx; ++i)
+            {
+                u32 ix = x * sx + i, iy = y * sy + j;
+                u32 off = toTiled ? iy * inW + ix : tiled_offset(ix, iy, inW);
+                u32 c = read_pixel((const u8*)inadr + off * transfer_bpp[inFmt], inFmt);
+                sum[0] += c & 0xFF; sum[1] += (c >> 8) & 0xFF; sum[2] += (c >> 16) & 0xFF; sum[3] += c >> 24;
+            }
+            u32 n = sx * sy;
+            u32 c = (sum[0] / n) | ((sum[1] / n) << 8) | ((sum[2] / n) << 16) | ((sum[3] / n) << 24);
+            u32 oy = flip ? outH - 1 - y : y;
+            u32 off = toTiled ? tiled_offset(x, oy, outW) : oy * outW + x;
+            write_pixel((u8*)outadr + off * transfer_bpp[outFmt], outFmt, c);
+        }
+    }
+    return 0;
+}
+
+Result GX_SetTextureCopy(u32* gxbuf, u32* inadr, u32 indim, u32* outadr, u32 outdim, u32 size, u32 flags)
+{
+    stats.textureCopies++;
+    if(inadr && outadr)memmove(outadr, inadr, size);
+    return 0;
+}
+
+static u32 lastList[0x40000];
+static u32 lastListSize = 0;
+
+static void submit(u32* buf, u32 size)
+{
+    stats.submissions++;
+    stats.commandWords += size / 4;
+    lastListSize = size / 4 > sizeof(lastList) / 4 ? sizeof(lastList) / 4 : size / 4;
+    memcpy(lastList, buf, lastListSize * 4);
+}
+
+Result GX_SetCommandList_Last(u32* gxbuf, u32* buf0a, u32 buf0s, u8 flags)
+{
+    submit(buf0a, buf0s);
+    return 0;
+}
+
+Result GX_SetCommandList_First(u32* gxbuf, u32* buf0a, u32 buf0s, u32* buf1a, u32 buf1s, u32* buf2a, u32 buf2s)
+{
+    return 0;
+}
+
+const ctru_host_stats* ctruHostGetStats(void)
+{
+    return &stats;
+}
+
+void ctruHostGetLastCommandList(const u32** cmds, u32* size)
+{
+    *cmds = lastList;
+    *size = lastListSize;
+}
+
+/*---------------------------------------------------------------------------------
+ * GPU commands
+ *-------------------------------------------------------------------------------*/
+
+static u32* gpuCmdBuf = NULL;
+static u32 gpuCmdBufSize = 0;
+static u32 gpuCmdBufOffset = 0;
+
+void GPU_Init(Handle* gsphandle)
+{
+    gpuCmdBuf = NULL;
+    gpuCmdBufSize = 0;
+    gpuCmdBufOffset = 0;
+}
+
+void GPUCMD_SetBuffer(u32* adr, u32 size, u32 offset)
+{
+    gpuCmdBuf = adr;
+    gpuCmdBufSize = size;
+    gpuCmdBufOffset = offset;
+}
+
+void GPUCMD_SetBufferOffset(u32 offset)
+{
+    gpuCmdBufOffset = offset;
+}
+
+void GPUCMD_GetBuffer(u32** adr, u32* size, u32* offset)
+{
+    if(adr)*adr = gpuCmdBuf;
+    if(size)*size = gpuCmdBufSize;
+    if(offset)*offset = gpuCmdBufOffset;
+}
+
+void GPUCMD_AddRawCommands(u32* cmd, u32 size)
+{
+    if(!cmd || !size || gpuCmdBufOffset + size > gpuCmdBufSize)return;
+    memcpy(&gpuCmdBuf[gpuCmdBufOffset], cmd, size * 4);
+    gpuCmdBufOffset += size;
+}
+
+void GPUCMD_Run(u32* gxbuf)
+{
+    GX_SetCommandList_Last(gxbuf, gpuCmdBuf, gpuCmdBufOffset * 4, 0x0);
+}
+
+void GPUCMD_FlushAndRun(u32* gxbuf)
+{
+    GSPGPU_FlushDataCache(NULL, (u8*)gpuCmdBuf, gpuCmdBufOffset * 4);
+    GX_SetCommandList_Last(gxbuf, gpuCmdBuf, gpuCmdBufOffset * 4, 0x0);
+}
+
+void GPUCMD_Add(u32 header, u32* param, u32 paramlength)
+{
+    if(!paramlength)paramlength = 1;
+    if(!gpuCmdBuf || gpuCmdBufOffset + paramlength + 1 > gpuCmdBufSize)return;
+
+    paramlength--;
+    header |= (paramlength & 0x7FF) << 20;
+
+    gpuCmdBuf[gpuCmdBufOffset] = param[0];
+    gpuCmdBuf[gpuCmdBufOffset + 1] = header;
+    if(paramlength)memcpy(&gpuCmdBuf[gpuCmdBufOffset + 2], &param[1], paramlength * 4);
+    gpuCmdBufOffset += paramlength + 2;
+
+    //Commands are 8 bytes aligned
+    if(paramlength & 1)gpuCmdBuf[gpuCmdBufOffset++] = 0x00000000;
+}
+
+void GPUCMD_Finalize(void)
+{
+    GPUCMD_AddMaskedWrite(GPUREG_0111, 0x1, 0x00000001);
+    GPUCMD_AddMaskedWrite(GPUREG_0110, 0x1, 0x00000001);
+    GPUCMD_AddWrite(GPUREG_FINALIZE, 0x12345678);
+    GPUCMD_AddWrite(GPUREG_FINALIZE, 0x12345678);
+}
+
+void GPU_Reset(u32* gxbuf, u32* gpuBuf, u32 gpuBufSize)
+{
+    GPUCMD_SetBuffer(gpuBuf, gpuBufSize, 0);
+    GPUCMD_AddWrite(GPUREG_0111, 0x00000001);
+    GPUCMD_AddWrite(GPUREG_0110, 0x00000001);
+    GPUCMD_Finalize();
+    GPUCMD_FlushAndRun(gxbuf);
+    gspWaitForP3D();
+    GPUCMD_SetBufferOffset(0);
+}
+
+u32 f32tof24(float f)
+{
+    u32 v;
+    memcpy(&v, &f, 4);
+    if(!(v & 0x7FFFFFFF))return (v >> 8) & 0x800000;
+
+    u32 mantissa = (v & 0x7FFFFF) >> 7;
+    s32 exponent = ((v >> 23) & 0xFF) - 127 + 63;
+    u32 sign = v >> 31;
+    if(exponent < 0)return sign << 23;
+    if(exponent > 0x7F)return (sign << 23) | (0x7F << 16);
+    return (sign << 23) | (exponent << 16) | mantissa;
+}
+
+u32 computeInvValue(u32 val)
+{
+    //Same as libctru: 1/val as a float31 shifted by 1
+    return f32tof31(1.0f / ((float)val / 2.0f)) << 1;
+}
+
+u32 f32tof31(float f)
+{
+    u32 v;
+    memcpy(&v, &f, 4);
+    if(!(v & 0x7FFFFFFF))return 0;
+
+    u32 mantissa = (v & 0x7FFFFF);
+    s32 exponent = ((v >> 23) & 0xFF) - 127 + 63;
+    u32 sign = v >> 31;
+    if(exponent < 0)return sign << 30;
+    return (sign << 30) | ((exponent & 0x7F) << 23) | mantissa;
+}
+
+void GPU_SetFloatUniform(GPU_SHADER_TYPE type, u32 startreg, u32* data, u32 numreg)
+{
+    u32 config = type == GPU_GEOMETRY_SHADER ? GPUREG_GSH_FLOATUNIFORM_CONFIG : GPUREG_VSH_FLOATUNIFORM_CONFIG;
+    if(!data)return;
+    GPUCMD_AddWrite(config, 0x80000000 | startreg);
+    GPUCMD_AddWrites(config + 1, data, numreg * 4);
+}
+
+void GPU_SetViewport(u32* depthBuffer, u32* colorBuffer, u32 x, u32 y, u32 w, u32 h)
+{
+    u32 param[0x4];
+    float fw = (float)w;
+    float fh = (float)h;
+
+    GPUCMD_AddWrite(GPUREG_0111, 0x00000001);
+    GPUCMD_AddWrite(GPUREG_0110, 0x00000001);
+
+    u32 f116e = 0x01000000 | (((h - 1) & 0xFFF) << 12) | (w & 0xFFF);
+
+    param[0x0] = ((u32)(uintptr_t)depthBuffer) >> 3;
+    param[0x1] = ((u32)(uintptr_t)colorBuffer) >> 3;
+    param[0x2] = f116e;
+    GPUCMD_AddIncrementalWrites(GPUREG_011C, param, 0x00000003);
+
+    GPUCMD_AddWrite(GPUREG_006E, f116e);
+    GPUCMD_AddWrite(GPUREG_0116, 0x00000003); //depth buffer format
+    GPUCMD_AddWrite(GPUREG_0117, 0x00000002); //color buffer format
+    GPUCMD_AddWrite(GPUREG_011B, 0x00000000);
+
+    param[0x0] = f32tof24(fw / 2);
+    param[0x1] = computeInvValue(fw);
+    param[0x2] = f32tof24(fh / 2);
+    param[0x3] = computeInvValue(fh);
+    GPUCMD_AddIncrementalWrites(GPUREG_0041, param, 0x00000004);
+
+    GPUCMD_AddWrite(GPUREG_0068, (y << 16) | (x & 0xFFFF));
+
+    param[0x0] = 0x00000000;
+    param[0x1] = 0x0000000F;
+    param[0x2] = 0x00000002;
+    param[0x3] = 0x00000002;
+    GPUCMD_AddIncrementalWrites(GPUREG_0112, param, 0x00000004);
+}
+
+void GPU_SetScissorTest(GPU_SCISSORMODE mode, u32 x, u32 y, u32 w, u32 h)
+{
+    u32 param[3];
+    param[0x0] = mode;
+    param[0x1] = (y << 16) | (x & 0xFFFF);
+    param[0x2] = ((h - 1) << 16) | ((w - 1) & 0xFFFF);
+    GPUCMD_AddIncrementalWrites(GPUREG_0065, param, 0x00000003);
+}
+
+void GPU_DepthMap(float zScale, float zOffset)
+{
+    GPUCMD_AddWrite(GPUREG_006D, 0x00000001);
+    GPUCMD_AddWrite(GPUREG_004D, f32tof24(zScale));
+    GPUCMD_AddWrite(GPUREG_004E, f32tof24(zOffset));
+}
+
+void GPU_SetAlphaTest(bool enable, GPU_TESTFUNC function, u8 ref)
+{
+    GPUCMD_AddWrite(GPUREG_0104, (enable & 1) | ((function & 7) << 4) | (ref << 8));
+}
+
+void GPU_SetStencilTest(bool enable, GPU_TESTFUNC function, u8 ref, u8 mask, u8 replace)
+{
+    GPUCMD_AddWrite(GPUREG_0105, (enable & 1) | ((function & 7) << 4) | (replace << 8) | (ref << 16) | (mask << 24));
+}
+
+void GPU_SetStencilOp(GPU_STENCILOP sfail, GPU_STENCILOP dfail, GPU_STENCILOP pass)
+{
+    GPUCMD_AddWrite(GPUREG_0106, sfail | (dfail << 4) | (pass << 8));
+}
+
+void GPU_SetDepthTestAndWriteMask(bool enable, GPU_TESTFUNC function, GPU_WRITEMASK writemask)
+{
+    GPUCMD_AddWrite(GPUREG_0107, (enable & 1) | ((function & 7) << 4) | (writemask << 8));
+}
+
+void GPU_SetFaceCulling(GPU_CULLMODE mode)
+{
+    GPUCMD_AddWrite(GPUREG_0040, mode & 0x3);
+}
+
+void GPU_SetAlphaBlending(GPU_BLENDEQUATION colorEquation, GPU_BLENDEQUATION alphaEquation,
+                          GPU_BLENDFACTOR colorSrc, GPU_BLENDFACTOR colorDst,
+                          GPU_BLENDFACTOR alphaSrc, GPU_BLENDFACTOR alphaDst)
+{
+    GPUCMD_AddWrite(GPUREG_0101, colorEquation | (alphaEquation << 8) | (colorSrc << 16) | (colorDst << 20) | (alphaSrc << 24) | (alphaDst << 28));
+    GPUCMD_AddMaskedWrite(GPUREG_0100, 0x2, 0x00000100);
+}
+
+void GPU_SetColorLogicOp(GPU_LOGICOP op)
+{
+    GPUCMD_AddWrite(GPUREG_0102, op);
+    GPUCMD_AddMaskedWrite(GPUREG_0100, 0x2, 0x00000000);
+}
+
+void GPU_SetBlendingColor(u8 r, u8 g, u8 b, u8 a)
+{
+    GPUCMD_AddWrite(GPUREG_0103, r | (g << 8) | (b << 16) | (a << 24));
+}
+
+void GPU_SetAttributeBuffers(u8 totalAttributes, u32* baseAddress, u64 attributeFormats, u16 attributeMask, u64 attributePermutation, u8 numBuffers, u32 bufferOffsets[], u64 bufferPermutations[], u8 bufferNumAttributes[])
+{
+    static const u8 sizeTable[] = {1, 1, 2, 4};
+    u32 param[0x28];
+    int i, j;
+
+    memset(param, 0x00, 0x28 * 4);
+
+    param[0x0] = ((u32)(uintptr_t)baseAddress) >> 3;
+    param[0x1] = attributeFormats & 0xFFFFFFFF;
+    param[0x2] = ((totalAttributes - 1) << 28) | ((attributeMask & 0xFFF) << 16) | ((attributeFormats >> 32) & 0xFFFF);
+
+    for(i = 0; i < numBuffers && i < 12; ++i)
+    {
+        u16 stride = 0;
+        param[3 * (i + 1) + 0] = bufferOffsets[i];
+        param[3 * (i + 1) + 1] = bufferPermutations[i] & 0xFFFFFFFF;
+        for(j = 0; j < bufferNumAttributes[i]; ++j)
+        {
+            u32 attr = (bufferPermutations[i] >> (4 * j)) & 0xF;
+            u32 fmt = (attributeFormats >> (4 * attr)) & 0xF;
+            stride += sizeTable[fmt & 3] * ((fmt >> 2) + 1);
+        }
+        param[3 * (i + 1) + 2] = (bufferNumAttributes[i] << 28) | ((stride & 0xFFF) << 16) | ((bufferPermutations[i] >> 32) & 0xFFFF);
+    }
+
+    GPUCMD_AddIncrementalWrites(GPUREG_ATTRIBBUFFERS_LOC, param, 0x00000027);
+
+    GPUCMD_AddMaskedWrite(GPUREG_VSH_INPUTBUFFER_CONFIG, 0xB, 0xA0000000 | (totalAttributes - 1));
+    GPUCMD_AddWrite(GPUREG_0242, (totalAttributes - 1));
+
+    param[0x0] = attributePermutation & 0xFFFFFFFF;
+    param[0x1] = (attributePermutation >> 32) & 0xFFFF;
+    GPUCMD_AddIncrementalWrites(GPUREG_VSH_ATTRIBUTES_PERMUTATION_LOW, param, 0x00000002);
+}
+
+void GPU_SetTextureEnable(GPU_TEXUNIT units)
+{
+    GPUCMD_AddWrite(GPUREG_006F, units << 8);
+    GPUCMD_AddWrite(GPUREG_0080, 0x00011000 | units);
+}
+
+void GPU_SetTexture(GPU_TEXUNIT unit, u32* data, u16 width, u16 height, u32 param, GPU_TEXCOLOR colorType)
+{
+    u32 typeReg, addrReg, dimReg, paramReg;
+    switch(unit)
+    {
+        case GPU_TEXUNIT0: typeReg = 0x008E; addrReg = 0x0085; dimReg = 0x0082; paramReg = 0x0083; break;
+        case GPU_TEXUNIT1: typeReg = 0x0096; addrReg = 0x0095; dimReg = 0x0092; paramReg = 0x0093; break;
+        case GPU_TEXUNIT2: typeReg = 0x009E; addrReg = 0x009D; dimReg = 0x009A; paramReg = 0x009B; break;
+        default: return;
+    }
+    GPUCMD_AddWrite(typeReg, colorType);
+    GPUCMD_AddWrite(addrReg, ((u32)(uintptr_t)data) >> 3);
+    GPUCMD_AddWrite(dimReg, (width << 16) | height);
+    GPUCMD_AddWrite(paramReg, param);
+}
+
+static const u8 tevOffsets[] = {0xC0, 0xC8, 0xD0, 0xD8, 0xF0, 0xF8};
+
+void GPU_SetTexEnv(u8 id, u16 rgbSources, u16 alphaSources, u16 rgbOperands, u16 alphaOperands, GPU_COMBINEFUNC rgbCombine, GPU_COMBINEFUNC alphaCombine, u32 constantColor)
+{
+    u32 param[0x5];
+    if(id > 5)return;
+
+    param[0x0] = (alphaSources << 16) | rgbSources;
+    param[0x1] = (alphaOperands << 12) | rgbOperands;
+    param[0x2] = (alphaCombine << 16) | rgbCombine;
+    param[0x3] = constantColor;
+    param[0x4] = 0x00000000;
+
+    GPUCMD_AddIncrementalWrites(GPUREG_0000 | tevOffsets[id], param, 0x00000005);
+}
+
+void GPU_DrawArray(GPU_Primitive_t primitive, u32 n)
+{
+    GPUCMD_AddMaskedWrite(GPUREG_PRIMITIVE_CONFIG, 0x2, primitive);
+    GPUCMD_AddWrite(GPUREG_RESTART_PRIMITIVE, 0x00000001);
+    GPUCMD_AddWrite(GPUREG_INDEXBUFFER_CONFIG, 0x80000000);
+    GPUCMD_AddWrite(GPUREG_NUMVERTICES, n);
+    GPUCMD_AddWrite(GPUREG_022A, 0x00000000);
+    GPUCMD_AddMaskedWrite(GPUREG_0253, 0x1, 0x00000000);
+
+    GPUCMD_AddMaskedWrite(GPUREG_0245, 0x1, 0x00000000);
+    GPUCMD_AddWrite(GPUREG_DRAWARRAYS, 0x00000001);
+    GPUCMD_AddMaskedWrite(GPUREG_0245, 0x1, 0x00000001);
+    GPUCMD_AddWrite(GPUREG_0231, 0x00000001);
+}
+
+void GPU_DrawElements(GPU_Primitive_t primitive, u32* indexArray, u32 n)
+{
+    GPUCMD_AddMaskedWrite(GPUREG_PRIMITIVE_CONFIG, 0x2, primitive);
+    GPUCMD_AddWrite(GPUREG_RESTART_PRIMITIVE, 0x00000001);
+    //Offset of the indices from the attribute buffers base address, bit 31 set for u16 indices
+    GPUCMD_AddWrite(GPUREG_INDEXBUFFER_CONFIG, 0x80000000 | ((u32)(uintptr_t)indexArray));
+    GPUCMD_AddWrite(GPUREG_NUMVERTICES, n);
+    GPUCMD_AddWrite(GPUREG_022A, 0x00000000);
+    GPUCMD_AddMaskedWrite(GPUREG_0253, 0x1, 0x00000100);
+
+    GPUCMD_AddMaskedWrite(GPUREG_0245, 0x1, 0x00000000);
+    GPUCMD_AddWrite(GPUREG_DRAWELEMENTS, 0x00000001);
+    GPUCMD_AddMaskedWrite(GPUREG_0245, 0x1, 0x00000001);
+    GPUCMD_AddWrite(GPUREG_0231, 0x00000001);
+}
+
+void GPU_FinishDrawing(void)
+{
+    GPUCMD_AddMaskedWrite(GPUREG_0111, 0x1, 0x00000001);
+    GPUCMD_AddMaskedWrite(GPUREG_0110, 0x1, 0x00000001);
+    GPUCMD_AddWrite(GPUREG_0063, 0x00000001);
+}
+
+void GPU_SetShaderOutmap(u32 outmapData[8])
+{
+    GPUCMD_AddMaskedWrite(GPUREG_PRIMITIVE_CONFIG, 0x1, outmapData[0] - 1);
+    GPUCMD_AddIncrementalWrites(GPUREG_004F, outmapData, 8);
+}
+
+void GPU_SendShaderCode(GPU_SHADER_TYPE type, u32* data, u16 offset, u16 length)
+{
+    u32 regOffset = type == GPU_GEOMETRY_SHADER ? (u32)-0x30 : 0x0;
+    int i;
+    if(!data)return;
+
+    GPUCMD_AddWrite(GPUREG_VSH_CODETRANSFER_CONFIG + regOffset, offset);
+    for(i = 0; i < length; i += 0x80)
+    {
+        GPUCMD_AddWrites(GPUREG_VSH_CODETRANSFER_DATA + regOffset, &data[i], ((length - i) < 0x80) ? (length - i) : 0x80);
+    }
+    GPUCMD_AddWrite(GPUREG_VSH_CODETRANSFER_END + regOffset, 0x00000001);
+}
+
+void GPU_SendOperandDescriptors(GPU_SHADER_TYPE type, u32* data, u16 offset, u16 length)
+{
+    u32 regOffset = type == GPU_GEOMETRY_SHADER ? (u32)-0x30 : 0x0;
+    if(!data)return;
+
+    GPUCMD_AddWrite(GPUREG_VSH_OPDESCS_CONFIG + regOffset, offset);
+    GPUCMD_AddWrites(GPUREG_VSH_OPDESCS_DATA + regOffset, data, length);
+}
+
+/*---------------------------------------------------------------------------------
+ * Shaders
+ *-------------------------------------------------------------------------------*/
+
+static void DVLE_GenerateOutmap(DVLE_s* dvle)
+{
+    int i;
+    memset(dvle->outmapData, 0x1F, sizeof(dvle->outmapData));
+    dvle->outmapMask = 0;
+    u8 numAttr = 0;
+    for(i = 0; i < dvle->outTableSize; ++i)
+    {
+        const DVLE_outEntry_s* e = &dvle->outTableData[i];
+        u32 reg = e->regID & 7;
+        u32 sem;
+        switch(e->type)
+        {
+            case RESULT_POSITION:   sem = 0x03020100; break;
+            case RESULT_NORMALQUAT: sem = 0x07060504; break;
+            case RESULT_COLOR:      sem = 0x0B0A0908; break;
+            case RESULT_TEXCOORD0:  sem = 0x1F1F0D0C; break;
+            case RESULT_TEXCOORD0W: sem = 0x1F1F1F10; break;
+            case RESULT_TEXCOORD1:  sem = 0x1F1F0F0E; break;
+            case RESULT_TEXCOORD2:  sem = 0x1F1F1716; break;
+            case RESULT_VIEW:       sem = 0x1F141312; break;
+            default: continue;
+        }
+        if(!(dvle->outmapMask & (1 << reg)))numAttr++;
+        dvle->outmapMask |= 1 << reg;
+        dvle->outmapData[reg + 1] = sem;
+    }
+    dvle->outmapData[0] = numAttr;
+}
+
+DVLB_s* DVLB_ParseFile(u32* shbinData, u32 shbinSize)
+{
+    u32 i;
+    if(!shbinData)return NULL;
+    DVLB_s* ret = malloc(sizeof(DVLB_s));
+    if(!ret)return NULL;
+
+    ret->numDVLE = shbinData[1];
+    ret->DVLE = calloc(ret->numDVLE, sizeof(DVLE_s));
+    if(!ret->DVLE)
+    {
+        free(ret);
+        return NULL;
+    }
+
+    u32* dvlpData = &shbinData[2 + ret->numDVLE];
+    ret->DVLP.codeSize = dvlpData[3];
+    ret->DVLP.codeData = &dvlpData[dvlpData[2] / 4];
+    ret->DVLP.opdescSize = dvlpData[5];
+    ret->DVLP.opcdescData = malloc(sizeof(u32) * (ret->DVLP.opdescSize + 1));
+    for(i = 0; i < ret->DVLP.opdescSize; ++i)ret->DVLP.opcdescData[i] = dvlpData[dvlpData[4] / 4 + i * 2];
+
+    for(i = 0; i < ret->numDVLE; ++i)
+    {
+        DVLE_s* dvle = &ret->DVLE[i];
+        u32* dvleData = &shbinData[shbinData[2 + i] / 4];
+
+        dvle->dvlp = &ret->DVLP;
+        dvle->type = (dvleData[1] >> 16) & 0xFF;
+        dvle->mainOffset = dvleData[2];
+        dvle->endmainOffset = dvleData[3];
+        dvle->constTableSize = dvleData[7];
+        dvle->constTableData = (DVLE_constEntry_s*)&dvleData[dvleData[6] / 4];
+        dvle->outTableSize = dvleData[11];
+        dvle->outTableData = (DVLE_outEntry_s*)&dvleData[dvleData[10] / 4];
+        dvle->uniformTableSize = dvleData[13];
+        dvle->uniformTableData = (DVLE_uniformEntry_s*)&dvleData[dvleData[12] / 4];
+        dvle->symbolTableData = (char*)&dvleData[dvleData[14] / 4];
+
+        DVLE_GenerateOutmap(dvle);
+    }
+    return ret;
+}
+
+void DVLB_Free(DVLB_s* dvlb)
+{
+    if(!dvlb)return;
+    free(dvlb->DVLP.opcdescData);
+    free(dvlb->DVLE);
+    free(dvlb);
+}
+
+s8 DVLE_GetUniformRegister(DVLE_s* dvle, const char* name)
+{
+    u32 i;
+    if(!dvle || !name)return -1;
+    for(i = 0; i < dvle->uniformTableSize; ++i)
+    {
+        if(!strcmp(&dvle->symbolTableData[dvle->uniformTableData[i].symbolOffset], name))
+        {
+            return dvle->uniformTableData[i].startReg - 0x10;
+        }
+    }
+    return -1;
+}
+
+Result shaderInstanceInit(shaderInstance_s* si, DVLE_s* dvle)
+{
+    u32 i;
+    if(!si || !dvle)return -1;
+    si->dvle = dvle;
+    si->numFloat24Uniforms = 0;
+    for(i = 0; i < dvle->constTableSize; ++i)if(dvle->constTableData[i].type == DVLE_CONST_FLOAT24)si->numFloat24Uniforms++;
+    si->float24Uniforms = calloc(si->numFloat24Uniforms + 1, sizeof(float24Uniform_s));
+    if(!si->float24Uniforms)return -1;
+
+    int n = 0;
+    for(i = 0; i < dvle->constTableSize; ++i)
+    {
+        const DVLE_constEntry_s* cnst = &dvle->constTableData[i];
+        if(cnst->type != DVLE_CONST_FLOAT24)continue;
+        float24Uniform_s* u = &si->float24Uniforms[n++];
+        u->id = cnst->id;
+        //Pack the 4 float24 in 3 words, w first like the uniform registers expect
+        u->data[0] = ((cnst->data[2] & 0xFF) << 24) | (cnst->data[3] & 0xFFFFFF);
+        u->data[1] = ((cnst->data[1] & 0xFFFF) << 16) | ((cnst->data[2] >> 8) & 0xFFFF);
+        u->data[2] = ((cnst->data[0] & 0xFFFFFF) << 8) | ((cnst->data[1] >> 16) & 0xFF);
+    }
+    return 0;
+}
+
+Result shaderInstanceFree(shaderInstance_s* si)
+{
+    if(!si)return -1;
+    free(si->float24Uniforms);
+    free(si);
+    return 0;
+}
+
+Result shaderInstanceGetUniformLocation(shaderInstance_s* si, const char* name)
+{
+    if(!si)return -1;
+    return DVLE_GetUniformRegister(si->dvle, name);
+}
+
+Result shaderProgramInit(shaderProgram_s* sp)
+{
+    if(!sp)return -1;
+    sp->vertexShader = NULL;
+    sp->geometryShader = NULL;
+    return 0;
+}
+
+Result shaderProgramFree(shaderProgram_s* sp)
+{
+    if(!sp)return -1;
+    if(sp->vertexShader)shaderInstanceFree(sp->vertexShader);
+    if(sp->geometryShader)shaderInstanceFree(sp->geometryShader);
+    sp->vertexShader = sp->geometryShader = NULL;
+    return 0;
+}
+
+static Result set_shader(shaderInstance_s** out, DVLE_s* dvle)
+{
+    if(*out)shaderInstanceFree(*out);
+    *out = malloc(sizeof(shaderInstance_s));
+    if(!*out)return -1;
+    return shaderInstanceInit(*out, dvle);
+}
+
+Result shaderProgramSetVsh(shaderProgram_s* sp, DVLE_s* dvle)
+{
+    if(!sp || !dvle || dvle->type != VERTEX_SHDR)return -1;
+    return set_shader(&sp->vertexShader, dvle);
+}
+
+Result shaderProgramSetGsh(shaderProgram_s* sp, DVLE_s* dvle, u8 stride)
+{
+    if(!sp || !dvle || dvle->type != GEOMETRY_SHDR)return -1;
+    sp->geometryShaderInputStride = stride;
+    return set_shader(&sp->geometryShader, dvle);
+}
+
+static void use_instance(GPU_SHADER_TYPE type, shaderInstance_s* si)
+{
+    DVLE_s* dvle = si->dvle;
+    u32 regOffset = type == GPU_GEOMETRY_SHADER ? (u32)-0x30 : 0x0;
+    int i;
+
+    GPU_SendShaderCode(type, dvle->dvlp->codeData, 0, dvle->dvlp->codeSize);
+    GPU_SendOperandDescriptors(type, dvle->dvlp->opcdescData, 0, dvle->dvlp->opdescSize);
+    GPUCMD_AddWrite(GPUREG_VSH_ENTRYPOINT + regOffset, 0x7FFF0000 | (dvle->mainOffset & 0xFFFF));
+    GPUCMD_AddWrite(GPUREG_VSH_OUTMAP_MASK + regOffset, dvle->outmapMask);
+    for(i = 0; i < si->numFloat24Uniforms; ++i)
+    {
+        GPUCMD_AddWrite(GPUREG_VSH_FLOATUNIFORM_CONFIG + regOffset, si->float24Uniforms[i].id);
+        GPUCMD_AddWrites(GPUREG_VSH_FLOATUNIFORM_DATA + regOffset, si->float24Uniforms[i].data, 3);
+    }
+}
+
+Result shaderProgramUse(shaderProgram_s* sp)
+{
+    if(!sp || !sp->vertexShader)return -1;
+    use_instance(GPU_VERTEX_SHADER, sp->vertexShader);
+    if(sp->geometryShader)use_instance(GPU_GEOMETRY_SHADER, sp->geometryShader);
+    GPU_SetShaderOutmap(sp->vertexShader->dvle->outmapData);
+    return 0;
+}
@@ -0,0 +1,39 @@
+/**
+ *@file ctru_host.h
+ *@author Lectem
+ *@date 17/10/2026
+ *
+ * Inspection API of the host stand-in for libctru (ctru_host.c).
+ *
+ * The stand-in does not rasterize anything: command lists are recorded, memory fills and display
+ * transfers are emulated on the host buffers, and every GSP event is signaled as soon as it is waited on.
+ *
+ * Environment variables:
+ *   GPUTEST_FRAMES  number of frames (hidScanInput calls) before aptMainLoop returns false, default 120
+ *   GPUTEST_KEYS    scripted input, eg. "1:X,30:A+UP" presses X on frame 1 then A and UP on frame 30
+ *   GPUTEST_QUIET   if set, no summary is printed by gfxExit
+ */
+#pragma once
+
+#include <3ds.h>
+
+typedef struct
+{
+    u32 frames;             ///< hidScanInput calls
+    u32 submissions;        ///< GPUCMD_FlushAndRun/GPUCMD_Run calls
+    u64 commandWords;       ///< Sum of the sizes of the submitted command lists
+    u32 memoryFills;
+    u32 displayTransfers;
+    u32 textureCopies;
+    u32 eventWaits[GSPEVENT_MAX];
+} ctru_host_stats;
+
+const ctru_host_stats* ctruHostGetStats(void);
+/**
+* The last submitted command list, copied at submission time.
+*/
+void ctruHostGetLastCommandList(const u32** cmds, u32* size);
+/**
+* Converts an address as seen by the GPU back to a host pointer, NULL if it is not in linear memory or VRAM.
+*/
+void* ctruHostPhysToVirt(u32 paddr);
@@ -0,0 +1,149 @@
+/**
+ *@file logcsv.c
+ *@author Lectem
+ *@date 17/10/2026
+ *
+ * Converts the record files of source/gpulog.c to CSV.
+ *
+ *   logcsv gpuLog.bin              lists the record types and how many records of each there are
+ *   logcsv gpuLog.bin <type>       prints the records of that type as CSV, frame and tick first
+ */
+#include "gpulog.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    char* name;             ///< NULL if the type isn't defined
+    char* fields;           ///< Comma separated, with the ":x" suffixes
+    u32 count;
+} record_type;
+
+static record_type types[GPU_LOG_MAX_TYPES];
+
+static u8* readFile(const char* path, u32* size)
+{
+    FILE* f = fopen(path, "rb");
+    u8* data = NULL;
+    long length;
+    if(!f)return NULL;
+    fseek(f, 0, SEEK_END);
+    length = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if(length > 0 && (data = malloc(length)) && fread(data, 1, length, f) != (size_t)length)
+    {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    *size = length;
+    return data;
+}
+
+static void define(const u32* values, u32 count)
+{
+    char* text;
+    char* colon;
+    if(count < 2 || values[0] == 0 || values[0] >= GPU_LOG_MAX_TYPES)return;
+    text = strndup((const char*)&values[1], (count - 1) * 4);
+    colon = strchr(text, ':');
+    free(types[values[0]].name);
+    types[values[0]].name = text;
+    types[values[0]].fields = colon ? colon + 1 : text + strlen(text);
+    if(colon)*colon = '\0';
+}
+
+/**
+* Prints the header line, without the ":x" suffixes, and marks the hex fields.
+*/
+static void printHeader(const record_type* t, bool* hex, u32 maxFields)
+{
+    const char* p = t->fields;
+    u32 i = 0;
+    printf("frame,tick");
+    while(*p && i < maxFields)
+    {
+        size_t n = strcspn(p, ",");
+        size_t nameLength = n;
+        hex[i] = n >= 2 && !strncmp(p + n - 2, ":x", 2);
+        if(hex[i])nameLength -= 2;
+        printf(",%.*s", (int)nameLength, p);
+        p += n;
+        if(*p)p++;
+        i++;
+    }
+    printf("\n");
+}
+
+int main(int argc, char** argv)
+{
+    u32 size, offset;
+    u8* data;
+    const gpu_log_file_header* header;
+    const char* wanted = argc > 2 ? argv[2] : NULL;
+    bool hex[GPU_LOG_MAX_VALUES];
+    bool headerPrinted = false;
+    u32 t;
+
+    if(argc < 2)
+    {
+        fprintf(stderr, "usage: logcsv <gpuLog.bin> [type]\n");
+        return 1;
+    }
+    data = readFile(argv[1], &size);
+    header = (const gpu_log_file_header*)data;
+    if(!data || size < sizeof(*header) || header->magic != GPU_LOG_MAGIC || header->version != GPU_LOG_VERSION)
+    {
+        fprintf(stderr, "%s isn't a record file\n", argv[1]);
+        return 1;
+    }
+
+    for(offset = header->headerSize; offset + sizeof(gpu_log_record_header) <= size;)
+    {
+        const gpu_log_record_header* r = (const gpu_log_record_header*)(data + offset);
+        const u32* values = (const u32*)(r + 1);
+        u32 i;
+        //The file may end in the middle of a record if the application didn't close the log
+        if(offset + sizeof(*r) + r->count * 4 > size)break;
+        offset += sizeof(*r) + r->count * 4;
+
+        if(r->type == 0)
+        {
+            define(values, r->count);
+            continue;
+        }
+        if(r->type >= GPU_LOG_MAX_TYPES || !types[r->type].name)continue;
+        types[r->type].count++;
+        if(!wanted || strcmp(types[r->type].name, wanted))continue;
+
+        if(!headerPrinted)
+        {
+            memset(hex, 0, sizeof(hex));
+            printHeader(&types[r->type], hex, GPU_LOG_MAX_VALUES);
+            headerPrinted = true;
+        }
+        printf("%lu,%llu", (unsigned long)r->frame, (unsigned long long)r->tick);
+        for(i = 0; i < r->count; ++i)
+        {
+            if(hex[i])printf(",0x%08lx", (unsigned long)values[i]);
+            else printf(",%lu", (unsigned long)values[i]);
+        }
+        printf("\n");
+    }
+
+    if(!wanted)
+    {
+        for(t = 1; t < GPU_LOG_MAX_TYPES; ++t)
+        {
+            if(types[t].name)printf("%-12s %8lu  %s\n", types[t].name, (unsigned long)types[t].count, types[t].fields);
+        }
+    }
+    else if(!headerPrinted)
+    {
+        fprintf(stderr, "no %s record\n", wanted);
+        return 1;
+    }
+    free(data);
+    return 0;
+}
@@ -0,0 +1,759 @@
+/**
+ *@file picashader.c
+ *@author Lectem
+ *@date 17/10/2026
+ *
+ * Arithmetic follows the PICA200 rules that matter for real shaders: 0 * inf = 0 in every multiplication,
+ * dot products and scalar instructions broadcast their result, and flow control uses a small stack of
+ * (end address, return address) like the hardware, see http://3dbrew.org/wiki/Shader_Instruction_Set
+ */
+#include "picashader.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+//Opcodes, MAD/MADI/CMP are normalized to their first value when decoding
+enum
+{
+    OP_ADD = 0x00,
+    OP_DP3 = 0x01,
+    OP_DP4 = 0x02,
+    OP_DPH = 0x03,
+    OP_DST = 0x04,
+    OP_EX2 = 0x05,
+    OP_LG2 = 0x06,
+    OP_LITP = 0x07,
+    OP_MUL = 0x08,
+    OP_SGE = 0x09,
+    OP_SLT = 0x0A,
+    OP_FLR = 0x0B,
+    OP_MAX = 0x0C,
+    OP_MIN = 0x0D,
+    OP_RCP = 0x0E,
+    OP_RSQ = 0x0F,
+    OP_MOVA = 0x12,
+    OP_MOV = 0x13,
+    OP_DPHI = 0x18,
+    OP_DSTI = 0x19,
+    OP_SGEI = 0x1A,
+    OP_SLTI = 0x1B,
+    OP_BREAK = 0x20,
+    OP_NOP = 0x21,
+    OP_END = 0x22,
+    OP_BREAKC = 0x23,
+    OP_CALL = 0x24,
+    OP_CALLC = 0x25,
+    OP_CALLU = 0x26,
+    OP_IFU = 0x27,
+    OP_IFC = 0x28,
+    OP_LOOP = 0x29,
+    OP_EMIT = 0x2A,
+    OP_SETEMIT = 0x2B,
+    OP_JMPC = 0x2C,
+    OP_JMPU = 0x2D,
+    OP_CMP = 0x2E,
+    OP_MADI = 0x30,
+    OP_MAD = 0x38,
+};
+
+struct pica_instr
+{
+    uint8_t op;
+    uint8_t dst;
+    uint8_t src[3];
+    uint8_t idx;        ///< 0: none, 1: a0.x, 2: a0.y, 3: aL
+    uint8_t idxSrc;     ///< The source the index applies to
+    uint8_t mask;       ///< Bit c set if component c (x=0) is written
+    uint8_t swz[3][4];
+    uint8_t neg[3];
+    uint8_t cmpOp[2];
+    //flow control
+    uint16_t dstOffset;
+    uint16_t num;
+    uint8_t uniformId;
+    uint8_t refX, refY, condOp;
+};
+
+/*---------------------------------------------------------------------------------
+ * SHBIN parsing
+ *-------------------------------------------------------------------------------*/
+
+float picaF24ToFloat(uint32_t f24)
+{
+    uint32_t sign = (f24 >> 23) & 1;
+    uint32_t exponent = (f24 >> 16) & 0x7F;
+    uint32_t mantissa = f24 & 0xFFFF;
+    uint32_t bits;
+    float f;
+
+    if(exponent == 0)bits = sign << 31; //No denormals
+    else if(exponent == 0x7F)bits = (sign << 31) | (0xFFu << 23) | (mantissa << 7);
+    else bits = (sign << 31) | ((exponent - 63 + 127) << 23) | (mantissa << 7);
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+static inline uint32_t read32(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint16_t read16(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static void decode(uint32_t word, const uint32_t* opdescs, uint32_t numOpdescs, pica_instr* in)
+{
+    uint32_t opcode = word >> 26;
+    uint32_t desc = 0;
+    int s, c;
+
+    memset(in, 0, sizeof(*in));
+    if(opcode >= 0x38)opcode = OP_MAD;
+    else if(opcode >= 0x30)opcode = OP_MADI;
+    else if(opcode == 0x2F)opcode = OP_CMP;
+    in->op = opcode;
+
+    switch(opcode)
+    {
+        case OP_DPHI: case OP_DSTI: case OP_SGEI: case OP_SLTI:
+            desc = word & 0x7F;
+            in->src[1] = (word >> 7) & 0x7F;
+            in->src[0] = (word >> 14) & 0x1F;
+            in->idx = (word >> 19) & 3;
+            in->idxSrc = 1;
+            in->dst = (word >> 21) & 0x1F;
+            break;
+        case OP_CMP:
+            desc = word & 0x7F;
+            in->src[1] = (word >> 7) & 0x1F;
+            in->src[0] = (word >> 12) & 0x7F;
+            in->idx = (word >> 19) & 3;
+            in->cmpOp[1] = (word >> 21) & 7;
+            in->cmpOp[0] = (word >> 24) & 7;
+            break;
+        case OP_MAD:
+            desc = word & 0x1F;
+            in->src[2] = (word >> 5) & 0x1F;
+            in->src[1] = (word >> 10) & 0x7F;
+            in->src[0] = (word >> 17) & 0x1F;
+            in->idx = (word >> 22) & 3;
+            in->idxSrc = 1;
+            in->dst = (word >> 24) & 0x1F;
+            break;
+        case OP_MADI:
+            desc = word & 0x1F;
+            in->src[2] = (word >> 5) & 0x7F;
+            in->src[1] = (word >> 12) & 0x1F;
+            in->src[0] = (word >> 17) & 0x1F;
+            in->idx = (word >> 22) & 3;
+            in->idxSrc = 2;
+            in->dst = (word >> 24) & 0x1F;
+            break;
+        case OP_BREAKC: case OP_CALLC: case OP_IFC: case OP_JMPC:
+            in->num = word & 0xFF;
+            in->dstOffset = (word >> 10) & 0xFFF;
+            in->condOp = (word >> 22) & 3;
+            in->refY = (word >> 24) & 1;
+            in->refX = (word >> 25) & 1;
+            return;
+        case OP_CALL: case OP_CALLU: case OP_IFU: case OP_JMPU: case OP_LOOP:
+            in->num = word & 0xFF;
+            in->dstOffset = (word >> 10) & 0xFFF;
+            in->uniformId = (word >> 22) & 0xF;
+            return;
+        case OP_BREAK: case OP_NOP: case OP_END: case OP_EMIT: case OP_SETEMIT:
+            return;
+        default:
+            desc = word & 0x7F;
+            in->src[1] = (word >> 7) & 0x1F;
+            in->src[0] = (word >> 12) & 0x7F;
+            in->idx = (word >> 19) & 3;
+            in->dst = (word >> 21) & 0x1F;
+            break;
+    }
+
+    uint32_t d = desc < numOpdescs ? opdescs[desc] : 0;
+    for(c = 0; c < 4; ++c)
+    {
+        if(d & (8 >> c))in->mask |= 1 << c;
+    }
+    for(s = 0; s < 3; ++s)
+    {
+        uint32_t neg_bit = 4 + 9 * s;
+        uint32_t swz = (d >> (neg_bit + 1)) & 0xFF;
+        in->neg[s] = (d >> neg_bit) & 1;
+        for(c = 0; c < 4; ++c)in->swz[s][c] = (swz >> (6 - 2 * c)) & 3;
+    }
+}
+
+static int is_supported(uint8_t op)
+{
+    switch(op)
+    {
+        case OP_LITP: case OP_EMIT: case OP_SETEMIT:
+        case 0x10: case 0x11: case 0x14: case 0x15: case 0x16: case 0x17:
+        case 0x1C: case 0x1D: case 0x1E: case 0x1F:
+            return 0;
+        default:
+            return 1;
+    }
+}
+
+int picaShaderLoad(pica_shader* sh, const void* shbin, size_t size, int dvleIndex)
+{
+    const uint8_t* data = shbin;
+    uint32_t i;
+
+    memset(sh, 0, sizeof(*sh));
+    if(size < 8 || memcmp(data, "DVLB", 4))return PICA_SHADER_BAD_FILE;
+
+    uint32_t numDVLE = read32(data + 4);
+    if(dvleIndex < 0 || (uint32_t)dvleIndex >= numDVLE)return PICA_SHADER_BAD_DVLE;
+    if(8 + 4 * (size_t)numDVLE + 0x18 > size)return PICA_SHADER_BAD_FILE;
+
+    //DVLP, right after the DVLE offsets
+    const uint8_t* dvlp = data + 8 + 4 * numDVLE;
+    if(memcmp(dvlp, "DVLP", 4))return PICA_SHADER_BAD_FILE;
+    uint32_t codeOffset = read32(dvlp + 0x8);
+    sh->codeSize = read32(dvlp + 0xC);
+    uint32_t opdescOffset = read32(dvlp + 0x10);
+    sh->opdescSize = read32(dvlp + 0x14);
+    if(sh->codeSize > PICA_MAX_CODE || sh->opdescSize > PICA_MAX_OPDESCS)return PICA_SHADER_TOO_BIG;
+    if((size_t)(dvlp - data) + codeOffset + 4 * (size_t)sh->codeSize > size
+       || (size_t)(dvlp - data) + opdescOffset + 8 * (size_t)sh->opdescSize > size)return PICA_SHADER_BAD_FILE;
+    for(i = 0; i < sh->codeSize; ++i)sh->code[i] = read32(dvlp + codeOffset + 4 * i);
+    for(i = 0; i < sh->opdescSize; ++i)sh->opdesc[i] = read32(dvlp + opdescOffset + 8 * i);
+
+    //DVLE
+    uint32_t dvleOffset = read32(data + 8 + 4 * dvleIndex);
+    if((size_t)dvleOffset + 0x40 > size)return PICA_SHADER_BAD_FILE;
+    const uint8_t* dvle = data + dvleOffset;
+    if(memcmp(dvle, "DVLE", 4))return PICA_SHADER_BAD_FILE;
+    sh->type = dvle[6];
+    sh->mainOffset = read32(dvle + 0x8);
+    sh->endmainOffset = read32(dvle + 0xC);
+
+    uint32_t constOffset = read32(dvle + 0x18), numConsts = read32(dvle + 0x1C);
+    uint32_t outOffset = read32(dvle + 0x28), numOuts = read32(dvle + 0x2C);
+    uint32_t uniformOffset = read32(dvle + 0x30), numUniforms = read32(dvle + 0x34);
+    uint32_t symbolOffset = read32(dvle + 0x38), symbolSize = read32(dvle + 0x3C);
+    if((size_t)dvleOffset + constOffset + 0x14 * (size_t)numConsts > size
+       || (size_t)dvleOffset + outOffset + 8 * (size_t)numOuts > size
+       || (size_t)dvleOffset + uniformOffset + 8 * (size_t)numUniforms > size
+       || (size_t)dvleOffset + symbolOffset + symbolSize > size)return PICA_SHADER_BAD_FILE;
+
+    for(i = 0; i < numOuts && i < PICA_MAX_OUTPUT_ENTRIES; ++i)
+    {
+        const uint8_t* e = dvle + outOffset + 8 * i;
+        sh->outputs[i].type = read16(e);
+        sh->outputs[i].reg = read16(e + 2) & 0xF;
+        sh->outputs[i].mask = e[4];
+    }
+    sh->numOutputs = i;
+
+    for(i = 0; i < numUniforms && i < PICA_MAX_UNIFORM_ENTRIES; ++i)
+    {
+        const uint8_t* e = dvle + uniformOffset + 8 * i;
+        uint32_t nameOffset = read32(e);
+        pica_uniform_entry* u = &sh->uniforms[i];
+        if(nameOffset < symbolSize)
+        {
+            const char* name = (const char*)dvle + symbolOffset + nameOffset;
+            size_t len = strnlen(name, symbolSize - nameOffset);
+            if(len >= sizeof(u->name))len = sizeof(u->name) - 1;
+            memcpy(u->name, name, len);
+        }
+        u->startReg = read16(e + 4);
+        u->endReg = read16(e + 6);
+    }
+    sh->numUniforms = i;
+
+    //Same default as the hardware after a reset: everything at 0
+    for(i = 0; i < numConsts; ++i)
+    {
+        const uint8_t* e = dvle + constOffset + 0x14 * i;
+        uint8_t type = e[0];
+        uint8_t id = e[2];
+        switch(type)
+        {
+            case 0: //bool
+                picaShaderSetBoolUniform(sh, id, read32(e + 4) & 1);
+                break;
+            case 1: //u8 x,y,z
+            {
+                uint32_t v = read32(e + 4);
+                picaShaderSetIntUniform(sh, id, v & 0xFF, (v >> 8) & 0xFF, (int8_t)(v >> 16));
+                break;
+            }
+            case 2: //float24 x,y,z,w
+            {
+                float f[4];
+                int c;
+                for(c = 0; c < 4; ++c)f[c] = picaF24ToFloat(read32(e + 4 + 4 * c));
+                picaShaderSetFloatUniform(sh, id, f, 1);
+                break;
+            }
+            default:break;
+        }
+    }
+
+    sh->decoded = malloc(sizeof(pica_instr) * (sh->codeSize ? sh->codeSize : 1));
+    if(!sh->decoded)return PICA_SHADER_TOO_BIG;
+    for(i = 0; i < sh->codeSize; ++i)
+    {
+        pica_instr* in = &sh->decoded[i];
+        decode(sh->code[i], sh->opdesc, sh->opdescSize, in);
+        if(!is_supported(in->op))
+        {
+            picaShaderFree(sh);
+            return PICA_SHADER_UNSUPPORTED;
+        }
+    }
+    return PICA_SHADER_OK;
+}
+
+void picaShaderFree(pica_shader* sh)
+{
+    free(sh->decoded);
+    sh->decoded = NULL;
+}
+
+int picaShaderGetUniformLocation(const pica_shader* sh, const char* name)
+{
+    int i;
+    for(i = 0; i < sh->numUniforms; ++i)
+    {
+        const pica_uniform_entry* u = &sh->uniforms[i];
+        if(!strcmp(u->name, name))
+        {
+            if(u->startReg >= 0x10 && u->startReg < 0x70)return u->startReg - 0x10;
+            if(u->startReg >= 0x70 && u->startReg < 0x74)return u->startReg - 0x70;
+            if(u->startReg >= 0x78 && u->startReg < 0x88)return u->startReg - 0x78;
+        }
+    }
+    return -1;
+}
+
+void picaShaderSetFloatUniform(pica_shader* sh, int reg, const float* data, int count)
+{
+    int i;
+    for(i = 0; i < count && reg + i < PICA_NUM_FLOAT_UNIFORMS; ++i)
+    {
+        if(reg + i < 0)continue;
+        sh->floatUniforms[reg + i] = (pica_vec4){data[4 * i], data[4 * i + 1], data[4 * i + 2], data[4 * i + 3]};
+    }
+}
+
+void picaShaderSetIntUniform(pica_shader* sh, int reg, int32_t x, int32_t y, int32_t z)
+{
+    if(reg < 0 || reg >= 4)return;
+    sh->intUniforms[reg][0] = x;
+    sh->intUniforms[reg][1] = y;
+    sh->intUniforms[reg][2] = z;
+}
+
+void picaShaderSetBoolUniform(pica_shader* sh, int reg, int value)
+{
+    if(reg < 0 || reg >= 16)return;
+    if(value)sh->boolUniforms |= 1 << reg;
+    else sh->boolUniforms &= ~(1 << reg);
+}
+
+/*---------------------------------------------------------------------------------
+ * Batched interpreter
+ *-------------------------------------------------------------------------------*/
+
+#define B PICA_SHADER_BATCH
+#define MAX_STEPS (1 << 20)
+#define STACK_SIZE 8
+
+typedef float lanes4[4][B];
+
+typedef struct
+{
+    lanes4 v[PICA_NUM_INPUTS];
+    lanes4 r[PICA_NUM_TEMPS];
+    lanes4 o[PICA_NUM_OUTPUTS];
+    int32_t a0[2][B];
+    int32_t aL;
+    uint8_t cmp[2][B];
+} batch_state;
+
+typedef struct
+{
+    uint32_t finalAddr;
+    uint32_t returnAddr;
+    int32_t repeat;     ///< Remaining loop iterations, -1 for calls and ifs
+    int32_t increment;
+    uint32_t loopAddr;
+} flow_entry;
+
+//0 * anything = 0, even inf and nan
+static inline float mul(float a, float b)
+{
+    float r = a * b;
+    return (r != r && a == a && b == b) ? 0.0f : r;
+}
+
+static void fetch(const pica_shader* sh, const batch_state* st, const pica_instr* in, int s, lanes4 out, int n)
+{
+    int reg = in->src[s];
+    const uint8_t* swz = in->swz[s];
+    int c, l;
+
+    if(reg < 0x20)
+    {
+        const float (*r)[B] = reg < 0x10 ? st->v[reg] : st->r[reg - 0x10];
+        for(c = 0; c < 4; ++c)
+        {
+            const float* src = r[swz[c]];
+            for(l = 0; l < n; ++l)out[c][l] = src[l];
+        }
+    }
+    else if(in->idx && in->idxSrc == s)
+    {
+        for(l = 0; l < n; ++l)
+        {
+            int offset = in->idx == 3 ? st->aL : st->a0[in->idx - 1][l];
+            int index = (reg - 0x20 + offset) & 0x7F;
+            //Out of range indices read as 0
+            pica_vec4 u = index < PICA_NUM_FLOAT_UNIFORMS ? sh->floatUniforms[index] : (pica_vec4){0, 0, 0, 0};
+            const float* f = &u.x;
+            for(c = 0; c < 4; ++c)out[c][l] = f[swz[c]];
+        }
+    }
+    else
+    {
+        const float* f = &sh->floatUniforms[reg - 0x20].x;
+        for(c = 0; c < 4; ++c)
+        {
+            float v = f[swz[c]];
+            for(l = 0; l < n; ++l)out[c][l] = v;
+        }
+    }
+
+    if(in->neg[s])
+    {
+        for(c = 0; c < 4; ++c)for(l = 0; l < n; ++l)out[c][l] = -out[c][l];
+    }
+}
+
+static void store(batch_state* st, const pica_instr* in, lanes4 res, int n)
+{
+    float (*d)[B] = in->dst < 0x10 ? st->o[in->dst] : st->r[in->dst - 0x10];
+    int c;
+    for(c = 0; c < 4; ++c)
+    {
+        if(in->mask & (1 << c))memcpy(d[c], res[c], n * sizeof(float));
+    }
+}
+
+static inline int compare(float a, float b, int op)
+{
+    switch(op)
+    {
+        case 0: return a == b;
+        case 1: return a != b;
+        case 2: return a < b;
+        case 3: return a <= b;
+        case 4: return a > b;
+        case 5: return a >= b;
+        default: return 1;
+    }
+}
+
+/**
+* Evaluates the condition of a format 2 instruction.
+* @return 0 or 1, or -1 if the lanes do not agree
+*/
+static int condition(const batch_state* st, const pica_instr* in, int n)
+{
+    int l, first = -1;
+    for(l = 0; l < n; ++l)
+    {
+        int x = st->cmp[0][l] == in->refX;
+        int y = st->cmp[1][l] == in->refY;
+        int res;
+        switch(in->condOp)
+        {
+            case 0: res = x || y; break;
+            case 1: res = x && y; break;
+            case 2: res = x; break;
+            default: res = y; break;
+        }
+        if(first < 0)first = res;
+        else if(res != first)return -1;
+    }
+    return first;
+}
+
+/**
+* Runs the program for the n first lanes of the batch.
+* @return 0, or -1 if the lanes diverged and the batch must be replayed one vertex at a time
+*/
+static int run_batch(const pica_shader* sh, batch_state* st, int n)
+{
+    flow_entry stack[STACK_SIZE];
+    int sp = 0;
+    uint32_t pc = sh->mainOffset;
+    int steps = 0;
+    lanes4 a, b, c, res;
+    int i, l;
+
+    st->aL = 0;
+    while(pc < sh->codeSize && steps++ < MAX_STEPS)
+    {
+        const pica_instr* in = &sh->decoded[pc];
+        uint32_t next = pc + 1;
+        int cond;
+
+        switch(in->op)
+        {
+            case OP_ADD:
+                fetch(sh, st, in, 0, a, n); fetch(sh, st, in, 1, b, n);
+                for(i = 0; i < 4; ++i)for(l = 0; l < n; ++l)res[i][l] = a[i][l] + b[i][l];
+                store(st, in, res, n);
+                break;
+            case OP_MUL:
+                fetch(sh, st, in, 0, a, n); fetch(sh, st, in, 1, b, n);
+                for(i = 0; i < 4; ++i)for(l = 0; l < n; ++l)res[i][l] = mul(a[i][l], b[i][l]);
+                store(st, in, res, n);
+                break;
+            case OP_DP3: case OP_DP4: case OP_DPH: case OP_DPHI:
+                fetch(sh, st, in, 0, a, n); fetch(sh, st, in, 1, b, n);
+                for(l = 0; l < n; ++l)
+                {
+                    float d = mul(a[0][l], b[0][l]) + mul(a[1][l], b[1][l]) + mul(a[2][l], b[2][l]);
+                    if(in->op == OP_DP4)d += mul(a[3][l], b[3][l]);
+                    else if(in->op != OP_DP3)d += b[3][l];
+                    res[0][l] = res[1][l] = res[2][l] = res[3][l] = d;
+                }
+                store(st, in, res, n);
+                break;
+            case OP_DST: case OP_DSTI:
+                fetch(sh, st, in, 0, a, n); fetch(sh, st, in, 1, b, n);
+                for(l = 0; l < n; ++l)
+                {
+                    res[0][l] = 1.0f;
+                    res[1][l] = mul(a[1][l], b[1][l]);
+                    res[2][l] = a[2][l];
+                    res[3][l] = b[3][l];
+                }
+                store(st, in, res, n);
+                break;
+            case OP_EX2: case OP_LG2: case OP_RCP: case OP_RSQ:
+                fetch(sh, st, in, 0, a, n);
+                for(l = 0; l < n; ++l)
+                {
+                    float x = a[0][l], r;
+                    switch(in->op)
+                    {
+                        case OP_EX2: r = exp2f(x); break;
+                        case OP_LG2: r = log2f(x); break;
+                        case OP_RCP: r = 1.0f / x; break;
+                        default:     r = 1.0f / sqrtf(x); break;
+                    }
+                    res[0][l] = res[1][l] = res[2][l] = res[3][l] = r;
+                }
+                store(st, in, res, n);
+                break;
+            case OP_SGE: case OP_SGEI: case OP_SLT: case OP_SLTI:
+                fetch(sh, st, in, 0, a, n); fetch(sh, st, in, 1, b, n);
+                for(i = 0; i < 4; ++i)for(l = 0; l < n; ++l)
+                {
+                    int ge = a[i][l] >= b[i][l];
+                    res[i][l] = (in->op == OP_SGE || in->op == OP_SGEI) == ge ? 1.0f : 0.0f;
+                }
+                store(st, in, res, n);
+                break;
+            case OP_FLR:
+                fetch(sh, st, in, 0, a, n);
+                for(i = 0; i < 4; ++i)for(l = 0; l < n; ++l)res[i][l] = floorf(a[i][l]);
+                store(st, in, res, n);
+                break;
+            case OP_MAX:
+                fetch(sh, st, in, 0, a, n); fetch(sh, st, in, 1, b, n);
+                for(i = 0; i < 4; ++i)for(l = 0; l < n; ++l)res[i][l] = a[i][l] > b[i][l] ? a[i][l] : b[i][l];
+                store(st, in, res, n);
+                break;
+            case OP_MIN:
+                fetch(sh, st, in, 0, a, n); fetch(sh, st, in, 1, b, n);
+                for(i = 0; i < 4; ++i)for(l = 0; l < n; ++l)res[i][l] = a[i][l] < b[i][l] ? a[i][l] : b[i][l];
+                store(st, in, res, n);
+                break;
+            case OP_MOVA:
+                fetch(sh, st, in, 0, a, n);
+                for(i = 0; i < 2; ++i)
+                {
+                    if(in->mask & (1 << i))for(l = 0; l < n; ++l)st->a0[i][l] = (int32_t)a[i][l];
+                }
+                break;
+            case OP_MOV:
+                fetch(sh, st, in, 0, a, n);
+                store(st, in, a, n);
+                break;
+            case OP_CMP:
+                fetch(sh, st, in, 0, a, n); fetch(sh, st, in, 1, b, n);
+                for(i = 0; i < 2; ++i)for(l = 0; l < n; ++l)st->cmp[i][l] = compare(a[i][l], b[i][l], in->cmpOp[i]);
+                break;
+            case OP_MAD: case OP_MADI:
+                fetch(sh, st, in, 0, a, n); fetch(sh, st, in, 1, b, n); fetch(sh, st, in, 2, c, n);
+                for(i = 0; i < 4; ++i)for(l = 0; l < n; ++l)res[i][l] = mul(a[i][l], b[i][l]) + c[i][l];
+                store(st, in, res, n);
+                break;
+
+            case OP_NOP:
+                break;
+            case OP_END:
+                return 0;
+
+            case OP_CALL: case OP_CALLU: case OP_CALLC:
+                if(in->op == OP_CALLU)cond = (sh->boolUniforms >> in->uniformId) & 1;
+                else if(in->op == OP_CALLC)cond = condition(st, in, n);
+                else cond = 1;
+                if(cond < 0)return -1;
+                if(cond && sp < STACK_SIZE)
+                {
+                    stack[sp++] = (flow_entry){in->dstOffset + in->num, pc + 1, -1, 0, 0};
+                    next = in->dstOffset;
+                }
+                break;
+            case OP_IFU: case OP_IFC:
+                cond = in->op == OP_IFU ? (int)((sh->boolUniforms >> in->uniformId) & 1) : condition(st, in, n);
+                if(cond < 0)return -1;
+                if(sp >= STACK_SIZE)break;
+                if(cond)
+                {
+                    stack[sp++] = (flow_entry){in->dstOffset, in->dstOffset + in->num, -1, 0, 0};
+                }
+                else
+                {
+                    stack[sp++] = (flow_entry){in->dstOffset + in->num, in->dstOffset + in->num, -1, 0, 0};
+                    next = in->dstOffset;
+                }
+                break;
+            case OP_LOOP:
+            {
+                const int32_t* iu = sh->intUniforms[in->uniformId & 3];
+                if(sp >= STACK_SIZE)break;
+                st->aL = iu[1];
+                stack[sp++] = (flow_entry){in->dstOffset + 1u, in->dstOffset + 1u, iu[0], iu[2], pc + 1};
+                break;
+            }
+            case OP_JMPU: case OP_JMPC:
+                if(in->op == OP_JMPU)cond = ((sh->boolUniforms >> in->uniformId) & 1) == !(in->num & 1);
+                else cond = condition(st, in, n);
+                if(cond < 0)return -1;
+                if(cond)next = in->dstOffset;
+                break;
+            case OP_BREAK: case OP_BREAKC:
+                cond = in->op == OP_BREAK ? 1 : condition(st, in, n);
+                if(cond < 0)return -1;
+                if(cond)
+                {
+                    //Leave the innermost loop
+                    while(sp > 0 && stack[sp - 1].repeat < 0)sp--;
+                    if(sp > 0)next = stack[--sp].returnAddr;
+                }
+                break;
+            default:
+                break;
+        }
+
+        pc = next;
+        //Unwind the blocks ending here
+        while(sp > 0 && pc == stack[sp - 1].finalAddr)
+        {
+            flow_entry* top = &stack[sp - 1];
+            if(top->repeat > 0)
+            {
+                top->repeat--;
+                st->aL += top->increment;
+                pc = top->loopAddr;
+                break;
+            }
+            pc = top->returnAddr;
+            sp--;
+        }
+    }
+    return 0;
+}
+
+static void load_inputs(batch_state* st, const pica_vec4* const inputs[PICA_NUM_INPUTS], size_t first, int n)
+{
+    int i, l;
+    for(i = 0; i < PICA_NUM_INPUTS; ++i)
+    {
+        const pica_vec4* in = inputs ? inputs[i] : NULL;
+        for(l = 0; l < n; ++l)
+        {
+            pica_vec4 v = in ? in[first + l] : (pica_vec4){0, 0, 0, 1};
+            st->v[i][0][l] = v.x;
+            st->v[i][1][l] = v.y;
+            st->v[i][2][l] = v.z;
+            st->v[i][3][l] = v.w;
+        }
+    }
+    memset(st->r, 0, sizeof(st->r));
+    memset(st->o, 0, sizeof(st->o));
+    memset(st->a0, 0, sizeof(st->a0));
+    memset(st->cmp, 0, sizeof(st->cmp));
+}
+
+static void store_outputs(const batch_state* st, pica_vec4* const outputs[PICA_NUM_OUTPUTS], size_t first, int n)
+{
+    int i, l;
+    for(i = 0; i < PICA_NUM_OUTPUTS; ++i)
+    {
+        if(!outputs[i])continue;
+        for(l = 0; l < n; ++l)
+        {
+            outputs[i][first + l] = (pica_vec4){st->o[i][0][l], st->o[i][1][l], st->o[i][2][l], st->o[i][3][l]};
+        }
+    }
+}
+
+static size_t run(const pica_shader* sh, const pica_vec4* const inputs[PICA_NUM_INPUTS],
+                  pica_vec4* const outputs[PICA_NUM_OUTPUTS], size_t n, int batch)
+{
+    batch_state* st = malloc(sizeof(*st));
+    size_t first, replays = 0;
+    if(!st)return 0;
+
+    for(first = 0; first < n; first += batch)
+    {
+        int count = n - first < (size_t)batch ? (int)(n - first) : batch;
+        load_inputs(st, inputs, first, count);
+        if(run_batch(sh, st, count) < 0)
+        {
+            //The vertices took different branches, run them separately
+            int l;
+            replays++;
+            for(l = 0; l < count; ++l)
+            {
+                load_inputs(st, inputs, first + l, 1);
+                run_batch(sh, st, 1);
+                store_outputs(st, outputs, first + l, 1);
+            }
+            continue;
+        }
+        store_outputs(st, outputs, first, count);
+    }
+    free(st);
+    return replays;
+}
+
+size_t picaShaderRun(const pica_shader* sh, const pica_vec4* const inputs[PICA_NUM_INPUTS],
+                     pica_vec4* const outputs[PICA_NUM_OUTPUTS], size_t n)
+{
+    return run(sh, inputs, outputs, n, B);
+}
+
+void picaShaderRunScalar(const pica_shader* sh, const pica_vec4* const inputs[PICA_NUM_INPUTS],
+                         pica_vec4* const outputs[PICA_NUM_OUTPUTS], size_t n)
+{
+    run(sh, inputs, outputs, n, 1);
+}
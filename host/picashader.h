@@ -0,0 +1,130 @@
+/**
+ *@file picashader.h
+ *@author Lectem
+ *@date 17/10/2026
+ *
+ * Host-side PICA200 vertex shader engine.
+ * Loads the assembled SHBIN that DVLB_ParseFile consumes on the console and runs it over whole vertex buffers.
+ *
+ * Vertices are processed in batches of PICA_SHADER_BATCH, one instruction at a time for the whole batch,
+ * with the registers stored as structure of arrays so that the compiler vectorizes the per-lane loops.
+ * A batch whose vertices take different branches (ifc, callc, jmpc, breakc) is replayed one vertex at a time.
+ *
+ * See http://3dbrew.org/wiki/SHBIN and http://3dbrew.org/wiki/Shader_Instruction_Set
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define PICA_SHADER_BATCH 64
+
+#define PICA_MAX_CODE 512
+#define PICA_MAX_OPDESCS 128
+#define PICA_NUM_INPUTS 16
+#define PICA_NUM_OUTPUTS 16
+#define PICA_NUM_TEMPS 16
+#define PICA_NUM_FLOAT_UNIFORMS 96
+#define PICA_MAX_OUTPUT_ENTRIES 16
+#define PICA_MAX_UNIFORM_ENTRIES 64
+
+//Error codes returned by picaShaderLoad
+enum
+{
+    PICA_SHADER_OK = 0,
+    PICA_SHADER_BAD_FILE = -1,      ///< Not a DVLB, or truncated
+    PICA_SHADER_BAD_DVLE = -2,      ///< No such DVLE in the file
+    PICA_SHADER_TOO_BIG = -3,       ///< Does not fit in the shader memory
+    PICA_SHADER_UNSUPPORTED = -4,   ///< Uses instructions we can't run (geometry shader instructions...)
+};
+
+typedef struct
+{
+    float x, y, z, w;
+} pica_vec4;
+
+//Output semantics, same values as DVLE_outputAttribute_t in libctru
+enum
+{
+    PICA_RESULT_POSITION = 0x0,
+    PICA_RESULT_NORMALQUAT = 0x1,
+    PICA_RESULT_COLOR = 0x2,
+    PICA_RESULT_TEXCOORD0 = 0x3,
+    PICA_RESULT_TEXCOORD0W = 0x4,
+    PICA_RESULT_TEXCOORD1 = 0x5,
+    PICA_RESULT_TEXCOORD2 = 0x6,
+    PICA_RESULT_VIEW = 0x8
+};
+
+typedef struct
+{
+    uint16_t type;  ///< PICA_RESULT_*
+    uint16_t reg;   ///< o register
+    uint8_t mask;
+} pica_output_entry;
+
+typedef struct
+{
+    char name[32];
+    uint16_t startReg, endReg; ///< In the DVLE register space: 0x10-0x6F float, 0x70-0x73 int, 0x78-0x87 bool
+} pica_uniform_entry;
+
+typedef struct pica_instr pica_instr;
+
+typedef struct
+{
+    int type;               ///< 0: vertex shader, 1: geometry shader
+    uint32_t code[PICA_MAX_CODE];
+    uint32_t codeSize;
+    uint32_t opdesc[PICA_MAX_OPDESCS];
+    uint32_t opdescSize;
+    uint32_t mainOffset, endmainOffset;
+
+    pica_output_entry outputs[PICA_MAX_OUTPUT_ENTRIES];
+    int numOutputs;
+    pica_uniform_entry uniforms[PICA_MAX_UNIFORM_ENTRIES];
+    int numUniforms;
+
+    pica_vec4 floatUniforms[PICA_NUM_FLOAT_UNIFORMS];
+    int32_t intUniforms[4][3];  ///< x: loop count, y: initial aL, z: aL increment
+    uint16_t boolUniforms;
+
+    pica_instr* decoded;        ///< The code, predecoded once at load time
+} pica_shader;
+
+/**
+* Loads the DVLE number dvleIndex of a SHBIN and applies its constants to the uniforms.
+* @return PICA_SHADER_OK or one of the error codes
+*/
+int picaShaderLoad(pica_shader* sh, const void* shbin, size_t size, int dvleIndex);
+void picaShaderFree(pica_shader* sh);
+
+/**
+* Same as shaderInstanceGetUniformLocation: the index of the first float register of the uniform, or -1.
+*/
+int picaShaderGetUniformLocation(const pica_shader* sh, const char* name);
+/**
+* Sets count vec4 float uniforms starting at c[reg], components in x,y,z,w order.
+*/
+void picaShaderSetFloatUniform(pica_shader* sh, int reg, const float* data, int count);
+void picaShaderSetIntUniform(pica_shader* sh, int reg, int32_t x, int32_t y, int32_t z);
+void picaShaderSetBoolUniform(pica_shader* sh, int reg, int value);
+
+/**
+* Runs the shader on n vertices.
+* inputs[i] points to the n values of v[i] (NULL reads as (0,0,0,1)),
+* outputs[i] receives the n values of o[i] (NULL if the output is not needed).
+* @return The number of batches that had to be replayed vertex by vertex.
+*/
+size_t picaShaderRun(const pica_shader* sh, const pica_vec4* const inputs[PICA_NUM_INPUTS],
+                     pica_vec4* const outputs[PICA_NUM_OUTPUTS], size_t n);
+/**
+* Same as picaShaderRun but never batches vertices, mostly to measure the batched path against.
+*/
+void picaShaderRunScalar(const pica_shader* sh, const pica_vec4* const inputs[PICA_NUM_INPUTS],
+                         pica_vec4* const outputs[PICA_NUM_OUTPUTS], size_t n);
+
+/**
+* Converts a float24 (as stored in the SHBIN constant table) to a float.
+*/
+float picaF24ToFloat(uint32_t f24);
@@ -0,0 +1,167 @@
+/**
+ *@file shaderrun.c
+ *@author Lectem
+ *@date 17/10/2026
+ *
+ * Runs a SHBIN (as assembled by picasso from the .vsh files of data/) on the host.
+ *
+ *   shaderrun <file.shbin>                 runs the shader on test_mesh with the 2D projection of gpuUIInit
+ *                                          and prints every output
+ *   shaderrun <file.shbin> bench [count]   runs it on a synthetic mesh of count vertices, batched and not
+ */
+#include "picashader.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+//Same as test_mesh in source/main.c
+static const float test_mesh[6][3] = {
+        {0.0f, 0.0f, 0.5f},
+        {400.0f, 0.0f, 0.5f},
+        {400.0f, 240.0f, 0.5f},
+        {400.0f, 240.0f, 0.5f},
+        {0.0f, 240.0f, 0.5f},
+        {0.0f, 0.0f, 0.5f}
+};
+
+static const char* output_names[] = {
+        "position", "normalquat", "color", "texcoord0", "texcoord0w", "texcoord1", "texcoord2", "?", "view"
+};
+
+/**
+* Same as initOrthographicMatrix in source/mmath.c (row major, z mapped to [-1;0] for the PICA).
+*/
+static void ortho_matrix(float* m, float left, float right, float bottom, float top, float near, float far)
+{
+    memset(m, 0, 16 * sizeof(float));
+    m[0x0] = 2.0f / (right - left);
+    m[0x3] = -(right + left) / (right - left);
+    m[0x5] = 2.0f / (top - bottom);
+    m[0x7] = -(top + bottom) / (top - bottom);
+    m[0xA] = 0.5f * -2.0f / (far - near);
+    m[0xB] = 0.5f * (far + near) / (far - near) - 0.5f;
+    m[0xF] = 1.0f;
+}
+
+static void* read_file(const char* path, size_t* size)
+{
+    FILE* f = fopen(path, "rb");
+    void* data;
+    if(!f)return NULL;
+    fseek(f, 0, SEEK_END);
+    *size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    data = malloc(*size);
+    if(data && fread(data, 1, *size, f) != *size)
+    {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    return data;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+* Builds the inputs of the test shader: v0 position, v1 color (unnormalized u8 like GPU_UNSIGNED_BYTE), v2 texcoord.
+*/
+static void make_inputs(pica_vec4* pos, pica_vec4* color, pica_vec4* tex, size_t n, int synthetic)
+{
+    size_t i;
+    for(i = 0; i < n; ++i)
+    {
+        if(synthetic)pos[i] = (pica_vec4){(float)(i % 400), (float)(i / 400 % 240), 0.5f, 1.0f};
+        else pos[i] = (pica_vec4){test_mesh[i][0], test_mesh[i][1], test_mesh[i][2], 1.0f};
+        color[i] = (pica_vec4){255.0f, 255.0f, 255.0f, 255.0f};
+        tex[i] = (pica_vec4){0.0f, 0.0f, 0.0f, 1.0f};
+    }
+}
+
+int main(int argc, char** argv)
+{
+    pica_shader sh;
+    size_t size, n, i;
+    void* shbin;
+    int res, o;
+    float proj[16];
+
+    if(argc < 2)
+    {
+        fprintf(stderr, "usage: %s <file.shbin> [bench [count]]\n", argv[0]);
+        return 1;
+    }
+    shbin = read_file(argv[1], &size);
+    if(!shbin)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    res = picaShaderLoad(&sh, shbin, size, 0);
+    free(shbin);
+    if(res != PICA_SHADER_OK)
+    {
+        fprintf(stderr, "couldn't load %s (error %d)\n", argv[1], res);
+        return 1;
+    }
+
+    int projReg = picaShaderGetUniformLocation(&sh, "projection");
+    ortho_matrix(proj, 0.0f, 400.0f, 0.0f, 240.0f, 0.0f, 1.0f);
+    if(projReg >= 0)picaShaderSetFloatUniform(&sh, projReg, proj, 4);
+    else fprintf(stderr, "no projection uniform, leaving the registers at 0\n");
+
+    int bench = argc >= 3 && !strcmp(argv[2], "bench");
+    n = bench ? (argc >= 4 ? strtoul(argv[3], NULL, 0) : 1000000) : 6;
+
+    pica_vec4* pos = malloc(n * sizeof(pica_vec4));
+    pica_vec4* color = malloc(n * sizeof(pica_vec4));
+    pica_vec4* tex = malloc(n * sizeof(pica_vec4));
+    pica_vec4* out[PICA_NUM_OUTPUTS] = {NULL};
+    const pica_vec4* in[PICA_NUM_INPUTS] = {pos, color, tex};
+    for(i = 0; i < (size_t)sh.numOutputs; ++i)
+    {
+        int reg = sh.outputs[i].reg;
+        if(!out[reg])out[reg] = malloc(n * sizeof(pica_vec4));
+    }
+    make_inputs(pos, color, tex, n, bench);
+
+    if(!bench)
+    {
+        picaShaderRun(&sh, in, out, n);
+        for(i = 0; i < n; ++i)
+        {
+            printf("vertex %zu:\n", i);
+            for(o = 0; o < sh.numOutputs; ++o)
+            {
+                const pica_output_entry* e = &sh.outputs[o];
+                pica_vec4 v = out[e->reg][i];
+                const char* name = e->type < sizeof(output_names) / sizeof(output_names[0]) ? output_names[e->type] : "?";
+                printf("  o%d %-10s (%g, %g, %g, %g)\n", e->reg, name, v.x, v.y, v.z, v.w);
+            }
+        }
+    }
+    else
+    {
+        double t0 = now();
+        size_t replays = picaShaderRun(&sh, in, out, n);
+        double t1 = now();
+        picaShaderRunScalar(&sh, in, out, n);
+        double t2 = now();
+        printf("%zu vertices: batched %.3fs (%.1f Mvtx/s, %zu batches replayed), one at a time %.3fs (%.1f Mvtx/s)\n",
+               n, t1 - t0, n / (t1 - t0) * 1e-6, replays, t2 - t1, n / (t2 - t1) * 1e-6);
+    }
+
+    for(o = 0; o < PICA_NUM_OUTPUTS; ++o)free(out[o]);
+    free(pos);
+    free(color);
+    free(tex);
+    picaShaderFree(&sh);
+    return 0;
+}
@@ -0,0 +1,728 @@
+/**
+ *@file tevfuzz.c
+ *@author Lectem
+ *@date 17/10/2026
+ *
+ * Differential fuzzer of the TEV, alpha test and blending reference model.
+ *
+ * Random configurations, restricted to what GPU_SetTexEnv, GPU_SetAlphaTest and GPU_SetAlphaBlending can set,
+ * are evaluated on every core by a work-stealing thread pool:
+ * - the vectorized TEV kernel is checked against the scalar one, any difference is a bug of the model
+ * - each configuration is mapped to the features it exercises (combiners, sources and operands in use,
+ *   blend equations and factors, alpha test outcomes, saturated outputs...). The first configuration hitting
+ *   a feature, in generation order so that the result doesn't depend on the scheduling, is kept.
+ * Kept configurations are then minimized (stages turned into pass-through, blending and alpha test removed,
+ * unused inputs cleared) as long as they still hit their feature, and written as a test list for
+ * gpuTestLoadSuite (source/gputest.h), the expected colors being the ones of the model. The tolerance of every
+ * case defaults to 1, as the vertex colors go through the float conversion of the shader.
+ *
+ *   tevfuzz [-n configs] [-j threads] [-s seed] [-t tolerance (1)] [-o gpuTestList.txt]
+ */
+#include "tevmodel.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+//Configurations evaluated by one task, they share their textures and vertex colors
+#define CHUNK_SIZE 1024
+#define MAX_QUADS 2
+#define MAX_CASE_FEATURES 128
+//Mismatches of the vectorized kernel printed, the others are only counted
+#define MAX_PRINTED_MISMATCHES 8
+
+typedef struct
+{
+    tev_config tev;
+    uint8_t numStages;          ///< Stages written to the list, the others pass the previous one through
+    tev_fragment_ops ops;
+    uint8_t blend, alphaTest;   ///< Written to the list, tev_fragment_ops is the default setup otherwise
+    uint8_t numQuads;
+    uint8_t numTextures;
+    uint32_t textures[3];
+    uint32_t quadColors[MAX_QUADS];
+} fuzz_case;
+
+/*---------------------------------------------------------------------------------
+ * Random generation
+ *-------------------------------------------------------------------------------*/
+
+static uint64_t splitmix64(uint64_t* state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static uint32_t rnd(uint64_t* state, uint32_t n)
+{
+    return (uint32_t)(splitmix64(state) >> 32) % n;
+}
+
+//Colors with the values that make the rounding and the clamping visible more often than uniform ones
+static uint32_t random_color(uint64_t* state)
+{
+    static const uint8_t special[] = {0x00, 0x01, 0x7F, 0x80, 0xFE, 0xFF};
+    uint32_t c = 0;
+    int i;
+    for(i = 0; i < 4; ++i)
+    {
+        uint32_t v = rnd(state, 3) ? rnd(state, 256) : special[rnd(state, sizeof(special))];
+        c |= v << (8 * i);
+    }
+    return c;
+}
+
+/*
+ * The sources GPU_SetTexEnv can select that the device test can control: the fragment lighting colors are 0,
+ * the previous buffer isn't set up by the tests and texture 3 is the procedural texture.
+ * The undocumented ids are included, they are the most interesting ones to run on the hardware.
+ */
+static uint32_t random_source(uint64_t* state)
+{
+    static const uint8_t sources[] = {
+            TEV_SRC_PRIMARY_COLOR, TEV_SRC_FRAGMENT_PRIMARY, TEV_SRC_FRAGMENT_SECONDARY,
+            TEV_SRC_TEXTURE0, TEV_SRC_TEXTURE1, TEV_SRC_TEXTURE2, TEV_SRC_CONSTANT, TEV_SRC_PREVIOUS,
+            0x7, 0x8, 0x9, 0xA, 0xB, 0xC,
+    };
+    //Mostly the documented ones, the first 8
+    return sources[rnd(state, 8) ? rnd(state, 8) : rnd(state, sizeof(sources))];
+}
+
+static void chunk_inputs(uint64_t seed, uint32_t chunk, uint32_t textures[3], uint32_t quadColors[MAX_QUADS])
+{
+    uint64_t state = seed ^ ((uint64_t)chunk << 32) ^ 0xC0FFEE;
+    int i;
+    for(i = 0; i < 3; ++i)textures[i] = random_color(&state);
+    for(i = 0; i < MAX_QUADS; ++i)quadColors[i] = random_color(&state);
+}
+
+/**
+* The configuration number index, the same for any number of threads.
+*/
+static void generate_case(uint64_t seed, uint64_t index, fuzz_case* c)
+{
+    uint64_t state = seed ^ (index * 0xD1B54A32D192ED03ull);
+    int s;
+    memset(c, 0, sizeof(*c));
+    tevConfigInit(&c->tev);
+    tevFragmentOpsInit(&c->ops);
+    chunk_inputs(seed, index / CHUNK_SIZE, c->textures, c->quadColors);
+    c->numTextures = 3;
+    c->numQuads = 1 + rnd(&state, MAX_QUADS);
+
+    //Short setups are the usual ones
+    c->numStages = 1 + (rnd(&state, 2) ? rnd(&state, 2) : rnd(&state, TEV_NUM_STAGES));
+    for(s = 0; s < c->numStages; ++s)
+    {
+        tev_stage* st = &c->tev.stages[s];
+        //Leave some of the later stages as pass-through
+        if(s > 0 && !rnd(&state, 4))continue;
+        st->rgbSources = random_source(&state) | random_source(&state) << 4 | random_source(&state) << 8;
+        st->alphaSources = random_source(&state) | random_source(&state) << 4 | random_source(&state) << 8;
+        st->rgbOperands = rnd(&state, 16) | rnd(&state, 16) << 4 | rnd(&state, 16) << 8;
+        st->alphaOperands = rnd(&state, 8) | rnd(&state, 8) << 4 | rnd(&state, 8) << 8;
+        st->rgbCombine = rnd(&state, 10);
+        st->alphaCombine = rnd(&state, 10);
+        st->constantColor = random_color(&state);
+    }
+
+    if(rnd(&state, 2))
+    {
+        c->blend = 1;
+        c->ops.colorEquation = rnd(&state, 5);
+        c->ops.alphaEquation = rnd(&state, 5);
+        c->ops.colorSrc = rnd(&state, 15);
+        c->ops.colorDst = rnd(&state, 15);
+        c->ops.alphaSrc = rnd(&state, 15);
+        c->ops.alphaDst = rnd(&state, 15);
+        c->ops.blendColor = random_color(&state);
+    }
+    if(!rnd(&state, 3))
+    {
+        c->alphaTest = 1;
+        c->ops.alphaTest = 1;
+        c->ops.alphaFunction = rnd(&state, 8);
+        c->ops.alphaRef = rnd(&state, 4) ? rnd(&state, 256) : 0x80;
+    }
+}
+
+/*---------------------------------------------------------------------------------
+ * Evaluation and features
+ *-------------------------------------------------------------------------------*/
+
+static void case_pixel(const fuzz_case* c, int quad, tev_pixel* px)
+{
+    memset(px, 0, sizeof(*px));
+    px->primaryColor = c->quadColors[quad];
+    memcpy(px->texture, c->textures, sizeof(c->textures));
+}
+
+/**
+* Draws the quads of the case in order on a buffer cleared to 0, like gpuTestRunAll.
+* @param tevOut The output of the combiners for each quad
+* @param discarded Bit i is set if the alpha test discarded quad i
+* @return The buffer color, in the register order
+*/
+static uint32_t simulate(const fuzz_case* c, uint32_t tevOut[MAX_QUADS], uint32_t* discarded)
+{
+    uint32_t dst = 0;
+    int q;
+    *discarded = 0;
+    for(q = 0; q < c->numQuads; ++q)
+    {
+        tev_pixel px;
+        int d;
+        case_pixel(c, q, &px);
+        tevOut[q] = tevEvalScalar(&c->tev, &px);
+        dst = tevFragmentOpsApply(&c->ops, tevOut[q], dst, &d);
+        *discarded |= d << q;
+    }
+    return dst;
+}
+
+//Inputs used by a combiner, the others don't change its output
+static int combiner_inputs(int combine)
+{
+    switch(combine)
+    {
+        case TEV_REPLACE:      return 1;
+        case TEV_INTERPOLATE:
+        case TEV_MULTIPLY_ADD:
+        case TEV_ADD_MULTIPLY: return 3;
+        default:               return 2;
+    }
+}
+
+static int is_passthrough(const tev_stage* st)
+{
+    return (st->rgbSources & 0xF) == TEV_SRC_PREVIOUS && (st->alphaSources & 0xF) == TEV_SRC_PREVIOUS
+           && (st->rgbOperands & 0xF) == 0 && (st->alphaOperands & 0x7) == 0
+           && st->rgbCombine == TEV_REPLACE && st->alphaCombine == TEV_REPLACE;
+}
+
+//Feature ranges, each one is a base plus an index
+enum
+{
+    F_RGB_COMBINE = 0,                          //10
+    F_ALPHA_COMBINE = F_RGB_COMBINE + 10,       //10
+    F_COMBINE_PAIR = F_ALPHA_COMBINE + 10,      //10 x 10
+    F_RGB_SOURCE = F_COMBINE_PAIR + 100,        //combiner x input x source, 10 x 3 x 16
+    F_ALPHA_SOURCE = F_RGB_SOURCE + 480,        //10 x 3 x 16
+    F_RGB_OPERAND = F_ALPHA_SOURCE + 480,       //16
+    F_ALPHA_OPERAND = F_RGB_OPERAND + 16,       //8
+    F_OUTPUT = F_ALPHA_OPERAND + 8,             //each channel is 0, 255 or between, 3^4
+    F_BLEND_COLOR = F_OUTPUT + 81,              //equation x src factor x dst factor, 5 x 15 x 15 for MIN/MAX only 1
+    F_BLEND_ALPHA = F_BLEND_COLOR + 1125,       //5 x 15 x 15
+    F_ALPHA_TEST = F_BLEND_ALPHA + 1125,        //function x passed, 8 x 2
+    F_COUNT = F_ALPHA_TEST + 16
+};
+
+static const char* feature_name(int f, char* buf, size_t size)
+{
+    if(f < F_ALPHA_COMBINE)snprintf(buf, size, "rgb_combine_%d", f - F_RGB_COMBINE);
+    else if(f < F_COMBINE_PAIR)snprintf(buf, size, "alpha_combine_%d", f - F_ALPHA_COMBINE);
+    else if(f < F_RGB_SOURCE)snprintf(buf, size, "combine_%d_%d", (f - F_COMBINE_PAIR) / 10, (f - F_COMBINE_PAIR) % 10);
+    else if(f < F_ALPHA_SOURCE)snprintf(buf, size, "rgb_combine_%d_src%d_%x", (f - F_RGB_SOURCE) / 48, (f - F_RGB_SOURCE) / 16 % 3, (f - F_RGB_SOURCE) % 16);
+    else if(f < F_RGB_OPERAND)snprintf(buf, size, "alpha_combine_%d_src%d_%x", (f - F_ALPHA_SOURCE) / 48, (f - F_ALPHA_SOURCE) / 16 % 3, (f - F_ALPHA_SOURCE) % 16);
+    else if(f < F_ALPHA_OPERAND)snprintf(buf, size, "rgb_operand_%x", f - F_RGB_OPERAND);
+    else if(f < F_OUTPUT)snprintf(buf, size, "alpha_operand_%x", f - F_ALPHA_OPERAND);
+    else if(f < F_BLEND_COLOR)snprintf(buf, size, "output_%d", f - F_OUTPUT);
+    else if(f < F_BLEND_ALPHA)snprintf(buf, size, "blend_rgb_%d_%d_%d", (f - F_BLEND_COLOR) / 225, (f - F_BLEND_COLOR) / 15 % 15, (f - F_BLEND_COLOR) % 15);
+    else if(f < F_ALPHA_TEST)snprintf(buf, size, "blend_alpha_%d_%d_%d", (f - F_BLEND_ALPHA) / 225, (f - F_BLEND_ALPHA) / 15 % 15, (f - F_BLEND_ALPHA) % 15);
+    else snprintf(buf, size, "alpha_test_%d_%s", (f - F_ALPHA_TEST) / 2, (f - F_ALPHA_TEST) % 2 ? "pass" : "fail");
+    return buf;
+}
+
+static int output_class(uint32_t c)
+{
+    int i, k = 0;
+    for(i = 3; i >= 0; --i)
+    {
+        uint32_t v = (c >> (8 * i)) & 0xFF;
+        k = k * 3 + (v == 0 ? 0 : (v == 255 ? 1 : 2));
+    }
+    return k;
+}
+
+static int blend_feature(int equation, int src, int dst)
+{
+    //MIN and MAX ignore the factors
+    if(equation == TEV_BLEND_MIN || equation == TEV_BLEND_MAX)src = dst = 0;
+    return (equation % 5) * 225 + (src % 15) * 15 + dst % 15;
+}
+
+/**
+* The features exercised by a case, without duplicates.
+* @return Their number
+*/
+static int case_features(const fuzz_case* c, uint16_t* out)
+{
+    static __thread uint8_t seen[F_COUNT];
+    uint32_t tevOut[MAX_QUADS], discarded, result;
+    int n = 0, s, i, q;
+    memset(seen, 0, sizeof(seen));
+#define ADD(f) do{ int f_ = (f); if(!seen[f_] && n < MAX_CASE_FEATURES){ seen[f_] = 1; out[n++] = f_; } }while(0)
+
+    result = simulate(c, tevOut, &discarded);
+    for(s = 0; s < c->numStages; ++s)
+    {
+        const tev_stage* st = &c->tev.stages[s];
+        if(is_passthrough(st))continue;
+        ADD(F_RGB_COMBINE + st->rgbCombine);
+        ADD(F_ALPHA_COMBINE + st->alphaCombine);
+        ADD(F_COMBINE_PAIR + st->rgbCombine * 10 + st->alphaCombine);
+        for(i = 0; i < combiner_inputs(st->rgbCombine); ++i)
+        {
+            ADD(F_RGB_SOURCE + st->rgbCombine * 48 + i * 16 + ((st->rgbSources >> (4 * i)) & 0xF));
+            ADD(F_RGB_OPERAND + ((st->rgbOperands >> (4 * i)) & 0xF));
+        }
+        for(i = 0; i < combiner_inputs(st->alphaCombine); ++i)
+        {
+            ADD(F_ALPHA_SOURCE + st->alphaCombine * 48 + i * 16 + ((st->alphaSources >> (4 * i)) & 0xF));
+            ADD(F_ALPHA_OPERAND + ((st->alphaOperands >> (4 * i)) & 0x7));
+        }
+    }
+    ADD(F_OUTPUT + output_class(result));
+    if(c->blend)
+    {
+        ADD(F_BLEND_COLOR + blend_feature(c->ops.colorEquation, c->ops.colorSrc, c->ops.colorDst));
+        ADD(F_BLEND_ALPHA + blend_feature(c->ops.alphaEquation, c->ops.alphaSrc, c->ops.alphaDst));
+    }
+    if(c->alphaTest)
+    {
+        for(q = 0; q < c->numQuads; ++q)ADD(F_ALPHA_TEST + c->ops.alphaFunction * 2 + !((discarded >> q) & 1));
+    }
+#undef ADD
+    return n;
+}
+
+static int has_feature(const fuzz_case* c, int feature)
+{
+    uint16_t features[MAX_CASE_FEATURES];
+    int n = case_features(c, features), i;
+    for(i = 0; i < n; ++i)
+    {
+        if(features[i] == feature)return 1;
+    }
+    return 0;
+}
+
+/*---------------------------------------------------------------------------------
+ * Work-stealing pool
+ *
+ * Every worker owns a deque of task numbers: it takes its own tasks from the back and, once it runs out,
+ * steals from the front of the others. Tasks don't create other tasks, so a worker stops when every deque is empty.
+ *-------------------------------------------------------------------------------*/
+
+typedef void (*task_fn)(void* ctx, uint32_t task, int worker);
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    uint32_t* tasks;
+    uint32_t head, tail;        ///< [head, tail[ is left to run
+    uint32_t executed, stolen;  ///< By the owner of the deque
+} task_deque;
+
+typedef struct
+{
+    task_deque* deques;
+    int workers;
+    task_fn fn;
+    void* ctx;
+} task_pool;
+
+typedef struct
+{
+    task_pool* pool;
+    int id;
+} worker_arg;
+
+static int deque_pop_back(task_deque* d, uint32_t* task)
+{
+    int ok;
+    pthread_mutex_lock(&d->lock);
+    ok = d->head < d->tail;
+    if(ok)*task = d->tasks[--d->tail];
+    pthread_mutex_unlock(&d->lock);
+    return ok;
+}
+
+static int deque_steal_front(task_deque* d, uint32_t* task)
+{
+    int ok;
+    pthread_mutex_lock(&d->lock);
+    ok = d->head < d->tail;
+    if(ok)*task = d->tasks[d->head++];
+    pthread_mutex_unlock(&d->lock);
+    return ok;
+}
+
+static void* worker_main(void* data)
+{
+    worker_arg* arg = data;
+    task_pool* pool = arg->pool;
+    task_deque* own = &pool->deques[arg->id];
+    uint32_t task;
+    for(;;)
+    {
+        int v, found = 0;
+        if(deque_pop_back(own, &task))
+        {
+            pool->fn(pool->ctx, task, arg->id);
+            own->executed++;
+            continue;
+        }
+        //Start with the next worker, so that thieves don't all fall on the same victim
+        for(v = 1; v < pool->workers && !found; ++v)
+        {
+            found = deque_steal_front(&pool->deques[(arg->id + v) % pool->workers], &task);
+        }
+        if(!found)break;
+        pool->fn(pool->ctx, task, arg->id);
+        own->executed++;
+        own->stolen++;
+    }
+    return NULL;
+}
+
+/**
+* Runs the tasks [0;count[ on workers threads, the calling thread being one of them.
+* Each worker starts with a contiguous range, which keeps the chunks of a worker close in memory.
+* @return The number of stolen tasks
+*/
+static uint32_t pool_run(int workers, uint32_t count, task_fn fn, void* ctx)
+{
+    task_pool pool = {calloc(workers, sizeof(task_deque)), workers, fn, ctx};
+    pthread_t* threads = calloc(workers, sizeof(pthread_t));
+    worker_arg* args = calloc(workers, sizeof(worker_arg));
+    uint32_t i, stolen = 0;
+    int w;
+    for(w = 0; w < workers; ++w)
+    {
+        task_deque* d = &pool.deques[w];
+        uint32_t first = (uint64_t)count * w / workers, last = (uint64_t)count * (w + 1) / workers;
+        pthread_mutex_init(&d->lock, NULL);
+        d->tasks = malloc((last - first + 1) * sizeof(uint32_t));
+        //Popped from the back: reversed so that the owner runs its range in order
+        for(i = first; i < last; ++i)d->tasks[d->tail++] = last - 1 - (i - first);
+    }
+    for(w = 0; w < workers; ++w)
+    {
+        args[w].pool = &pool;
+        args[w].id = w;
+        if(w && pthread_create(&threads[w], NULL, worker_main, &args[w]))threads[w] = 0;
+    }
+    worker_main(&args[0]);
+    for(w = 1; w < workers; ++w)
+    {
+        if(threads[w])pthread_join(threads[w], NULL);
+    }
+    for(w = 0; w < workers; ++w)
+    {
+        stolen += pool.deques[w].stolen;
+        pthread_mutex_destroy(&pool.deques[w].lock);
+        free(pool.deques[w].tasks);
+    }
+    free(pool.deques);
+    free(threads);
+    free(args);
+    return stolen;
+}
+
+/*---------------------------------------------------------------------------------
+ * Fuzzing
+ *-------------------------------------------------------------------------------*/
+
+typedef struct
+{
+    uint64_t seed;
+    uint64_t count;
+    //Lowest configuration index hitting each feature, UINT64_MAX if none
+    uint64_t best[F_COUNT];
+    uint64_t mismatches;
+    uint32_t printed;
+    pthread_mutex_t printLock;
+} fuzz_state;
+
+static void atomic_min(uint64_t* p, uint64_t v)
+{
+    uint64_t cur = __atomic_load_n(p, __ATOMIC_RELAXED);
+    while(v < cur && !__atomic_compare_exchange_n(p, &cur, v, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+static void fuzz_chunk(void* ctx, uint32_t chunk, int worker)
+{
+    fuzz_state* st = ctx;
+    static __thread fuzz_case cases[CHUNK_SIZE];
+    static __thread tev_config cfgs[CHUNK_SIZE];
+    static __thread uint32_t vectorized[CHUNK_SIZE];
+    uint64_t first = (uint64_t)chunk * CHUNK_SIZE;
+    uint32_t n = st->count - first < CHUNK_SIZE ? st->count - first : CHUNK_SIZE, i;
+    int q, k;
+    (void)worker;
+
+    for(i = 0; i < n; ++i)
+    {
+        uint16_t features[MAX_CASE_FEATURES];
+        generate_case(st->seed, first + i, &cases[i]);
+        cfgs[i] = cases[i].tev;
+        k = case_features(&cases[i], features);
+        while(k--)
+        {
+            if(first + i < __atomic_load_n(&st->best[features[k]], __ATOMIC_RELAXED))atomic_min(&st->best[features[k]], first + i);
+        }
+    }
+
+    //The configurations of a chunk share their inputs, which is what the vectorized kernel wants
+    for(q = 0; q < MAX_QUADS; ++q)
+    {
+        tev_pixel px;
+        uint64_t bad = 0;
+        case_pixel(&cases[0], q, &px);
+        tevEvalConfigs(cfgs, n, &px, vectorized);
+        for(i = 0; i < n; ++i)
+        {
+            uint32_t expected = tevEvalScalar(&cfgs[i], &px);
+            if(expected == vectorized[i])continue;
+            bad++;
+            if(__atomic_fetch_add(&st->printed, 1, __ATOMIC_RELAXED) < MAX_PRINTED_MISMATCHES)
+            {
+                pthread_mutex_lock(&st->printLock);
+                printf("mismatch: config %llu quad %d scalar=%08x vectorized=%08x\n",
+                       (unsigned long long)(first + i), q, expected, vectorized[i]);
+                pthread_mutex_unlock(&st->printLock);
+            }
+        }
+        if(bad)__atomic_fetch_add(&st->mismatches, bad, __ATOMIC_RELAXED);
+    }
+}
+
+/*---------------------------------------------------------------------------------
+ * Minimization
+ *-------------------------------------------------------------------------------*/
+
+typedef struct
+{
+    uint64_t seed;
+    const int* features;        ///< The feature each case must keep
+    const uint64_t* indices;    ///< Configuration of each case
+    fuzz_case* out;
+} minimize_state;
+
+static void format_case(const fuzz_case* c, int tolerance, char* buf, size_t size);
+
+/**
+* Keeps a change if the case still hits its feature.
+* Cases are compared through what is written to the list: memcmp would see the padding.
+*/
+static int try_change(fuzz_case* c, const fuzz_case* candidate, int feature)
+{
+    char a[512], b[512];
+    format_case(c, 0, a, sizeof(a));
+    format_case(candidate, 0, b, sizeof(b));
+    if(!strcmp(a, b) || !has_feature(candidate, feature))return 0;
+    *c = *candidate;
+    return 1;
+}
+
+static void minimize_case(void* ctx, uint32_t task, int worker)
+{
+    minimize_state* st = ctx;
+    int feature = st->features[task];
+    fuzz_case c, t;
+    int changed, s, i;
+    (void)worker;
+    generate_case(st->seed, st->indices[task], &c);
+
+    do
+    {
+        changed = 0;
+        t = c; t.numQuads = 1;
+        changed |= try_change(&c, &t, feature);
+        t = c; t.blend = 0; tevFragmentOpsInit(&t.ops); t.ops.alphaTest = c.ops.alphaTest;
+        t.ops.alphaFunction = c.ops.alphaFunction; t.ops.alphaRef = c.ops.alphaRef;
+        changed |= try_change(&c, &t, feature);
+        t = c; t.alphaTest = 0; t.ops.alphaTest = 0; t.ops.alphaFunction = TEV_TEST_ALWAYS; t.ops.alphaRef = 0;
+        changed |= try_change(&c, &t, feature);
+        if(c.blend)
+        {
+            t = c; t.ops.blendColor = 0;
+            changed |= try_change(&c, &t, feature);
+        }
+        //Later stages first: trailing pass-through stages are then dropped
+        for(s = c.numStages - 1; s >= 0; --s)
+        {
+            tev_config pass;
+            tevConfigInit(&pass);
+            t = c;
+            //Already passing through once its unused inputs are cleared, which the init setup doesn't do
+            if(!is_passthrough(&t.tev.stages[s]))t.tev.stages[s] = pass.stages[s];
+            if(s == t.numStages - 1 && t.numStages > 1)t.numStages--;
+            changed |= try_change(&c, &t, feature);
+        }
+        for(s = 0; s < c.numStages; ++s)
+        {
+            tev_stage* st;
+            t = c; st = &t.tev.stages[s];
+            //Inputs the combiners don't read
+            for(i = combiner_inputs(st->rgbCombine); i < 3; ++i)
+            {
+                st->rgbSources &= ~(0xF << (4 * i));
+                st->rgbOperands &= ~(0xF << (4 * i));
+            }
+            for(i = combiner_inputs(st->alphaCombine); i < 3; ++i)
+            {
+                st->alphaSources &= ~(0xF << (4 * i));
+                st->alphaOperands &= ~(0x7 << (4 * i));
+            }
+            changed |= try_change(&c, &t, feature);
+            t = c; t.tev.stages[s].constantColor = 0xFFFFFFFF;
+            changed |= try_change(&c, &t, feature);
+        }
+        for(i = 0; i < 3; ++i)
+        {
+            t = c; t.textures[i] = 0;
+            changed |= try_change(&c, &t, feature);
+        }
+    }while(changed);
+
+    //Units after the last one in use are left disabled
+    while(c.numTextures && !c.textures[c.numTextures - 1])c.numTextures--;
+    st->out[task] = c;
+}
+
+/*---------------------------------------------------------------------------------
+ * Output
+ *-------------------------------------------------------------------------------*/
+
+/**
+* The fields of a case in the gpuTestLoadSuite format, without its name.
+*/
+static void format_case(const fuzz_case* c, int tolerance, char* buf, size_t size)
+{
+    uint32_t tevOut[MAX_QUADS], discarded;
+    uint32_t result = simulate(c, tevOut, &discarded);
+    size_t n = 0;
+    int i;
+#define OUT(...) do{ if(n < size)n += snprintf(buf + n, size - n, __VA_ARGS__); }while(0)
+    buf[0] = '\0';
+    if(c->numTextures)
+    {
+        OUT(" tex=");
+        for(i = 0; i < c->numTextures; ++i)OUT("%s%08x", i ? "," : "", c->textures[i]);
+    }
+    for(i = 0; i < c->numStages; ++i)
+    {
+        const tev_stage* st = &c->tev.stages[i];
+        OUT(" tev=%x,%x,%x,%x,%x,%x,%08x", st->rgbSources, st->alphaSources, st->rgbOperands,
+            st->alphaOperands, st->rgbCombine, st->alphaCombine, st->constantColor);
+    }
+    if(c->blend)
+        OUT(" blend=%x,%x,%x,%x,%x,%x,%08x", c->ops.colorEquation, c->ops.alphaEquation, c->ops.colorSrc,
+            c->ops.colorDst, c->ops.alphaSrc, c->ops.alphaDst, c->ops.blendColor);
+    if(c->alphaTest)OUT(" alpha=%x,%x", c->ops.alphaFunction, c->ops.alphaRef);
+    for(i = 0; i < c->numQuads; ++i)OUT(" quad=%08x", c->quadColors[i]);
+    OUT(" expected=%08x tolerance=%d", tevColorToFramebuffer(result), tolerance);
+#undef OUT
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char** argv)
+{
+    static fuzz_state state;
+    uint64_t count = 1000000;
+    int workers = sysconf(_SC_NPROCESSORS_ONLN);
+    //Every case draws vertex colored quads, and the vertex colors may be off by one (VERTEX_TOLERANCE of testcases.c)
+    int tolerance = 1, opt, f, kept = 0, written = 0;
+    const char* path = "gpuTestList.txt";
+    int features[F_COUNT];
+    uint64_t indices[F_COUNT];
+    fuzz_case* minimized;
+    char (*lines)[512];
+    minimize_state ms;
+    uint32_t stolen;
+    double t0, t1, t2;
+    FILE* out;
+
+    state.seed = 1;
+    while((opt = getopt(argc, argv, "n:j:s:t:o:")) != -1)
+    {
+        switch(opt)
+        {
+            case 'n': count = strtoull(optarg, NULL, 0); break;
+            case 'j': workers = atoi(optarg); break;
+            case 's': state.seed = strtoull(optarg, NULL, 0); break;
+            case 't': tolerance = atoi(optarg); break;
+            case 'o': path = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-n configs] [-j threads] [-s seed] [-t tolerance (1)] [-o gpuTestList.txt]\n", argv[0]);
+                return 1;
+        }
+    }
+    if(workers < 1)workers = 1;
+    if(!count)count = 1;
+    state.count = count;
+    for(f = 0; f < F_COUNT; ++f)state.best[f] = UINT64_MAX;
+    pthread_mutex_init(&state.printLock, NULL);
+
+    t0 = now();
+    stolen = pool_run(workers, (count + CHUNK_SIZE - 1) / CHUNK_SIZE, fuzz_chunk, &state);
+    t1 = now();
+    printf("%llu configs in %.3fs on %d threads (%.2f M/s), %u chunks stolen, %llu kernel mismatches\n",
+           (unsigned long long)count, t1 - t0, workers, count / (t1 - t0) * 1e-6, stolen,
+           (unsigned long long)state.mismatches);
+
+    for(f = 0; f < F_COUNT; ++f)
+    {
+        if(state.best[f] == UINT64_MAX)continue;
+        features[kept] = f;
+        indices[kept] = state.best[f];
+        kept++;
+    }
+    minimized = malloc((kept ? kept : 1) * sizeof(fuzz_case));
+    ms.seed = state.seed;
+    ms.features = features;
+    ms.indices = indices;
+    ms.out = minimized;
+    pool_run(workers, kept, minimize_case, &ms);
+    t2 = now();
+
+    out = fopen(path, "w");
+    if(!out)
+    {
+        perror(path);
+        return 1;
+    }
+    fprintf(out, "# tevfuzz -n %llu -s %llu: %d features of %d hit, expected colors from host/tevmodel.c\n",
+            (unsigned long long)count, (unsigned long long)state.seed, kept, F_COUNT);
+    //Different features often end up with the same minimal case, write it once under the name of the first one
+    lines = malloc((kept ? kept : 1) * sizeof(*lines));
+    for(f = 0; f < kept; ++f)
+    {
+        char name[64];
+        int j;
+        format_case(&minimized[f], tolerance, lines[f], sizeof(lines[f]));
+        for(j = 0; j < f && strcmp(lines[j], lines[f]); ++j);
+        if(j < f)continue;
+        fprintf(out, "name=%s%s\n", feature_name(features[f], name, sizeof(name)), lines[f]);
+        written++;
+    }
+    free(lines);
+    fclose(out);
+    printf("%d features hit, %d cases after minimization and deduplication (%.3fs), written to %s\n",
+           kept, written, t2 - t1, path);
+    free(minimized);
+    return state.mismatches != 0;
+}
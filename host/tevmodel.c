@@ -0,0 +1,656 @@
+/**
+ *@file tevmodel.c
+ *@author Lectem
+ *@date 17/10/2026
+ *
+ * The behaviour follows what is documented on 3dbrew (GPU/Internal Registers) and what citra implements.
+ * Values that are not documented (sources 0x7-0xC, DOT3 as an alpha combiner...) are modeled the simplest
+ * way and commented as such: those are exactly what the sweeps are here to find out.
+ */
+#include "tevmodel.h"
+
+#include <string.h>
+
+static const uint32_t passthrough_sources = (TEV_SRC_PREVIOUS << 16) | TEV_SRC_PREVIOUS;
+
+void tevConfigInit(tev_config* cfg)
+{
+    int i;
+    memset(cfg, 0, sizeof(*cfg));
+    for(i = 0; i < TEV_NUM_STAGES; ++i)
+    {
+        tevSetStage(cfg, i,
+                    TEV_SRC_PREVIOUS | TEV_SRC_PREVIOUS << 4 | TEV_SRC_PREVIOUS << 8,
+                    TEV_SRC_PREVIOUS | TEV_SRC_PREVIOUS << 4 | TEV_SRC_PREVIOUS << 8,
+                    0, 0,
+                    TEV_REPLACE, TEV_REPLACE,
+                    0xFFFFFFFF);
+    }
+}
+
+void tevSetStage(tev_config* cfg, int id,
+                 uint16_t rgbSources, uint16_t alphaSources,
+                 uint16_t rgbOperands, uint16_t alphaOperands,
+                 uint8_t rgbCombine, uint8_t alphaCombine,
+                 uint32_t constantColor)
+{
+    if(id < 0 || id >= TEV_NUM_STAGES)return;
+    tev_stage* st = &cfg->stages[id];
+    st->rgbSources = rgbSources;
+    st->alphaSources = alphaSources;
+    st->rgbOperands = rgbOperands;
+    st->alphaOperands = alphaOperands;
+    st->rgbCombine = rgbCombine;
+    st->alphaCombine = alphaCombine;
+    st->rgbScale = 0;
+    st->alphaScale = 0;
+    st->constantColor = constantColor;
+}
+
+/*
+ * GPU_SetTexEnv packs its parameters in registers as (alphaSources<<16)|rgbSources and
+ * (alphaOperands<<12)|rgbOperands, while the alpha operands are only 3 bits wide.
+ * Decode the fields from those register values so that we see exactly what the hardware sees.
+ */
+static inline uint32_t source_reg(const tev_stage* st)
+{
+    return ((uint32_t)st->alphaSources << 16) | st->rgbSources;
+}
+
+static inline uint32_t operand_reg(const tev_stage* st)
+{
+    return ((uint32_t)st->alphaOperands << 12) | st->rgbOperands;
+}
+
+#define RGB_SRC(reg, i)   (((reg) >> (4 * (i))) & 0xF)
+#define ALPHA_SRC(reg, i) (((reg) >> (16 + 4 * (i))) & 0xF)
+#define RGB_OP(reg, i)    (((reg) >> (4 * (i))) & 0xF)
+#define ALPHA_OP(reg, i)  (((reg) >> (12 + 3 * (i))) & 0x7)
+
+static int is_passthrough(const tev_stage* st)
+{
+    return (source_reg(st) & 0x000F000F) == passthrough_sources
+           && (operand_reg(st) & 0x700F) == 0
+           && st->rgbCombine == TEV_REPLACE && st->alphaCombine == TEV_REPLACE
+           && st->rgbScale == 0 && st->alphaScale == 0;
+}
+
+static inline int scale_shift(uint8_t scale)
+{
+    //3 is reserved, assume it behaves like x4
+    return scale > 2 ? 2 : scale;
+}
+
+/*---------------------------------------------------------------------------------
+ * Scalar model
+ *-------------------------------------------------------------------------------*/
+
+typedef struct
+{
+    int r, g, b, a;
+} color4;
+
+static inline color4 unpack(uint32_t c)
+{
+    return (color4){c & 0xFF, (c >> 8) & 0xFF, (c >> 16) & 0xFF, c >> 24};
+}
+
+static inline uint32_t pack(color4 c)
+{
+    return (uint32_t)c.r | ((uint32_t)c.g << 8) | ((uint32_t)c.b << 16) | ((uint32_t)c.a << 24);
+}
+
+static inline int clamp255(int x)
+{
+    return x < 0 ? 0 : (x > 255 ? 255 : x);
+}
+
+static color4 get_source(int src, const tev_pixel* in, const tev_stage* st, color4 prev, color4 buffer)
+{
+    switch(src)
+    {
+        case TEV_SRC_PRIMARY_COLOR:     return unpack(in->primaryColor);
+        case TEV_SRC_FRAGMENT_PRIMARY:  return unpack(in->fragmentPrimary);
+        case TEV_SRC_FRAGMENT_SECONDARY:return unpack(in->fragmentSecondary);
+        case TEV_SRC_TEXTURE0:          return unpack(in->texture[0]);
+        case TEV_SRC_TEXTURE1:          return unpack(in->texture[1]);
+        case TEV_SRC_TEXTURE2:          return unpack(in->texture[2]);
+        case TEV_SRC_TEXTURE3:          return unpack(in->texture[3]);
+        case TEV_SRC_PREVIOUS_BUFFER:   return buffer;
+        case TEV_SRC_CONSTANT:          return unpack(st->constantColor);
+        case TEV_SRC_PREVIOUS:          return prev;
+        //Undocumented, assume they read as 0
+        default:                        return (color4){0, 0, 0, 0};
+    }
+}
+
+static void rgb_operand(int op, color4 c, int out[3])
+{
+    int sel = op >> 2;
+    if(sel == 0)
+    {
+        if(op & 2){ out[0] = out[1] = out[2] = c.a; }
+        else { out[0] = c.r; out[1] = c.g; out[2] = c.b; }
+    }
+    else
+    {
+        //Bit 1 is undocumented for the single component operands, assume it is ignored
+        int v = sel == 1 ? c.r : (sel == 2 ? c.g : c.b);
+        out[0] = out[1] = out[2] = v;
+    }
+    if(op & 1)
+    {
+        out[0] = 255 - out[0];
+        out[1] = 255 - out[1];
+        out[2] = 255 - out[2];
+    }
+}
+
+static int alpha_operand(int op, color4 c)
+{
+    int v;
+    switch(op >> 1)
+    {
+        case 0: v = c.a; break;
+        case 1: v = c.r; break;
+        case 2: v = c.g; break;
+        default: v = c.b; break;
+    }
+    return (op & 1) ? 255 - v : v;
+}
+
+static int combine(int func, int a, int b, int c)
+{
+    switch(func)
+    {
+        case TEV_MODULATE:     return a * b / 255;
+        case TEV_ADD:          return clamp255(a + b);
+        case TEV_ADD_SIGNED:   return clamp255(a + b - 128);
+        case TEV_INTERPOLATE:  return (a * c + b * (255 - c)) / 255;
+        case TEV_SUBTRACT:     return clamp255(a - b);
+        case TEV_MULTIPLY_ADD: return clamp255(a * b / 255 + c);
+        case TEV_ADD_MULTIPLY: return clamp255(a + b) * c / 255;
+        //REPLACE, and the unknown values
+        default:               return a;
+    }
+}
+
+//As in citra: each product is rounded on its own, then the sum is clamped
+static int dot3(const int a[3], const int b[3])
+{
+    int d = ((a[0] * 2 - 255) * (b[0] * 2 - 255) + 128) / 256
+            + ((a[1] * 2 - 255) * (b[1] * 2 - 255) + 128) / 256
+            + ((a[2] * 2 - 255) * (b[2] * 2 - 255) + 128) / 256;
+    return clamp255(d);
+}
+
+uint32_t tevEvalScalar(const tev_config* cfg, const tev_pixel* in)
+{
+    color4 prev = {0, 0, 0, 0};
+    color4 buffer = unpack(cfg->bufferColor);
+    color4 next_buffer = buffer;
+    int s, i;
+
+    for(s = 0; s < TEV_NUM_STAGES; ++s)
+    {
+        const tev_stage* st = &cfg->stages[s];
+        uint32_t srcs = source_reg(st);
+        uint32_t ops = operand_reg(st);
+        int rgb_in[3][3];
+        int alpha_in[3];
+        color4 out;
+
+        for(i = 0; i < 3; ++i)
+        {
+            rgb_operand(RGB_OP(ops, i), get_source(RGB_SRC(srcs, i), in, st, prev, buffer), rgb_in[i]);
+            alpha_in[i] = alpha_operand(ALPHA_OP(ops, i), get_source(ALPHA_SRC(srcs, i), in, st, prev, buffer));
+        }
+
+        if(st->rgbCombine == TEV_DOT3_RGB || st->rgbCombine == TEV_DOT3_RGBA)
+        {
+            out.r = out.g = out.b = dot3(rgb_in[0], rgb_in[1]);
+        }
+        else
+        {
+            out.r = combine(st->rgbCombine, rgb_in[0][0], rgb_in[1][0], rgb_in[2][0]);
+            out.g = combine(st->rgbCombine, rgb_in[0][1], rgb_in[1][1], rgb_in[2][1]);
+            out.b = combine(st->rgbCombine, rgb_in[0][2], rgb_in[1][2], rgb_in[2][2]);
+        }
+        //DOT3 as an alpha combiner is undocumented and ends up as REPLACE in combine()
+        if(st->rgbCombine == TEV_DOT3_RGBA)out.a = out.r;
+        else out.a = combine(st->alphaCombine, alpha_in[0], alpha_in[1], alpha_in[2]);
+
+        out.r = clamp255(out.r << scale_shift(st->rgbScale));
+        out.g = clamp255(out.g << scale_shift(st->rgbScale));
+        out.b = clamp255(out.b << scale_shift(st->rgbScale));
+        out.a = clamp255(out.a << scale_shift(st->alphaScale));
+        prev = out;
+
+        //The buffer seen by a stage is the one written by the stage before the previous one
+        buffer = next_buffer;
+        if(s < 4 && (cfg->bufferUpdate & (1 << s)))
+        {
+            next_buffer.r = out.r;
+            next_buffer.g = out.g;
+            next_buffer.b = out.b;
+        }
+        if(s < 4 && (cfg->bufferUpdate & (0x10 << s)))next_buffer.a = out.a;
+    }
+    return pack(prev);
+}
+
+/*---------------------------------------------------------------------------------
+ * Alpha test and blending
+ *-------------------------------------------------------------------------------*/
+
+void tevFragmentOpsInit(tev_fragment_ops* ops)
+{
+    memset(ops, 0, sizeof(*ops));
+    ops->alphaFunction = TEV_TEST_ALWAYS;
+    ops->colorEquation = ops->alphaEquation = TEV_BLEND_ADD;
+    ops->colorSrc = ops->alphaSrc = TEV_FACTOR_ONE;
+    ops->colorDst = ops->alphaDst = TEV_FACTOR_ZERO;
+}
+
+static int alpha_test(int function, int a, int ref)
+{
+    switch(function)
+    {
+        case TEV_TEST_NEVER:    return 0;
+        case TEV_TEST_EQUAL:    return a == ref;
+        case TEV_TEST_NOTEQUAL: return a != ref;
+        case TEV_TEST_LESS:     return a < ref;
+        case TEV_TEST_LEQUAL:   return a <= ref;
+        case TEV_TEST_GREATER:  return a > ref;
+        case TEV_TEST_GEQUAL:   return a >= ref;
+        default:                return 1;
+    }
+}
+
+/*
+ * Factor of one channel (0-3: r, g, b, a). The reserved factors are modeled as ONE.
+ */
+static int blend_factor(int factor, int channel, color4 src, color4 dst, color4 k)
+{
+    const int s[4] = {src.r, src.g, src.b, src.a};
+    const int d[4] = {dst.r, dst.g, dst.b, dst.a};
+    const int c[4] = {k.r, k.g, k.b, k.a};
+    switch(factor)
+    {
+        case TEV_FACTOR_ZERO:                     return 0;
+        case TEV_FACTOR_SRC_COLOR:                return s[channel];
+        case TEV_FACTOR_ONE_MINUS_SRC_COLOR:      return 255 - s[channel];
+        case TEV_FACTOR_DST_COLOR:                return d[channel];
+        case TEV_FACTOR_ONE_MINUS_DST_COLOR:      return 255 - d[channel];
+        case TEV_FACTOR_SRC_ALPHA:                return src.a;
+        case TEV_FACTOR_ONE_MINUS_SRC_ALPHA:      return 255 - src.a;
+        case TEV_FACTOR_DST_ALPHA:                return dst.a;
+        case TEV_FACTOR_ONE_MINUS_DST_ALPHA:      return 255 - dst.a;
+        case TEV_FACTOR_CONSTANT_COLOR:           return c[channel];
+        case TEV_FACTOR_ONE_MINUS_CONSTANT_COLOR: return 255 - c[channel];
+        case TEV_FACTOR_CONSTANT_ALPHA:           return k.a;
+        case TEV_FACTOR_ONE_MINUS_CONSTANT_ALPHA: return 255 - k.a;
+        case TEV_FACTOR_SRC_ALPHA_SATURATE:
+            if(channel == 3)return 255;
+            return src.a < 255 - dst.a ? src.a : 255 - dst.a;
+        default:                                  return 255;
+    }
+}
+
+/*
+ * The products are rounded to the nearest, as citra does. MIN and MAX ignore the factors.
+ * Unknown equations are modeled as ADD.
+ */
+static int blend_channel(int equation, int s, int sf, int d, int df)
+{
+    switch(equation)
+    {
+        case TEV_BLEND_SUBTRACT:         return clamp255((s * sf - d * df + 127) / 255);
+        case TEV_BLEND_REVERSE_SUBTRACT: return clamp255((d * df - s * sf + 127) / 255);
+        case TEV_BLEND_MIN:              return s < d ? s : d;
+        case TEV_BLEND_MAX:              return s > d ? s : d;
+        default:                         return clamp255((s * sf + d * df + 127) / 255);
+    }
+}
+
+uint32_t tevFragmentOpsApply(const tev_fragment_ops* ops, uint32_t src, uint32_t dst, int* discarded)
+{
+    color4 s = unpack(src), d = unpack(dst), k = unpack(ops->blendColor), out;
+    if(discarded)*discarded = 0;
+    if(ops->alphaTest && !alpha_test(ops->alphaFunction, s.a, ops->alphaRef))
+    {
+        if(discarded)*discarded = 1;
+        return dst;
+    }
+    out.r = blend_channel(ops->colorEquation, s.r, blend_factor(ops->colorSrc, 0, s, d, k),
+                          d.r, blend_factor(ops->colorDst, 0, s, d, k));
+    out.g = blend_channel(ops->colorEquation, s.g, blend_factor(ops->colorSrc, 1, s, d, k),
+                          d.g, blend_factor(ops->colorDst, 1, s, d, k));
+    out.b = blend_channel(ops->colorEquation, s.b, blend_factor(ops->colorSrc, 2, s, d, k),
+                          d.b, blend_factor(ops->colorDst, 2, s, d, k));
+    out.a = blend_channel(ops->alphaEquation, s.a, blend_factor(ops->alphaSrc, 3, s, d, k),
+                          d.a, blend_factor(ops->alphaDst, 3, s, d, k));
+    return pack(out);
+}
+
+/*---------------------------------------------------------------------------------
+ * Vectorized model
+ *
+ * Same code as above, but every lane can have its own inputs and its own configuration.
+ * Generic GCC vectors are used so that this compiles to SSE/AVX/NEON depending on the host.
+ *-------------------------------------------------------------------------------*/
+
+#define TEV_LANES 8
+
+typedef int32_t vec __attribute__((vector_size(TEV_LANES * sizeof(int32_t))));
+
+typedef struct
+{
+    vec r, g, b, a;
+} vcolor;
+
+typedef struct
+{
+    vec rgbSrc[3], alphaSrc[3];
+    vec rgbOp[3], alphaOp[3];
+    vec rgbFunc, alphaFunc;
+    vec rgbShift, alphaShift;
+    vcolor constant;
+    vec updateRgb, updateAlpha;
+    uint32_t rgbFuncs, alphaFuncs; ///< Bitmask of the functions used by at least one lane
+    int active;                    ///< 0 if every lane simply passes the previous color through
+} lane_stage;
+
+typedef struct
+{
+    lane_stage stages[TEV_NUM_STAGES];
+    vcolor buffer;
+} lane_config;
+
+enum
+{
+    IN_PRIMARY,
+    IN_FRAGMENT_PRIMARY,
+    IN_FRAGMENT_SECONDARY,
+    IN_TEXTURE0,
+    IN_COUNT = IN_TEXTURE0 + 4
+};
+
+static inline vec vsplat(int32_t x)
+{
+    return (vec){0} + x;
+}
+
+static inline vec vsel(vec m, vec a, vec b)
+{
+    return (a & m) | (b & ~m);
+}
+
+static inline vec vmin(vec a, vec b)
+{
+    return vsel(a < b, a, b);
+}
+
+static inline vec vmax(vec a, vec b)
+{
+    return vsel(a > b, a, b);
+}
+
+static inline vec vclamp255(vec x)
+{
+    return vmin(vmax(x, vsplat(0)), vsplat(255));
+}
+
+//floor(x/255), exact for 0 <= x <= 65534
+static inline vec vdiv255(vec x)
+{
+    return (x + 1 + (x >> 8)) >> 8;
+}
+
+static inline vcolor vunpack(vec c)
+{
+    return (vcolor){c & 0xFF, (c >> 8) & 0xFF, (c >> 16) & 0xFF, (c >> 24) & 0xFF};
+}
+
+static inline vec vpack(vcolor c)
+{
+    return c.r | (c.g << 8) | (c.b << 16) | (c.a << 24);
+}
+
+static inline vcolor vcsel(vec m, vcolor a, vcolor b)
+{
+    return (vcolor){vsel(m, a.r, b.r), vsel(m, a.g, b.g), vsel(m, a.b, b.b), vsel(m, a.a, b.a)};
+}
+
+static void lane_stage_set(lane_stage* ls, int lane, const tev_stage* st, const tev_config* cfg, int s)
+{
+    uint32_t srcs = source_reg(st);
+    uint32_t ops = operand_reg(st);
+    color4 k = unpack(st->constantColor);
+    int i;
+    for(i = 0; i < 3; ++i)
+    {
+        ls->rgbSrc[i][lane] = RGB_SRC(srcs, i);
+        ls->alphaSrc[i][lane] = ALPHA_SRC(srcs, i);
+        ls->rgbOp[i][lane] = RGB_OP(ops, i);
+        ls->alphaOp[i][lane] = ALPHA_OP(ops, i);
+    }
+    ls->rgbFunc[lane] = st->rgbCombine;
+    ls->alphaFunc[lane] = st->alphaCombine;
+    ls->rgbShift[lane] = scale_shift(st->rgbScale);
+    ls->alphaShift[lane] = scale_shift(st->alphaScale);
+    ls->constant.r[lane] = k.r;
+    ls->constant.g[lane] = k.g;
+    ls->constant.b[lane] = k.b;
+    ls->constant.a[lane] = k.a;
+    ls->updateRgb[lane] = (s < 4 && (cfg->bufferUpdate & (1 << s))) ? -1 : 0;
+    ls->updateAlpha[lane] = (s < 4 && (cfg->bufferUpdate & (0x10 << s))) ? -1 : 0;
+    ls->rgbFuncs |= 1u << (st->rgbCombine & 0xF);
+    ls->alphaFuncs |= 1u << (st->alphaCombine & 0xF);
+    if(!is_passthrough(st))ls->active = 1;
+}
+
+/**
+* Fills the lanes with cfgs[0..n-1], the remaining lanes repeat the last configuration.
+*/
+static void lane_config_load(lane_config* lc, const tev_config* cfgs, size_t n)
+{
+    int lane, s;
+    memset(lc, 0, sizeof(*lc));
+    for(lane = 0; lane < TEV_LANES; ++lane)
+    {
+        const tev_config* cfg = &cfgs[(size_t)lane < n ? (size_t)lane : n - 1];
+        color4 buf = unpack(cfg->bufferColor);
+        for(s = 0; s < TEV_NUM_STAGES; ++s)
+        {
+            lane_stage_set(&lc->stages[s], lane, &cfg->stages[s], cfg, s);
+        }
+        lc->buffer.r[lane] = buf.r;
+        lc->buffer.g[lane] = buf.g;
+        lc->buffer.b[lane] = buf.b;
+        lc->buffer.a[lane] = buf.a;
+    }
+}
+
+static vcolor vget_source(vec src, const vcolor* in, const vcolor* constant, const vcolor* prev, const vcolor* buffer)
+{
+    static const int ids[IN_COUNT] = {
+            TEV_SRC_PRIMARY_COLOR, TEV_SRC_FRAGMENT_PRIMARY, TEV_SRC_FRAGMENT_SECONDARY,
+            TEV_SRC_TEXTURE0, TEV_SRC_TEXTURE1, TEV_SRC_TEXTURE2, TEV_SRC_TEXTURE3
+    };
+    vcolor res = {vsplat(0), vsplat(0), vsplat(0), vsplat(0)};
+    int i;
+    for(i = 0; i < IN_COUNT; ++i)
+    {
+        res = vcsel(src == ids[i], in[i], res);
+    }
+    res = vcsel(src == TEV_SRC_PREVIOUS_BUFFER, *buffer, res);
+    res = vcsel(src == TEV_SRC_CONSTANT, *constant, res);
+    res = vcsel(src == TEV_SRC_PREVIOUS, *prev, res);
+    return res;
+}
+
+static void vrgb_operand(vec op, vcolor c, vec out[3])
+{
+    vec sel = op >> 2;
+    vec single = vsel(sel == 1, c.r, vsel(sel == 2, c.g, c.b));
+    vec is_color = (sel == 0) & ((op & 2) == 0);
+    vec is_alpha = (sel == 0) & ((op & 2) != 0);
+    vec inv = vsel((op & 1) != 0, vsplat(0xFF), vsplat(0));
+
+    out[0] = vsel(is_color, c.r, vsel(is_alpha, c.a, single)) ^ inv;
+    out[1] = vsel(is_color, c.g, vsel(is_alpha, c.a, single)) ^ inv;
+    out[2] = vsel(is_color, c.b, vsel(is_alpha, c.a, single)) ^ inv;
+}
+
+static vec valpha_operand(vec op, vcolor c)
+{
+    vec sel = op >> 1;
+    vec v = vsel(sel == 0, c.a, vsel(sel == 1, c.r, vsel(sel == 2, c.g, c.b)));
+    return v ^ vsel((op & 1) != 0, vsplat(0xFF), vsplat(0));
+}
+
+static vec vcombine(vec func, uint32_t used, vec a, vec b, vec c)
+{
+    vec res = a; //REPLACE, and the unknown values
+    if(used & (1 << TEV_MODULATE))    res = vsel(func == TEV_MODULATE, vdiv255(a * b), res);
+    if(used & (1 << TEV_ADD))         res = vsel(func == TEV_ADD, vmin(a + b, vsplat(255)), res);
+    if(used & (1 << TEV_ADD_SIGNED))  res = vsel(func == TEV_ADD_SIGNED, vclamp255(a + b - 128), res);
+    if(used & (1 << TEV_INTERPOLATE)) res = vsel(func == TEV_INTERPOLATE, vdiv255(a * c + b * (255 - c)), res);
+    if(used & (1 << TEV_SUBTRACT))    res = vsel(func == TEV_SUBTRACT, vmax(a - b, vsplat(0)), res);
+    if(used & (1 << TEV_MULTIPLY_ADD))res = vsel(func == TEV_MULTIPLY_ADD, vmin(vdiv255(a * b) + c, vsplat(255)), res);
+    if(used & (1 << TEV_ADD_MULTIPLY))res = vsel(func == TEV_ADD_MULTIPLY, vdiv255(vmin(a + b, vsplat(255)) * c), res);
+    return res;
+}
+
+/**
+* x / 256 rounded toward 0 like the C division of dot3, the products can be negative.
+*/
+static inline vec vdiv256(vec x)
+{
+    return (x + ((x >> 31) & 255)) >> 8;
+}
+
+static vec vdot3(const vec a[3], const vec b[3])
+{
+    vec d = vdiv256((a[0] * 2 - 255) * (b[0] * 2 - 255) + 128)
+            + vdiv256((a[1] * 2 - 255) * (b[1] * 2 - 255) + 128)
+            + vdiv256((a[2] * 2 - 255) * (b[2] * 2 - 255) + 128);
+    return vclamp255(d);
+}
+
+static vec tev_kernel(const lane_config* lc, const vcolor* in)
+{
+    vcolor prev = {vsplat(0), vsplat(0), vsplat(0), vsplat(0)};
+    vcolor buffer = lc->buffer;
+    vcolor next_buffer = buffer;
+    int s, i;
+
+    for(s = 0; s < TEV_NUM_STAGES; ++s)
+    {
+        const lane_stage* ls = &lc->stages[s];
+        if(ls->active)
+        {
+            vec rgb_in[3][3];
+            vec alpha_in[3];
+            vcolor out;
+
+            for(i = 0; i < 3; ++i)
+            {
+                vrgb_operand(ls->rgbOp[i], vget_source(ls->rgbSrc[i], in, &ls->constant, &prev, &buffer), rgb_in[i]);
+                alpha_in[i] = valpha_operand(ls->alphaOp[i], vget_source(ls->alphaSrc[i], in, &ls->constant, &prev, &buffer));
+            }
+
+            out.r = vcombine(ls->rgbFunc, ls->rgbFuncs, rgb_in[0][0], rgb_in[1][0], rgb_in[2][0]);
+            out.g = vcombine(ls->rgbFunc, ls->rgbFuncs, rgb_in[0][1], rgb_in[1][1], rgb_in[2][1]);
+            out.b = vcombine(ls->rgbFunc, ls->rgbFuncs, rgb_in[0][2], rgb_in[1][2], rgb_in[2][2]);
+            out.a = vcombine(ls->alphaFunc, ls->alphaFuncs, alpha_in[0], alpha_in[1], alpha_in[2]);
+            if(ls->rgbFuncs & ((1 << TEV_DOT3_RGB) | (1 << TEV_DOT3_RGBA)))
+            {
+                vec d = vdot3(rgb_in[0], rgb_in[1]);
+                vec is_dot = (ls->rgbFunc == TEV_DOT3_RGB) | (ls->rgbFunc == TEV_DOT3_RGBA);
+                out.r = vsel(is_dot, d, out.r);
+                out.g = vsel(is_dot, d, out.g);
+                out.b = vsel(is_dot, d, out.b);
+                out.a = vsel(ls->rgbFunc == TEV_DOT3_RGBA, d, out.a);
+            }
+
+            out.r = vclamp255(out.r << ls->rgbShift);
+            out.g = vclamp255(out.g << ls->rgbShift);
+            out.b = vclamp255(out.b << ls->rgbShift);
+            out.a = vclamp255(out.a << ls->alphaShift);
+            prev = out;
+        }
+
+        buffer = next_buffer;
+        next_buffer.r = vsel(ls->updateRgb, prev.r, next_buffer.r);
+        next_buffer.g = vsel(ls->updateRgb, prev.g, next_buffer.g);
+        next_buffer.b = vsel(ls->updateRgb, prev.b, next_buffer.b);
+        next_buffer.a = vsel(ls->updateAlpha, prev.a, next_buffer.a);
+    }
+    return vpack(prev);
+}
+
+static inline vec load_plane(const uint32_t* plane, size_t i, size_t n)
+{
+    vec v = vsplat(0);
+    if(!plane)return v;
+    if(i + TEV_LANES <= n)
+    {
+        memcpy(&v, plane + i, sizeof(v));
+    }
+    else
+    {
+        size_t l;
+        for(l = 0; i + l < n; ++l)v[l] = plane[i + l];
+    }
+    return v;
+}
+
+void tevEvalPlanes(const tev_config* cfg, const tev_planes* in, uint32_t* out, size_t n)
+{
+    lane_config lc;
+    vcolor inputs[IN_COUNT];
+    size_t i;
+    int t;
+
+    lane_config_load(&lc, cfg, 1);
+    for(i = 0; i < n; i += TEV_LANES)
+    {
+        inputs[IN_PRIMARY] = vunpack(load_plane(in->primaryColor, i, n));
+        inputs[IN_FRAGMENT_PRIMARY] = vunpack(load_plane(in->fragmentPrimary, i, n));
+        inputs[IN_FRAGMENT_SECONDARY] = vunpack(load_plane(in->fragmentSecondary, i, n));
+        for(t = 0; t < 4; ++t)inputs[IN_TEXTURE0 + t] = vunpack(load_plane(in->texture[t], i, n));
+
+        vec res = tev_kernel(&lc, inputs);
+        if(i + TEV_LANES <= n)
+        {
+            memcpy(out + i, &res, sizeof(res));
+        }
+        else
+        {
+            size_t l;
+            for(l = 0; i + l < n; ++l)out[i + l] = res[l];
+        }
+    }
+}
+
+void tevEvalConfigs(const tev_config* cfgs, size_t n, const tev_pixel* in, uint32_t* out)
+{
+    lane_config lc;
+    vcolor inputs[IN_COUNT];
+    size_t i, l;
+    int t;
+
+    inputs[IN_PRIMARY] = vunpack(vsplat(in->primaryColor));
+    inputs[IN_FRAGMENT_PRIMARY] = vunpack(vsplat(in->fragmentPrimary));
+    inputs[IN_FRAGMENT_SECONDARY] = vunpack(vsplat(in->fragmentSecondary));
+    for(t = 0; t < 4; ++t)inputs[IN_TEXTURE0 + t] = vunpack(vsplat(in->texture[t]));
+
+    for(i = 0; i < n; i += TEV_LANES)
+    {
+        lane_config_load(&lc, cfgs + i, n - i);
+        vec res = tev_kernel(&lc, inputs);
+        for(l = 0; l < TEV_LANES && i + l < n; ++l)out[i + l] = res[l];
+    }
+}
@@ -0,0 +1,196 @@
+/**
+ *@file tevmodel.h
+ *@author Lectem
+ *@date 17/10/2026
+ *
+ * Software reference model of the PICA200 texture combiners (TEV), built on the host.
+ * It takes the same parameters as GPU_SetTexEnv so that expected gpuColorBuffer values can be
+ * computed for any configuration and diffed against what the hardware produced.
+ *
+ * Colors use the register order (r in the low byte, like the RGBA8 macro and the TEV constant color).
+ * Use tevColorToFramebuffer to compare against a pixel read from an RGBA8 color buffer.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define TEV_NUM_STAGES 6
+
+//Source ids as used in GPU_TEVSOURCES
+enum
+{
+    TEV_SRC_PRIMARY_COLOR = 0x0,
+    TEV_SRC_FRAGMENT_PRIMARY = 0x1,
+    TEV_SRC_FRAGMENT_SECONDARY = 0x2,
+    TEV_SRC_TEXTURE0 = 0x3,
+    TEV_SRC_TEXTURE1 = 0x4,
+    TEV_SRC_TEXTURE2 = 0x5,
+    TEV_SRC_TEXTURE3 = 0x6,
+    TEV_SRC_PREVIOUS_BUFFER = 0xD,
+    TEV_SRC_CONSTANT = 0xE,
+    TEV_SRC_PREVIOUS = 0xF,
+};
+
+//Combiner functions as used by GPU_SetTexEnv
+enum
+{
+    TEV_REPLACE = 0x0,
+    TEV_MODULATE = 0x1,
+    TEV_ADD = 0x2,
+    TEV_ADD_SIGNED = 0x3,
+    TEV_INTERPOLATE = 0x4,
+    TEV_SUBTRACT = 0x5,
+    TEV_DOT3_RGB = 0x6,
+    TEV_DOT3_RGBA = 0x7,
+    TEV_MULTIPLY_ADD = 0x8,
+    TEV_ADD_MULTIPLY = 0x9,
+};
+
+/**
+* One TEV stage, fields have the same encoding as the GPU_SetTexEnv parameters.
+* The scales are the raw register values (0: x1, 1: x2, 2: x4), GPU_SetTexEnv always leaves them at 0.
+*/
+typedef struct
+{
+    uint16_t rgbSources, alphaSources;
+    uint16_t rgbOperands, alphaOperands;
+    uint8_t rgbCombine, alphaCombine;
+    uint8_t rgbScale, alphaScale;
+    uint32_t constantColor;
+} tev_stage;
+
+typedef struct
+{
+    tev_stage stages[TEV_NUM_STAGES];
+    uint32_t bufferColor;   ///< Initial value of the combiner buffer
+    uint8_t bufferUpdate;   ///< Bits 0-3: stage i writes its rgb to the buffer, bits 4-7: same for alpha
+} tev_config;
+
+/**
+* The inputs of the combiners for a single fragment.
+*/
+typedef struct
+{
+    uint32_t primaryColor;
+    uint32_t fragmentPrimary;
+    uint32_t fragmentSecondary;
+    uint32_t texture[4];
+} tev_pixel;
+
+/**
+* The same inputs for a whole framebuffer, one plane per source. A NULL plane reads as 0.
+*/
+typedef struct
+{
+    const uint32_t* primaryColor;
+    const uint32_t* fragmentPrimary;
+    const uint32_t* fragmentSecondary;
+    const uint32_t* texture[4];
+} tev_planes;
+
+/**
+* Fills every stage with the pass-through setup of GPU_SetDummyTexEnv.
+*/
+void tevConfigInit(tev_config* cfg);
+/**
+* Same as GPU_SetTexEnv.
+*/
+void tevSetStage(tev_config* cfg, int id,
+                 uint16_t rgbSources, uint16_t alphaSources,
+                 uint16_t rgbOperands, uint16_t alphaOperands,
+                 uint8_t rgbCombine, uint8_t alphaCombine,
+                 uint32_t constantColor);
+
+/**
+* Plain scalar evaluation, the specification the vectorized kernels are checked against.
+*/
+uint32_t tevEvalScalar(const tev_config* cfg, const tev_pixel* in);
+/**
+* Evaluates one configuration over n fragments, vectorized over the fragments.
+*/
+void tevEvalPlanes(const tev_config* cfg, const tev_planes* in, uint32_t* out, size_t n);
+/**
+* Evaluates n configurations on the same fragment, vectorized over the configurations.
+*/
+void tevEvalConfigs(const tev_config* cfgs, size_t n, const tev_pixel* in, uint32_t* out);
+
+//Alpha test functions, same values as GPU_TESTFUNC
+enum
+{
+    TEV_TEST_NEVER = 0,
+    TEV_TEST_ALWAYS = 1,
+    TEV_TEST_EQUAL = 2,
+    TEV_TEST_NOTEQUAL = 3,
+    TEV_TEST_LESS = 4,
+    TEV_TEST_LEQUAL = 5,
+    TEV_TEST_GREATER = 6,
+    TEV_TEST_GEQUAL = 7,
+};
+
+//Blend equations and factors, same values as GPU_BLENDEQUATION and GPU_BLENDFACTOR
+enum
+{
+    TEV_BLEND_ADD = 0,
+    TEV_BLEND_SUBTRACT = 1,
+    TEV_BLEND_REVERSE_SUBTRACT = 2,
+    TEV_BLEND_MIN = 3,
+    TEV_BLEND_MAX = 4,
+};
+
+enum
+{
+    TEV_FACTOR_ZERO = 0,
+    TEV_FACTOR_ONE = 1,
+    TEV_FACTOR_SRC_COLOR = 2,
+    TEV_FACTOR_ONE_MINUS_SRC_COLOR = 3,
+    TEV_FACTOR_DST_COLOR = 4,
+    TEV_FACTOR_ONE_MINUS_DST_COLOR = 5,
+    TEV_FACTOR_SRC_ALPHA = 6,
+    TEV_FACTOR_ONE_MINUS_SRC_ALPHA = 7,
+    TEV_FACTOR_DST_ALPHA = 8,
+    TEV_FACTOR_ONE_MINUS_DST_ALPHA = 9,
+    TEV_FACTOR_CONSTANT_COLOR = 10,
+    TEV_FACTOR_ONE_MINUS_CONSTANT_COLOR = 11,
+    TEV_FACTOR_CONSTANT_ALPHA = 12,
+    TEV_FACTOR_ONE_MINUS_CONSTANT_ALPHA = 13,
+    TEV_FACTOR_SRC_ALPHA_SATURATE = 14,
+};
+
+/**
+* What happens to the output of the combiners before it is written: the alpha test then the blending, with the
+* parameters of GPU_SetAlphaTest, GPU_SetAlphaBlending and GPU_SetBlendingColor.
+*/
+typedef struct
+{
+    uint8_t alphaTest;          ///< Enabled
+    uint8_t alphaFunction, alphaRef;
+    uint8_t colorEquation, alphaEquation;
+    uint8_t colorSrc, colorDst;
+    uint8_t alphaSrc, alphaDst;
+    uint32_t blendColor;        ///< Register order
+} tev_fragment_ops;
+
+/**
+* The setup of gpuDisableEverything: no alpha test, the blending writes the source as is (ONE, ZERO).
+*/
+void tevFragmentOpsInit(tev_fragment_ops* ops);
+/**
+* Applies the alpha test and the blending to a fragment, colors in the register order.
+* @param discarded Set to 1 if the alpha test failed, may be NULL
+* @return The new color of the buffer, dst if the fragment was discarded
+*/
+uint32_t tevFragmentOpsApply(const tev_fragment_ops* ops, uint32_t src, uint32_t dst, int* discarded);
+
+/**
+* Converts between the register order and the u32 as read from an RGBA8 color buffer or texture.
+*/
+static inline uint32_t tevColorToFramebuffer(uint32_t c)
+{
+    return __builtin_bswap32(c);
+}
+
+static inline uint32_t tevColorFromTexel(uint32_t c)
+{
+    return __builtin_bswap32(c);
+}
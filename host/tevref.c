@@ -0,0 +1,252 @@
+/**
+ *@file tevref.c
+ *@author Lectem
+ *@date 17/10/2026
+ *
+ * Command line front-end of the TEV reference model.
+ *
+ *   tevref [sweep]        prints the expected results of the device sweeps, in the gpuTestReport.txt format
+ *   tevref diff <report>  compares a gpuTestReport.txt against the model and prints the mismatches
+ *   tevref bench [count]  evaluates count random configurations and a full framebuffer, checks the
+ *                         vectorized kernels against the scalar model and prints the throughput
+ */
+#include "tevmodel.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define FB_PIXELS (480 * 400)
+
+//Inputs of the device test, see fill_test_textures and test_mesh in source/main.c
+static const tev_pixel test_pixel = {
+        .primaryColor = 0xFFFFFFFF,
+        .fragmentPrimary = 0,
+        .fragmentSecondary = 0,
+        .texture = {0x11111111, 0x22222222, 0x33333333, 0}
+};
+
+/*
+ * Mirrors the case enumeration of source/tevsweep.c, keep them in sync.
+ */
+typedef enum
+{
+    SWEEP_SOURCES,
+    SWEEP_OPERANDS,
+    SWEEP_COMBINERS,
+    SWEEP_COUNT
+} sweep_kind;
+
+static const char* sweep_names[SWEEP_COUNT] = {"sources", "operands", "combiners"};
+static const unsigned sweep_sizes[SWEEP_COUNT] = {16 * 16, 16 * 8, 10 * 10};
+
+static void sweep_case(sweep_kind kind, unsigned index, tev_stage* st)
+{
+    const uint16_t default_sources = TEV_SRC_CONSTANT | TEV_SRC_TEXTURE1 << 4 | TEV_SRC_TEXTURE2 << 8;
+    memset(st, 0, sizeof(*st));
+    st->rgbSources = default_sources;
+    st->alphaSources = default_sources;
+    st->constantColor = 0xAABBCCDD;
+    switch(kind)
+    {
+        case SWEEP_SOURCES:
+            st->rgbSources = index % 16;
+            st->alphaSources = index / 16;
+            break;
+        case SWEEP_OPERANDS:
+            st->rgbOperands = index % 16;
+            st->alphaOperands = index / 16;
+            break;
+        case SWEEP_COMBINERS:
+            st->rgbCombine = index % 10;
+            st->alphaCombine = index / 10;
+            break;
+        default:break;
+    }
+}
+
+static uint32_t expected_color(const tev_stage* st)
+{
+    tev_config cfg;
+    tevConfigInit(&cfg);
+    tevSetStage(&cfg, 0, st->rgbSources, st->alphaSources, st->rgbOperands, st->alphaOperands,
+                st->rgbCombine, st->alphaCombine, st->constantColor);
+    return tevColorToFramebuffer(tevEvalScalar(&cfg, &test_pixel));
+}
+
+static int cmd_sweep(void)
+{
+    int kind;
+    unsigned i;
+    for(kind = 0; kind < SWEEP_COUNT; ++kind)
+    {
+        for(i = 0; i < sweep_sizes[kind]; ++i)
+        {
+            tev_stage st;
+            sweep_case(kind, i, &st);
+            printf("%s rgbSrc=%03x aSrc=%03x rgbOp=%03x aOp=%03x rgbComb=%x aComb=%x const=%08x gpuColor=%08x\n",
+                   sweep_names[kind],
+                   st.rgbSources, st.alphaSources, st.rgbOperands, st.alphaOperands,
+                   st.rgbCombine, st.alphaCombine, st.constantColor, expected_color(&st));
+        }
+    }
+    return 0;
+}
+
+static int cmd_diff(const char* path)
+{
+    FILE* f = fopen(path, "r");
+    char line[256];
+    unsigned checked = 0, mismatches = 0;
+    if(!f)
+    {
+        perror(path);
+        return 1;
+    }
+    while(fgets(line, sizeof(line), f))
+    {
+        char name[32];
+        unsigned rs, as, ro, ao, rc, ac, k, color;
+        tev_stage st;
+        memset(&st, 0, sizeof(st));
+        if(sscanf(line, "%31s rgbSrc=%x aSrc=%x rgbOp=%x aOp=%x rgbComb=%x aComb=%x const=%x gpuColor=%x",
+                  name, &rs, &as, &ro, &ao, &rc, &ac, &k, &color) == 9)
+        {
+            st.rgbSources = rs; st.alphaSources = as;
+            st.rgbOperands = ro; st.alphaOperands = ao;
+            st.rgbCombine = rc; st.alphaCombine = ac;
+            st.constantColor = k;
+        }
+        //Lines logged by the interactive test
+        else if(sscanf(line, "cSource=%x aSource=%x gpuColor=%x", &rs, &as, &color) == 3)
+        {
+            st.rgbSources = rs; st.alphaSources = as;
+            st.constantColor = 0xAABBCCDD;
+        }
+        else continue;
+
+        uint32_t expected = expected_color(&st);
+        checked++;
+        if(expected != color)
+        {
+            mismatches++;
+            printf("expected=%08x %s", expected, line);
+        }
+    }
+    fclose(f);
+    printf("%u cases checked, %u mismatches\n", checked, mismatches);
+    return mismatches != 0;
+}
+
+static uint32_t xorshift_state = 0x12345678;
+
+static uint32_t xorshift(void)
+{
+    uint32_t x = xorshift_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return xorshift_state = x;
+}
+
+static void random_config(tev_config* cfg)
+{
+    int s;
+    tevConfigInit(cfg);
+    for(s = 0; s < TEV_NUM_STAGES; ++s)
+    {
+        tev_stage* st = &cfg->stages[s];
+        //Leave some stages as pass-through, like most real setups
+        if(s > 0 && (xorshift() & 3) == 0)continue;
+        st->rgbSources = xorshift() & 0xFFF;
+        st->alphaSources = xorshift() & 0xFFF;
+        st->rgbOperands = xorshift() & 0xFFF;
+        st->alphaOperands = xorshift() & 0x777;
+        st->rgbCombine = xorshift() % 10;
+        st->alphaCombine = xorshift() % 10;
+        st->rgbScale = xorshift() & 3;
+        st->alphaScale = xorshift() & 3;
+        st->constantColor = xorshift();
+    }
+    cfg->bufferColor = xorshift();
+    cfg->bufferUpdate = xorshift() & 0xFF;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int cmd_bench(size_t count)
+{
+    tev_config* cfgs = malloc(count * sizeof(*cfgs));
+    uint32_t* simd = malloc(count * sizeof(*simd));
+    uint32_t* planes[7];
+    uint32_t* fb_simd = malloc(FB_PIXELS * sizeof(uint32_t));
+    size_t i, mismatches = 0, fbMismatches = 0;
+    int p;
+    double t0, t1, t2;
+
+    if(!cfgs || !simd || !fb_simd)
+    {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    for(i = 0; i < count; ++i)random_config(&cfgs[i]);
+
+    t0 = now();
+    tevEvalConfigs(cfgs, count, &test_pixel, simd);
+    t1 = now();
+    for(i = 0; i < count; ++i)
+    {
+        if(tevEvalScalar(&cfgs[i], &test_pixel) != simd[i])mismatches++;
+    }
+    t2 = now();
+    printf("configs: %zu in %.3fs (%.1f M/s), scalar %.3fs, %zu mismatches\n",
+           count, t1 - t0, count / (t1 - t0) * 1e-6, t2 - t1, mismatches);
+
+    //Whole framebuffer with random inputs for every source
+    tev_planes in;
+    for(p = 0; p < 7; ++p)
+    {
+        planes[p] = malloc(FB_PIXELS * sizeof(uint32_t));
+        for(i = 0; i < FB_PIXELS; ++i)planes[p][i] = xorshift();
+    }
+    in.primaryColor = planes[0];
+    in.fragmentPrimary = planes[1];
+    in.fragmentSecondary = planes[2];
+    for(p = 0; p < 4; ++p)in.texture[p] = planes[3 + p];
+
+    t0 = now();
+    tevEvalPlanes(&cfgs[0], &in, fb_simd, FB_PIXELS);
+    t1 = now();
+    for(i = 0; i < FB_PIXELS; ++i)
+    {
+        tev_pixel px = {planes[0][i], planes[1][i], planes[2][i], {planes[3][i], planes[4][i], planes[5][i], planes[6][i]}};
+        if(tevEvalScalar(&cfgs[0], &px) != fb_simd[i])fbMismatches++;
+    }
+    t2 = now();
+    printf("framebuffer: %d pixels in %.3fms, scalar %.3fms, %zu mismatches\n",
+           FB_PIXELS, (t1 - t0) * 1e3, (t2 - t1) * 1e3, fbMismatches);
+
+    for(p = 0; p < 7; ++p)free(planes[p]);
+    free(fb_simd);
+    free(simd);
+    free(cfgs);
+    //Either kernel disagreeing with the scalar model is a failure
+    return mismatches != 0 || fbMismatches != 0;
+}
+
+int main(int argc, char** argv)
+{
+    if(argc < 2 || !strcmp(argv[1], "sweep"))return cmd_sweep();
+    if(!strcmp(argv[1], "diff") && argc >= 3)return cmd_diff(argv[2]);
+    if(!strcmp(argv[1], "bench"))return cmd_bench(argc >= 3 ? strtoul(argv[2], NULL, 0) : 1000000);
+
+    fprintf(stderr, "usage: %s [sweep | diff <gpuTestReport.txt> | bench [count]]\n", argv[0]);
+    return 1;
+}
@@ -0,0 +1,107 @@
+/**
+ *@file texbench.c
+ *@author Lectem
+ *@date 17/10/2026
+ *
+ * Checks and measures the texture tiling of source/gputexture.c.
+ *
+ *   texbench [size] [iterations]     tiles and untiles size x size images (1024 by default) of every format
+ *
+ * Each format is checked against the per pixel reference and the round trip, then timed. The GX path goes through
+ * the display transfer emulation of the stand-in, so its time means nothing, only its output is checked.
+ */
+#include "gputexture.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static const struct {
+    GPU_TEXCOLOR format;
+    const char* name;
+} formats[] = {
+        {GPU_RGBA8, "rgba8"},
+        {GPU_RGB8, "rgb8"},
+        {GPU_RGB565, "rgb565"},
+        {GPU_RGBA5551, "rgba5551"},
+        {GPU_RGBA4, "rgba4"},
+        {GPU_LA8, "la8"},
+        {GPU_A8, "a8"},
+};
+
+int main(int argc, char** argv)
+{
+    u32 size = argc > 1 ? strtoul(argv[1], NULL, 0) : 1024;
+    u32 iterations = argc > 2 ? strtoul(argv[2], NULL, 0) : 20;
+    u32 bytes = size * size * 4;
+    u8* linear = linearMemAlign(bytes, 0x80);
+    u8* tiled = linearMemAlign(bytes, 0x80);
+    u8* expected = malloc(bytes);
+    u8* back = malloc(bytes);
+    u32 i, f, it;
+    int failures = 0;
+
+    if(!size || (size & 7) || !linear || !tiled || !expected || !back)
+    {
+        fprintf(stderr, "usage: texbench [size, multiple of 8] [iterations]\n");
+        return 1;
+    }
+    srand(1);
+    printf("%ux%u, %u iterations\n", (unsigned)size, (unsigned)size, (unsigned)iterations);
+    printf("%-8s %10s %10s %11s  %s\n", "format", "ref MB/s", "tile MB/s", "untile MB/s", "check");
+    for(f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f)
+    {
+        GPU_TEXCOLOR format = formats[f].format;
+        u32 imageBytes = size * size * gpuTextureBpp(format);
+        double t0, tRef, tTile, tUntile;
+        bool ok = true;
+        u32 flags;
+
+        for(i = 0; i < imageBytes; ++i)linear[i] = rand();
+
+        for(flags = 0; flags <= GPU_TEXTURE_FLIP_Y; ++flags)
+        {
+            gpuTextureTileReference(expected, linear, size, size, format, flags);
+            gpuTextureTile(tiled, linear, size, size, format, flags);
+            ok = ok && !memcmp(tiled, expected, imageBytes);
+            gpuTextureUntile(back, tiled, size, size, format, flags);
+            ok = ok && !memcmp(back, linear, imageBytes);
+        }
+
+        t0 = now();
+        for(it = 0; it < iterations; ++it)gpuTextureTileReference(expected, linear, size, size, format, 0);
+        tRef = now() - t0;
+        t0 = now();
+        for(it = 0; it < iterations; ++it)gpuTextureTile(tiled, linear, size, size, format, 0);
+        tTile = now() - t0;
+        t0 = now();
+        for(it = 0; it < iterations; ++it)gpuTextureUntile(back, tiled, size, size, format, 0);
+        tUntile = now() - t0;
+
+        //The GX path changes the byte order of RGBA8 images in place, so it is checked last on a copy
+        if(format == GPU_RGBA8 || format == GPU_RGB565 || format == GPU_RGBA4)
+        {
+            memcpy(back, linear, imageBytes);
+            gpuTextureTileGX(tiled, linear, size, size, format, 0);
+            ok = ok && !memcmp(tiled, expected, imageBytes);
+            memcpy(linear, back, imageBytes);
+        }
+
+        double mb = (double)imageBytes * iterations / (1024 * 1024);
+        printf("%-8s %10.0f %10.0f %11.0f  %s\n", formats[f].name, mb / tRef, mb / tTile, mb / tUntile, ok ? "ok" : "FAILED");
+        if(!ok)failures++;
+    }
+    linearFree(linear);
+    linearFree(tiled);
+    free(expected);
+    free(back);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,97 @@
+/**
+ *@file tracedump.c
+ *@author Lectem
+ *@date 17/10/2026
+ *
+ * Decodes the command list traces recorded by source/gputrace.c (gpuTrace.bin).
+ *
+ *   tracedump <trace>               prints the size of every frame and the compression ratio
+ *   tracedump <trace> <frame>       prints the commands of a frame
+ *   tracedump <trace> bench         measures how fast the whole trace decodes
+ */
+#include "gputrace.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void print_frame(const u32* cmds, s32 size)
+{
+    s32 i = 0, k;
+    while(i + 1 < size)
+    {
+        u32 header = cmds[i + 1];
+        u32 extra = (header >> 20) & 0x7FF;
+        printf("%03x mask=%x%s:", header & 0xFFFF, (header >> 16) & 0xF, header >> 31 ? " incremental" : "");
+        printf(" %08x", cmds[i]);
+        for(k = 1; k <= (s32)extra; ++k)printf(" %08x", cmds[i + 1 + k]);
+        printf("\n");
+        i += 2 + extra + (extra & 1);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    gpu_trace* trace;
+    u32* cmds;
+    u32 f, frames;
+
+    if(argc < 2)
+    {
+        fprintf(stderr, "usage: %s <trace> [frame|bench]\n", argv[0]);
+        return 1;
+    }
+    trace = gpuTraceLoad(argv[1]);
+    if(!trace)
+    {
+        fprintf(stderr, "couldn't load %s\n", argv[1]);
+        return 1;
+    }
+    frames = gpuTraceFrameCount(trace);
+    cmds = malloc((trace->header->maxFrameWords + 1) * sizeof(u32));
+
+    if(argc >= 3 && !strcmp(argv[2], "bench"))
+    {
+        u64 words = 0;
+        double t0 = now();
+        for(f = 0; f < frames; ++f)words += gpuTraceDecodeFrame(trace, f, cmds, trace->header->maxFrameWords);
+        double t1 = now();
+        printf("%u frames, %llu words decoded in %.3fs (%.1f frames/s, %.1f MB/s)\n", frames,
+               (unsigned long long)words, t1 - t0, frames / (t1 - t0), words * 4 / (t1 - t0) * 1e-6);
+    }
+    else if(argc >= 3)
+    {
+        f = strtoul(argv[2], NULL, 0);
+        s32 size = gpuTraceDecodeFrame(trace, f, cmds, trace->header->maxFrameWords);
+        if(size < 0)
+        {
+            fprintf(stderr, "couldn't decode frame %u\n", f);
+            return 1;
+        }
+        print_frame(cmds, size);
+    }
+    else
+    {
+        u64 words = 0;
+        for(f = 0; f < frames; ++f)
+        {
+            const gpu_trace_frame* frame = &trace->index[f];
+            printf("frame %u: %u words, %u bytes%s%s\n", f, frame->words, frame->size,
+                   frame->flags & GPU_TRACE_KEYFRAME ? " keyframe" : "", frame->flags & GPU_TRACE_RAW ? " raw" : "");
+            words += frame->words;
+        }
+        printf("%u frames, %llu bytes of commands in a %u bytes trace (%.1fx)\n", frames,
+               (unsigned long long)words * 4, trace->size, trace->size ? words * 4.0 / trace->size : 0.0);
+    }
+
+    free(cmds);
+    gpuTraceFree(trace);
+    return 0;
+}
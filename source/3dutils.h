@@ -5,6 +5,7 @@
 #ifndef _2DGPU_3DUTILS_H_
 #define _2DGPU_3DUTILS_H_
 #include <3ds.h>
+//One shot upload, gpu_uniform_block (gpuuniform.h) avoids the copy and only sends what changed
 void SetUniformMatrix(u32 startreg, float* m);
 
 #endif //_2DGPU_3DUTILS_H_
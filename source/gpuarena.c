@@ -0,0 +1,120 @@
+/**
+ *@file gpuarena.c
+ *@author Lectem
+ *@date 17/10/2026
+ */
+#include "gpuarena.h"
+#include <string.h>
+
+bool gpuArenaInit(gpu_arena* arena, u32 size)
+{
+    gpuArenaInitFrom(arena, linearMemAlign(size, 0x80), size);
+    arena->owned = arena->base != NULL;
+    return arena->base != NULL;
+}
+
+void gpuArenaInitFrom(gpu_arena* arena, void* mem, u32 size)
+{
+    memset(arena, 0, sizeof(*arena));
+    arena->base = mem;
+    arena->size = mem ? size : 0;
+}
+
+bool gpuArenaInitSub(gpu_arena* arena, gpu_arena* parent, u32 size)
+{
+    gpuArenaInitFrom(arena, gpuArenaAlloc(parent, size, 0x80), size);
+    return arena->base != NULL;
+}
+
+void gpuArenaFree(gpu_arena* arena)
+{
+    if(arena->owned)linearFree(arena->base);
+    memset(arena, 0, sizeof(*arena));
+}
+
+void* gpuArenaAlloc(gpu_arena* arena, u32 size, u32 align)
+{
+    //The base is at least 0x80 aligned, so aligning the offset is enough
+    u32 offset = (arena->offset + align - 1) & ~(align - 1);
+    if(!arena->base || offset > arena->size || size > arena->size - offset)
+    {
+        arena->failures++;
+        return NULL;
+    }
+    arena->offset = offset + size;
+    if(arena->offset > arena->peak)arena->peak = arena->offset;
+    arena->allocations++;
+    return arena->base + offset;
+}
+
+void gpuArenaRelease(gpu_arena* arena, u32 mark)
+{
+    if(mark < arena->offset)arena->offset = mark;
+}
+
+void gpuArenaResetStats(gpu_arena* arena)
+{
+    arena->peak = arena->offset;
+    arena->allocations = 0;
+    arena->failures = 0;
+}
+
+bool gpuPoolInit(gpu_pool* pool, gpu_arena* arena, u32 blockSize, u32 align, u32 count)
+{
+    u32 i;
+    memset(pool, 0, sizeof(*pool));
+    if(blockSize < sizeof(void*))blockSize = sizeof(void*);
+    if(align < sizeof(void*))align = sizeof(void*);
+    blockSize = (blockSize + align - 1) & ~(align - 1);
+
+    pool->base = gpuArenaAlloc(arena, blockSize * count, align);
+    if(!pool->base)return false;
+    pool->blockSize = blockSize;
+    pool->count = count;
+    //Chain the blocks in address order
+    for(i = count; i-- > 0;)
+    {
+        void* block = pool->base + i * blockSize;
+        *(void**)block = pool->freeList;
+        pool->freeList = block;
+    }
+    return true;
+}
+
+void* gpuPoolAlloc(gpu_pool* pool)
+{
+    void* block = pool->freeList;
+    if(!block)
+    {
+        pool->failures++;
+        return NULL;
+    }
+    pool->freeList = *(void**)block;
+    if(++pool->used > pool->peak)pool->peak = pool->used;
+    return block;
+}
+
+void gpuPoolFree(gpu_pool* pool, void* block)
+{
+    if(!block)return;
+    *(void**)block = pool->freeList;
+    pool->freeList = block;
+    pool->used--;
+}
+
+void gpuArenaPrint(FILE* f, const char* name, const gpu_arena* arena)
+{
+    //In KB, to fit the bottom screen console
+    fprintf(f, "%-8s %4lu/%4luK peak %4luK n=%lu", name, (unsigned long)(arena->offset + 1023) / 1024,
+            (unsigned long)arena->size / 1024, (unsigned long)(arena->peak + 1023) / 1024, (unsigned long)arena->allocations);
+    if(arena->failures)fprintf(f, ", %lu failed", (unsigned long)arena->failures);
+    fprintf(f, "\n");
+}
+
+void gpuPoolPrint(FILE* f, const char* name, const gpu_pool* pool)
+{
+    fprintf(f, "%-8s %4lu/%4lu of %luB peak %lu", name, (unsigned long)pool->used, (unsigned long)pool->count,
+            (unsigned long)pool->blockSize, (unsigned long)pool->peak);
+    if(pool->failures)fprintf(f, ", %lu failed", (unsigned long)pool->failures);
+    fprintf(f, "\n");
+}
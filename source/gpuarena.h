@@ -0,0 +1,78 @@
+/**
+ *@file gpuarena.h
+ *@author Lectem
+ *@date 17/10/2026
+ *
+ * Allocators over a single linear heap block, instead of one linearAlloc (a heap operation) per buffer.
+ *
+ * An arena only allocates by moving an offset forward, and frees everything at once (gpuArenaReset) or everything
+ * after a mark (gpuArenaRelease). A pool hands out blocks of a fixed size (eg. all the 8x8 RGBA8 textures of a test)
+ * that can be freed in any order, without fragmenting the heap.
+ *
+ * gpuframework.c owns gpuArena, from which the command buffers are allocated, and a transient arena per command
+ * buffer: gpuFrameAlloc() memory lives until the frame that allocated it has been rendered.
+ */
+#pragma once
+
+#include <3ds.h>
+#include <stdio.h>
+
+typedef struct {
+    u8* base;
+    u32 size;
+    u32 offset;
+    u32 peak;           ///< Highest offset since the last gpuArenaResetStats
+    u32 allocations;    ///< Since the last gpuArenaResetStats
+    u32 failures;       ///< Allocations that didn't fit
+    bool owned;         ///< base comes from linearMemAlign, see gpuArenaFree
+} gpu_arena;
+
+typedef struct {
+    u8* base;
+    u32 blockSize;
+    u32 count;
+    void* freeList;     ///< Each free block starts with a pointer to the next one
+    u32 used, peak;
+    u32 failures;
+} gpu_pool;
+
+/**
+* Allocates the arena memory on the linear heap, aligned to 0x80 (enough for textures).
+*/
+bool gpuArenaInit(gpu_arena* arena, u32 size);
+/**
+* Makes an arena over memory owned by someone else, usually taken from another arena.
+*/
+void gpuArenaInitFrom(gpu_arena* arena, void* mem, u32 size);
+/**
+* Carves a sub-arena out of parent.
+*/
+bool gpuArenaInitSub(gpu_arena* arena, gpu_arena* parent, u32 size);
+void gpuArenaFree(gpu_arena* arena);
+
+/**
+* @param align Power of 2
+* @return NULL if it doesn't fit
+*/
+void* gpuArenaAlloc(gpu_arena* arena, u32 size, u32 align);
+/**
+* Everything allocated after gpuArenaMark() is freed by gpuArenaRelease().
+*/
+static inline u32 gpuArenaMark(const gpu_arena* arena) { return arena->offset; }
+void gpuArenaRelease(gpu_arena* arena, u32 mark);
+static inline void gpuArenaReset(gpu_arena* arena) { gpuArenaRelease(arena, 0); }
+void gpuArenaResetStats(gpu_arena* arena);
+
+/**
+* Takes count blocks of blockSize bytes from the arena.
+* @param align Power of 2, blockSize is rounded up to it
+*/
+bool gpuPoolInit(gpu_pool* pool, gpu_arena* arena, u32 blockSize, u32 align, u32 count);
+void* gpuPoolAlloc(gpu_pool* pool);
+void gpuPoolFree(gpu_pool* pool, void* block);
+
+/**
+* One line per allocator: used/size, peak and number of allocations (or blocks).
+*/
+void gpuArenaPrint(FILE* f, const char* name, const gpu_arena* arena);
+void gpuPoolPrint(FILE* f, const char* name, const gpu_pool* pool);
@@ -5,10 +5,14 @@
  */
 #include "gpuframework.h"
 #include <3ds.h>
+#include <string.h>
+#include <stdlib.h>
 
-#include "shader_vsh_shbin.h"
 #include "3dutils.h"
 #include "mmath.h"
+#include "gpustateblock.h"
+#include "gputiming.h"
+#include "gputarget.h"
 
 void _my_assert(char * text)
 {
@@ -25,21 +29,130 @@ void _my_assert(char * text)
 
 
 
-#define GPU_CMD_SIZE 0x40000
-
 //GPU framebuffer address
 u32*gpuColorBuffer =(u32*)0x1F119400;
 //GPU depth buffer address
 u32* gpuDBuffer =(u32*)0x1F370800;
+//Right eye buffers, in the VRAM of rightEye
+u32* gpuRightColorBuffer = NULL;
+u32* gpuRightDBuffer = NULL;
 
-//GPU command buffers
+//GPU command buffers, gpuCmd is the one being recorded while the GPU may still be running the previous one
 u32* gpuCmd = NULL;
+static u32* gpuCmdBuffers[GPU_CMD_BUFFERS];
+static u32 gpuCmdCurrent = 0;
+static u32 frameNumber = 0;
+
+//The frame submitted to the GPU and not completed yet, see completeFrame
+static bool frameInFlight = false;
+static gpu_frame_done_callback inFlightDone = NULL;
+static void* inFlightDoneData = NULL;
+//Set for the frame being recorded
+static gpu_frame_done_callback frameDone = NULL;
+static void* frameDoneData = NULL;
 
-//shader structure
-DVLB_s* shader_dvlb;    //the header
-shaderProgram_s shader; //the program
+//Clears: the buffers the frame being recorded wants cleared, and what was drawn to each buffer
+#define FB_TILES_X (GPU_FB_WIDTH / 8)
+#define FB_TILE_ROWS (GPU_FB_HEIGHT / 8)
+enum { DIRTY_COLOR, DIRTY_DEPTH, DIRTY_BUFFERS };
+typedef struct {
+    u8 x0[FB_TILE_ROWS], x1[FB_TILE_ROWS];  //Tiles [x0;x1[ of each row of tiles in memory, empty if x0 >= x1
+} dirty_rows;
+typedef struct {
+    u32 start, end;                         //In words
+} fill_range;
+static u32 clearRequested = 0;
+static dirty_rows dirty[DIRTY_BUFFERS];         //Since the last clear of each buffer
+static dirty_rows frameDirty[DIRTY_BUFFERS];    //By the frame being recorded
+static u32 frameMarked = 0;                     //Buffers the frame being recorded called gpuMarkDirty for
+static u32 cleanColor = 0;                      //What the parts of the color buffer that aren't dirty hold
+static gpu_clear_stats clearStats, lastClearStats;
 
+//Presentation: rows of tiles of the color buffer changed by the frame being submitted and by the one in flight,
+//and since each screen buffer was last shown. Bit n is row n in memory, like the rows of dirty_rows.
+static gpu_present_mode presentMode = GPU_PRESENT_ALWAYS;
+static u32 presentInterval = 1;
+static u32 completedFrames = 0;
+static u64 frameChangedRows = 0;
+static u64 inFlightChangedRows = 0;
+static u64 screenDirtyRows[2];
+static u32 screenBuffer = 0;
+#define ALL_TILE_ROWS ((1ull << FB_TILE_ROWS) - 1)
 
+static void dirtyNone(dirty_rows* d)
+{
+    memset(d->x0, FB_TILES_X, FB_TILE_ROWS);
+    memset(d->x1, 0, FB_TILE_ROWS);
+}
+
+static void dirtyAll(dirty_rows* d)
+{
+    memset(d->x0, 0, FB_TILE_ROWS);
+    memset(d->x1, FB_TILES_X, FB_TILE_ROWS);
+}
+
+static u64 dirtyRowMask(const dirty_rows* d)
+{
+    u64 mask = 0;
+    u32 row;
+    for(row = 0; row < FB_TILE_ROWS; ++row)
+    {
+        if(d->x0[row] < d->x1[row])mask |= 1ull << row;
+    }
+    return mask;
+}
+
+static void dirtyAdd(dirty_rows* d, u32 x0, u32 y0, u32 x1, u32 y1)
+{
+    u32 row;
+    for(row = y0; row < y1; ++row)
+    {
+        if(d->x0[row] >= d->x1[row])
+        {
+            d->x0[row] = x0;
+            d->x1[row] = x1;
+            continue;
+        }
+        if(x0 < d->x0[row])d->x0[row] = x0;
+        if(x1 > d->x1[row])d->x1[row] = x1;
+    }
+}
+
+//Stereo: the right eye buffers, and the depth of the frames being recorded
+static gpu_target rightEye;
+static float stereoParallax = 0.0f, stereoScreenZ = 0.0f;
+//The frame being recorded started in stereo, the projection register then and where shader switches moved it
+static bool frameStereo = false;
+static s32 frameProjRegister = -1;
+typedef struct {
+    u32 offset;                             //In words, from the start of gpuCmd
+    s32 reg;
+} proj_move;
+static proj_move projMoves[GPU_STEREO_MAX_PROJ_MOVES];
+static u32 numProjMoves = 0;
+//The list being submitted has the right eye, and so did the frame in flight and the last one presented
+static bool frameRightEye = false;
+static bool inFlightRightEye = false;
+static bool shownRightEye = false;
+
+//Timestamps for gputiming
+static u64 recordStartTick = 0;
+static u64 kickTick = 0;
+static u64 lastSubmitTick = 0;
+
+//The render thread only notices the P3D interrupt once it is done recording the next frame,
+//so a thread above it waits for the interrupt and timestamps it
+#define P3D_WATCH_STACK_SIZE 0x1000
+static Handle p3dThread = 0;
+static Handle p3dKicked = 0;
+static Handle p3dDone = 0;
+static u32* p3dStack = NULL;
+static bool p3dQuit = false;
+static u64 p3dTick = 0;
+
+//The program of gpuUIInit, and where the current one wants the projection
+static gpu_shader_program* defaultShader = NULL;
+static s32 projUniformId = -1;
 Result projUniformRegister      =-1;
 Result modelviewUniformRegister =-1;
 
@@ -47,11 +160,227 @@ Result modelviewUniformRegister =-1;
 //The color used to clear the screen
 u32 clearColor=0;//RGBA8(0xFF, 0x00, 0x80, 0xFF);
 
-//The projection matrix
+//The projection matrix, and the one of gpuSetProjectionRegion to move it to the register of another program
 static float ortho_matrix[4*4];
+static float projMatrix[4*4];
+gpu_uniform_block gpuVertexUniforms;
 
+gpu_arena gpuArena;
+//One per command buffer, reset when the buffer is reused
+static gpu_arena frameArenas[GPU_CMD_BUFFERS];
 
-void gpuDisableEverything()
+//Called with every finalized command list, see gpuSetSubmitCallback
+static gpu_submit_callback submitCallback = NULL;
+
+//What gpuDisableEverything writes, recorded once by gpuUIInit
+static gpu_state_block defaultState;
+
+//Shadow of the PICA registers, see gpuSetRedundantWriteFilter
+#define SHADOW_REGS 0x300
+static bool filterEnabled = true;
+static u32 shadowRegs[SHADOW_REGS];
+static u8 shadowKnown[SHADOW_REGS];     //Bytes of shadowRegs that hold the register value, same bits as the write mask
+static u8 stateRegs[SHADOW_REGS / 8];   //Registers that only hold state, so that writing the same value again does nothing
+static gpu_filter_stats filterStats;
+
+
+/**
+* Registers without side effects, from http://3dbrew.org/wiki/GPU/Internal_Registers
+* Left out: the triggers (draw, flushes, FINALIZE...), the data ports (uniforms, shader code, LUTs...)
+* and their index registers, the command buffer jumps, and 0x080 which also clears the texture cache.
+*/
+static const u16 stateRegRanges[][2] = {
+        {0x040, 0x04E}, //Culling, viewport, clipping, depth map
+        {0x04F, 0x056}, //Shader output map
+        {0x061, 0x062}, //Early depth
+        {0x064, 0x06F}, //Scissor, viewport position, render buffer dimensions
+        {0x081, 0x0AE}, //Texture units
+        {0x0B8, 0x0E5}, //TEV stages, gas, fog color
+        {0x0F0, 0x0FF}, //TEV stages 4 and 5, combiner buffer color
+        {0x100, 0x107}, //Blending, logic op, alpha/stencil/depth tests
+        {0x112, 0x11E}, //Framebuffer access and location
+        {0x140, 0x1C4}, //Lighting
+        {0x1D0, 0x1D9}, //Lighting
+        {0x200, 0x22A}, //Attribute and index buffers, vertex count
+        {0x242, 0x242},
+        {0x25E, 0x25E}, //Primitive config
+        {0x280, 0x28D}, //Geometry shader config
+        {0x2B0, 0x2BD}, //Vertex shader config
+};
+
+static bool isStateReg(u32 reg)
+{
+    return reg < SHADOW_REGS && (stateRegs[reg >> 3] & (1 << (reg & 7)));
+}
+
+void gpuInvalidateState()
+{
+    memset(shadowKnown, 0, sizeof(shadowKnown));
+    gpuShaderInvalidate();
+}
+
+void gpuSetRedundantWriteFilter(bool enable)
+{
+    u32 i, reg;
+    if(enable && !filterEnabled)gpuInvalidateState();
+    filterEnabled = enable;
+    if(stateRegs[0x040 >> 3])return;
+    for(i = 0; i < sizeof(stateRegRanges) / sizeof(stateRegRanges[0]); ++i)
+    {
+        for(reg = stateRegRanges[i][0]; reg <= stateRegRanges[i][1]; ++reg)stateRegs[reg >> 3] |= 1 << (reg & 7);
+    }
+}
+
+const gpu_filter_stats* gpuGetFilterStats()
+{
+    return &filterStats;
+}
+
+/**
+* Updates the shadow of a state register.
+* @return false if the write changes nothing.
+*/
+static bool shadowWrite(u32 reg, u32 mask, u32 value)
+{
+    u32 bytes = ((mask & 1) ? 0xFF : 0) | ((mask & 2) ? 0xFF00 : 0) | ((mask & 4) ? 0xFF0000 : 0) | ((mask & 8) ? 0xFF000000 : 0);
+    if((shadowKnown[reg] & mask) == mask && ((shadowRegs[reg] ^ value) & bytes) == 0)return false;
+    shadowRegs[reg] = (shadowRegs[reg] & ~bytes) | (value & bytes);
+    shadowKnown[reg] |= mask;
+    return true;
+}
+
+//The burst being built by filterCommands
+static u32 burstParams[0x800];
+static u32 burstReg, burstMask, burstCount;
+
+static u32 commandWords(u32 count)
+{
+    return 2 + (count - 1) + ((count - 1) & 1);
+}
+
+static u32 flushBurst(u32* out)
+{
+    u32 i, words;
+    if(!burstCount)return 0;
+    out[0] = burstParams[0];
+    out[1] = burstReg | (burstMask << 16) | ((burstCount - 1) << 20) | (burstCount > 1 ? 0x80000000 : 0);
+    for(i = 1; i < burstCount; ++i)out[1 + i] = burstParams[i];
+    if((burstCount - 1) & 1)out[1 + burstCount] = 0;
+    words = commandWords(burstCount);
+    burstCount = 0;
+    filterStats.commands++;
+    return words;
+}
+
+/**
+* Appends consecutive register writes to the burst, or starts a new burst with them.
+*/
+static u32 addToBurst(u32* out, u32 reg, u32 mask, const u32* params, u32 count)
+{
+    u32 written = 0;
+    if(!burstCount || mask != 0xF || burstMask != 0xF || reg != burstReg + burstCount || burstCount + count > 0x800)
+    {
+        written = flushBurst(out);
+        burstReg = reg;
+        burstMask = mask;
+    }
+    else filterStats.mergedCommands++;
+    memcpy(&burstParams[burstCount], params, count * sizeof(u32));
+    burstCount += count;
+    return written;
+}
+
+/**
+* Drops the writes of a command list that don't change the value of a state register, and merges writes to
+* consecutive registers into incremental writes. The list is rewritten in place, it never grows.
+* @return The new size of the list
+*/
+static u32 filterCommands(u32* cmds, u32 size)
+{
+    static u32 params[0x800];
+    static u32 runs[0x800][2];
+    u32 in = 0, out = 0, k;
+    burstCount = 0;
+
+    while(in + 1 < size)
+    {
+        u32 header = cmds[in + 1];
+        u32 reg = header & 0xFFFF;
+        u32 mask = (header >> 16) & 0xF;
+        u32 count = ((header >> 20) & 0x7FF) + 1;
+        bool incremental = header >> 31;
+        u32 words = commandWords(count);
+        bool state = true;
+        if(in + words > size)break;
+
+        params[0] = cmds[in];
+        memcpy(&params[1], &cmds[in + 2], (count - 1) * sizeof(u32));
+        in += words;
+        filterStats.inputCommands++;
+        for(k = 0; k < count && state; ++k)state = isStateReg(incremental ? reg + k : reg);
+
+        if(!state || (!incremental && count > 1))
+        {
+            //Keep it as is, but still track what it writes
+            for(k = 0; k < count; ++k)
+            {
+                u32 r = incremental ? reg + k : reg;
+                if(isStateReg(r))shadowWrite(r, mask, params[k]);
+            }
+            out += flushBurst(&cmds[out]);
+            memmove(&cmds[out], &cmds[in - words], words * sizeof(u32));
+            out += words;
+            filterStats.commands++;
+            continue;
+        }
+
+        //Keep the runs of changed registers, a single unchanged register between two runs costs less than a new command
+        u32 runStart = 0, runEnd = 0, cost = 0, numRuns = 0;
+        for(k = 0; k < count; ++k)
+        {
+            if(!shadowWrite(reg + k, mask, params[k]))
+            {
+                filterStats.droppedWrites++;
+                continue;
+            }
+            if(numRuns && k <= runEnd + 1)
+            {
+                if(k == runEnd + 1)filterStats.droppedWrites--;
+                runEnd = k + 1;
+                runs[numRuns - 1][1] = runEnd;
+                continue;
+            }
+            runStart = k;
+            runEnd = k + 1;
+            runs[numRuns][0] = runStart;
+            runs[numRuns][1] = runEnd;
+            numRuns++;
+        }
+        for(k = 0; k < numRuns; ++k)cost += commandWords(runs[k][1] - runs[k][0]);
+        if(cost > words)
+        {
+            numRuns = 1;
+            runs[0][0] = 0;
+            runs[0][1] = count;
+        }
+        for(k = 0; k < numRuns; ++k)
+        {
+            out += addToBurst(&cmds[out], reg + runs[k][0], mask, &params[runs[k][0]], runs[k][1] - runs[k][0]);
+        }
+    }
+    out += flushBurst(&cmds[out]);
+
+    //The list size must stay a multiple of 16 bytes, pad it with another FINALIZE like GPUCMD_Finalize does
+    if(out & 3)
+    {
+        cmds[out] = 0x12345678;
+        cmds[out + 1] = GPUREG_FINALIZE | (0xF << 16);
+        out += 2;
+    }
+    return out;
+}
+
+static void setDefaultState()
 {
 
     GPU_SetFaceCulling(GPU_CULL_NONE);
@@ -82,47 +411,172 @@ void gpuDisableEverything()
     GPU_SetDummyTexEnv(5);
 }
 
+void gpuDisableEverything()
+{
+    if(!defaultState.cmds || !gpuStateBlockAppend(&defaultState))setDefaultState();
+}
+
+void gpuSetProjectionRegion(float x, float y, float w, float h)
+{
+    //The bounds of the drawing space that put its [0;400]x[0;240] at (x, y, w, h)
+    float m[4*4];
+    if(projUniformRegister < 0 || w <= 0.0f || h <= 0.0f)return;
+    initOrthographicMatrix(m, -x * GPU_UI_WIDTH / w, (GPU_UI_WIDTH - x) * GPU_UI_WIDTH / w,
+                           -y * GPU_UI_HEIGHT / h, (GPU_UI_HEIGHT - y) * GPU_UI_HEIGHT / h, 0.0f, 1.0f);
+    memcpy(projMatrix, m, sizeof(m));
+    gpuUniformSetMatrix(&gpuVertexUniforms, projUniformRegister, m);
+}
+
+bool gpuSetShader(gpu_shader_program* program)
+{
+    s32 reg;
+    u32 i;
+    if(!program)program = defaultShader;
+    if(program == gpuShaderCurrent())return true;
+    reg = gpuShaderUniformReg(program, GPU_VERTEX_SHADER, projUniformId);
+    if(frameStereo && reg >= 0 && reg != projUniformRegister)
+    {
+        //The eyes are patched where the projection is, from before the .constf of the program
+        u32 offset;
+        GPUCMD_GetBuffer(NULL, NULL, &offset);
+        if(numProjMoves < GPU_STEREO_MAX_PROJ_MOVES)
+        {
+            projMoves[numProjMoves].offset = offset;
+            projMoves[numProjMoves].reg = reg;
+        }
+        numProjMoves++;
+    }
+    if(!gpuShaderUse(program))return false;
+    //Its .constf overwrote these registers, send our values again if we had some there
+    for(i = 0; i < GPU_FLOAT_UNIFORMS / 32; ++i)gpuVertexUniforms.dirty[i] |= program->constRegs[i] & gpuVertexUniforms.valid[i];
+    if(reg >= 0 && reg != projUniformRegister)
+    {
+        projUniformRegister = reg;
+        gpuUniformSetMatrix(&gpuVertexUniforms, projUniformRegister, projMatrix);
+    }
+    return true;
+}
+
+
+static void p3dWatchThread(u32 arg)
+{
+    for(;;)
+    {
+        svcWaitSynchronization(p3dKicked, U64_MAX);
+        if(__atomic_load_n(&p3dQuit, __ATOMIC_ACQUIRE))break;
+        gspWaitForP3D();
+        __atomic_store_n(&p3dTick, svcGetSystemTick(), __ATOMIC_RELEASE);
+        svcSignalEvent(p3dDone);
+    }
+    svcExitThread();
+}
+
+/**
+* Starts the thread timestamping the P3D interrupts. Without it, completeFrame waits for them itself
+* and there is no GPU_PHASE_P3D sample.
+*/
+static void p3dWatchStart()
+{
+    s32 priority = 0x30;
+    p3dQuit = false;
+    p3dStack = malloc(P3D_WATCH_STACK_SIZE);
+    if(!p3dStack || svcCreateEvent(&p3dKicked, 0) || svcCreateEvent(&p3dDone, 0))goto fail;
+    //Above the render thread, so that it wakes up as soon as the interrupt is signaled
+    svcGetThreadPriority(&priority, CUR_THREAD_HANDLE);
+    if(priority > 0x18)priority--;
+    if(svcCreateThread(&p3dThread, p3dWatchThread, 0, p3dStack + P3D_WATCH_STACK_SIZE / 4, priority, -2))
+    {
+        p3dThread = 0;
+        goto fail;
+    }
+    return;
+
+fail:
+    if(p3dKicked)svcCloseHandle(p3dKicked);
+    if(p3dDone)svcCloseHandle(p3dDone);
+    free(p3dStack);
+    p3dKicked = p3dDone = 0;
+    p3dStack = NULL;
+}
+
+static void p3dWatchStop()
+{
+    if(!p3dThread)return;
+    __atomic_store_n(&p3dQuit, true, __ATOMIC_RELEASE);
+    svcSignalEvent(p3dKicked);
+    svcWaitSynchronization(p3dThread, U64_MAX);
+    svcCloseHandle(p3dThread);
+    svcCloseHandle(p3dKicked);
+    svcCloseHandle(p3dDone);
+    free(p3dStack);
+    p3dThread = p3dKicked = p3dDone = 0;
+    p3dStack = NULL;
+}
 
 void gpuUIInit()
 {
 
     GPU_Init(NULL);//initialize GPU
+    //Nothing is known about the registers yet
+    gpuSetRedundantWriteFilter(filterEnabled);
+    gpuInvalidateState();
 
-    gfxSet3D(false);//We will not be using the 3D mode in this example
-    Result res=0;
+    gfxSet3D(false);//Until gpuSetStereo
 
-    /**
-    * Load our vertex shader and its uniforms
-    * Check http://3dbrew.org/wiki/SHBIN for more informations about the shader binaries
-    */
-    shader_dvlb = DVLB_ParseFile((u32 *)shader_vsh_shbin, shader_vsh_shbin_size);//load our vertex shader binary
-    my_assert(shader_dvlb != NULL);
-    shaderProgramInit(&shader);
-    res = shaderProgramSetVsh(&shader, &shader_dvlb->DVLE[0]);
-    my_assert(res >=0); // check for errors
-
-    //In this example we are only rendering in "2D mode", so we don't need one command buffer per eye
-    gpuCmd=(u32*)linearAlloc(GPU_CMD_SIZE * (sizeof *gpuCmd) ); //Don't forget that commands size is 4 (hence the sizeof)
-    my_assert(gpuCmd != NULL);
+    //Even in stereo both eyes go in the same command list, so we don't need one command buffer per eye
+    //But we want one to record while the GPU runs the other
+    //A single linear heap block for all of them, and what the tests allocate through gpuArena
+    my_assert(gpuArenaInit(&gpuArena, GPU_ARENA_SIZE));
+    int i;
+    for(i = 0; i < GPU_CMD_BUFFERS; ++i)
+    {
+        gpuCmdBuffers[i]=(u32*)gpuArenaAlloc(&gpuArena, GPU_CMD_SIZE * (sizeof *gpuCmd), 0x10); //Don't forget that commands size is 4 (hence the sizeof)
+        my_assert(gpuCmdBuffers[i] != NULL);
+        my_assert(gpuArenaInitSub(&frameArenas[i], &gpuArena, GPU_FRAME_ARENA_SIZE));
+    }
+    gpuCmdCurrent = 0;
+    gpuCmd = gpuCmdBuffers[0];
 
     //Reset the gpu
     //This actually needs a command buffer to work, and will then use it as default
     GPU_Reset(NULL, gpuCmd, GPU_CMD_SIZE);
 
-    projUniformRegister = shaderInstanceGetUniformLocation(shader.vertexShader, "projection");
-    my_assert(projUniformRegister != -1); // make sure we did get the uniform
-
+    if(gpuStateBlockBegin(&defaultState, 0x100))
+    {
+        setDefaultState();
+        if(!gpuStateBlockEnd(&defaultState))gpuStateBlockFree(&defaultState);
+    }
 
-    shaderProgramUse(&shader); // Select the shader to use
+    /**
+    * Load every shader of data/ and their uniforms, see gpushader.h
+    * Check http://3dbrew.org/wiki/SHBIN for more informations about the shader binaries
+    */
+    my_assert(gpuShaderInit());
+    defaultShader = gpuShaderFind("shader");
+    my_assert(defaultShader != NULL);
+    projUniformId = gpuShaderUniformId("projection");
+    projUniformRegister = gpuShaderUniformReg(defaultShader, GPU_VERTEX_SHADER, projUniformId);
+    my_assert(projUniformRegister != -1); // make sure we did get the uniform
 
     initOrthographicMatrix(ortho_matrix, 0.0f, 400.0f, 0.0f, 240.0f, 0.0f, 1.0f); // A basic projection for 2D drawings
-    SetUniformMatrix(projUniformRegister, ortho_matrix); // Upload the matrix to the GPU
+    memcpy(projMatrix, ortho_matrix, sizeof(projMatrix));
+    gpuUniformBlockInit(&gpuVertexUniforms, GPU_VERTEX_SHADER);
+    gpuUniformSetMatrix(&gpuVertexUniforms, projUniformRegister, ortho_matrix);
+    gpuSetShader(defaultShader); // Select the shader to use
+    gpuUniformBlockUpload(&gpuVertexUniforms); // Upload the matrix to the GPU
 
     GPU_DepthMap(-1.0f, 0.0f);  //Be careful, standard OpenGL clipping is [-1;1], but it is [-1;0] on the pica200
     // Note : this is corrected by our projection matrix !
 
     gpuDisableEverything();
 
+    //Nothing is known about the buffers either
+    dirtyAll(&dirty[DIRTY_COLOR]);
+    dirty[DIRTY_DEPTH] = dirty[DIRTY_COLOR];
+    cleanColor = clearColor;
+    screenDirtyRows[0] = screenDirtyRows[1] = ALL_TILE_ROWS;
+
+    p3dWatchStart();
     //Flush buffers and setup the environment for the next frame
     gpuEndFrame();
 
@@ -131,53 +585,546 @@ void gpuUIInit()
 void gpuUIExit()
 {
     //do things properly
-    linearFree(gpuCmd);
-    shaderProgramFree(&shader);
-    DVLB_Free(shader_dvlb);
+    gpuSetStereo(false);
+    gpuWaitIdle();
+    p3dWatchStop();
+    gpuStateBlockFree(&defaultState);
     GPU_Reset(NULL, gpuCmd, GPU_CMD_SIZE); // Not really needed, but safer for the next applications ?
+    int i;
+    for(i = 0; i < GPU_CMD_BUFFERS; ++i)
+    {
+        gpuCmdBuffers[i] = NULL;
+        frameArenas[i].base = NULL;
+    }
+    gpuCmd = NULL;
+    gpuArenaFree(&gpuArena);
+    gpuShaderExit();
+    defaultShader = NULL;
 }
 
 void gpuStartFrame()
 {
 
-    //Get ready to start a new frame
-    GPUCMD_SetBufferOffset(0);
+    recordStartTick = svcGetSystemTick();
+    //Get ready to start a new frame, in the buffer the GPU isn't reading
+    gpuCmdCurrent = (gpuCmdCurrent + 1) % GPU_CMD_BUFFERS;
+    frameNumber++;
+    gpuCmd = gpuCmdBuffers[gpuCmdCurrent];
+    GPUCMD_SetBuffer(gpuCmd, GPU_CMD_SIZE, 0);
+    //The frame that last used this buffer was completed by the last gpuSubmitFrame
+    gpuArenaReset(&frameArenas[gpuCmdCurrent]);
+
+    //Draw to the framebuffer
+    gpuSetTarget(NULL);
 
-    //Viewport (http://3dbrew.org/wiki/GPU_Commands#Command_0x0041)
-    GPU_SetViewport((u32 *)osConvertVirtToPhys((u32)gpuDBuffer),
-                    (u32 *)osConvertVirtToPhys((u32) gpuColorBuffer),
-                    0, 0,
-            //Our screen is 400*240, but the GPU actually renders to 400*480 and then downscales it SetDisplayTransfer bit 24 is set
-            //This is the case here (See http://3dbrew.org/wiki/GPU#0x1EF00C10 for more details)
-                    240*2, 400);
+    //Each eye starts with its own projection, the GPU still has the one of the right eye of the previous frame
+    frameStereo = gpuRightColorBuffer != NULL;
+    frameProjRegister = projUniformRegister;
+    numProjMoves = 0;
+    if(frameStereo && projUniformRegister >= 0)
+        GPU_SetFloatUniform(GPU_VERTEX_SHADER, projUniformRegister, (u32*)gpuUniformGetRegs(&gpuVertexUniforms, projUniformRegister), 4);
 
-    //Clear the screen
-    GX_SetMemoryFill(NULL, gpuColorBuffer, clearColor, &gpuColorBuffer[0x2EE00],
-                     0x201, gpuDBuffer, 0x00000000, &gpuDBuffer[0x2EE00], 0x201);
-    gspWaitForPSC0();
+    frameMarked = 0;
+    gpuClearBuffers(GPU_CLEAR_ALL);
+}
+
+u32 gpuFrameNumber()
+{
+    return frameNumber;
+}
 
+void* gpuFrameAlloc(u32 size, u32 align)
+{
+    return gpuArenaAlloc(&frameArenas[gpuCmdCurrent], size, align);
+}
+
+void gpuPrintArenas(FILE* f)
+{
+    int i;
+    gpuArenaPrint(f, "linear", &gpuArena);
+    for(i = 0; i < GPU_CMD_BUFFERS; ++i)
+    {
+        char name[16];
+        sprintf(name, "frame%d", i);
+        gpuArenaPrint(f, name, &frameArenas[i]);
+    }
+}
+
+void gpuClearBuffers(u32 buffers)
+{
+    //The buffers may still be in use by the previous frame, so this is done by gpuSubmitFrame
+    clearRequested = buffers & GPU_CLEAR_ALL;
+}
+
+void gpuMarkDirty(u32 buffers, u16 x, u16 y, u16 w, u16 h)
+{
+    s32 top = y, bottom = y + h;
+    u32 x0, y0, x1, y1;
+    int b;
+    if(frameStereo && stereoParallax != 0.0f)
+    {
+        //Each eye moves the points of depth 0 to 1 by up to half the parallax of the depth farthest from the screen
+        float front = stereoScreenZ < 0.0f ? -stereoScreenZ : stereoScreenZ;
+        float back = stereoScreenZ > 1.0f ? stereoScreenZ - 1.0f : 1.0f - stereoScreenZ;
+        float parallax = stereoParallax < 0.0f ? -stereoParallax : stereoParallax;
+        s32 margin = (s32)((front > back ? front : back) * parallax / 2.0f) + 1;
+        top = top > margin ? top - margin : 0;
+        bottom += margin;
+    }
+    //Same mapping as gpuReadColor, rounded out to whole tiles so that the edges of the triangles are in
+    x0 = (u32)x * GPU_FB_WIDTH / GPU_UI_WIDTH / 8;
+    y0 = (u32)top * GPU_FB_HEIGHT / GPU_UI_HEIGHT / 8;
+    x1 = ((u32)(x + w) * GPU_FB_WIDTH + GPU_UI_WIDTH * 8 - 1) / (GPU_UI_WIDTH * 8);
+    y1 = ((u32)bottom * GPU_FB_HEIGHT + GPU_UI_HEIGHT * 8 - 1) / (GPU_UI_HEIGHT * 8);
+    if(x1 > FB_TILES_X)x1 = FB_TILES_X;
+    if(y1 > FB_TILE_ROWS)y1 = FB_TILE_ROWS;
+    if(x0 >= x1 || y0 >= y1)return;
+    for(b = 0; b < DIRTY_BUFFERS; ++b)
+    {
+        if(!(buffers & (1 << b)))continue;
+        if(!(frameMarked & (1 << b)))
+        {
+            dirtyNone(&frameDirty[b]);
+            frameMarked |= 1 << b;
+        }
+        //The rows of tiles are kept in memory order, the bottom of the drawing space first (see GPU_FB_HEIGHT)
+        dirtyAdd(&frameDirty[b], x0, FB_TILE_ROWS - y1, x1, FB_TILE_ROWS - y0);
+    }
+}
+
+const gpu_clear_stats* gpuGetClearStats()
+{
+    return &lastClearStats;
+}
+
+/**
+* The dirty parts of a buffer as ranges of words: each row of tiles is contiguous in memory, and ranges separated by
+* less than GPU_CLEAR_MERGE_GAP tiles are merged since a fill costs more to start than to run a little longer.
+*/
+static u32 dirtyRanges(const dirty_rows* d, fill_range* out)
+{
+    u32 row, n = 0;
+    for(row = 0; row < FB_TILE_ROWS; ++row)
+    {
+        u32 start, end;
+        if(d->x0[row] >= d->x1[row])continue;
+        start = (row * FB_TILES_X + d->x0[row]) * 64;
+        end = (row * FB_TILES_X + d->x1[row]) * 64;
+        if(n && start - out[n - 1].end <= GPU_CLEAR_MERGE_GAP * 64)out[n - 1].end = end;
+        else
+        {
+            out[n].start = start;
+            out[n].end = end;
+            n++;
+        }
+    }
+    return n;
+}
+
+/**
+* Fills the dirty parts of a buffer, and of the one of the right eye in stereo, two ranges at a time (one per memory
+* fill unit), and waits for it.
+*/
+static void clearBuffer(int b)
+{
+    fill_range ranges[FB_TILE_ROWS];
+    u32* buffers[2];
+    u32 numBuffers = 1;
+    u32 value = b == DIRTY_COLOR ? clearColor : 0;
+    u32 i, count;
+    u64 start = svcGetSystemTick();
+
+    buffers[0] = b == DIRTY_COLOR ? gpuColorBuffer : gpuDBuffer;
+    //Both eyes draw the same parts of the buffers, see gpuMarkDirty
+    if(gpuRightColorBuffer)buffers[numBuffers++] = b == DIRTY_COLOR ? gpuRightColorBuffer : gpuRightDBuffer;
+    if(b == DIRTY_COLOR && clearColor != cleanColor)
+    {
+        dirtyAll(&dirty[b]);
+        cleanColor = clearColor;
+    }
+    //What gets cleared changes on screen too
+    if(b == DIRTY_COLOR)frameChangedRows |= dirtyRowMask(&dirty[b]);
+    //Fill i is range i / numBuffers of buffer i % numBuffers
+    count = dirtyRanges(&dirty[b], ranges) * numBuffers;
+    for(i = 0; i < count; i += 2)
+    {
+        const fill_range* r0 = &ranges[i / numBuffers];
+        const fill_range* r1 = i + 1 < count ? &ranges[(i + 1) / numBuffers] : NULL;
+        u32* b0 = buffers[i % numBuffers];
+        u32* b1 = buffers[(i + 1) % numBuffers];
+        u32 words = r0->end - r0->start + (r1 ? r1->end - r1->start : 0);
+        if(r1)
+        {
+            GX_SetMemoryFill(NULL, &b0[r0->start], value, &b0[r0->end], 0x201,
+                             &b1[r1->start], value, &b1[r1->end], 0x201);
+        }
+        else GX_SetMemoryFill(NULL, &b0[r0->start], value, &b0[r0->end], 0x201, NULL, 0, NULL, 0);
+        gspWaitForPSC0();
+        if(r1)gspWaitForPSC1();
+        clearStats.fills++;
+        if(b == DIRTY_COLOR)clearStats.colorWords += words;
+        else clearStats.depthWords += words;
+    }
+    dirtyNone(&dirty[b]);
+    clearRequested &= ~(1 << b);
+    gpuTimingAdd(GPU_PHASE_FILL, svcGetSystemTick() - start);
+}
+
+/**
+* Patches the commands [start;end[ of a stereo frame for one eye. Every write of the y row of the projection made while
+* drawing to the screen gets the parallax of the eye: y += eye * parallax * (screenZ - z) / 2 in the drawing space,
+* which is y_clip += eye * parallax / GPU_UI_HEIGHT * (screenZ * w_clip + z_clip) since z_clip = -z.
+* For the right eye, the addresses of the screen buffers become the ones of the right buffers.
+*/
+static void patchEye(u32* cmds, u32 start, u32 end, bool right)
+{
+    const u32 leftColor = osConvertVirtToPhys((u32)gpuColorBuffer) >> 3, leftDepth = osConvertVirtToPhys((u32)gpuDBuffer) >> 3;
+    const float shear = (right ? -stereoParallax : stereoParallax) / GPU_UI_HEIGHT;
+    float rows[4][4];           //Of the projection as written so far, register order
+    u32* yRow[4];               //Words of the y row written by the current command
+    bool yRowWritten = false, onScreen = true, f32 = true;
+    s32 projReg = frameProjRegister;
+    u32 in = start, move = 0, index = 0, word = 0, k, j;
+
+    memset(rows, 0, sizeof(rows));
+    while(in + 1 < end)
+    {
+        u32 header = cmds[in + 1];
+        u32 reg = header & 0xFFFF;
+        u32 count = ((header >> 20) & 0x7FF) + 1;
+        bool incremental = header >> 31;
+        u32 words = commandWords(count);
+        if(in + words > end)break;
+        while(move < numProjMoves && projMoves[move].offset <= in - start)projReg = projMoves[move++].reg;
+
+        for(k = 0; k < count; ++k)
+        {
+            u32* param = k ? &cmds[in + 1 + k] : &cmds[in];
+            u32 r = incremental ? reg + k : reg;
+            if(r == GPUREG_VSH_FLOATUNIFORM_CONFIG)
+            {
+                index = *param & 0xFF;
+                f32 = *param >> 31;
+                word = 0;
+            }
+            else if(r > GPUREG_VSH_FLOATUNIFORM_CONFIG && r <= GPUREG_VSH_FLOATUNIFORM_CONFIG + 8)
+            {
+                //Float24 uniforms (3 words per register) are never the projection
+                s32 row = (s32)index - projReg;
+                if(f32 && projReg >= 0 && row >= 0 && row < 4)
+                {
+                    memcpy(&rows[row][word], param, sizeof(float));
+                    if(row == 1)
+                    {
+                        yRow[word] = param;
+                        yRowWritten = word == 3;
+                    }
+                }
+                if(++word == (f32 ? 4 : 3))
+                {
+                    word = 0;
+                    index++;
+                }
+            }
+            else if(r == GPUREG_011D)
+            {
+                onScreen = *param == leftColor;
+                if(right && onScreen)*param = osConvertVirtToPhys((u32)gpuRightColorBuffer) >> 3;
+            }
+            else if(r == GPUREG_011C && right && *param == leftDepth)*param = osConvertVirtToPhys((u32)gpuRightDBuffer) >> 3;
+        }
+        //Once the whole command is seen, the depth and w rows sent with the y row are known too
+        if(yRowWritten && onScreen)
+        {
+            for(j = 0; j < 4; ++j)
+            {
+                float value = rows[1][j] + shear * (stereoScreenZ * rows[3][j] + rows[2][j]);
+                memcpy(yRow[j], &value, sizeof(float));
+            }
+        }
+        yRowWritten = false;
+        in += words;
+    }
+}
+
+/**
+* Copies the commands of the frame after themselves for the right eye, then patches each eye.
+* @return false if the frame doesn't fit twice in gpuCmd, it is left as it is
+*/
+static bool addRightEye()
+{
+    u32* cmds;
+    u32 size, end;
+    GPUCMD_GetBuffer(&cmds, &size, &end);
+    //Room for GPU_FinishDrawing and GPUCMD_Finalize after it
+    if(numProjMoves > GPU_STEREO_MAX_PROJ_MOVES || end * 2 + 0x10 > size)return false;
+    GPUCMD_AddRawCommands(cmds, end);
+    patchEye(cmds, 0, end, false);
+    patchEye(cmds, end, end * 2, true);
+    return true;
+}
+
+bool gpuSetStereo(bool enable)
+{
+    if(enable == (gpuRightColorBuffer != NULL))return true;
+    gpuWaitIdle();
+    if(enable)
+    {
+        if(!gpuTargetCreate(&rightEye, GPU_FB_WIDTH, GPU_FB_HEIGHT, GPU_TARGET_RGBA8, GPU_TARGET_D24S8, GPU_TARGET_VRAM))
+            return false;
+        gpuRightColorBuffer = rightEye.color;
+        gpuRightDBuffer = rightEye.depth;
+        //Nothing is known about the right eye buffers
+        dirtyAll(&dirty[DIRTY_COLOR]);
+        dirtyAll(&dirty[DIRTY_DEPTH]);
+    }
+    else
+    {
+        gpuTargetFree(&rightEye);
+        gpuRightColorBuffer = gpuRightDBuffer = NULL;
+        //The GPU was left with the projection of the right eye
+        if(projUniformRegister >= 0)gpuUniformTouch(&gpuVertexUniforms, projUniformRegister, 4);
+    }
+    gfxSet3D(enable);
+    screenDirtyRows[0] = screenDirtyRows[1] = ALL_TILE_ROWS;
+    return true;
+}
+
+bool gpuStereoEnabled()
+{
+    return gpuRightColorBuffer != NULL;
+}
+
+void gpuSetStereoDepth(float parallax, float screenZ)
+{
+    stereoParallax = parallax;
+    stereoScreenZ = screenZ;
+}
+
+float gpuGetStereoDepth(float* screenZ)
+{
+    if(screenZ)*screenZ = stereoScreenZ;
+    return stereoParallax;
 }
 
 void gpuEndFrame()
 {
+    //The right eye goes in the same command list, replayed from the left one
+    frameRightEye = frameStereo && gpuRightColorBuffer && addRightEye();
+    frameStereo = false;
     //Ask the GPU to draw everything (execute the commands)
     GPU_FinishDrawing();
     GPUCMD_Finalize();
-    GPUCMD_FlushAndRun(NULL);
-    gspWaitForP3D();//Wait for the gpu 3d processing to be done
-    //Copy the GPU output buffer to the screen framebuffer
+    gpuSubmitFrame();
+}
+
+void gpuSetPresentMode(gpu_present_mode mode, u32 interval)
+{
+    presentMode = mode;
+    presentInterval = interval ? interval : 1;
+}
+
+gpu_present_mode gpuGetPresentMode(u32* interval)
+{
+    if(interval)*interval = presentInterval;
+    return presentMode;
+}
+
+/**
+* The bands of rows of tiles to copy to the screen buffer for the frame being completed, as rows in memory:
+* that is the order the display transfer reads them in, so a band is a single transfer even though it is
+* upside down in the drawing space.
+* @return Their number, 0 if the frame isn't presented
+*/
+static u32 presentBands(u32 bands[][2])
+{
+    u64 rows;
+    u32 row, n = 0;
+    completedFrames++;
+    switch(presentMode)
+    {
+        case GPU_PRESENT_HEADLESS: return 0;
+        case GPU_PRESENT_THROTTLED: rows = completedFrames % presentInterval ? 0 : ALL_TILE_ROWS; break;
+        case GPU_PRESENT_DIRTY: rows = screenDirtyRows[screenBuffer]; break;
+        default: rows = ALL_TILE_ROWS; break;
+    }
+    for(row = 0; row < FB_TILE_ROWS; ++row)
+    {
+        if(!(rows >> row & 1))continue;
+        if(n && row - bands[n - 1][1] <= GPU_PRESENT_MERGE_ROWS)bands[n - 1][1] = row + 1;
+        else
+        {
+            bands[n][0] = row;
+            bands[n][1] = row + 1;
+            n++;
+        }
+    }
+    return n;
+}
+
+/**
+* Copies rows [row0;row1[ of tiles of a color buffer to the screen buffer of an eye, row0 being the row in memory
+* (see GPU_FB_HEIGHT). They are contiguous in both buffers: the color buffer is tiled by rows of 8x8 tiles, and a
+* row of the color buffer is a column of the (rotated) screen, in the same order as the full copy.
+*/
+static void transferRows(u32* buffer, gfx3dSide_t side, u32 row0, u32 row1)
+{
+    u8* screen = gfxGetFramebuffer(GFX_TOP, side, NULL, NULL);
+    u32 dim = ((row1 - row0) * 8) << 16 | GPU_FB_WIDTH;
+    //The output is downscaled to 240 pixels per row, 3 bytes each
+    GX_SetDisplayTransfer(NULL, &buffer[row0 * 8 * GPU_FB_WIDTH], dim,
+                          (u32*)(screen + row0 * 8 * (GPU_FB_WIDTH / 2) * 3), dim, 0x01001000);
+}
+
+/**
+* Waits for the frame in flight to be rendered and presented.
+* @return true if there was one and it was copied to the screen
+*/
+static bool completeFrame()
+{
+    u32 bands[FB_TILE_ROWS][2];
+    u32 count, i;
+    //In stereo, the right eye is shown the left one if the frame doesn't have its own
+    u32* rightBuffer = inFlightRightEye ? gpuRightColorBuffer : gpuColorBuffer;
+    if(!frameInFlight)return false;
+    u64 t0 = svcGetSystemTick();
+    //Wait for the gpu 3d processing to be done
+    if(p3dThread)svcWaitSynchronization(p3dDone, U64_MAX);
+    else gspWaitForP3D();
+    u64 t1 = svcGetSystemTick();
+    gpuTimingAdd(GPU_PHASE_P3D_WAIT, t1 - t0);
+    //When the interrupt came, not when we got to check for it
+    if(p3dThread)gpuTimingAdd(GPU_PHASE_P3D, __atomic_load_n(&p3dTick, __ATOMIC_ACQUIRE) - kickTick);
+
+    screenDirtyRows[0] |= inFlightChangedRows;
+    screenDirtyRows[1] |= inFlightChangedRows;
+    //Going from one image for both eyes to one each changes what the right eye sees everywhere
+    if(gpuRightColorBuffer && inFlightRightEye != shownRightEye)screenDirtyRows[0] = screenDirtyRows[1] = ALL_TILE_ROWS;
+    count = presentBands(bands);
+    //Copy the GPU output buffer to the screen framebuffer, then the right eye one
     //See http://3dbrew.org/wiki/GPU#Transfer_Engine for more details about the transfer engine
+    if(count)transferRows(gpuColorBuffer, GFX_LEFT, bands[0][0], bands[0][1]);
+    //The copy only reads the color buffer, the depth buffer can be cleared meanwhile
+    if(clearRequested & GPU_CLEAR_DEPTH)clearBuffer(DIRTY_DEPTH);
+    if(count)
+    {
+        gspWaitForPPF();
+        for(i = 0; i < count; ++i)
+        {
+            if(i)
+            {
+                transferRows(gpuColorBuffer, GFX_LEFT, bands[i][0], bands[i][1]);
+                gspWaitForPPF();
+            }
+            if(!gpuRightColorBuffer)continue;
+            transferRows(rightBuffer, GFX_RIGHT, bands[i][0], bands[i][1]);
+            gspWaitForPPF();
+        }
+        gpuTimingAdd(GPU_PHASE_TRANSFER, svcGetSystemTick() - t1);
+        //The other screen buffer still shows what changed since it was last presented
+        screenDirtyRows[screenBuffer] = 0;
+        shownRightEye = inFlightRightEye;
+    }
+    frameInFlight = false;
 
-    GX_SetDisplayTransfer(NULL, gpuColorBuffer, 0x019001E0, (u32*)gfxGetFramebuffer(GFX_TOP, GFX_LEFT, NULL, NULL), 0x019001E0, 0x01001000);
-    gspWaitForPPF();
+    //Last chance to read the buffers before the next frame clears them
+    if(inFlightDone)inFlightDone(inFlightDoneData);
 
+    if(!count)return false;
     gfxSwapBuffersGpu();
+    screenBuffer ^= 1;
+    return true;
+}
+
+void gpuSubmitFrame()
+{
+    u32* cmds;
+    u32 size;
+    u64 t0 = svcGetSystemTick();
+    if(recordStartTick)gpuTimingAdd(GPU_PHASE_RECORD, t0 - recordStartTick);
+    recordStartTick = 0;
+    if(lastSubmitTick)gpuTimingAdd(GPU_PHASE_FRAME, t0 - lastSubmitTick);
+    lastSubmitTick = t0;
+
+    GPUCMD_GetBuffer(&cmds, NULL, &size);
+    if(submitCallback)submitCallback(cmds, size);
+
+    memset(&filterStats, 0, sizeof(filterStats));
+    filterStats.inputWords = size;
+    if(filterEnabled)
+    {
+        size = filterCommands(cmds, size);
+        GPUCMD_SetBufferOffset(size);
+    }
+    else filterStats.commands = filterStats.inputCommands = 0;
+    filterStats.words = size;
+    gpuTimingAdd(GPU_PHASE_SUBMIT, svcGetSystemTick() - t0);
+
+    //This frame was recorded while the GPU was busy with the previous one, which must be done before we touch the buffers
+    bool presented = completeFrame();
 
-    //Wait for the screen to be updated
-    gspWaitForVBlank();
+    //Without a frame in flight, the depth buffer wasn't cleared during the copy
+    if(clearRequested & GPU_CLEAR_DEPTH)clearBuffer(DIRTY_DEPTH);
+    if(clearRequested & GPU_CLEAR_COLOR)clearBuffer(DIRTY_COLOR);
+    gpuTargetRunClears();
+    lastClearStats = clearStats;
+    memset(&clearStats, 0, sizeof(clearStats));
+    //What this frame draws has to be cleared before the next frame that asks for it
+    int b;
+    for(b = 0; b < DIRTY_BUFFERS; ++b)
+    {
+        if(!(frameMarked & (1 << b)))
+        {
+            dirtyAll(&dirty[b]);
+            continue;
+        }
+        u32 row;
+        for(row = 0; row < FB_TILE_ROWS; ++row)
+        {
+            if(frameDirty[b].x0[row] < frameDirty[b].x1[row])
+                dirtyAdd(&dirty[b], frameDirty[b].x0[row], row, frameDirty[b].x1[row], row + 1);
+        }
+    }
+    frameChangedRows |= frameMarked & GPU_CLEAR_COLOR ? dirtyRowMask(&frameDirty[DIRTY_COLOR]) : ALL_TILE_ROWS;
+    frameMarked = 0;
+
+    kickTick = svcGetSystemTick();
+    GPUCMD_FlushAndRun(NULL);
+    if(p3dThread)svcSignalEvent(p3dKicked);
+    frameInFlight = true;
+    inFlightRightEye = frameRightEye;
+    frameRightEye = false;
+    inFlightChangedRows = frameChangedRows;
+    frameChangedRows = 0;
+    inFlightDone = frameDone;
+    inFlightDoneData = frameDoneData;
+    frameDone = NULL;
+    frameDoneData = NULL;
+
+    //Wait for the screen to be updated with the previous frame, while the GPU renders this one
+    if(presented)
+    {
+        u64 vblankStart = svcGetSystemTick();
+        gspWaitForVBlank();
+        gpuTimingAdd(GPU_PHASE_VBLANK, svcGetSystemTick() - vblankStart);
+    }
 }
 
+void gpuWaitIdle()
+{
+    completeFrame();
+}
 
+void gpuSetFrameDoneCallback(gpu_frame_done_callback callback, void* data)
+{
+    frameDone = callback;
+    frameDoneData = data;
+}
+
+void gpuSetSubmitCallback(gpu_submit_callback callback)
+{
+    submitCallback = callback;
+}
 
 
 
@@ -192,4 +1139,74 @@ void GPU_SetDummyTexEnv(u8 num)
                   GPU_REPLACE,
                   GPU_REPLACE,
                   0xFFFFFFFF);
-}
\ No newline at end of file
+}
+
+
+bool gpuDrawElements(GPU_Primitive_t primitive, const void* vertices, const void* indices, u32 count, gpu_index_type type)
+{
+    //The attribute buffers base address is 8 bytes aligned (GPU_SetAttributeBuffers takes it >> 3)
+    u32 base = osConvertVirtToPhys((u32)vertices) & ~7;
+    u32 address = osConvertVirtToPhys((u32)indices);
+    u32 offset = address - base;
+    if(address < base || offset > 0x0FFFFFFF || (type == GPU_INDEX_U16 && (address & 1)))return false;
+
+    //Same sequence as GPU_DrawElements, which only knows u16 indices
+    GPUCMD_AddMaskedWrite(GPUREG_PRIMITIVE_CONFIG, 0x2, primitive);
+    GPUCMD_AddWrite(GPUREG_RESTART_PRIMITIVE, 0x00000001);
+    GPUCMD_AddWrite(GPUREG_INDEXBUFFER_CONFIG, (type == GPU_INDEX_U16 ? 0x80000000 : 0) | offset);
+    GPUCMD_AddWrite(GPUREG_NUMVERTICES, count);
+    GPUCMD_AddWrite(GPUREG_022A, 0x00000000);
+    GPUCMD_AddMaskedWrite(GPUREG_0253, 0x1, 0x00000100);
+
+    GPUCMD_AddMaskedWrite(GPUREG_0245, 0x1, 0x00000000);
+    GPUCMD_AddWrite(GPUREG_DRAWELEMENTS, 0x00000001);
+    GPUCMD_AddMaskedWrite(GPUREG_0245, 0x1, 0x00000001);
+    GPUCMD_AddWrite(GPUREG_0231, 0x00000001);
+    return true;
+}
+
+u32 gpuDrawInstanced(gpu_uniform_block* uniforms, u32 reg, u32 numRegs, const float* instanceData, u32 instances,
+                     GPU_Primitive_t primitive, const void* vertices, const void* indices, u32 count, gpu_index_type type)
+{
+    u32* buf;
+    u32 size, offset, drawStart, drawEnd, i;
+    if(!instances || !numRegs || reg + numRegs > GPU_FLOAT_UNIFORMS)return 0;
+
+    gpuUniformSetRegs(uniforms, reg, instanceData, numRegs);
+    gpuUniformBlockUpload(uniforms);
+    GPUCMD_GetBuffer(&buf, &size, &drawStart);
+    if(!gpuDrawElements(primitive, vertices, indices, count, type))return 0;
+    GPUCMD_GetBuffer(NULL, NULL, &drawEnd);
+    if(drawEnd == drawStart)return 0;
+
+    //The draw is the same for every instance, so its commands are copied instead of being built again
+    for(i = 1; i < instances; ++i)
+    {
+        //Worst case of the upload: a burst per register, a header and a padding word each
+        GPUCMD_GetBuffer(NULL, NULL, &offset);
+        if(offset + numRegs * 8 + drawEnd - drawStart > size)return i;
+        gpuUniformSetRegs(uniforms, reg, instanceData + i * numRegs * 4, numRegs);
+        gpuUniformBlockUpload(uniforms);
+        GPUCMD_AddRawCommands(buf + drawStart, drawEnd - drawStart);
+    }
+    return instances;
+}
+
+
+u32 gpuTiledOffset(u32 x, u32 y)
+{
+    //Interleave the 3 low bits of x and y: x0 y0 x1 y1 x2 y2
+    u32 morton = (x & 1) | ((y & 1) << 1) | ((x & 2) << 1) | ((y & 2) << 2) | ((x & 4) << 2) | ((y & 4) << 3);
+    return ((y >> 3) * (GPU_FB_WIDTH >> 3) + (x >> 3)) * 64 + morton;
+}
+
+u32 gpuReadColor(u16 x, u16 y)
+{
+    //The projection maps the 400x240 space onto the whole 480x400 viewport
+    u32 fbx = (u32)x * GPU_FB_WIDTH / GPU_UI_WIDTH;
+    u32 fby = (u32)y * GPU_FB_HEIGHT / GPU_UI_HEIGHT;
+    if(fbx >= GPU_FB_WIDTH) fbx = GPU_FB_WIDTH - 1;
+    if(fby >= GPU_FB_HEIGHT) fby = GPU_FB_HEIGHT - 1;
+    //The rows are stored from the top of the viewport, see GPU_FB_HEIGHT
+    return gpuColorBuffer[gpuTiledOffset(fbx, GPU_FB_HEIGHT - 1 - fby)];
+}
@@ -8,6 +8,9 @@
 
 #include <3ds.h>
 #include <stdio.h>
+#include "gpuuniform.h"
+#include "gpuarena.h"
+#include "gpushader.h"
 
 
 
@@ -22,9 +25,35 @@ void _my_assert(char * text);
 
 #define RGBA8(r,g,b,a) (((r)&0xFF) | (((g)&0xFF)<<8) | (((b)&0xFF)<<16) | (((a)&0xFF)<<24))
 
-u32*gpuColorBuffer;
-u32*gpuDBuffer;
-u32* gpuCmd;
+//Size of the 2D drawing space set up by gpuUIInit (see the orthographic matrix)
+#define GPU_UI_WIDTH  400
+#define GPU_UI_HEIGHT 240
+//Size of the tiled buffers the GPU actually renders to (see GPU_SetViewport in gpuStartFrame)
+//The projection puts y = 0 of the drawing space at the bottom of the viewport, but the PICA stores the rows of the
+//buffers the other way: framebuffer row y (gpuReadColor, gpuRegionFromUI, the linear images of gpureadback.h) is
+//memory row GPU_FB_HEIGHT - 1 - y (gpuTiledOffset, the rows of tiles of gpuMarkDirty and of the presentation).
+#define GPU_FB_WIDTH  480
+#define GPU_FB_HEIGHT 400
+
+//Size in words of gpuCmd
+#define GPU_CMD_SIZE 0x40000
+//Number of command buffers, one is recorded while the GPU runs another
+#define GPU_CMD_BUFFERS 2
+//Linear memory taken once by gpuUIInit, for the command buffers, the frame arenas and gpuArena users
+#define GPU_ARENA_SIZE 0x800000
+//Size in bytes of the transient memory of each command buffer, see gpuFrameAlloc
+#define GPU_FRAME_ARENA_SIZE 0x40000
+
+extern u32* gpuColorBuffer;
+extern u32* gpuDBuffer;
+//The buffers of the right eye, NULL unless stereo is on (see gpuSetStereo)
+extern u32* gpuRightColorBuffer;
+extern u32* gpuRightDBuffer;
+extern u32* gpuCmd;
+//Float uniforms of the vertex shader, the projection is set by gpuUIInit. Send changes with gpuUniformBlockUpload.
+extern gpu_uniform_block gpuVertexUniforms;
+//Linear memory for everything that lives until gpuUIExit (meshes, textures, pools...)
+extern gpu_arena gpuArena;
 
 typedef struct {
     float x, y;
@@ -51,6 +80,207 @@ typedef struct __attribute__((__packed__)){
 
 void gpuUIInit();
 void gpuUIExit();
+/**
+* Goes back to the default state: no culling, stencil, blending or alpha test, depth test always passing
+* and every TEV stage passing its input through. This is a prebaked block, so it is cheap to call every frame.
+*/
+void gpuDisableEverything();
+/**
+* Changes the projection so that the whole 400x240 drawing space lands in the rectangle (x, y, w, h) of itself,
+* to draw something made for the full screen in a part of it. (0, 0, GPU_UI_WIDTH, GPU_UI_HEIGHT) goes back to normal.
+* Only sets gpuVertexUniforms, send it with gpuUniformBlockUpload.
+*/
+void gpuSetProjectionRegion(float x, float y, float w, float h);
+/**
+* Switches shader program, see gpushader.h. NULL is the default one (data/shader.vsh).
+* The projection follows the program to its register, and the values of gpuVertexUniforms that its constants
+* overwrote are sent again: gpuUniformBlockUpload has to be called after it.
+* @return false if the command list is full
+*/
+bool gpuSetShader(gpu_shader_program* program);
+/**
+* Starts recording a frame in the next command buffer (gpuCmd), while the GPU may still be rendering the previous one.
+*/
 void gpuStartFrame();
 void gpuEndFrame();
+/**
+* Number of gpuStartFrame() calls so far, which identifies the frame being recorded.
+* The GPU is done with the frames older than gpuFrameNumber() - GPU_CMD_BUFFERS + 1.
+*/
+u32 gpuFrameNumber();
+/**
+* Linear memory for the frame being recorded (vertices generated for this frame...), freed at once when its command
+* buffer is reused, 2 gpuStartFrame() later. The GPU has finished reading it by then.
+* @return NULL if the GPU_FRAME_ARENA_SIZE bytes of the frame are used up
+*/
+void* gpuFrameAlloc(u32 size, u32 align);
+/**
+* Prints the usage of gpuArena and of the frame arenas.
+*/
+void gpuPrintArenas(FILE* f);
+//Buffers of gpuClearBuffers and gpuMarkDirty
+#define GPU_CLEAR_COLOR 0x1
+#define GPU_CLEAR_DEPTH 0x2     ///< Depth and stencil
+#define GPU_CLEAR_ALL   (GPU_CLEAR_COLOR | GPU_CLEAR_DEPTH)
+//Ranges of the buffers closer than this (in 8x8 tiles) are cleared by a single memory fill
+#define GPU_CLEAR_MERGE_GAP 16
+
+/**
+* Sets the buffers to clear before the frame being recorded runs, gpuStartFrame() asks for GPU_CLEAR_ALL.
+* Only what was drawn since the last clear of a buffer is filled (see gpuMarkDirty). A buffer left out isn't
+* forgotten: it is cleared by the next frame that asks for it. Leave the depth buffer out if nothing tests
+* depth or stencil, and ask for nothing if the frame covers everything it reads.
+* The depth buffer is filled while the previous frame is copied to the screen, the color buffer after that.
+*/
+void gpuClearBuffers(u32 buffers);
+/**
+* Tells that the frame being recorded draws to the rectangle (x, y, w, h) of the 400x240 drawing space of buffers,
+* can be called for several rectangles. A buffer the frame never marks is assumed to be drawn to everywhere.
+* In stereo, the rectangles are widened by the parallax of the eyes.
+*/
+void gpuMarkDirty(u32 buffers, u16 x, u16 y, u16 w, u16 h);
+
+typedef struct {
+    u32 fills;                  ///< GX_SetMemoryFill calls
+    u32 colorWords, depthWords; ///< Words filled
+} gpu_clear_stats;
+
+/**
+* What the clears before the last submitted frame did.
+*/
+const gpu_clear_stats* gpuGetClearStats();
+typedef enum {
+    GPU_PRESENT_ALWAYS,     ///< Every frame is copied to the screen, then the VBlank is waited for (the default)
+    GPU_PRESENT_HEADLESS,   ///< Nothing is copied and there is no VBlank wait, for runs nobody watches
+    GPU_PRESENT_THROTTLED,  ///< Only one frame out of interval is copied
+    GPU_PRESENT_DIRTY,      ///< Only the rows of tiles that changed since the screen buffer was last shown, nothing if none
+} gpu_present_mode;
+//Bands of rows of tiles closer than this are copied to the screen at once by GPU_PRESENT_DIRTY
+#define GPU_PRESENT_MERGE_ROWS 2
+
+/**
+* Sets how gpuSubmitFrame() shows the completed frames. GPU_PRESENT_DIRTY relies on gpuMarkDirty and on what the
+* clears filled, frames that don't mark anything change the whole screen.
+* @param interval One frame out of interval is presented by GPU_PRESENT_THROTTLED
+*/
+void gpuSetPresentMode(gpu_present_mode mode, u32 interval);
+gpu_present_mode gpuGetPresentMode(u32* interval);
+
+//Projection register moves (shader switches) a stereo frame can have, see gpuSetStereo
+#define GPU_STEREO_MAX_PROJ_MOVES 64
+
+/**
+* Stereoscopic 3D on the top screen, the frames still being recorded once: gpuEndFrame() copies the command list of the
+* frame after itself for the right eye, and only patches the projection and the screen buffer addresses in each copy.
+* Both eyes are then copied to the screen by one display transfer each, see gpuSetPresentMode.
+* The projection is patched wherever the frame writes it while drawing to the screen, so set it again after drawing
+* to an offscreen target (gputarget.h): the right eye draws the targets again, as they are.
+* A frame that doesn't fit twice in gpuCmd, or moves the projection more than GPU_STEREO_MAX_PROJ_MOVES times,
+* is drawn once and shown to both eyes.
+* The right eye buffers come from the VRAM of gputarget.h, so enable it after creating the VRAM targets that outlive it.
+* Waits for the GPU, call it between frames.
+* @return false if the right eye buffers couldn't be allocated, stereo is off then
+*/
+bool gpuSetStereo(bool enable);
+bool gpuStereoEnabled();
+/**
+* Sets how far apart the eyes see things: a point at depth z is drawn parallax * (screenZ - z) units of the drawing
+* space further along y (the horizontal of the screen) for the left eye than for the right one. With a positive
+* parallax, what is in front of screenZ comes out of the screen. The default is 0, both eyes see the same image.
+* Applies from the next gpuStartFrame().
+*/
+void gpuSetStereoDepth(float parallax, float screenZ);
+/**
+* @return The parallax of gpuSetStereoDepth
+*/
+float gpuGetStereoDepth(float* screenZ);
+
+/**
+* Sends the command list of gpuCmd as is (it must already be finalized) to the GPU, and returns without waiting for it.
+* The previous frame is completed first: it is copied to the screen (see gpuSetPresentMode) and its done callback is called.
+* gpuEndFrame() is GPU_FinishDrawing() + GPUCMD_Finalize() + gpuSubmitFrame(), after adding the right eye in stereo.
+* A list submitted without gpuEndFrame() only has the left eye, which both eyes are shown.
+*/
+void gpuSubmitFrame();
+/**
+* Waits for the last submitted frame to be rendered and presented.
+* Needed before reading the color or depth buffer (gpuReadColor...).
+*/
+void gpuWaitIdle();
+
+/**
+* Called once a frame is rendered and presented, before its color buffer gets cleared for the next one.
+* The depth buffer may already be cleared, see gpuClearBuffers.
+*/
+typedef void (*gpu_frame_done_callback)(void* data);
+/**
+* Sets the function called when the frame being recorded is done, so that its results can be read without gpuWaitIdle().
+*/
+void gpuSetFrameDoneCallback(gpu_frame_done_callback callback, void* data);
+
+/**
+* @param cmds The finalized command list, about to be submitted
+* @param size Its size in words
+*/
+typedef void (*gpu_submit_callback)(const u32* cmds, u32 size);
+/**
+* Sets a function called by gpuSubmitFrame() with every command list, NULL to remove it.
+*/
+void gpuSetSubmitCallback(gpu_submit_callback callback);
+
+typedef struct {
+    u32 inputCommands, inputWords;  ///< The list as it was built
+    u32 commands, words;            ///< The list as it was submitted
+    u32 droppedWrites;              ///< Register writes that didn't change anything
+    u32 mergedCommands;             ///< Commands appended to the incremental write of the previous one
+} gpu_filter_stats;
+
+/**
+* When enabled (the default), gpuSubmitFrame() mirrors the state registers of the PICA and removes the writes that
+* don't change their value, then merges writes to consecutive registers into incremental writes.
+* Only registers without side effects are filtered: draws, flushes, uniform and shader uploads are always kept.
+*/
+void gpuSetRedundantWriteFilter(bool enable);
+/**
+* Forgets the mirrored register values, needed if commands were sent to the GPU without gpuSubmitFrame().
+*/
+void gpuInvalidateState();
+/**
+* What the filter did to the last submitted list.
+*/
+const gpu_filter_stats* gpuGetFilterStats();
 void GPU_SetDummyTexEnv(u8 num);
+
+typedef enum {
+    GPU_INDEX_U8 = 0,
+    GPU_INDEX_U16 = 1,
+} gpu_index_type;
+
+/**
+* Draws count vertices fetched through an index buffer, the indexed counterpart of GPU_DrawArray.
+* The PICA reads the indices at an offset from the attribute buffers base address, so they must be in linear memory
+* after vertices (the buffer the attributes were bound with) and less than 256MB away: allocating the vertices
+* then the indices from the same arena does it.
+* @return false if indices can't be reached from vertices, nothing is drawn then
+*/
+bool gpuDrawElements(GPU_Primitive_t primitive, const void* vertices, const void* indices, u32 count, gpu_index_type type);
+/**
+* Pseudo instancing: draws the same indexed mesh instances times, instance i setting the numRegs float uniform
+* registers from reg to the ones at instanceData + i * numRegs * 4 (register order, see gpuuniform.h).
+* Only the registers that change from an instance to the next are sent, and the draw commands are built once
+* then copied, so all the instances are a single sequence of commands. uniforms keeps the values of the last one.
+* @return The number of instances drawn, less than instances if gpuCmd is full
+*/
+u32 gpuDrawInstanced(gpu_uniform_block* uniforms, u32 reg, u32 numRegs, const float* instanceData, u32 instances,
+                     GPU_Primitive_t primitive, const void* vertices, const void* indices, u32 count, gpu_index_type type);
+
+/**
+* Returns the offset (in pixels) of the pixel (x,y) in the tiled color/depth buffers, y being the memory row
+* (see GPU_FB_HEIGHT). The PICA stores them as 8x8 tiles, each tile being in Morton (Z) order.
+*/
+u32 gpuTiledOffset(u32 x, u32 y);
+/**
+* Reads back the color at (x,y) in the 400x240 drawing space.
+* Only meaningful after gpuWaitIdle(), or from a frame done callback.
+*/
+u32 gpuReadColor(u16 x, u16 y);
@@ -0,0 +1,215 @@
+/**
+ *@file gpulog.c
+ *@author Lectem
+ *@date 17/10/2026
+ */
+#define _GNU_SOURCE //fopencookie
+#include "gpulog.h"
+#include "gpuframework.h"
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DRAIN_STACK_SIZE 0x4000
+
+//The thread entry point only takes a u32, so the drain threads find their log here
+static gpu_log* logs[GPU_LOG_MAX];
+
+/**
+* Writes what the ring holds, a block at a time. The last partial block is only written if all is set,
+* after which the writes are aligned on the next block again.
+*/
+static void drain(gpu_log* log, bool all)
+{
+    for(;;)
+    {
+        u32 head = __atomic_load_n(&log->head, __ATOMIC_ACQUIRE);
+        u32 tail = log->tail;
+        //Up to the end of the block, which is never past the end of the ring
+        u32 n = GPU_LOG_BLOCK_SIZE - (tail & (GPU_LOG_BLOCK_SIZE - 1));
+        if(head - tail < n)
+        {
+            if(!all || head == tail)return;
+            n = head - tail;
+        }
+        fwrite(log->ring + (tail & (log->size - 1)), 1, n, log->file);
+        __atomic_store_n(&log->tail, tail + n, __ATOMIC_RELEASE);
+    }
+}
+
+static void drainThread(u32 slot)
+{
+    gpu_log* log = logs[slot];
+    for(;;)
+    {
+        svcWaitSynchronization(log->wake, U64_MAX);
+        //Read before draining, so that everything logged before the request is written
+        u32 request = __atomic_load_n(&log->flushRequest, __ATOMIC_ACQUIRE);
+        bool quit = __atomic_load_n(&log->quit, __ATOMIC_ACQUIRE);
+        bool flush = request != log->flushDone;
+        drain(log, flush || quit);
+        if(flush)
+        {
+            fflush(log->file);
+            __atomic_store_n(&log->flushDone, request, __ATOMIC_RELEASE);
+            svcSignalEvent(log->flushed);
+        }
+        if(quit)break;
+    }
+    svcExitThread();
+}
+
+bool gpuLogOpen(gpu_log* log, const char* path, u32 ringSize)
+{
+    s32 priority = 0x30;
+    u32 slot;
+    memset(log, 0, sizeof(*log));
+    if(!ringSize || (ringSize & (ringSize - 1)) || (ringSize % GPU_LOG_BLOCK_SIZE))return false;
+    for(slot = 0; slot < GPU_LOG_MAX && logs[slot]; ++slot);
+    if(slot == GPU_LOG_MAX)return false;
+
+    log->size = ringSize;
+    log->ring = malloc(ringSize);
+    log->stack = malloc(DRAIN_STACK_SIZE);
+    log->file = fopen(path, "wb");
+    if(!log->ring || !log->stack || !log->file)goto fail;
+    //The ring already gathers the data in blocks, another copy in the stdio buffer would be useless
+    setvbuf(log->file, NULL, _IONBF, 0);
+    if(svcCreateEvent(&log->wake, 0))goto fail;
+    if(svcCreateEvent(&log->flushed, 0))goto fail;
+
+    //Below the render thread, so that it runs while it waits for the GPU or the VBlank
+    svcGetThreadPriority(&priority, CUR_THREAD_HANDLE);
+    if(priority < 0x3F)priority++;
+    log->slot = slot;
+    logs[slot] = log;
+    if(svcCreateThread(&log->thread, drainThread, slot, log->stack + DRAIN_STACK_SIZE / 4, priority, -2))
+    {
+        logs[slot] = NULL;
+        log->thread = 0;
+        goto fail;
+    }
+    return true;
+
+fail:
+    if(log->wake)svcCloseHandle(log->wake);
+    if(log->flushed)svcCloseHandle(log->flushed);
+    if(log->file)fclose(log->file);
+    free(log->ring);
+    free(log->stack);
+    memset(log, 0, sizeof(*log));
+    return false;
+}
+
+bool gpuLogOpenRecords(gpu_log* log, const char* path, u32 ringSize)
+{
+    const gpu_log_file_header header = {GPU_LOG_MAGIC, GPU_LOG_VERSION, sizeof(gpu_log_file_header)};
+    if(!gpuLogOpen(log, path, ringSize))return false;
+    gpuLogWrite(log, &header, sizeof(header));
+    //Type 0 holds the definitions
+    log->types[0] = "";
+    log->numTypes = 1;
+    return true;
+}
+
+void gpuLogClose(gpu_log* log)
+{
+    if(!log->ring)return;
+    if(log->stream)fclose(log->stream);
+    log->stream = NULL;
+    __atomic_store_n(&log->quit, true, __ATOMIC_RELEASE);
+    svcSignalEvent(log->wake);
+    svcWaitSynchronization(log->thread, U64_MAX);
+    svcCloseHandle(log->thread);
+    svcCloseHandle(log->wake);
+    svcCloseHandle(log->flushed);
+    logs[log->slot] = NULL;
+    fclose(log->file);
+    free(log->ring);
+    free(log->stack);
+    memset(log, 0, sizeof(*log));
+}
+
+void gpuLogFlush(gpu_log* log)
+{
+    u32 request;
+    if(!log->ring)return;
+    if(log->stream)fflush(log->stream);
+    request = log->flushRequest + 1;
+    __atomic_store_n(&log->flushRequest, request, __ATOMIC_RELEASE);
+    svcSignalEvent(log->wake);
+    while(__atomic_load_n(&log->flushDone, __ATOMIC_ACQUIRE) != request)svcWaitSynchronization(log->flushed, U64_MAX);
+}
+
+bool gpuLogWrite(gpu_log* log, const void* data, u32 size)
+{
+    u32 head = log->head;
+    u32 tail = __atomic_load_n(&log->tail, __ATOMIC_ACQUIRE);
+    u32 offset = head & (log->size - 1), first;
+    if(!log->ring || size > log->size - (head - tail))
+    {
+        log->dropped++;
+        return false;
+    }
+    first = log->size - offset;
+    if(first > size)first = size;
+    memcpy(log->ring + offset, data, first);
+    memcpy(log->ring, (const u8*)data + first, size - first);
+    __atomic_store_n(&log->head, head + size, __ATOMIC_RELEASE);
+    //The drain thread only has something to do once a block is complete
+    if((head ^ (head + size)) & ~(GPU_LOG_BLOCK_SIZE - 1))svcSignalEvent(log->wake);
+    return true;
+}
+
+static ssize_t streamWrite(void* cookie, const char* buf, size_t size)
+{
+    //Dropped text is still reported as written, stdio would retry it otherwise
+    gpuLogWrite(cookie, buf, size);
+    return size;
+}
+
+FILE* gpuLogStream(gpu_log* log)
+{
+    if(!log->stream && log->ring)
+    {
+        cookie_io_functions_t functions = {NULL, streamWrite, NULL, NULL};
+        log->stream = fopencookie(log, "w", functions);
+    }
+    return log->stream;
+}
+
+u16 gpuLogDefine(gpu_log* log, const char* description)
+{
+    u32 values[GPU_LOG_MAX_VALUES];
+    u32 length = strlen(description), nameLength = strcspn(description, ":");
+    u16 type;
+    for(type = 1; type < log->numTypes; ++type)
+    {
+        const char* t = log->types[type];
+        if(strcspn(t, ":") == nameLength && !strncmp(t, description, nameLength))return type;
+    }
+    if(log->numTypes >= GPU_LOG_MAX_TYPES || length + 1 > (GPU_LOG_MAX_VALUES - 1) * 4)return 0;
+
+    type = log->numTypes;
+    memset(values, 0, sizeof(values));
+    values[0] = type;
+    memcpy(&values[1], description, length);
+    if(!gpuLogRecord(log, 0, values, 1 + (length + 4) / 4))return 0;
+    log->types[log->numTypes++] = description;
+    return type;
+}
+
+bool gpuLogRecord(gpu_log* log, u16 type, const u32* values, u32 count)
+{
+    struct {
+        gpu_log_record_header header;
+        u32 values[GPU_LOG_MAX_VALUES];
+    } record;
+    if(count > GPU_LOG_MAX_VALUES)return false;
+    record.header.type = type;
+    record.header.count = count;
+    record.header.frame = gpuFrameNumber();
+    record.header.tick = svcGetSystemTick();
+    memcpy(record.values, values, count * sizeof(u32));
+    return gpuLogWrite(log, &record, sizeof(record.header) + count * sizeof(u32));
+}
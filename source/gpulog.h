@@ -0,0 +1,107 @@
+/**
+ *@file gpulog.h
+ *@author Lectem
+ *@date 17/10/2026
+ *
+ * Logs written to the SD card by a thread of their own, so that logging every frame doesn't stall the rendering.
+ *
+ * The render thread only copies bytes into a ring buffer, the drain thread writes them to the file in blocks of
+ * GPU_LOG_BLOCK_SIZE bytes aligned on the file offset. There is one writer and one reader, so the ring needs
+ * no lock. When the ring is full, messages are dropped and counted instead of waiting for the SD card.
+ *
+ * A log is either text (gpuLogStream gives a FILE* for the usual fprintf calls) or binary records.
+ *
+ * Record file layout (little endian):
+ *   gpu_log_file_header
+ *   records, back to back: gpu_log_record_header then count u32 values
+ * Record type 0 defines the other types: value 0 is the type being defined, followed by a NUL terminated
+ * "name:field,field,..." string padded to a multiple of 4 bytes. A field ending with ":x" is shown in hex.
+ * host/logcsv converts the records of a type to CSV.
+ */
+#pragma once
+
+#include <3ds.h>
+#include <stdio.h>
+
+#define GPU_LOG_MAGIC 0x4C555047 //"GPUL"
+#define GPU_LOG_VERSION 1
+//Size of the writes to the SD card, the ring size must be a multiple of it
+#define GPU_LOG_BLOCK_SIZE 0x4000
+//Record types a log can define, type 0 being the definitions
+#define GPU_LOG_MAX_TYPES 32
+#define GPU_LOG_MAX_VALUES 64
+//Logs open at the same time
+#define GPU_LOG_MAX 4
+
+typedef struct {
+    u32 magic;
+    u16 version;
+    u16 headerSize;
+} gpu_log_file_header;
+
+typedef struct {
+    u16 type;
+    u16 count;      ///< Values following the header
+    u32 frame;      ///< gpuFrameNumber() when the record was added
+    u64 tick;       ///< svcGetSystemTick()
+} gpu_log_record_header;
+
+typedef struct {
+    u8* ring;
+    u32 size;                   ///< Power of 2
+    u32 head;                   ///< Bytes added so far, only written by the render thread
+    u32 tail;                   ///< Bytes written to the file so far, only written by the drain thread
+    u32 dropped;                ///< Messages that didn't fit
+    u32 flushRequest, flushDone;
+    bool quit;
+
+    FILE* file;
+    FILE* stream;               ///< See gpuLogStream
+    Handle thread, wake, flushed;
+    u32* stack;
+    u32 slot;
+
+    //Names of the record types defined so far
+    const char* types[GPU_LOG_MAX_TYPES];
+    u16 numTypes;
+} gpu_log;
+
+/**
+* Creates the file and starts the drain thread, at a lower priority than the caller.
+* @param ringSize Multiple of GPU_LOG_BLOCK_SIZE and power of 2
+*/
+bool gpuLogOpen(gpu_log* log, const char* path, u32 ringSize);
+/**
+* Same as gpuLogOpen, for a record file.
+*/
+bool gpuLogOpenRecords(gpu_log* log, const char* path, u32 ringSize);
+/**
+* Writes everything left to the file, stops the thread and closes the file.
+*/
+void gpuLogClose(gpu_log* log);
+/**
+* Waits until everything logged so far is in the file.
+*/
+void gpuLogFlush(gpu_log* log);
+
+/**
+* Adds size bytes to the ring, all of them or nothing.
+* @return false if they were dropped
+*/
+bool gpuLogWrite(gpu_log* log, const void* data, u32 size);
+/**
+* A buffered stdio stream writing to the ring, for the functions that print to a FILE*.
+* fflush() only moves the data to the ring, use gpuLogFlush to wait for the file.
+*/
+FILE* gpuLogStream(gpu_log* log);
+
+/**
+* Defines a record type, or finds the one with the same name.
+* @param description "name:field,field,...", kept as is (not copied)
+* @return The type, 0 if there is no room left
+*/
+u16 gpuLogDefine(gpu_log* log, const char* description);
+/**
+* @return false if the record was dropped
+*/
+bool gpuLogRecord(gpu_log* log, u16 type, const u32* values, u32 count);
@@ -0,0 +1,149 @@
+/**
+ *@file gpureadback.c
+ *@author Lectem
+ *@date 17/10/2026
+ */
+#include "gpuframework.h"
+#include "gpureadback.h"
+#include <string.h>
+
+/**
+* Offsets of the pixel pairs (x, x+1) of a tile row, for x = 0, 2, 4, 6, and of the rows.
+* x0 is the lowest bit of the Morton order, so two horizontally adjacent pixels are always contiguous
+* and a row of a tile is copied as 4 u64 (see gpuTiledOffset).
+*/
+static const u8 pairOffsets[4] = {0, 4, 16, 20};
+static const u8 rowOffsets[8] = {0, 2, 8, 10, 32, 34, 40, 42};
+
+void gpuUntile32(const u32* tiled, u32* out, u32 width, u32 height)
+{
+    u32 tx, ty, y;
+    u32 tilesX = width >> 3;
+    for(ty = 0; ty < (height >> 3); ++ty)
+    {
+        for(tx = 0; tx < tilesX; ++tx)
+        {
+            const u32* tile = &tiled[(ty * tilesX + tx) * 64];
+            //The first row in memory is the last one of the image, see GPU_FB_HEIGHT
+            u32* dst = &out[(height - 1 - ty * 8) * width + tx * 8];
+            for(y = 0; y < 8; ++y, dst -= width)
+            {
+                const u32* row = tile + rowOffsets[y];
+                //Fixed size memcpy compiles to a single 64 bits load/store (ldrd/strd)
+                memcpy(dst + 0, row + pairOffsets[0], 8);
+                memcpy(dst + 2, row + pairOffsets[1], 8);
+                memcpy(dst + 4, row + pairOffsets[2], 8);
+                memcpy(dst + 6, row + pairOffsets[3], 8);
+            }
+        }
+    }
+}
+
+void gpuReadbackColor(u32* out)
+{
+    gpuUntile32(gpuColorBuffer, out, GPU_FB_WIDTH, GPU_FB_HEIGHT);
+}
+
+void gpuReadbackDepth(u32* out)
+{
+    gpuUntile32(gpuDBuffer, out, GPU_FB_WIDTH, GPU_FB_HEIGHT);
+}
+
+bool gpuReadbackRightColor(u32* out)
+{
+    if(!gpuRightColorBuffer)return false;
+    gpuUntile32(gpuRightColorBuffer, out, GPU_FB_WIDTH, GPU_FB_HEIGHT);
+    return true;
+}
+
+gpu_region gpuRegionFromUI(u16 x, u16 y, u16 w, u16 h)
+{
+    //Same mapping as gpuReadColor, the projection stretches 400x240 over the whole 480x400 viewport
+    gpu_region r;
+    u32 x1 = (u32)(x + w) * GPU_FB_WIDTH / GPU_UI_WIDTH;
+    u32 y1 = (u32)(y + h) * GPU_FB_HEIGHT / GPU_UI_HEIGHT;
+    if(x1 > GPU_FB_WIDTH)x1 = GPU_FB_WIDTH;
+    if(y1 > GPU_FB_HEIGHT)y1 = GPU_FB_HEIGHT;
+    r.x = (u32)x * GPU_FB_WIDTH / GPU_UI_WIDTH;
+    r.y = (u32)y * GPU_FB_HEIGHT / GPU_UI_HEIGHT;
+    if(r.x > x1)r.x = x1;
+    if(r.y > y1)r.y = y1;
+    r.w = x1 - r.x;
+    r.h = y1 - r.y;
+    return r;
+}
+
+void gpuRegionStats(const u32* image, gpu_region region, gpu_region_stats* stats)
+{
+    //Small open addressing set, most test regions have a handful of colors
+    u32 colors[GPU_STATS_MAX_COLORS * 2];
+    u8 used[GPU_STATS_MAX_COLORS * 2];
+    u32 x, y;
+    u32 hash = 2166136261u;
+    u32 minLo = 0xFFFFFFFF, minHi = 0xFFFFFFFF, maxLo = 0, maxHi = 0;
+
+    memset(stats, 0, sizeof(*stats));
+    memset(used, 0, sizeof(used));
+    //An empty region may start right after the last pixel, don't read it
+    if(!region.w || !region.h)return;
+    if(region.x + region.w > GPU_FB_WIDTH || region.y + region.h > GPU_FB_HEIGHT)return;
+
+    for(y = region.y; y < region.y + region.h; ++y)
+    {
+        const u32* row = &image[y * GPU_FB_WIDTH];
+        u32 last = ~row[region.x];
+        for(x = region.x; x < region.x + region.w; ++x)
+        {
+            u32 c = row[x];
+            //Per byte min/max, done on the even and odd bytes separately so that each byte has room for a borrow bit
+            u32 lo = c & 0x00FF00FF, hi = (c >> 8) & 0x00FF00FF;
+            u32 lt;
+            lt = ((lo | 0x01000100) - (minLo & 0x00FF00FF)) & 0x01000100; //bit set where lo >= minLo
+            lt = (lt >> 8) * 0xFF;                                        //0xFF where lo >= minLo
+            minLo = (minLo & lt) | (lo & ~lt);
+            lt = (((hi | 0x01000100) - (minHi & 0x00FF00FF)) & 0x01000100) >> 8;
+            lt *= 0xFF;
+            minHi = (minHi & lt) | (hi & ~lt);
+            lt = (((maxLo | 0x01000100) - lo) & 0x01000100) >> 8;
+            lt *= 0xFF;
+            maxLo = (maxLo & lt) | (lo & ~lt);
+            lt = (((maxHi | 0x01000100) - hi) & 0x01000100) >> 8;
+            lt *= 0xFF;
+            maxHi = (maxHi & lt) | (hi & ~lt);
+
+            hash = (hash ^ (c & 0xFF)) * 16777619u;
+            hash = (hash ^ ((c >> 8) & 0xFF)) * 16777619u;
+            hash = (hash ^ ((c >> 16) & 0xFF)) * 16777619u;
+            hash = (hash ^ (c >> 24)) * 16777619u;
+
+            //Runs of the same color are the common case
+            if(c == last || stats->uniqueColors >= GPU_STATS_MAX_COLORS)continue;
+            last = c;
+            u32 slot = (c * 2654435761u) >> 23; //9 bits, GPU_STATS_MAX_COLORS * 2 slots
+            while(used[slot] && colors[slot] != c)slot = (slot + 1) & (GPU_STATS_MAX_COLORS * 2 - 1);
+            if(!used[slot])
+            {
+                used[slot] = 1;
+                colors[slot] = c;
+                stats->uniqueColors++;
+            }
+        }
+    }
+    stats->pixels = region.w * region.h;
+    stats->checksum = hash;
+    if(stats->pixels)
+    {
+        stats->min = (minLo & 0x00FF00FF) | ((minHi & 0x00FF00FF) << 8);
+        stats->max = (maxLo & 0x00FF00FF) | ((maxHi & 0x00FF00FF) << 8);
+    }
+}
+
+bool gpuReadbackDump(const char* path, const u32* image)
+{
+    FILE* f = fopen(path, "wb");
+    bool ok;
+    if(!f)return false;
+    ok = fwrite(image, sizeof(u32), GPU_FB_PIXELS, f) == GPU_FB_PIXELS;
+    if(fclose(f))ok = false;
+    return ok;
+}
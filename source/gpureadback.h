@@ -0,0 +1,63 @@
+/**
+ *@file gpureadback.h
+ *@author Lectem
+ *@date 17/10/2026
+ *
+ * Whole framebuffer readback: un-tiles the color and depth buffers into linear images and computes statistics
+ * over regions of them, so that every pixel of a frame can be checked instead of a few samples.
+ *
+ * Linear images are GPU_FB_WIDTH x GPU_FB_HEIGHT words, row y starting at y * GPU_FB_WIDTH, in the same
+ * coordinates as gpuReadColor() and gpuRegionFromUI(). Like gpuReadColor, only read the buffers once the frame is done.
+ */
+#pragma once
+
+#include <3ds.h>
+#include <stdio.h>
+
+#define GPU_FB_PIXELS (GPU_FB_WIDTH * GPU_FB_HEIGHT)
+//Regions with more different colors than this only report it as a lower bound
+#define GPU_STATS_MAX_COLORS 256
+
+typedef struct {
+    u16 x, y, w, h;
+} gpu_region;
+
+typedef struct {
+    u32 pixels;
+    u32 uniqueColors;       ///< Capped to GPU_STATS_MAX_COLORS
+    u32 checksum;           ///< FNV-1a of the pixels, row by row
+    u32 min, max;           ///< Per byte minimum and maximum, eg. min & 0xFF is the minimum of the low bytes
+} gpu_region_stats;
+
+/**
+* Un-tiles gpuColorBuffer (RGBA8, stored as R<<24|G<<16|B<<8|A) into out.
+*/
+void gpuReadbackColor(u32* out);
+/**
+* Un-tiles gpuDBuffer (24 bits depth + 8 bits stencil) into out.
+*/
+void gpuReadbackDepth(u32* out);
+/**
+* Un-tiles gpuRightColorBuffer like gpuReadbackColor, the right eye of a frame that had its own (see gpuSetStereo).
+* @return false if stereo is off
+*/
+bool gpuReadbackRightColor(u32* out);
+/**
+* Un-tiles any 8x8 tiled 32 bits buffer of the given size (multiples of 8), the last row in memory first.
+*/
+void gpuUntile32(const u32* tiled, u32* out, u32 width, u32 height);
+
+/**
+* Converts a rectangle of the 400x240 drawing space to the framebuffer space.
+*/
+gpu_region gpuRegionFromUI(u16 x, u16 y, u16 w, u16 h);
+/**
+* Statistics of a region of a linear image that is GPU_FB_WIDTH wide.
+*/
+void gpuRegionStats(const u32* image, gpu_region region, gpu_region_stats* stats);
+
+/**
+* Writes the raw words of a linear image, no header: the size is GPU_FB_WIDTH x GPU_FB_HEIGHT.
+* @return false if the file couldn't be written entirely
+*/
+bool gpuReadbackDump(const char* path, const u32* image);
@@ -0,0 +1,232 @@
+/**
+ *@file gpushader.c
+ *@author Lectem
+ *@date 17/10/2026
+ */
+#include "gpushader.h"
+#include <string.h>
+
+typedef struct {
+    const char* name;
+    const char* kind;   //vsh or gsh
+    const u8* data;
+    const u32* size;
+} shader_binary;
+
+//shader_list.h has a GPU_SHADER_BINARY(name, kind) line for every data/<name>.<kind>, generated by the build
+#define GPU_SHADER_BINARY(name, kind) extern const u8 name##_##kind##_shbin[]; extern const u32 name##_##kind##_shbin_size;
+#include "shader_list.h"
+#undef GPU_SHADER_BINARY
+
+static const shader_binary binaries[] = {
+#define GPU_SHADER_BINARY(name, kind) {#name, #kind, name##_##kind##_shbin, &name##_##kind##_shbin_size},
+#include "shader_list.h"
+#undef GPU_SHADER_BINARY
+};
+#define NUM_BINARIES (sizeof(binaries) / sizeof(binaries[0]))
+
+static DVLB_s* dvlbs[NUM_BINARIES];
+static gpu_shader_program programs[GPU_SHADER_MAX_PROGRAMS];
+static u32 numPrograms = 0;
+static const char* uniformNames[GPU_SHADER_MAX_UNIFORMS];
+static u32 numUniforms = 0;
+
+//What the GPU has: the current program, and the code in the vertex and geometry units
+static gpu_shader_program* current = NULL;
+static const DVLP_s* residentCode[2];
+
+static DVLE_s* findDvle(DVLB_s* dvlb, DVLE_type type)
+{
+    u32 i;
+    for(i = 0; dvlb && i < dvlb->numDVLE; ++i)
+    {
+        if(dvlb->DVLE[i].type == type)return &dvlb->DVLE[i];
+    }
+    return NULL;
+}
+
+static s32 addUniform(const char* name)
+{
+    s32 id = gpuShaderUniformId(name);
+    if(id >= 0 || numUniforms >= GPU_SHADER_MAX_UNIFORMS)return id;
+    uniformNames[numUniforms] = name;
+    return numUniforms++;
+}
+
+static void resolveUniforms(DVLE_s* dvle, s8* regs)
+{
+    u32 i;
+    memset(regs, -1, GPU_SHADER_MAX_UNIFORMS);
+    for(i = 0; dvle && i < dvle->uniformTableSize; ++i)
+    {
+        const DVLE_uniformEntry_s* u = &dvle->uniformTableData[i];
+        s32 id;
+        //Float registers are 0x10-0x6F, the others are the inputs and the integer and boolean uniforms
+        if(u->startReg < 0x10 || u->startReg >= 0x10 + GPU_FLOAT_UNIFORMS)continue;
+        id = addUniform(&dvle->symbolTableData[u->symbolOffset]);
+        if(id >= 0)regs[id] = u->startReg - 0x10;
+    }
+}
+
+/**
+* Records what shaderProgramUse sends for the program, without the code: it is given DVLEs whose DVLP has no data,
+* which GPU_SendShaderCode and GPU_SendOperandDescriptors skip.
+*/
+static bool bakeConfig(gpu_shader_program* p)
+{
+    DVLP_s vshCode = *p->vsh->dvlp, gshCode;
+    DVLE_s vsh = *p->vsh, gsh;
+    shaderProgram_s sp;
+    bool ok;
+
+    vshCode.codeData = vshCode.opcdescData = NULL;
+    vsh.dvlp = &vshCode;
+    shaderProgramInit(&sp);
+    shaderProgramSetVsh(&sp, &vsh);
+    if(p->gsh)
+    {
+        gshCode = *p->gsh->dvlp;
+        gshCode.codeData = gshCode.opcdescData = NULL;
+        gsh = *p->gsh;
+        gsh.dvlp = &gshCode;
+        //The geometry shader gets every output of the vertex shader
+        shaderProgramSetGsh(&sp, &gsh, p->vsh->outmapData[0]);
+    }
+    ok = gpuStateBlockBegin(&p->config, 0x200);
+    if(ok)
+    {
+        shaderProgramUse(&sp);
+        ok = gpuStateBlockEnd(&p->config);
+        if(!ok)gpuStateBlockFree(&p->config);
+    }
+    shaderProgramFree(&sp);
+    return ok;
+}
+
+bool gpuShaderInit()
+{
+    u32 i, j;
+    bool ok = true;
+    numPrograms = 0;
+    numUniforms = 0;
+    gpuShaderInvalidate();
+    for(i = 0; i < NUM_BINARIES; ++i)
+    {
+        dvlbs[i] = DVLB_ParseFile((u32*)binaries[i].data, *binaries[i].size);
+        if(!dvlbs[i])ok = false;
+    }
+    for(i = 0; i < NUM_BINARIES && numPrograms < GPU_SHADER_MAX_PROGRAMS; ++i)
+    {
+        gpu_shader_program* p = &programs[numPrograms];
+        if(strcmp(binaries[i].kind, "vsh") || !(p->vsh = findDvle(dvlbs[i], VERTEX_SHDR)))continue;
+        p->name = binaries[i].name;
+        //A geometry shader in the same binary, or in the .gsh of the same name
+        p->gsh = findDvle(dvlbs[i], GEOMETRY_SHDR);
+        for(j = 0; j < NUM_BINARIES && !p->gsh; ++j)
+        {
+            if(!strcmp(binaries[j].kind, "gsh") && !strcmp(binaries[j].name, p->name))p->gsh = findDvle(dvlbs[j], GEOMETRY_SHDR);
+        }
+
+        resolveUniforms(p->vsh, p->vshUniforms);
+        resolveUniforms(p->gsh, p->gshUniforms);
+        memset(p->constRegs, 0, sizeof(p->constRegs));
+        for(j = 0; j < p->vsh->constTableSize; ++j)
+        {
+            const DVLE_constEntry_s* c = &p->vsh->constTableData[j];
+            if(c->type == DVLE_CONST_FLOAT24 && c->id < GPU_FLOAT_UNIFORMS)p->constRegs[c->id >> 5] |= 1 << (c->id & 31);
+        }
+        if(!bakeConfig(p))
+        {
+            ok = false;
+            continue;
+        }
+        numPrograms++;
+    }
+    return ok;
+}
+
+void gpuShaderExit()
+{
+    u32 i;
+    for(i = 0; i < numPrograms; ++i)gpuStateBlockFree(&programs[i].config);
+    for(i = 0; i < NUM_BINARIES; ++i)
+    {
+        DVLB_Free(dvlbs[i]);
+        dvlbs[i] = NULL;
+    }
+    numPrograms = 0;
+    gpuShaderInvalidate();
+}
+
+u32 gpuShaderCount()
+{
+    return numPrograms;
+}
+
+gpu_shader_program* gpuShaderGet(u32 index)
+{
+    return index < numPrograms ? &programs[index] : NULL;
+}
+
+gpu_shader_program* gpuShaderFind(const char* name)
+{
+    u32 i;
+    for(i = 0; name && i < numPrograms; ++i)
+    {
+        if(!strcmp(programs[i].name, name))return &programs[i];
+    }
+    return NULL;
+}
+
+s32 gpuShaderUniformId(const char* name)
+{
+    u32 i;
+    for(i = 0; name && i < numUniforms; ++i)
+    {
+        if(!strcmp(uniformNames[i], name))return i;
+    }
+    return -1;
+}
+
+static void sendCode(GPU_SHADER_TYPE type, const DVLP_s* dvlp)
+{
+    GPU_SendShaderCode(type, dvlp->codeData, 0, dvlp->codeSize);
+    GPU_SendOperandDescriptors(type, dvlp->opcdescData, 0, dvlp->opdescSize);
+    residentCode[type == GPU_GEOMETRY_SHADER] = dvlp;
+}
+
+bool gpuShaderUse(gpu_shader_program* program)
+{
+    if(!program)return false;
+    if(program == current)return true;
+    if(residentCode[0] != program->vsh->dvlp)
+    {
+        //Without a geometry shader the code of the vertex shader goes to every unit, the geometry one included
+        if(!current || !current->gsh)residentCode[1] = NULL;
+        sendCode(GPU_VERTEX_SHADER, program->vsh->dvlp);
+    }
+    if(program->gsh && residentCode[1] != program->gsh->dvlp)
+    {
+        //Its own code for the geometry unit first, or the upload would also go to the vertex unit
+        if(!current || !current->gsh)GPUCMD_AddMaskedWrite(GPUREG_0244, 0x1, 1);
+        sendCode(GPU_GEOMETRY_SHADER, program->gsh->dvlp);
+    }
+    if(!gpuStateBlockAppend(&program->config))
+    {
+        current = NULL;
+        return false;
+    }
+    current = program;
+    return true;
+}
+
+gpu_shader_program* gpuShaderCurrent()
+{
+    return current;
+}
+
+void gpuShaderInvalidate()
+{
+    current = NULL;
+    residentCode[0] = residentCode[1] = NULL;
+}
@@ -0,0 +1,81 @@
+/**
+ *@file gpushader.h
+ *@author Lectem
+ *@date 17/10/2026
+ *
+ * Every shader program built from data/, loaded once, with their uniforms resolved once.
+ *
+ * Each data/<name>.vsh is a program, with the geometry shader of data/<name>.gsh if there is one. The build lists the
+ * binaries in shader_list.h, so adding a shader to data/ is enough.
+ *
+ * Uniforms get an id shared by all the programs (gpuShaderUniformId), and each program has a table of the register
+ * of every id: finding where a program wants a uniform is an array lookup.
+ *
+ * Switching programs doesn't go through shaderProgramUse every time: what it sends besides the code (entry point,
+ * output map, .constf constants, geometry stage setup) is prebaked in a state block, and the code is only sent when
+ * the shader unit holds the code of another binary. Switching between programs of the same binary, or back to
+ * a program whose code is still there, costs a few dozen words.
+ */
+#pragma once
+
+#include <3ds.h>
+#include "gpustateblock.h"
+#include "gpuuniform.h"
+
+#define GPU_SHADER_MAX_PROGRAMS 16
+//Different uniform names in all the programs
+#define GPU_SHADER_MAX_UNIFORMS 64
+
+typedef struct {
+    const char* name;               ///< Of the sources in data/, eg. "shader" for data/shader.vsh
+    DVLE_s* vsh;
+    DVLE_s* gsh;                    ///< NULL without geometry shader
+    s8 vshUniforms[GPU_SHADER_MAX_UNIFORMS];    ///< Float register of each uniform id, -1 if the shader doesn't have it
+    s8 gshUniforms[GPU_SHADER_MAX_UNIFORMS];
+    u32 constRegs[GPU_FLOAT_UNIFORMS / 32];     ///< Vertex float registers written by its .constf when switching to it
+    gpu_state_block config;         ///< Everything shaderProgramUse sends but the code
+} gpu_shader_program;
+
+/**
+* Loads the binaries, resolves the uniforms and bakes the switch of every program.
+* Needs a command buffer (to record the state blocks), gpuUIInit calls it.
+* @return false if a binary couldn't be loaded, the programs that could are usable
+*/
+bool gpuShaderInit();
+void gpuShaderExit();
+
+u32 gpuShaderCount();
+gpu_shader_program* gpuShaderGet(u32 index);
+/**
+* @return NULL if there is no data/<name>.vsh
+*/
+gpu_shader_program* gpuShaderFind(const char* name);
+
+/**
+* @return The id of a float uniform of any program, -1 if none has it
+*/
+s32 gpuShaderUniformId(const char* name);
+/**
+* @return The float register of a uniform in a program, -1 if it doesn't have it
+*/
+static inline s32 gpuShaderUniformReg(const gpu_shader_program* program, GPU_SHADER_TYPE type, s32 id)
+{
+    if(!program || id < 0 || id >= GPU_SHADER_MAX_UNIFORMS)return -1;
+    return type == GPU_GEOMETRY_SHADER ? program->gshUniforms[id] : program->vshUniforms[id];
+}
+
+/**
+* Switches to a program in the current command list, nothing is sent if it is already the current one.
+* The uniforms aren't taken care of, gpuSetShader (gpuframework.h) does it for gpuVertexUniforms.
+* @return false if the command list is full
+*/
+bool gpuShaderUse(gpu_shader_program* program);
+/**
+* @return The program of the last gpuShaderUse, NULL if unknown
+*/
+gpu_shader_program* gpuShaderCurrent();
+/**
+* Forgets which program and code the GPU has, needed if commands were sent to the GPU without gpuShaderUse
+* (eg. a replayed trace).
+*/
+void gpuShaderInvalidate();
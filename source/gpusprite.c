@@ -0,0 +1,250 @@
+/**
+ *@file gpusprite.c
+ *@author Lectem
+ *@date 17/10/2026
+ */
+#include "gpusprite.h"
+#include "transform.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SPRITE_KEYS (GPU_SPRITE_TEXTURES * GPU_SPRITE_TEVS)
+
+static inline u32 spriteKey(const gpu_sprite* s)
+{
+    return (s->texture % GPU_SPRITE_TEXTURES) * GPU_SPRITE_TEVS + s->tev % GPU_SPRITE_TEVS;
+}
+
+static void recordDefaultTev(void)
+{
+    GPU_SetTexEnv(0,
+                  GPU_TEVSOURCES(GPU_TEXTURE0, GPU_PRIMARY_COLOR, 0),
+                  GPU_TEVSOURCES(GPU_TEXTURE0, GPU_PRIMARY_COLOR, 0),
+                  GPU_TEVOPERANDS(0, 0, 0),
+                  GPU_TEVOPERANDS(0, 0, 0),
+                  GPU_MODULATE, GPU_MODULATE,
+                  0xFFFFFFFF);
+}
+
+bool gpuSpriteBatchInit(gpu_sprite_batch* batch, u32 capacity, u32 ringSize)
+{
+    u32 i;
+    memset(batch, 0, sizeof(*batch));
+    if(!capacity || capacity > 0x10000)return false;
+    gpuVertexFormatPosCol(&batch->format);
+    batch->capacity = capacity;
+    batch->sprites = malloc(capacity * sizeof(gpu_sprite));
+    batch->order = malloc(capacity * sizeof(u16));
+    //The indices are after every vertex of the ring, where the PICA can reach them from any draw
+    batch->ringSize = ringSize & ~0x7F;
+    batch->ring = gpuArenaAlloc(&gpuArena, batch->ringSize + GPU_SPRITE_MAX_PER_DRAW * 6 * sizeof(u16), 0x80);
+    if(!batch->sprites || !batch->order || !batch->ring || !gpuSpriteBatchSetTev(batch, 0, recordDefaultTev))
+    {
+        gpuSpriteBatchExit(batch);
+        return false;
+    }
+    batch->indices = (u16*)(batch->ring + batch->ringSize);
+    for(i = 0; i < GPU_SPRITE_MAX_PER_DRAW; ++i)
+    {
+        u16* quad = &batch->indices[6 * i];
+        quad[0] = 4 * i;
+        quad[1] = 4 * i + 1;
+        quad[2] = 4 * i + 2;
+        quad[3] = 4 * i + 2;
+        quad[4] = 4 * i + 3;
+        quad[5] = 4 * i;
+    }
+    GSPGPU_FlushDataCache(NULL, (u8*)batch->indices, GPU_SPRITE_MAX_PER_DRAW * 6 * sizeof(u16));
+    return true;
+}
+
+void gpuSpriteBatchExit(gpu_sprite_batch* batch)
+{
+    u32 i;
+    for(i = 0; i < GPU_SPRITE_TEVS; ++i)gpuStateBlockFree(&batch->tevs[i]);
+    free(batch->sprites);
+    free(batch->order);
+    batch->sprites = NULL;
+    batch->order = NULL;
+    batch->ring = NULL;
+    batch->count = batch->capacity = 0;
+}
+
+void gpuSpriteBatchSetTexture(gpu_sprite_batch* batch, u8 index, u32* data, u16 width, u16 height, GPU_TEXCOLOR format, u32 param)
+{
+    gpu_sprite_texture* t;
+    if(index >= GPU_SPRITE_TEXTURES)return;
+    t = &batch->textures[index];
+    t->data = data;
+    t->width = width;
+    t->height = height;
+    t->format = format;
+    t->param = param;
+}
+
+bool gpuSpriteBatchSetTev(gpu_sprite_batch* batch, u8 index, void (*record)(void))
+{
+    gpu_state_block* block;
+    if(index >= GPU_SPRITE_TEVS)return false;
+    block = &batch->tevs[index];
+    gpuStateBlockFree(block);
+    if(!gpuStateBlockBegin(block, 0x80))return false;
+    record();
+    if(!gpuStateBlockEnd(block))
+    {
+        gpuStateBlockFree(block);
+        return false;
+    }
+    return true;
+}
+
+void gpuSpriteBatchBegin(gpu_sprite_batch* batch)
+{
+    u32 frame = gpuFrameNumber(), slot = frame % GPU_CMD_BUFFERS, oldest = 0, i;
+    if(batch->frameNumber[slot] == frame)return;
+    batch->frameNumber[slot] = frame;
+
+    //Free space ends where the oldest frame the GPU may still be reading starts
+    batch->tail = batch->head;
+    for(i = 0; i < GPU_CMD_BUFFERS; ++i)
+    {
+        u32 age = frame - batch->frameNumber[i];
+        if(i == slot || !batch->frameNumber[i] || age >= GPU_CMD_BUFFERS || age <= oldest)continue;
+        oldest = age;
+        batch->tail = batch->frameStart[i];
+    }
+    //Nothing in flight, start over from the beginning to keep the ring in one piece
+    if(batch->tail == batch->head)batch->head = batch->tail = 0;
+    batch->frameStart[slot] = batch->head;
+}
+
+static void* ringAlloc(gpu_sprite_batch* batch, u32 size)
+{
+    u32 offset = batch->head;
+    //head never catches up with tail from behind, head == tail means the ring is empty
+    if(batch->head >= batch->tail)
+    {
+        if(batch->head + size > batch->ringSize)
+        {
+            if(size >= batch->tail)return NULL;
+            offset = 0;
+        }
+    }
+    else if(batch->head + size >= batch->tail)return NULL;
+    batch->head = offset + size;
+    return batch->ring + offset;
+}
+
+void gpuSpriteBatchAdd(gpu_sprite_batch* batch, const gpu_sprite* sprite)
+{
+    if(batch->count == batch->capacity)gpuSpriteBatchFlush(batch);
+    if(batch->count < batch->capacity)batch->sprites[batch->count++] = *sprite;
+}
+
+static void writeSprite(vertex_pos_col* v, const gpu_sprite* s)
+{
+    //Corners relative to the center, in the order of the quad indices
+    float hw = s->w * 0.5f, hh = s->h * 0.5f;
+    float cx = s->x + hw, cy = s->y + hh;
+    const float dx[4] = {-hw, hw, hw, -hw};
+    const float dy[4] = {-hh, -hh, hh, hh};
+    const float u[4] = {s->u0, s->u1, s->u1, s->u0};
+    const float t[4] = {s->v0, s->v0, s->v1, s->v1};
+    const vector_4u8 color = {s->color & 0xFF, (s->color >> 8) & 0xFF, (s->color >> 16) & 0xFF, s->color >> 24};
+    float sn = 0.0f, cs = 1.0f;
+    u32 k;
+    if(s->angle != 0.0f)mtxSinCos(s->angle, &sn, &cs);
+    for(k = 0; k < 4; ++k)
+    {
+        v[k].position.x = cx + dx[k] * cs - dy[k] * sn;
+        v[k].position.y = cy + dx[k] * sn + dy[k] * cs;
+        v[k].position.z = s->z;
+        v[k].color = color;
+        v[k].texpos.x = u[k];
+        v[k].texpos.y = t[k];
+    }
+}
+
+void gpuSpriteBatchFlush(gpu_sprite_batch* batch)
+{
+    u32 offsets[SPRITE_KEYS];
+    u32 i, first, n, r, run, sum = 0;
+    s32 texture = -1, tev = -1;
+    if(!batch->count)return;
+    gpuSpriteBatchBegin(batch);
+    batch->stats.flushes++;
+
+    //Counting sort on the state, stable so that the sprites of a state keep the order they were added in
+    memset(offsets, 0, sizeof(offsets));
+    for(i = 0; i < batch->count; ++i)offsets[spriteKey(&batch->sprites[i])]++;
+    for(i = 0; i < SPRITE_KEYS; ++i)
+    {
+        u32 c = offsets[i];
+        offsets[i] = sum;
+        sum += c;
+    }
+    for(i = 0; i < batch->count; ++i)batch->order[offsets[spriteKey(&batch->sprites[i])]++] = i;
+
+    GPU_SetTextureEnable(GPU_TEXUNIT0);
+    for(first = 0; first < batch->count; first += n)
+    {
+        u32 size;
+        vertex_pos_col* vertices;
+        n = batch->count - first;
+        if(n > GPU_SPRITE_MAX_PER_DRAW)n = GPU_SPRITE_MAX_PER_DRAW;
+        size = n * 4 * sizeof(vertex_pos_col);
+        vertices = ringAlloc(batch, size);
+        if(!vertices)
+        {
+            batch->stats.dropped += batch->count - first;
+            break;
+        }
+        for(i = 0; i < n; ++i)writeSprite(&vertices[4 * i], &batch->sprites[batch->order[first + i]]);
+        GSPGPU_FlushDataCache(NULL, (u8*)vertices, size);
+        batch->stats.vertexBytes += size;
+        batch->stats.sprites += n;
+
+        //One attribute buffer for the whole chunk, each run starts further in the index buffer
+        gpuVertexFormatSetBuffer(&batch->format, vertices);
+        for(r = 0; r < n; r += run)
+        {
+            const gpu_sprite* s = &batch->sprites[batch->order[first + r]];
+            u32 key = spriteKey(s);
+            for(run = 1; r + run < n && spriteKey(&batch->sprites[batch->order[first + r + run]]) == key; ++run);
+
+            if((s32)(s->texture % GPU_SPRITE_TEXTURES) != texture)
+            {
+                const gpu_sprite_texture* t = &batch->textures[s->texture % GPU_SPRITE_TEXTURES];
+                texture = s->texture % GPU_SPRITE_TEXTURES;
+                if(t->data)
+                {
+                    GPU_SetTexture(GPU_TEXUNIT0, (u32*)osConvertVirtToPhys((u32)t->data), t->width, t->height, t->param, t->format);
+                    batch->stats.textureChanges++;
+                }
+            }
+            if((s32)(s->tev % GPU_SPRITE_TEVS) != tev)
+            {
+                tev = s->tev % GPU_SPRITE_TEVS;
+                if(batch->tevs[tev].cmds && gpuStateBlockAppend(&batch->tevs[tev]))batch->stats.tevChanges++;
+            }
+            gpuDrawElements(GPU_TRIANGLES, vertices, &batch->indices[6 * r], 6 * run, GPU_INDEX_U16);
+            batch->stats.draws++;
+        }
+    }
+    batch->count = 0;
+}
+
+void gpuSpriteBatchResetStats(gpu_sprite_batch* batch)
+{
+    memset(&batch->stats, 0, sizeof(batch->stats));
+}
+
+void gpuSpriteBatchPrint(FILE* f, const gpu_sprite_batch* batch, u64 ticks)
+{
+    const gpu_sprite_stats* s = &batch->stats;
+    fprintf(f, "sprites %lu (%lu dropped), %lu draws in %lu flushes\n",
+            (unsigned long)s->sprites, (unsigned long)s->dropped, (unsigned long)s->draws, (unsigned long)s->flushes);
+    fprintf(f, "texture changes %lu, tev changes %lu, %luK of vertices\n",
+            (unsigned long)s->textureChanges, (unsigned long)s->tevChanges, (unsigned long)(s->vertexBytes / 1024));
+    if(ticks)fprintf(f, "%llu sprites/s\n", (unsigned long long)((u64)s->sprites * SYSCLOCK_ARM11 / ticks));
+}
@@ -0,0 +1,116 @@
+/**
+ *@file gpusprite.h
+ *@author Lectem
+ *@date 17/10/2026
+ *
+ * Batched 2D sprites in the 400x240 drawing space of gpuUIInit.
+ *
+ * Sprites are queued with gpuSpriteBatchAdd, then gpuSpriteBatchFlush sorts them by texture and TEV setup,
+ * writes their vertices to a ring buffer in linear memory and draws each run of sprites sharing the same state
+ * with a single indexed draw. The state is only written when it changes from a run to the next.
+ *
+ * Sorting changes the drawing order of sprites that don't share a state: use z with the depth test when they overlap.
+ * The vertices of a frame stay in the ring until the GPU is done with it (see gpuFrameNumber), so the ring must
+ * hold the sprites of GPU_CMD_BUFFERS frames.
+ */
+#pragma once
+
+#include <3ds.h>
+#include <stdio.h>
+#include "gpuframework.h"
+#include "gpustateblock.h"
+#include "gpuvertex.h"
+
+//Textures and TEV setups a batch can switch between, sprites refer to them by index
+#define GPU_SPRITE_TEXTURES 16
+#define GPU_SPRITE_TEVS 16
+//Sprites drawn from the same vertex buffer address, the u16 indices of the largest draw are precomputed
+#define GPU_SPRITE_MAX_PER_DRAW 4096
+
+typedef struct {
+    float x, y;             ///< Corner of (u0, v0)
+    float w, h;             ///< Corner of (u1, v1) at (x + w, y + h)
+    float z;
+    float angle;            ///< Rotation around the center, in radians
+    float u0, v0, u1, v1;
+    u32 color;              ///< RGBA8(), multiplied with the texture by the default TEV setup
+    u8 texture, tev;
+} gpu_sprite;
+
+typedef struct {
+    u32* data;              ///< Tiled, in linear memory or VRAM
+    u16 width, height;
+    GPU_TEXCOLOR format;
+    u32 param;              ///< Filters and wrapping, as given to GPU_SetTexture
+} gpu_sprite_texture;
+
+typedef struct {
+    u32 sprites;            ///< Drawn
+    u32 dropped;            ///< Not drawn, the ring was full
+    u32 flushes;
+    u32 draws;
+    u32 textureChanges;
+    u32 tevChanges;
+    u32 vertexBytes;        ///< Written to the ring
+} gpu_sprite_stats;
+
+typedef struct {
+    gpu_sprite* sprites;    ///< Queued since the last flush
+    u32 count, capacity;
+    u16* order;             ///< Sorting scratch, capacity entries
+
+    gpu_sprite_texture textures[GPU_SPRITE_TEXTURES];
+    gpu_state_block tevs[GPU_SPRITE_TEVS];  ///< tevs[0] is texture 0 * vertex color
+
+    gpu_vertex_format format;   ///< vertex_pos_col
+    u8* ring;               ///< The vertex ring, followed by the indices, in gpuArena
+    u32 ringSize;
+    u32 head, tail;         ///< Free space is [head, tail[, wrapping around
+    //Ring offset of the first vertex of the last GPU_CMD_BUFFERS frames, and their gpuFrameNumber()
+    u32 frameStart[GPU_CMD_BUFFERS];
+    u32 frameNumber[GPU_CMD_BUFFERS];
+    u16* indices;           ///< 6 per quad, GPU_SPRITE_MAX_PER_DRAW quads
+
+    gpu_sprite_stats stats;
+} gpu_sprite_batch;
+
+/**
+* @param capacity Sprites queued before gpuSpriteBatchAdd flushes on its own, up to 65536
+* @param ringSize Bytes of vertices, 96 per sprite, for all the frames in flight
+* @return false if the memory couldn't be allocated, from the heap and gpuArena
+*/
+bool gpuSpriteBatchInit(gpu_sprite_batch* batch, u32 capacity, u32 ringSize);
+/**
+* Frees what gpuSpriteBatchInit allocated on the heap, the ring goes with gpuArena.
+*/
+void gpuSpriteBatchExit(gpu_sprite_batch* batch);
+
+/**
+* Textures sprites can use, on texture unit 0.
+*/
+void gpuSpriteBatchSetTexture(gpu_sprite_batch* batch, u8 index, u32* data, u16 width, u16 height, GPU_TEXCOLOR format, u32 param);
+/**
+* Records the TEV setup index, made by the GPU_SetTexEnv... calls of record. Index 0 is set up by gpuSpriteBatchInit.
+* @return false if the setup couldn't be recorded
+*/
+bool gpuSpriteBatchSetTev(gpu_sprite_batch* batch, u8 index, void (*record)(void));
+
+/**
+* To be called once per frame after gpuStartFrame(), before adding sprites. Takes back the ring space of the frames
+* the GPU is done with. gpuSpriteBatchFlush calls it if it wasn't.
+*/
+void gpuSpriteBatchBegin(gpu_sprite_batch* batch);
+/**
+* Queues a sprite, flushing the queue first if it is full.
+*/
+void gpuSpriteBatchAdd(gpu_sprite_batch* batch, const gpu_sprite* sprite);
+/**
+* Draws the queued sprites. Sets the attribute buffers, texture unit 0 and the TEV stages of the setups in use.
+*/
+void gpuSpriteBatchFlush(gpu_sprite_batch* batch);
+
+void gpuSpriteBatchResetStats(gpu_sprite_batch* batch);
+/**
+* Prints the stats, and the sprites per second if ticks (the time it took) isn't 0.
+*/
+void gpuSpriteBatchPrint(FILE* f, const gpu_sprite_batch* batch, u64 ticks);
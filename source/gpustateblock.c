@@ -0,0 +1,70 @@
+/**
+ *@file gpustateblock.c
+ *@author Lectem
+ *@date 17/10/2026
+ */
+#include "gpustateblock.h"
+#include <string.h>
+
+//GPUCMD_Add silently drops what doesn't fit, so consider the block full a bit before its end.
+//The biggest write of the GPU_* functions is the 0x28 params of GPU_SetAttributeBuffers.
+#define BLOCK_SLACK 0x40
+
+bool gpuStateBlockBegin(gpu_state_block* block, u32 capacity)
+{
+    block->size = 0;
+    block->capacity = capacity + BLOCK_SLACK;
+    block->cmds = linearAlloc(block->capacity * sizeof(u32));
+    if(!block->cmds)return false;
+
+    GPUCMD_GetBuffer(&block->savedBuffer, &block->savedSize, &block->savedOffset);
+    GPUCMD_SetBuffer(block->cmds, block->capacity, 0);
+    return true;
+}
+
+bool gpuStateBlockEnd(gpu_state_block* block)
+{
+    GPUCMD_GetBuffer(NULL, NULL, &block->size);
+    GPUCMD_SetBuffer(block->savedBuffer, block->savedSize, block->savedOffset);
+    return block->size + BLOCK_SLACK <= block->capacity;
+}
+
+void gpuStateBlockFree(gpu_state_block* block)
+{
+    if(block->cmds)linearFree(block->cmds);
+    block->cmds = NULL;
+    block->size = 0;
+}
+
+u32* gpuStateBlockAppend(const gpu_state_block* block)
+{
+    u32* buffer;
+    u32 size, offset;
+    GPUCMD_GetBuffer(&buffer, &size, &offset);
+    if(!buffer || offset + block->size > size)return NULL;
+
+    //Blocks only contain whole commands, so they keep the list 8 bytes aligned
+    memcpy(&buffer[offset], block->cmds, block->size * sizeof(u32));
+    GPUCMD_SetBufferOffset(offset + block->size);
+    return &buffer[offset];
+}
+
+s32 gpuStateBlockFind(const gpu_state_block* block, u16 reg)
+{
+    s32 found = -1;
+    u32 i = 0, k;
+    while(i + 1 < block->size)
+    {
+        //See http://3dbrew.org/wiki/GPU#Command_Buffer: [param0, header, params..., padding]
+        u32 header = block->cmds[i + 1];
+        u32 cmdReg = header & 0xFFFF;
+        u32 extra = (header >> 20) & 0x7FF;
+        for(k = 0; k <= extra; ++k)
+        {
+            u32 r = (header & 0x80000000) ? cmdReg + k : cmdReg;
+            if(r == reg)found = k ? i + 1 + k : i;
+        }
+        i += 2 + extra + (extra & 1);
+    }
+    return found;
+}
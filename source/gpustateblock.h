@@ -0,0 +1,48 @@
+/**
+ *@file gpustateblock.h
+ *@author Lectem
+ *@date 17/10/2026
+ *
+ * Prebaked command lists for state that doesn't change from one frame to the next.
+ *
+ * A block is recorded once with the usual GPU_* functions, then copied as is into the frame command list
+ * instead of calling them again. The params that do change (a TEV source, a buffer address...) are found
+ * once with gpuStateBlockFind and patched, either in the block itself or in the copy returned by
+ * gpuStateBlockAppend.
+ */
+#pragma once
+
+#include <3ds.h>
+
+typedef struct {
+    u32* cmds;      ///< In linear memory
+    u32 size;       ///< In words
+    u32 capacity;   ///< In words
+    //The command buffer in use when the recording started
+    u32* savedBuffer;
+    u32 savedSize, savedOffset;
+} gpu_state_block;
+
+/**
+* Redirects the GPU_* functions to the block until gpuStateBlockEnd.
+* @param capacity Maximum size of the block in words
+* @return false if the block couldn't be allocated
+*/
+bool gpuStateBlockBegin(gpu_state_block* block, u32 capacity);
+/**
+* Stops recording and goes back to the previous command buffer.
+* @return false if the block was too small for everything that was recorded
+*/
+bool gpuStateBlockEnd(gpu_state_block* block);
+void gpuStateBlockFree(gpu_state_block* block);
+
+/**
+* Copies the block at the end of the current command list.
+* @return The copy (to patch it), or NULL if there was no room left
+*/
+u32* gpuStateBlockAppend(const gpu_state_block* block);
+/**
+* Finds the last write to a register in the block.
+* @return The index of the param word in block->cmds, or -1
+*/
+s32 gpuStateBlockFind(const gpu_state_block* block, u16 reg);
@@ -0,0 +1,216 @@
+/**
+ *@file gputarget.c
+ *@author Lectem
+ *@date 17/10/2026
+ */
+#include "gputarget.h"
+#include "gpuframework.h"
+#include "gpureadback.h"
+#include "gputexture.h"
+#include "gputiming.h"
+#include <string.h>
+
+//The VRAM before, between and after the screen buffers
+#define VRAM_ARENAS 3
+static gpu_arena vramArenas[VRAM_ARENAS];
+static bool vramReady = false;
+
+static const gpu_target* currentTarget = NULL;
+
+typedef struct {
+    u32* start;
+    u32* end;
+    u32 value;
+    u16 control;
+} target_fill;
+static target_fill pendingFills[GPU_TARGET_MAX_CLEARS * 2];
+static u32 numPendingFills = 0;
+
+//Low bits of the color format register
+static const u8 pixelSizes[] = {2, 1, 0, 0, 0};
+
+static u32 colorBpp(gpu_target_color format)
+{
+    switch(format)
+    {
+        case GPU_TARGET_RGBA8: return 4;
+        case GPU_TARGET_RGB8: return 3;
+        default: return 2;
+    }
+}
+
+static u32 depthBpp(gpu_target_depth format)
+{
+    switch(format)
+    {
+        case GPU_TARGET_D16: return 2;
+        case GPU_TARGET_D24: return 3;
+        case GPU_TARGET_D24S8: return 4;
+        default: return 0;
+    }
+}
+
+static void initVram()
+{
+    u32 fbBytes = GPU_FB_WIDTH * GPU_FB_HEIGHT * 4;
+    u32 a = (u32)gpuColorBuffer < (u32)gpuDBuffer ? (u32)gpuColorBuffer : (u32)gpuDBuffer;
+    u32 b = (u32)gpuColorBuffer < (u32)gpuDBuffer ? (u32)gpuDBuffer : (u32)gpuColorBuffer;
+    gpuArenaInitFrom(&vramArenas[0], (void*)OS_VRAM_VADDR, a - OS_VRAM_VADDR);
+    gpuArenaInitFrom(&vramArenas[1], (void*)(a + fbBytes), b - (a + fbBytes));
+    gpuArenaInitFrom(&vramArenas[2], (void*)(b + fbBytes), OS_VRAM_VADDR + OS_VRAM_SIZE - (b + fbBytes));
+    vramReady = true;
+}
+
+bool gpuTargetCreate(gpu_target* target, u16 width, u16 height, gpu_target_color color, gpu_target_depth depth, u32 flags)
+{
+    u32 colorBytes = width * height * colorBpp(color);
+    u32 depthBytes = width * height * depthBpp(depth);
+    //Both buffers in one block, the depth buffer 0x80 aligned after the color one
+    u32 colorSpace = (colorBytes + 0x7F) & ~0x7F;
+    u8* mem = NULL;
+    int i;
+
+    memset(target, 0, sizeof(*target));
+    if(!width || !height || (width & 7) || (height & 7) || width > 1024 || height > 1024)return false;
+    if(color > GPU_TARGET_RGBA4 || (depth != GPU_TARGET_NO_DEPTH && !depthBpp(depth)))return false;
+
+    if(flags & GPU_TARGET_VRAM)
+    {
+        if(!vramReady)initVram();
+        for(i = 0; i < VRAM_ARENAS && !mem; ++i)
+        {
+            target->mark = gpuArenaMark(&vramArenas[i]);
+            if((mem = gpuArenaAlloc(&vramArenas[i], colorSpace + depthBytes, 0x80)))target->arena = &vramArenas[i];
+        }
+    }
+    else mem = linearMemAlign(colorSpace + depthBytes, 0x80);
+    if(!mem)return false;
+
+    target->width = width;
+    target->height = height;
+    target->colorFormat = color;
+    target->depthFormat = depthBytes ? depth : GPU_TARGET_NO_DEPTH;
+    target->color = mem;
+    target->depth = depthBytes ? mem + colorSpace : NULL;
+    return true;
+}
+
+void gpuTargetFree(gpu_target* target)
+{
+    if(!target->color)return;
+    if(currentTarget == target)currentTarget = NULL;
+    if(target->arena)gpuArenaRelease(target->arena, target->mark);
+    else linearFree(target->color);
+    memset(target, 0, sizeof(*target));
+}
+
+void gpuSetTarget(const gpu_target* target)
+{
+    currentTarget = target;
+    if(!target)
+    {
+        //Viewport (http://3dbrew.org/wiki/GPU_Commands#Command_0x0041)
+        GPU_SetViewport((u32 *)osConvertVirtToPhys((u32)gpuDBuffer),
+                        (u32 *)osConvertVirtToPhys((u32) gpuColorBuffer),
+                        0, 0,
+                //Our screen is 400*240, but the GPU actually renders to 400*480 and then downscales it SetDisplayTransfer bit 24 is set
+                //This is the case here (See http://3dbrew.org/wiki/GPU#0x1EF00C10 for more details)
+                        240*2, 400);
+        return;
+    }
+    //Also flushes what was drawn to the previous target, and sets the framebuffer access
+    GPU_SetViewport(target->depth ? (u32*)osConvertVirtToPhys((u32)target->depth) : NULL,
+                    (u32*)osConvertVirtToPhys((u32)target->color),
+                    0, 0, target->width, target->height);
+    //GPU_SetViewport only knows RGBA8 and D24S8
+    GPUCMD_AddWrite(GPUREG_0117, (target->colorFormat << 16) | pixelSizes[target->colorFormat]);
+    if(target->depth)GPUCMD_AddWrite(GPUREG_0116, target->depthFormat);
+    else
+    {
+        //No depth reads or writes, the depth test doesn't have to be disabled
+        GPUCMD_AddWrite(GPUREG_0114, 0);
+        GPUCMD_AddWrite(GPUREG_0115, 0);
+    }
+}
+
+const gpu_target* gpuGetTarget()
+{
+    return currentTarget;
+}
+
+static bool addFill(void* start, u32 bytes, u32 value, u32 bpp)
+{
+    target_fill* f;
+    if(numPendingFills == sizeof(pendingFills) / sizeof(pendingFills[0]))return false;
+    f = &pendingFills[numPendingFills++];
+    f->start = start;
+    f->end = (u32*)((u8*)start + bytes);
+    f->value = value;
+    //Bit 0 starts the fill, bits 8-9 are the size of the value: 16, 24 or 32 bits
+    f->control = ((bpp - 2) << 8) | 0x1;
+    return true;
+}
+
+bool gpuTargetClear(const gpu_target* target, u32 buffers, u32 color, u32 depth)
+{
+    u32 pixels = target->width * target->height;
+    u32 needed = ((buffers & GPU_CLEAR_COLOR) ? 1 : 0) + ((buffers & GPU_CLEAR_DEPTH) && target->depth ? 1 : 0);
+    if(numPendingFills + needed > sizeof(pendingFills) / sizeof(pendingFills[0]))return false;
+    if(buffers & GPU_CLEAR_COLOR)addFill(target->color, pixels * colorBpp(target->colorFormat), color, colorBpp(target->colorFormat));
+    if((buffers & GPU_CLEAR_DEPTH) && target->depth)
+        addFill(target->depth, pixels * depthBpp(target->depthFormat), depth, depthBpp(target->depthFormat));
+    return true;
+}
+
+void gpuTargetRunClears()
+{
+    u32 i;
+    if(!numPendingFills)return;
+    u64 start = svcGetSystemTick();
+    //Two at a time, one per memory fill unit
+    for(i = 0; i < numPendingFills; i += 2)
+    {
+        const target_fill* f0 = &pendingFills[i];
+        const target_fill* f1 = i + 1 < numPendingFills ? &pendingFills[i + 1] : NULL;
+        if(f1)GX_SetMemoryFill(NULL, f0->start, f0->value, f0->end, f0->control, f1->start, f1->value, f1->end, f1->control);
+        else GX_SetMemoryFill(NULL, f0->start, f0->value, f0->end, f0->control, NULL, 0, NULL, 0);
+        gspWaitForPSC0();
+        if(f1)gspWaitForPSC1();
+    }
+    numPendingFills = 0;
+    gpuTimingAdd(GPU_PHASE_FILL, svcGetSystemTick() - start);
+}
+
+GPU_TEXCOLOR gpuTargetTextureFormat(const gpu_target* target)
+{
+    //Same values for the formats that are both
+    return (GPU_TEXCOLOR)target->colorFormat;
+}
+
+void gpuTargetBindTexture(const gpu_target* target, GPU_TEXUNIT unit, u32 param)
+{
+    GPU_SetTexture(unit, (u32*)osConvertVirtToPhys((u32)target->color), target->width, target->height, param,
+                   gpuTargetTextureFormat(target));
+}
+
+bool gpuTargetReadback(const gpu_target* target, u32 buffer, void* out)
+{
+    u32 pixels = target->width * target->height;
+    if(buffer == GPU_CLEAR_COLOR)
+    {
+        //Linear heap targets may be in the data cache from an earlier readback
+        if(!target->arena)GSPGPU_InvalidateDataCache(NULL, (u32)target->color, pixels * colorBpp(target->colorFormat));
+        return gpuTextureUntile(out, target->color, target->width, target->height, gpuTargetTextureFormat(target), GPU_TEXTURE_FLIP_Y);
+    }
+    if(buffer != GPU_CLEAR_DEPTH || !target->depth)return false;
+    if(!target->arena)GSPGPU_InvalidateDataCache(NULL, (u32)target->depth, pixels * depthBpp(target->depthFormat));
+    switch(target->depthFormat)
+    {
+        //Raw 16 bits values, no byte swap
+        case GPU_TARGET_D16: return gpuTextureUntile(out, target->depth, target->width, target->height, GPU_RGB565, GPU_TEXTURE_FLIP_Y);
+        case GPU_TARGET_D24S8:
+            gpuUntile32(target->depth, out, target->width, target->height);
+            return true;
+        default: return false;
+    }
+}
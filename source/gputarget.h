@@ -0,0 +1,111 @@
+/**
+ *@file gputarget.h
+ *@author Lectem
+ *@date 17/10/2026
+ *
+ * Offscreen render targets: color and depth buffers other than gpuColorBuffer/gpuDBuffer, that are never shown.
+ *
+ * A target is drawn to between gpuSetTarget(target) and gpuSetTarget(NULL), in the same command list as everything
+ * else: the 400x240 drawing space is stretched over the whole target, like over the framebuffer, and
+ * gpuSetProjectionRegion and the scissor work the same way. Its color buffer has the tiled layout of the textures,
+ * so a later draw of the same frame can sample it (gpuTargetBindTexture), and the CPU can read it back
+ * (gpuTargetReadback) once the frame is done. No display transfer is involved.
+ *
+ * The memory comes from the VRAM left around the screen buffers, or from the linear heap.
+ */
+#pragma once
+
+#include <3ds.h>
+#include "gpuarena.h"
+
+//Values of the color buffer format register
+typedef enum {
+    GPU_TARGET_RGBA8 = 0,
+    GPU_TARGET_RGB8 = 1,
+    GPU_TARGET_RGBA5551 = 2,
+    GPU_TARGET_RGB565 = 3,
+    GPU_TARGET_RGBA4 = 4,
+} gpu_target_color;
+
+//Values of the depth buffer format register
+typedef enum {
+    GPU_TARGET_D16 = 0,
+    GPU_TARGET_D24 = 2,
+    GPU_TARGET_D24S8 = 3,
+    GPU_TARGET_NO_DEPTH = 0xFF,
+} gpu_target_depth;
+
+//gpuTargetCreate flags
+//In VRAM instead of the linear heap: faster to render to, but only about 4.5MB are left
+#define GPU_TARGET_VRAM 0x1
+
+//Pending gpuTargetClear per frame
+#define GPU_TARGET_MAX_CLEARS 16
+
+typedef struct {
+    u16 width, height;
+    gpu_target_color colorFormat;
+    gpu_target_depth depthFormat;
+    void* color;
+    void* depth;            ///< NULL without depth buffer
+    //VRAM targets come from an arena, see gpuTargetFree
+    gpu_arena* arena;
+    u32 mark;
+} gpu_target;
+
+/**
+* Allocates the buffers of a target.
+* @param width, height Multiples of 8 up to 1024, powers of 2 from 8 to be used as a texture
+* @param flags GPU_TARGET_VRAM
+* @return false if the size isn't supported or the memory is missing
+*/
+bool gpuTargetCreate(gpu_target* target, u16 width, u16 height, gpu_target_color color, gpu_target_depth depth, u32 flags);
+/**
+* VRAM is handed out like an arena: freeing a VRAM target also frees the VRAM targets created after it,
+* so free them in the reverse order. The GPU must be done with the target.
+*/
+void gpuTargetFree(gpu_target* target);
+
+/**
+* Draws to target from now on in the current command list, NULL goes back to the framebuffer.
+* The previous target is flushed, so it can be sampled or read back afterwards. gpuStartFrame starts on the framebuffer.
+*/
+void gpuSetTarget(const gpu_target* target);
+/**
+* @return The target being drawn to, NULL for the framebuffer
+*/
+const gpu_target* gpuGetTarget();
+
+/**
+* Fills buffers (GPU_CLEAR_COLOR, GPU_CLEAR_DEPTH) of a target before the commands of the frame being recorded run,
+* like gpuClearBuffers. It can't happen in the middle of a frame: draw over the target to clear it again.
+* @param color, depth Raw pixel values, eg. for GPU_TARGET_RGBA8 the color as read back from the framebuffer
+* @return false if there are already GPU_TARGET_MAX_CLEARS clears in this frame
+*/
+bool gpuTargetClear(const gpu_target* target, u32 buffers, u32 color, u32 depth);
+/**
+* Runs the clears of the frame, called by gpuSubmitFrame once the GPU is done with the previous one.
+*/
+void gpuTargetRunClears();
+
+/**
+* @return The texture format that samples the color buffer of a target
+*/
+GPU_TEXCOLOR gpuTargetTextureFormat(const gpu_target* target);
+/**
+* Samples the color buffer of a target with a texture unit, s and t following the x and y of the drawing space.
+* Don't sample the target being drawn to. GPU_SetTextureEnable afterwards flushes the texture cache.
+* @param param As for GPU_SetTexture (filters, wrapping)
+*/
+void gpuTargetBindTexture(const gpu_target* target, GPU_TEXUNIT unit, u32 param);
+
+/**
+* Copies a buffer of a target to a linear image, once the frame that drew it is done.
+* Like gpuReadbackColor, the first row of the image is the top of the drawing space.
+* The color buffer uses the byte order of gputexture.h for gpuTargetTextureFormat(target), the depth buffer
+* is only supported for GPU_TARGET_D16 (u16) and GPU_TARGET_D24S8 (u32, stencil in the high byte).
+* @param buffer GPU_CLEAR_COLOR or GPU_CLEAR_DEPTH
+* @param out width x height pixels
+* @return false if the buffer is missing or its format isn't supported
+*/
+bool gpuTargetReadback(const gpu_target* target, u32 buffer, void* out);
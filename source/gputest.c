@@ -0,0 +1,566 @@
+/**
+ *@file gputest.c
+ *@author Lectem
+ *@date 17/10/2026
+ */
+#include "gputest.h"
+#include <stdlib.h>
+#include <string.h>
+#include "gpuframework.h"
+#include "gpureadback.h"
+#include "gputarget.h"
+#include "gputexture.h"
+#include "gputiming.h"
+#include "gpuvertex.h"
+
+#define TEXTURE_SIZE 8
+
+static const gpu_test_suite* suites[GPU_TEST_MAX_SUITES];
+static u32 numSuites = 0;
+
+static gpu_vertex_format quad_format;
+
+//The textures of the page being recorded, in its frame arena, shared by the cases using the same color
+typedef struct {
+    u32 color;
+    u32* data;
+    bool rendered;          ///< Drawn in the atlas, see GPU_TEST_RENDER_TEXTURES
+} page_texture;
+static page_texture page_textures[GPU_TEST_TILES_PER_PAGE * GPU_TEST_MAX_TEXTURES];
+static u32 numPageTextures = 0;
+
+//Render targets for the textures of GPU_TEST_RENDER_TEXTURES, one per page in flight. Tile i of the atlas of a page
+//is the i-th texture of page_textures.
+#define ATLAS_WIDTH 256
+#define ATLAS_HEIGHT (GPU_TEST_TILES_PER_PAGE * GPU_TEST_MAX_TEXTURES * TEXTURE_SIZE * TEXTURE_SIZE / ATLAS_WIDTH)
+static gpu_target atlases[2];
+static gpu_target* pageAtlas = &atlases[0];
+
+//What pageDone needs to know about a tile, the case itself may have been generated
+typedef struct {
+    u8 suite;
+    bool skipped;           ///< Couldn't be recorded, out of frame memory
+    u32 index;
+    const char* name;
+    u32 expected;
+    u8 tolerance;
+    u32 flags;
+    u64 recordTicks;
+} test_tile;
+
+//A page of gpuTestRunAll waiting for the GPU
+typedef struct {
+    u32 count;
+    test_tile tiles[GPU_TEST_TILES_PER_PAGE];
+    FILE* report;
+    gpu_log* records;
+    gpu_test_summary* summary;
+} test_page;
+
+static test_page pages[2];
+//The console only shows the first failures of a run, the report has all of them
+#define MAX_PRINTED_FAILURES 8
+static u32 printedFailures = 0;
+
+bool gpuTestInit()
+{
+    gpuVertexFormatPosCol(&quad_format);
+    //Every pixel of a tile must match, and in stereo be the same in both eyes
+    gpuTileInit();
+    //Without them, the cases with GPU_TEST_RENDER_TEXTURES are skipped
+    return gpuTargetCreate(&atlases[0], ATLAS_WIDTH, ATLAS_HEIGHT, GPU_TARGET_RGBA8, GPU_TARGET_NO_DEPTH, GPU_TARGET_VRAM) &&
+           gpuTargetCreate(&atlases[1], ATLAS_WIDTH, ATLAS_HEIGHT, GPU_TARGET_RGBA8, GPU_TARGET_NO_DEPTH, GPU_TARGET_VRAM);
+}
+
+void gpuTestExit()
+{
+    gpuTargetFree(&atlases[1]);
+    gpuTargetFree(&atlases[0]);
+    gpuTileExit();
+    numSuites = 0;
+}
+
+bool gpuTestRegister(const gpu_test_suite* suite)
+{
+    if(numSuites == GPU_TEST_MAX_SUITES)return false;
+    suites[numSuites++] = suite;
+    return true;
+}
+
+void gpuTestGetCase(const gpu_test_suite* suite, u32 index, gpu_test_case* out)
+{
+    if(suite->cases)
+    {
+        *out = suite->cases[index];
+        return;
+    }
+    memset(out, 0, sizeof(*out));
+    if(suite->generate)suite->generate(index, out);
+}
+
+/**
+* Reads up to max comma separated hex numbers.
+* @return How many were read
+*/
+static u32 parseHexList(const char* text, u32* values, u32 max)
+{
+    u32 n = 0;
+    while(n < max && *text)
+    {
+        char* end;
+        values[n++] = strtoul(text, &end, 16);
+        if(*end != ',')break;
+        text = end + 1;
+    }
+    return n;
+}
+
+/**
+* Fills a case from a line of gpuTestLoadSuite.
+* @return false if there is nothing to run in the line
+*/
+static bool parseCase(char* line, gpu_test_case* c)
+{
+    char* save = NULL;
+    char* token;
+    bool any = false;
+    memset(c, 0, sizeof(*c));
+    for(token = strtok_r(line, " \t\r\n", &save); token; token = strtok_r(NULL, " \t\r\n", &save))
+    {
+        char* value = strchr(token, '=');
+        u32 v[7];
+        if(value)*value++ = '\0';
+        if(!strcmp(token, "record"))c->flags |= GPU_TEST_RECORD_ONLY;
+        if(!strcmp(token, "rendered"))c->flags |= GPU_TEST_RENDER_TEXTURES;
+        if(!value)continue;
+
+        if(!strcmp(token, "name"))
+        {
+            free((char*)c->name);
+            c->name = strdup(value);
+        }
+        else if(!strcmp(token, "shader"))
+        {
+            free((char*)c->shader);
+            c->shader = strdup(value);
+        }
+        else if(!strcmp(token, "tex"))c->numTextures = parseHexList(value, c->textures, GPU_TEST_MAX_TEXTURES);
+        else if(!strcmp(token, "tev") && c->numStages < 6 && parseHexList(value, v, 7) == 7)
+        {
+            const gpu_test_tev tev = {v[0], v[1], v[2], v[3], v[4], v[5], v[6]};
+            c->tev[c->numStages++] = tev;
+        }
+        else if(!strcmp(token, "blend") && parseHexList(value, v, 7) == 7)
+        {
+            const gpu_test_blend blend = {true, v[0], v[1], v[2], v[3], v[4], v[5], v[6]};
+            c->blend = blend;
+        }
+        else if(!strcmp(token, "alpha") && parseHexList(value, v, 2) == 2)
+        {
+            const gpu_test_alpha alpha = {true, v[0], v[1]};
+            c->alphaTest = alpha;
+        }
+        else if(!strcmp(token, "quad") && c->numQuads < GPU_TEST_MAX_QUADS)
+        {
+            gpu_test_quad* q = &c->quads[c->numQuads++];
+            char* end;
+            memset(q, 0, sizeof(*q));
+            q->color = strtoul(value, &end, 16);
+            q->z = *end == ',' ? strtof(end + 1, NULL) : 0.5f;
+        }
+        else if(!strcmp(token, "expected"))c->expected = strtoul(value, NULL, 16);
+        else if(!strcmp(token, "tolerance"))c->tolerance = strtoul(value, NULL, 10);
+        else continue;
+        any = true;
+    }
+    return any;
+}
+
+bool gpuTestLoadSuite(gpu_test_suite* suite, const char* name, const char* path)
+{
+    FILE* f = fopen(path, "r");
+    char line[1024];
+    gpu_test_case* cases = NULL;
+    u32 count = 0, capacity = 0;
+    memset(suite, 0, sizeof(*suite));
+    suite->name = name;
+    if(!f)return false;
+    while(fgets(line, sizeof(line), f))
+    {
+        gpu_test_case c;
+        if(line[0] == '#' || !parseCase(line, &c))continue;
+        if(count == capacity)
+        {
+            gpu_test_case* grown;
+            capacity = capacity ? capacity * 2 : 64;
+            grown = realloc(cases, capacity * sizeof(gpu_test_case));
+            if(!grown)
+            {
+                free((char*)c.name);
+                free((char*)c.shader);
+                break;
+            }
+            cases = grown;
+        }
+        cases[count++] = c;
+    }
+    fclose(f);
+    suite->cases = cases;
+    suite->count = count;
+    if(!count)gpuTestFreeSuite(suite);
+    return count != 0;
+}
+
+void gpuTestFreeSuite(gpu_test_suite* suite)
+{
+    u32 i;
+    for(i = 0; i < suite->count; ++i)
+    {
+        free((char*)suite->cases[i].name);
+        free((char*)suite->cases[i].shader);
+    }
+    free((gpu_test_case*)suite->cases);
+    suite->cases = NULL;
+    suite->count = 0;
+}
+
+static void writeQuad(vertex_pos_col* v, u8* indices, u32 first, const gpu_test_quad* q)
+{
+    float x0 = q->x, y0 = q->y, x1 = q->x + q->w, y1 = q->y + q->h;
+    const vector_4u8 color = {q->color & 0xFF, (q->color >> 8) & 0xFF, (q->color >> 16) & 0xFF, q->color >> 24};
+    u32 k;
+    if(q->w <= 0.0f || q->h <= 0.0f)
+    {
+        x0 = 0.0f; y0 = 0.0f;
+        x1 = GPU_UI_WIDTH; y1 = GPU_UI_HEIGHT;
+    }
+    const float xs[4] = {x0, x1, x1, x0};
+    const float ys[4] = {y0, y0, y1, y1};
+    for(k = 0; k < 4; ++k)
+    {
+        v[k].position.x = xs[k];
+        v[k].position.y = ys[k];
+        v[k].position.z = q->z;
+        v[k].color = color;
+        v[k].texpos.x = k == 1 || k == 2 ? 1.0f : 0.0f;
+        v[k].texpos.y = k >= 2 ? 1.0f : 0.0f;
+    }
+    indices[0] = first;
+    indices[1] = first + 1;
+    indices[2] = first + 2;
+    indices[3] = first + 2;
+    indices[4] = first + 3;
+    indices[5] = first;
+}
+
+/**
+* Draws an 8x8 texture of a single color in a tile of the atlas of the page, in the command list of the page.
+* The draw changes the state of the framebuffer, the case sets its own afterwards.
+*/
+static u32* renderTexture(u32 color)
+{
+    const gpu_test_quad quad = {0.0f, 0.0f, 0.0f, 0.0f, 0.5f, color};
+    u32 tile = numPageTextures;
+    u32 x = (tile % (ATLAS_WIDTH / TEXTURE_SIZE)) * TEXTURE_SIZE, y = (tile / (ATLAS_WIDTH / TEXTURE_SIZE)) * TEXTURE_SIZE;
+    u32 size = 4 * sizeof(vertex_pos_col);
+    vertex_pos_col* vertices;
+
+    if(!pageAtlas->color || y >= pageAtlas->height)return NULL;
+    vertices = gpuFrameAlloc(size + 6, 0x10);
+    if(!vertices)return NULL;
+    writeQuad(vertices, (u8*)vertices + size, 0, &quad);
+    GSPGPU_FlushDataCache(NULL, (u8*)vertices, size + 6);
+
+    gpuSetTarget(pageAtlas);
+    gpuDisableEverything();
+    GPU_SetTexEnv(0,
+                  GPU_TEVSOURCES(GPU_PRIMARY_COLOR, 0, 0), GPU_TEVSOURCES(GPU_PRIMARY_COLOR, 0, 0),
+                  GPU_TEVOPERANDS(0, 0, 0), GPU_TEVOPERANDS(0, 0, 0),
+                  GPU_REPLACE, GPU_REPLACE, 0xFFFFFFFF);
+    GPU_SetScissorTest(GPU_SCISSOR_NORMAL, x, y, TEXTURE_SIZE, TEXTURE_SIZE);
+    gpuSetShader(NULL);
+    gpuSetProjectionRegion(x * (float)GPU_UI_WIDTH / ATLAS_WIDTH, y * (float)GPU_UI_HEIGHT / ATLAS_HEIGHT,
+                           TEXTURE_SIZE * (float)GPU_UI_WIDTH / ATLAS_WIDTH, TEXTURE_SIZE * (float)GPU_UI_HEIGHT / ATLAS_HEIGHT);
+    gpuUniformBlockUpload(&gpuVertexUniforms);
+    gpuVertexFormatBind(&quad_format, vertices);
+    gpuDrawElements(GPU_TRIANGLES, vertices, (u8*)vertices + size, 6, GPU_INDEX_U8);
+    gpuSetTarget(NULL);
+    //Each tile of 8x8 pixels is contiguous, and is a texture by itself.
+    //Like in the framebuffer, the rows of tiles are stored from the other end of y (see GPU_FB_HEIGHT).
+    tile = (ATLAS_HEIGHT / TEXTURE_SIZE - 1 - y / TEXTURE_SIZE) * (ATLAS_WIDTH / TEXTURE_SIZE) + x / TEXTURE_SIZE;
+    return (u32*)pageAtlas->color + tile * TEXTURE_SIZE * TEXTURE_SIZE;
+}
+
+static u32* pageTexture(u32 color, bool rendered)
+{
+    u32 image[TEXTURE_SIZE * TEXTURE_SIZE];
+    u32 i;
+    u32* data;
+    for(i = 0; i < numPageTextures; ++i)
+    {
+        if(page_textures[i].color == color && page_textures[i].rendered == rendered)return page_textures[i].data;
+    }
+    if(numPageTextures == sizeof(page_textures) / sizeof(page_textures[0]))return NULL;
+    if(rendered)
+    {
+        if(!(data = renderTexture(color)))return NULL;
+        page_textures[numPageTextures].color = color;
+        page_textures[numPageTextures].data = data;
+        page_textures[numPageTextures].rendered = true;
+        numPageTextures++;
+        return data;
+    }
+    data = gpuFrameAlloc(sizeof(image), 0x80);
+    if(!data)return NULL;
+    for(i = 0; i < TEXTURE_SIZE * TEXTURE_SIZE; ++i)image[i] = color;
+    gpuTextureTile(data, image, TEXTURE_SIZE, TEXTURE_SIZE, GPU_RGBA8, 0);
+    GSPGPU_FlushDataCache(NULL, (u8*)data, sizeof(image));
+    page_textures[numPageTextures].color = color;
+    page_textures[numPageTextures].data = data;
+    page_textures[numPageTextures].rendered = false;
+    numPageTextures++;
+    return data;
+}
+
+/**
+* Records a case in its tile. Everything it needs from the frame arena is allocated first, so nothing is recorded
+* if it doesn't fit.
+* @return false if the frame arena or the command list is full
+*/
+static bool recordCase(u32 tile, const gpu_test_case* c)
+{
+    static const gpu_test_quad white = {0.0f, 0.0f, 0.0f, 0.0f, 0.5f, RGBA8(0xFF, 0xFF, 0xFF, 0xFF)};
+    const gpu_test_quad* quads = c->numQuads ? c->quads : &white;
+    u32 numQuads = c->numQuads ? c->numQuads : 1;
+    u32* textures[GPU_TEST_MAX_TEXTURES];
+    u32 numTextures = c->numTextures < GPU_TEST_MAX_TEXTURES ? c->numTextures : GPU_TEST_MAX_TEXTURES;
+    u32 i, size;
+    vertex_pos_col* vertices;
+    u8* indices;
+    u16 x, y;
+    gpu_region r;
+
+    gpuTileOrigin(tile, &x, &y);
+    r = gpuRegionFromUI(x, y, GPU_TILE_W, GPU_TILE_H);
+    if(numQuads > GPU_TEST_MAX_QUADS)numQuads = GPU_TEST_MAX_QUADS;
+    for(i = 0; i < numTextures; ++i)
+    {
+        if(!(textures[i] = pageTexture(c->textures[i], c->flags & GPU_TEST_RENDER_TEXTURES)))return false;
+    }
+    //The indices right after the vertices, where the PICA looks for them
+    size = numQuads * 4 * sizeof(vertex_pos_col);
+    vertices = gpuFrameAlloc(size + numQuads * 6, 0x10);
+    if(!vertices)return false;
+    indices = (u8*)vertices + size;
+    for(i = 0; i < numQuads; ++i)writeQuad(&vertices[4 * i], &indices[6 * i], 4 * i, &quads[i]);
+    GSPGPU_FlushDataCache(NULL, (u8*)vertices, size + numQuads * 6);
+
+    //The whole drawing space lands in the tile, the scissor keeps anything else out of the neighbours
+    gpuDisableEverything();
+    GPU_SetScissorTest(GPU_SCISSOR_NORMAL, r.x, r.y, r.w, r.h);
+    if(!gpuSetShader(gpuShaderFind(c->shader)))return false;
+    gpuSetProjectionRegion(x, y, GPU_TILE_W, GPU_TILE_H);
+    gpuUniformBlockUpload(&gpuVertexUniforms);
+
+    GPU_SetTextureEnable((1 << numTextures) - 1);
+    for(i = 0; i < numTextures; ++i)
+    {
+        GPU_SetTexture(1 << i, (u32*)osConvertVirtToPhys((u32)textures[i]), TEXTURE_SIZE, TEXTURE_SIZE,
+                       GPU_TEXTURE_MAG_FILTER(GPU_NEAREST) | GPU_TEXTURE_MIN_FILTER(GPU_NEAREST), GPU_RGBA8);
+    }
+    if(!c->numStages)
+    {
+        GPU_SetTexEnv(0,
+                      GPU_TEVSOURCES(GPU_PRIMARY_COLOR, 0, 0), GPU_TEVSOURCES(GPU_PRIMARY_COLOR, 0, 0),
+                      GPU_TEVOPERANDS(0, 0, 0), GPU_TEVOPERANDS(0, 0, 0),
+                      GPU_REPLACE, GPU_REPLACE, 0xFFFFFFFF);
+    }
+    for(i = 0; i < c->numStages && i < 6; ++i)
+    {
+        const gpu_test_tev* t = &c->tev[i];
+        GPU_SetTexEnv(i, t->rgbSources, t->alphaSources, t->rgbOperands, t->alphaOperands,
+                      t->rgbCombine, t->alphaCombine, t->constantColor);
+    }
+
+    if(c->blend.set)
+    {
+        const gpu_test_blend* b = &c->blend;
+        GPU_SetAlphaBlending(b->colorEquation, b->alphaEquation, b->colorSrc, b->colorDst, b->alphaSrc, b->alphaDst);
+        GPU_SetBlendingColor(b->color & 0xFF, (b->color >> 8) & 0xFF, (b->color >> 16) & 0xFF, b->color >> 24);
+    }
+    if(c->alphaTest.set)GPU_SetAlphaTest(true, c->alphaTest.function, c->alphaTest.ref);
+    if(c->depth.set)GPU_SetDepthTestAndWriteMask(c->depth.enable, c->depth.function, c->depth.writeMask);
+    if(c->stencil.set)
+    {
+        const gpu_test_stencil* s = &c->stencil;
+        GPU_SetStencilTest(true, s->function, s->ref, s->mask, s->replace);
+        GPU_SetStencilOp(s->sfail, s->dfail, s->pass);
+    }
+
+    if(!tile)gpuVertexFormatBind(&quad_format, vertices);
+    else gpuVertexFormatSetBuffer(&quad_format, vertices);
+    gpuDrawElements(GPU_TRIANGLES, vertices, indices, numQuads * 6, GPU_INDEX_U8);
+    return true;
+}
+
+static bool withinTolerance(u32 color, u32 expected, u8 tolerance)
+{
+    int shift;
+    for(shift = 0; shift < 32; shift += 8)
+    {
+        int d = (int)((color >> shift) & 0xFF) - (int)((expected >> shift) & 0xFF);
+        if(d > tolerance || d < -tolerance)return false;
+    }
+    return true;
+}
+
+static u64 toMicroseconds(u64 ticks)
+{
+    return ticks * 1000000 / SYSCLOCK_ARM11;
+}
+
+static void pageDone(void* data)
+{
+    const test_page* page = data;
+    gpu_test_summary* summary = page->summary;
+    //The GPU time of the page, shared between its cases
+    u64 gpuTicks = page->count ? gpuTimingLast(GPU_PHASE_P3D) / page->count : 0;
+    u16 type = page->records ? gpuLogDefine(page->records, "test:suite,index,passed,color:x,expected:x,colors,"
+                                            "recordTicks,gpuTicks") : 0;
+    u32 tile;
+    gpuTileReadback(true);
+    for(tile = 0; tile < page->count; ++tile)
+    {
+        const test_tile* t = &page->tiles[tile];
+        gpu_tile_result res;
+        u32 color;
+        bool passed, sameEyes;
+        const char* status;
+        char name[64];
+
+        gpuTileRead(tile, &res);
+        color = res.color;
+        sameEyes = res.sameEyes;
+        passed = !t->skipped && withinTolerance(res.stats.min, t->expected, t->tolerance)
+                 && withinTolerance(res.stats.max, t->expected, t->tolerance);
+
+        if(t->skipped)status = "SKIP";
+        else if(t->flags & GPU_TEST_RECORD_ONLY)status = "RECORD";
+        else if(passed && !sameEyes)status = "EYES";
+        else status = passed ? "PASS" : "FAIL";
+        passed = passed && sameEyes;
+        if(summary)
+        {
+            summary->cases++;
+            if(!t->skipped && t->flags & GPU_TEST_RECORD_ONLY)summary->recorded++;
+            else if(passed)summary->passed++;
+            else summary->failed++;
+        }
+        if(t->name)snprintf(name, sizeof(name), "%s/%s", suites[t->suite]->name, t->name);
+        else snprintf(name, sizeof(name), "%s/%lu", suites[t->suite]->name, (unsigned long)t->index);
+        if(!passed && !(t->flags & GPU_TEST_RECORD_ONLY) && printedFailures++ < MAX_PRINTED_FAILURES)
+            printf("%s %s gpuColor=%08lx expected=%08lx\n", status, name, (unsigned long)color, (unsigned long)t->expected);
+        if(page->report)
+        {
+            fprintf(page->report, "test %-28s %-6s gpuColor=%08lx expected=%08lx colors=%lu cpu=%lluus gpu=%lluus\n",
+                    name, status, (unsigned long)color, (unsigned long)t->expected, (unsigned long)res.stats.uniqueColors,
+                    (unsigned long long)toMicroseconds(t->recordTicks), (unsigned long long)toMicroseconds(gpuTicks));
+        }
+        if(type)
+        {
+            const u32 values[] = {t->suite, t->index, passed, color, t->expected, res.stats.uniqueColors,
+                                  (u32)t->recordTicks, (u32)gpuTicks};
+            gpuLogRecord(page->records, type, values, sizeof(values) / sizeof(values[0]));
+        }
+    }
+}
+
+/**
+* Puts back what the cases changed and isn't part of gpuDisableEverything().
+*/
+static void endPage(u32 count)
+{
+    //Only the tiles of the page are cleared before the next one, the depth and stencil tests need both buffers
+    gpuTileMarkDirty(GPU_CLEAR_ALL, count);
+    GPU_SetScissorTest(GPU_SCISSOR_DISABLE, 0, 0, GPU_FB_WIDTH, GPU_FB_HEIGHT);
+    gpuSetShader(NULL);
+    gpuSetProjectionRegion(0.0f, 0.0f, GPU_UI_WIDTH, GPU_UI_HEIGHT);
+    gpuUniformBlockUpload(&gpuVertexUniforms);
+    gpuDisableEverything();
+}
+
+u32 gpuTestRunAll(FILE* report, gpu_log* records, gpu_test_summary* summary)
+{
+    gpu_test_summary total;
+    u32 suite = 0, index = 0, interval;
+    u64 start = svcGetSystemTick();
+    //The pages are read back, showing them would only cap the run at 60 pages per second
+    gpu_present_mode mode = gpuGetPresentMode(&interval);
+    //In stereo, both eyes must see the same pages: the right one is a replay of the left one
+    float screenZ, parallax = gpuGetStereoDepth(&screenZ);
+    memset(&total, 0, sizeof(total));
+    printedFailures = 0;
+    gpuSetPresentMode(GPU_PRESENT_HEADLESS, 1);
+    gpuSetStereoDepth(0.0f, screenZ);
+
+    while(suite < numSuites)
+    {
+        test_page* page = &pages[total.frames % 2];
+        page->count = 0;
+        page->report = report;
+        page->records = records;
+        page->summary = &total;
+        numPageTextures = 0;
+        pageAtlas = &atlases[total.frames % 2];
+
+        //Recorded while the GPU renders the previous page, which is read back when this one is submitted
+        gpuStartFrame();
+        while(page->count < GPU_TEST_TILES_PER_PAGE && suite < numSuites)
+        {
+            gpu_test_case c;
+            test_tile* t = &page->tiles[page->count];
+            u64 t0;
+            if(index >= suites[suite]->count)
+            {
+                suite++;
+                index = 0;
+                continue;
+            }
+            gpuTestGetCase(suites[suite], index, &c);
+            t0 = svcGetSystemTick();
+            //Without its shader it can't run on any page
+            if(c.shader && !gpuShaderFind(c.shader))t->skipped = true;
+            else
+            {
+                t->skipped = !recordCase(page->count, &c);
+                //Out of frame memory, the case goes to the next page unless it is alone in this one
+                if(t->skipped && page->count)break;
+            }
+            t->recordTicks = svcGetSystemTick() - t0;
+            t->suite = suite;
+            t->index = index;
+            t->name = c.name;
+            t->expected = c.expected;
+            t->tolerance = c.tolerance;
+            t->flags = c.flags;
+            page->count++;
+            index++;
+        }
+        endPage(page->count);
+        gpuTileEndPage(pageDone, page);
+        total.frames++;
+    }
+    gpuWaitIdle();
+    gpuSetPresentMode(mode, interval);
+    gpuSetStereoDepth(parallax, screenZ);
+    total.ticks = svcGetSystemTick() - start;
+    if(report)
+    {
+        fprintf(report, "tests: %lu passed, %lu failed, %lu recorded, %lu frames, %llu ms\n",
+                (unsigned long)total.passed, (unsigned long)total.failed, (unsigned long)total.recorded,
+                (unsigned long)total.frames, (unsigned long long)(total.ticks / TICKS_PER_MSEC));
+        fflush(report);
+    }
+    if(summary)*summary = total;
+    return total.failed;
+}
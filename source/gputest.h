@@ -0,0 +1,155 @@
+/**
+ *@file gputest.h
+ *@author Lectem
+ *@date 17/10/2026
+ *
+ * Declarative GPU test cases and their runner.
+ *
+ * A case describes its whole setup (textures, TEV stages, blending, alpha/depth/stencil tests and a few quads)
+ * and the color the tile should end up with. Anything left at 0 in a case keeps the state of gpuDisableEverything().
+ * Cases are grouped in suites, either a static array or a generator function, registered with gpuTestRegister.
+ *
+ * gpuTestRunAll draws many cases per frame: each case is drawn in the full 400x240 space, and the projection
+ * and the scissor squeeze it into a tile of its own. Like the TEV sweeps, a page of tiles is read back while the
+ * next one is recorded. Each case reports pass/fail, the time the CPU took to record it and its share of the GPU
+ * time of its page.
+ */
+#pragma once
+
+#include <3ds.h>
+#include <stdio.h>
+#include "gpulog.h"
+#include "gputile.h"
+
+//One case per tile of gputile.h, as for the TEV sweeps
+#define GPU_TEST_TILES_PER_PAGE GPU_TILES_PER_PAGE
+#define GPU_TEST_MAX_QUADS 4
+#define GPU_TEST_MAX_TEXTURES 3
+#define GPU_TEST_MAX_SUITES 16
+
+//A color as read back from the color buffer (gpuReadbackColor), to write the expected results
+#define GPU_TEST_COLOR(r,g,b,a) ((((r)&0xFF)<<24) | (((g)&0xFF)<<16) | (((b)&0xFF)<<8) | ((a)&0xFF))
+
+//gpu_test_case flags
+//No expected color, the result is only reported (eg. to be checked against the host reference model)
+#define GPU_TEST_RECORD_ONLY 0x1
+//The textures are drawn by the GPU to an offscreen target in the same command list, instead of being uploaded
+#define GPU_TEST_RENDER_TEXTURES 0x2
+
+/**
+* A TEV stage, with the same meaning as the parameters of GPU_SetTexEnv.
+*/
+typedef struct {
+    u16 rgbSources, alphaSources;
+    u16 rgbOperands, alphaOperands;
+    u8 rgbCombine, alphaCombine;
+    u32 constantColor;
+} gpu_test_tev;
+
+typedef struct {
+    float x, y, w, h;       ///< In the 400x240 space, the whole space if w or h is 0
+    float z;
+    u32 color;              ///< RGBA8()
+} gpu_test_quad;
+
+typedef struct {
+    bool set;               ///< false keeps the default: no blending
+    GPU_BLENDEQUATION colorEquation, alphaEquation;
+    GPU_BLENDFACTOR colorSrc, colorDst;
+    GPU_BLENDFACTOR alphaSrc, alphaDst;
+    u32 color;              ///< RGBA8() of the constant blend color
+} gpu_test_blend;
+
+typedef struct {
+    bool set;               ///< false keeps the default: disabled
+    GPU_TESTFUNC function;
+    u8 ref;
+} gpu_test_alpha;
+
+typedef struct {
+    bool set;               ///< false keeps the default: always passing, writing depth and color
+    bool enable;
+    GPU_TESTFUNC function;
+    GPU_WRITEMASK writeMask;
+} gpu_test_depth;
+
+typedef struct {
+    bool set;               ///< false keeps the default: disabled
+    GPU_TESTFUNC function;
+    u8 ref, mask, replace;
+    GPU_STENCILOP sfail, dfail, pass;
+} gpu_test_stencil;
+
+typedef struct {
+    const char* name;
+    const char* shader;     ///< Name of the program (see gpushader.h), NULL for the default one
+    //8x8 textures of a single RGBA8() color on the units 0 to numTextures-1
+    u8 numTextures;
+    u32 textures[GPU_TEST_MAX_TEXTURES];
+    //Without stages, stage 0 replaces with the primary color. The other stages pass the previous one through.
+    u8 numStages;
+    gpu_test_tev tev[6];
+    gpu_test_blend blend;
+    gpu_test_alpha alphaTest;
+    gpu_test_depth depth;
+    gpu_test_stencil stencil;
+    //Drawn in order with the same state, without quads a white one covers everything at z 0.5
+    u8 numQuads;
+    gpu_test_quad quads[GPU_TEST_MAX_QUADS];
+    //The color of the whole tile (GPU_TEST_COLOR), on top of the cleared buffer
+    u32 expected;
+    u8 tolerance;           ///< Largest difference allowed on each channel
+    u32 flags;
+} gpu_test_case;
+
+typedef struct {
+    const char* name;
+    const gpu_test_case* cases; ///< count cases, or NULL to use generate
+    u32 count;
+    void (*generate)(u32 index, gpu_test_case* out);
+} gpu_test_suite;
+
+typedef struct {
+    u32 cases;
+    u32 passed, failed;
+    u32 recorded;           ///< Cases with GPU_TEST_RECORD_ONLY
+    u32 frames;
+    u64 ticks;              ///< Whole run
+} gpu_test_summary;
+
+/**
+* Loads a suite from a text file, one case per line, as written by host/tevfuzz. Empty lines and lines starting with
+* '#' are skipped. A case is a list of space separated fields, numbers in hex unless noted:
+*   name=<text>
+*   shader=<text>                                      program of data/<text>.vsh, skipped if it isn't built
+*   tex=<color>[,<color>[,<color>]]                    RGBA8() of the textures, numTextures is their count
+*   tev=<rgbSrc>,<aSrc>,<rgbOp>,<aOp>,<rgbComb>,<aComb>,<constant>   one per stage, in order
+*   blend=<colorEq>,<alphaEq>,<colorSrc>,<colorDst>,<alphaSrc>,<alphaDst>,<color>
+*   alpha=<function>,<ref>
+*   quad=<color>[,<z>]                                 a quad covering everything, z in decimal (0.5 by default)
+*   expected=<GPU_TEST_COLOR value>  tolerance=<decimal>  record  rendered (GPU_TEST_RENDER_TEXTURES)
+* @return false if the file couldn't be read or has no case, suite is then empty
+*/
+bool gpuTestLoadSuite(gpu_test_suite* suite, const char* name, const char* path);
+/**
+* Frees what gpuTestLoadSuite allocated.
+*/
+void gpuTestFreeSuite(gpu_test_suite* suite);
+
+bool gpuTestInit();
+void gpuTestExit();
+/**
+* Adds a suite to the ones gpuTestRunAll runs, the suite isn't copied.
+* @return false if there are already GPU_TEST_MAX_SUITES
+*/
+bool gpuTestRegister(const gpu_test_suite* suite);
+void gpuTestGetCase(const gpu_test_suite* suite, u32 index, gpu_test_case* out);
+
+/**
+* Runs every case of every registered suite, and writes one line per case to the report file and a "test" record
+* to records if they aren't NULL. Failures are printed to the console too.
+* In stereo (gpuSetStereo), the pages are drawn without parallax and each tile of the right eye must be the same as
+* in the left one, the cases where only that fails are reported as EYES.
+* @return The number of failed cases
+*/
+u32 gpuTestRunAll(FILE* report, gpu_log* records, gpu_test_summary* summary);
@@ -0,0 +1,194 @@
+/**
+ *@file gputexture.c
+ *@author Lectem
+ *@date 17/10/2026
+ */
+#include "gputexture.h"
+#include <string.h>
+
+/**
+* Offsets in pixels, inside a tile, of the rows and of the pixel pairs (x, x+1) of a row, x = 0, 2, 4, 6.
+* x0 is the lowest bit of the Morton order, so a pair is always contiguous and moved as a single word.
+*/
+static const u8 rowOffsets[8] = {0, 2, 8, 10, 32, 34, 40, 42};
+static const u8 pairOffsets[4] = {0, 4, 16, 20};
+
+u32 gpuTextureBpp(GPU_TEXCOLOR format)
+{
+    switch(format)
+    {
+        case GPU_RGBA8: return 4;
+        case GPU_RGB8: return 3;
+        case GPU_RGBA5551:
+        case GPU_RGB565:
+        case GPU_RGBA4:
+        case GPU_LA8: return 2;
+        case GPU_A8: return 1;
+        default: return 0;
+    }
+}
+
+//Byte order swaps of a pair of pixels
+static inline u64 swapPair32(u64 v)
+{
+    return ((u64)__builtin_bswap32(v >> 32) << 32) | __builtin_bswap32((u32)v);
+}
+
+static inline u32 swapPair16(u32 v)
+{
+    return ((v >> 8) & 0x00FF00FF) | ((v & 0x00FF00FF) << 8);
+}
+
+/**
+* Moves whole tiles in either direction. Always inlined with constant bpp/swap/toTiled, so that each format
+* gets its own loop with the pair moves and the swap resolved at compile time.
+*/
+static inline __attribute__((always_inline))
+void convertTiles(u8* tiled, u8* linear, u32 width, u32 height, u32 bpp, bool swap, bool flip, bool toTiled)
+{
+    u32 tx, ty, y, k;
+    const u32 tileBytes = 64 * bpp;
+    const u32 stride = width * bpp;
+    for(ty = 0; ty < height / 8; ++ty)
+    {
+        for(y = 0; y < 8; ++y)
+        {
+            u32 row = ty * 8 + y;
+            u8* line = linear + (flip ? height - 1 - row : row) * stride;
+            u8* tile = tiled + ty * (width / 8) * tileBytes + rowOffsets[y] * bpp;
+            for(tx = 0; tx < width / 8; ++tx, tile += tileBytes, line += 8 * bpp)
+            {
+                for(k = 0; k < 4; ++k)
+                {
+                    u8* t = tile + pairOffsets[k] * bpp;
+                    u8* l = line + 2 * k * bpp;
+                    u8* dst = toTiled ? t : l;
+                    const u8* src = toTiled ? l : t;
+                    if(bpp == 4)
+                    {
+                        u64 v;
+                        memcpy(&v, src, 8);
+                        if(swap)v = swapPair32(v);
+                        memcpy(dst, &v, 8);
+                    }
+                    else if(bpp == 3)
+                    {
+                        //Byte by byte, several times faster than a 6 bytes memcpy
+                        dst[0] = src[swap ? 2 : 0];
+                        dst[1] = src[1];
+                        dst[2] = src[swap ? 0 : 2];
+                        dst[3] = src[swap ? 5 : 3];
+                        dst[4] = src[4];
+                        dst[5] = src[swap ? 3 : 5];
+                    }
+                    else if(bpp == 2)
+                    {
+                        u32 v;
+                        memcpy(&v, src, 4);
+                        if(swap)v = swapPair16(v);
+                        memcpy(dst, &v, 4);
+                    }
+                    else
+                    {
+                        memcpy(dst, src, 2);
+                    }
+                }
+            }
+        }
+    }
+}
+
+static bool convert(u8* tiled, u8* linear, u32 width, u32 height, GPU_TEXCOLOR format, u32 flags, bool toTiled)
+{
+    bool flip = flags & GPU_TEXTURE_FLIP_Y;
+    if((width & 7) || (height & 7) || !tiled || !linear)return false;
+    switch(format)
+    {
+        case GPU_RGBA8:
+            if(toTiled)convertTiles(tiled, linear, width, height, 4, true, flip, true);
+            else convertTiles(tiled, linear, width, height, 4, true, flip, false);
+            return true;
+        case GPU_RGB8:
+            if(toTiled)convertTiles(tiled, linear, width, height, 3, true, flip, true);
+            else convertTiles(tiled, linear, width, height, 3, true, flip, false);
+            return true;
+        case GPU_RGBA5551:
+        case GPU_RGB565:
+        case GPU_RGBA4:
+            if(toTiled)convertTiles(tiled, linear, width, height, 2, false, flip, true);
+            else convertTiles(tiled, linear, width, height, 2, false, flip, false);
+            return true;
+        case GPU_LA8:
+            if(toTiled)convertTiles(tiled, linear, width, height, 2, true, flip, true);
+            else convertTiles(tiled, linear, width, height, 2, true, flip, false);
+            return true;
+        case GPU_A8:
+            if(toTiled)convertTiles(tiled, linear, width, height, 1, false, flip, true);
+            else convertTiles(tiled, linear, width, height, 1, false, flip, false);
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool gpuTextureTile(void* tiled, const void* linear, u32 width, u32 height, GPU_TEXCOLOR format, u32 flags)
+{
+    return convert(tiled, (u8*)linear, width, height, format, flags, true);
+}
+
+bool gpuTextureUntile(void* linear, const void* tiled, u32 width, u32 height, GPU_TEXCOLOR format, u32 flags)
+{
+    return convert((u8*)tiled, linear, width, height, format, flags, false);
+}
+
+bool gpuTextureTileReference(void* tiled, const void* linear, u32 width, u32 height, GPU_TEXCOLOR format, u32 flags)
+{
+    u32 bpp = gpuTextureBpp(format);
+    u32 x, y, b;
+    if(!bpp || (width & 7) || (height & 7))return false;
+    for(y = 0; y < height; ++y)
+    {
+        u32 row = (flags & GPU_TEXTURE_FLIP_Y) ? height - 1 - y : y;
+        for(x = 0; x < width; ++x)
+        {
+            u32 morton = (x & 1) | ((y & 1) << 1) | ((x & 2) << 1) | ((y & 2) << 2) | ((x & 4) << 2) | ((y & 4) << 3);
+            u32 offset = ((y >> 3) * (width >> 3) + (x >> 3)) * 64 + morton;
+            const u8* src = (const u8*)linear + (row * width + x) * bpp;
+            u8* dst = (u8*)tiled + offset * bpp;
+            bool swap = format == GPU_RGBA8 || format == GPU_RGB8 || format == GPU_LA8;
+            for(b = 0; b < bpp; ++b)dst[b] = swap ? src[bpp - 1 - b] : src[b];
+        }
+    }
+    return true;
+}
+
+bool gpuTextureTileGX(void* tiled, void* linear, u32 width, u32 height, GPU_TEXCOLOR format, u32 flags)
+{
+    u32 gxFormat;
+    switch(format)
+    {
+        case GPU_RGBA8: gxFormat = 0; break;
+        case GPU_RGB565: gxFormat = 2; break;
+        case GPU_RGBA4: gxFormat = 4; break;
+        default: return gpuTextureTile(tiled, linear, width, height, format, flags);
+    }
+    if(width < 64 || height < 64)return gpuTextureTile(tiled, linear, width, height, format, flags);
+    if((width & 7) || (height & 7) || !tiled || !linear)return false;
+
+    u32 size = width * height * gpuTextureBpp(format);
+    if(format == GPU_RGBA8)
+    {
+        //The transfer keeps the bytes of each pixel as they are
+        u32* p = linear;
+        u32 i;
+        for(i = 0; i < width * height; ++i)p[i] = __builtin_bswap32(p[i]);
+    }
+    GSPGPU_FlushDataCache(NULL, linear, size);
+
+    //See http://3dbrew.org/wiki/GPU#Transfer_Engine: bit 0 flips, bit 1 makes the output tiled
+    u32 dim = (height << 16) | width;
+    GX_SetDisplayTransfer(NULL, linear, dim, tiled, dim,
+                          (gxFormat << 8) | (gxFormat << 12) | 0x2 | ((flags & GPU_TEXTURE_FLIP_Y) ? 0x1 : 0));
+    gspWaitForPPF();
+    return true;
+}
@@ -0,0 +1,52 @@
+/**
+ *@file gputexture.h
+ *@author Lectem
+ *@date 17/10/2026
+ *
+ * Conversion between linear images and the layout the PICA samples textures from:
+ * 8x8 tiles, left to right then top to bottom, the pixels of a tile in Morton order (x0 y0 x1 y1 x2 y2),
+ * the same layout as the framebuffer (see gpuTiledOffset).
+ *
+ * Linear images use the usual byte order, the PICA one is reversed for multi-byte components:
+ * - GPU_RGBA8: bytes R, G, B, A (the RGBA8 macro), the PICA stores A, B, G, R
+ * - GPU_RGB8: bytes R, G, B, the PICA stores B, G, R
+ * - GPU_RGB565, GPU_RGBA5551, GPU_RGBA4: native u16 (R in the high bits), same for the PICA
+ * - GPU_LA8: bytes L, A, the PICA stores A, L
+ * - GPU_A8: one byte
+ *
+ * The first row of tiles is sampled at t = 0, which is the bottom of the texture with the usual texture coordinates:
+ * GPU_TEXTURE_FLIP_Y makes row 0 of the linear image the top of the texture instead.
+ */
+#pragma once
+
+#include <3ds.h>
+
+#define GPU_TEXTURE_FLIP_Y 0x1
+
+/**
+* Bytes per pixel of the formats supported here, 0 for the others.
+*/
+u32 gpuTextureBpp(GPU_TEXCOLOR format);
+/**
+* Linear to tiled, a whole 8x8 tile at a time.
+* @param width, height Multiples of 8
+* @param flags GPU_TEXTURE_FLIP_Y
+* @return false if the format or the size isn't supported
+*/
+bool gpuTextureTile(void* tiled, const void* linear, u32 width, u32 height, GPU_TEXCOLOR format, u32 flags);
+/**
+* Tiled to linear, the reverse of gpuTextureTile.
+*/
+bool gpuTextureUntile(void* linear, const void* tiled, u32 width, u32 height, GPU_TEXCOLOR format, u32 flags);
+/**
+* Same as gpuTextureTile, one pixel at a time. Slow, it is the reference the fast path is checked against.
+*/
+bool gpuTextureTileReference(void* tiled, const void* linear, u32 width, u32 height, GPU_TEXCOLOR format, u32 flags);
+
+/**
+* Tiles with the display transfer engine (GX) instead of the CPU, for GPU_RGBA8, GPU_RGB565 and GPU_RGBA4.
+* Both buffers must be in linear memory or VRAM. A GPU_RGBA8 image is put in the PICA byte order in place first,
+* linear is only an input for the 16 bits formats. Waits for the transfer to be done.
+* Falls back to gpuTextureTile for the other formats and for images under 64x64.
+*/
+bool gpuTextureTileGX(void* tiled, void* linear, u32 width, u32 height, GPU_TEXCOLOR format, u32 flags);
@@ -0,0 +1,90 @@
+/**
+ *@file gputile.c
+ *@author Lectem
+ *@date 17/10/2026
+ */
+#include "gputile.h"
+#include <stdlib.h>
+#include <string.h>
+
+//Linear copy of the whole color buffer, so that every pixel of a tile is checked and not only its center
+static u32* page_image = NULL;
+//The right eye, allocated by the first readback of a page that has one
+static u32* right_image = NULL;
+static u32 users = 0;
+//What the last gpuTileReadback got
+static bool imageRead = false;
+static bool rightRead = false;
+
+void gpuTileInit()
+{
+    //Only read by the CPU, no need for the linear heap
+    if(!users++)page_image = malloc(GPU_FB_PIXELS * sizeof(u32));
+}
+
+void gpuTileExit()
+{
+    if(!users || --users)return;
+    free(page_image);
+    free(right_image);
+    page_image = right_image = NULL;
+}
+
+void gpuTileOrigin(u32 tile, u16* x, u16* y)
+{
+    *x = (tile % GPU_TILES_X) * GPU_TILE_W;
+    *y = (tile / GPU_TILES_X) * GPU_TILE_H;
+}
+
+void gpuTileMarkDirty(u32 buffers, u32 count)
+{
+    //The full rows, then the start of the last one
+    gpuMarkDirty(buffers, 0, 0, GPU_TILES_X * GPU_TILE_W, count / GPU_TILES_X * GPU_TILE_H);
+    gpuMarkDirty(buffers, 0, count / GPU_TILES_X * GPU_TILE_H, count % GPU_TILES_X * GPU_TILE_W, GPU_TILE_H);
+}
+
+void gpuTileEndPage(gpu_frame_done_callback done, void* data)
+{
+    gpuSetFrameDoneCallback(done, data);
+    gpuEndFrame();
+}
+
+void gpuTileReadback(bool rightEye)
+{
+    imageRead = page_image != NULL;
+    rightRead = false;
+    if(!imageRead)return;
+    gpuReadbackColor(page_image);
+    if(!rightEye || !gpuRightColorBuffer)return;
+    if(!right_image)right_image = malloc(GPU_FB_PIXELS * sizeof(u32));
+    rightRead = right_image && gpuReadbackRightColor(right_image);
+}
+
+bool gpuTileRead(u32 tile, gpu_tile_result* out)
+{
+    u16 x, y;
+    gpuTileOrigin(tile, &x, &y);
+    out->sameEyes = true;
+    if(!imageRead)
+    {
+        out->color = gpuReadColor(x + GPU_TILE_W / 2, y + GPU_TILE_H / 2);
+        memset(&out->stats, 0, sizeof(out->stats));
+        out->stats.pixels = out->stats.uniqueColors = 1;
+        out->stats.min = out->stats.max = out->color;
+        return true;
+    }
+
+    gpu_region r = gpuRegionFromUI(x, y, GPU_TILE_W, GPU_TILE_H);
+    //Leave out the edges shared with the neighbouring tiles
+    r.x += 1; r.y += 1;
+    r.w -= 2; r.h -= 2;
+    gpuRegionStats(page_image, r, &out->stats);
+    out->color = page_image[(r.y + r.h / 2) * GPU_FB_WIDTH + r.x + r.w / 2];
+    if(rightRead)
+    {
+        gpu_region_stats right;
+        gpuRegionStats(right_image, r, &right);
+        out->sameEyes = right.checksum == out->stats.checksum;
+    }
+    return out->stats.uniqueColors == 1;
+}
@@ -0,0 +1,60 @@
+/**
+ *@file gputile.h
+ *@author Lectem
+ *@date 17/10/2026
+ *
+ * Pages of tiles, shared by the TEV sweeps and the test runner.
+ *
+ * The 400x240 drawing space is split in a grid of tiles, one case per tile, so that a whole page of cases is
+ * recorded in a single command list. A page is recorded while the GPU renders the previous one, and read back
+ * from the frame done callback of gpuTileEndPage, so two pages are in use at any time.
+ */
+#pragma once
+
+#include <3ds.h>
+#include "gpuframework.h"
+#include "gpureadback.h"
+
+//The 400x240 drawing space is split in 16x16 tiles of 25x15
+#define GPU_TILES_X 16
+#define GPU_TILES_Y 16
+#define GPU_TILES_PER_PAGE (GPU_TILES_X*GPU_TILES_Y)
+#define GPU_TILE_W (GPU_UI_WIDTH / GPU_TILES_X)
+#define GPU_TILE_H (GPU_UI_HEIGHT / GPU_TILES_Y)
+
+typedef struct {
+    u32 color;              ///< The center of the tile
+    gpu_region_stats stats; ///< Without the edges, a single color (the center) if the page couldn't be read back
+    bool sameEyes;          ///< The right eye has the same pixels, always true if it wasn't read back
+} gpu_tile_result;
+
+/**
+* Allocates the linear copies of the color buffer, shared by every user of the pages.
+* Without them, only the center of each tile is read.
+*/
+void gpuTileInit();
+void gpuTileExit();
+
+/**
+* Top left corner of a tile, in the 400x240 space.
+*/
+void gpuTileOrigin(u32 tile, u16* x, u16* y);
+/**
+* Marks the first count tiles of the page as drawn, so that only they are cleared before the next page.
+*/
+void gpuTileMarkDirty(u32 buffers, u32 count);
+/**
+* Sets the frame done callback of the page being recorded and submits it.
+*/
+void gpuTileEndPage(gpu_frame_done_callback done, void* data);
+
+/**
+* Reads back the color buffer of a page that is done, from its frame done callback or after gpuWaitIdle().
+* @param rightEye Also read back the right eye, if the page has one
+*/
+void gpuTileReadback(bool rightEye);
+/**
+* Reads a tile of the page of the last gpuTileReadback.
+* @return false if the tile isn't a single color
+*/
+bool gpuTileRead(u32 tile, gpu_tile_result* out);
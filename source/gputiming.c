@@ -0,0 +1,123 @@
+/**
+ *@file gputiming.c
+ *@author Lectem
+ *@date 17/10/2026
+ */
+#include "gputiming.h"
+#include <string.h>
+
+//Log-linear buckets: 8 buckets per power of 2, so a bucket is at most 12.5% wide
+#define SUB_BUCKET_BITS 3
+#define SUB_BUCKETS (1 << SUB_BUCKET_BITS)
+#define NUM_BUCKETS (64 * SUB_BUCKETS)
+
+typedef struct {
+    u32 count;
+    u64 min, max, sum;
+    u64 last;
+    u32 buckets[NUM_BUCKETS];
+} phase_histogram;
+
+static phase_histogram histograms[GPU_PHASE_COUNT];
+
+static const char* phase_names[GPU_PHASE_COUNT] = {
+        "record",
+        "submit",
+        "p3d",
+        "p3dwait",
+        "transfer",
+        "fill",
+        "vblank",
+        "frame",
+};
+
+static u32 bucketIndex(u64 v)
+{
+    if(v < SUB_BUCKETS)return v;
+    u32 msb = 63 - __builtin_clzll(v);
+    u32 sub = (v >> (msb - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    return ((msb - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS) | sub;
+}
+
+static u64 bucketUpperBound(u32 index)
+{
+    if(index < SUB_BUCKETS)return index;
+    u32 shift = (index >> SUB_BUCKET_BITS) - 1;
+    u64 base = (u64)(SUB_BUCKETS | (index & (SUB_BUCKETS - 1))) << shift;
+    return base + ((u64)1 << shift) - 1;
+}
+
+void gpuTimingAdd(gpu_phase phase, u64 ticks)
+{
+    phase_histogram* h;
+    if(phase >= GPU_PHASE_COUNT)return;
+    h = &histograms[phase];
+    if(!h->count || ticks < h->min)h->min = ticks;
+    if(ticks > h->max)h->max = ticks;
+    h->sum += ticks;
+    h->last = ticks;
+    h->count++;
+    h->buckets[bucketIndex(ticks)]++;
+}
+
+void gpuTimingReset()
+{
+    memset(histograms, 0, sizeof(histograms));
+}
+
+const char* gpuTimingPhaseName(gpu_phase phase)
+{
+    if(phase >= GPU_PHASE_COUNT)return "unknown";
+    return phase_names[phase];
+}
+
+bool gpuTimingGetStats(gpu_phase phase, gpu_phase_stats* stats)
+{
+    const phase_histogram* h;
+    u32 i, seen = 0;
+    if(phase >= GPU_PHASE_COUNT || !histograms[phase].count)return false;
+    h = &histograms[phase];
+    stats->count = h->count;
+    stats->min = h->min;
+    stats->max = h->max;
+    stats->mean = h->sum / h->count;
+
+    //First bucket that reaches 99% of the samples
+    u32 target = h->count - h->count / 100;
+    stats->p99 = h->max;
+    for(i = 0; i < NUM_BUCKETS; ++i)
+    {
+        seen += h->buckets[i];
+        if(seen >= target)
+        {
+            stats->p99 = bucketUpperBound(i);
+            break;
+        }
+    }
+    if(stats->p99 > h->max)stats->p99 = h->max;
+    return true;
+}
+
+static unsigned long toMicroseconds(u64 ticks)
+{
+    return (unsigned long)(ticks * 1000 / TICKS_PER_MSEC);
+}
+
+void gpuTimingPrint(FILE* f)
+{
+    int phase;
+    fprintf(f, "%-8s %5s %6s %6s %6s %6s\n", "us", "n", "min", "mean", "p99", "max");
+    for(phase = 0; phase < GPU_PHASE_COUNT; ++phase)
+    {
+        gpu_phase_stats stats;
+        if(!gpuTimingGetStats(phase, &stats))continue;
+        fprintf(f, "%-8s %5lu %6lu %6lu %6lu %6lu\n", gpuTimingPhaseName(phase), (unsigned long)stats.count,
+                toMicroseconds(stats.min), toMicroseconds(stats.mean), toMicroseconds(stats.p99), toMicroseconds(stats.max));
+    }
+}
+
+u64 gpuTimingLast(gpu_phase phase)
+{
+    if(phase >= GPU_PHASE_COUNT)return 0;
+    return histograms[phase].last;
+}
@@ -0,0 +1,46 @@
+/**
+ *@file gputiming.h
+ *@author Lectem
+ *@date 17/10/2026
+ *
+ * Where the time of a frame goes, measured with the ARM11 tick counter (svcGetSystemTick).
+ * gpuframework.c feeds the samples, every phase gets its own histogram.
+ */
+#pragma once
+
+#include <3ds.h>
+#include <stdio.h>
+
+typedef enum {
+    GPU_PHASE_RECORD,       ///< gpuStartFrame() to gpuSubmitFrame(), the CPU writing commands
+    GPU_PHASE_SUBMIT,       ///< Submit callback and redundant write filter
+    GPU_PHASE_P3D,          ///< Command list kicked to P3D interrupt, the GPU running it
+    GPU_PHASE_P3D_WAIT,     ///< Part of GPU_PHASE_P3D the CPU spent blocked, high when GPU bound
+    GPU_PHASE_TRANSFER,     ///< Display transfer to the screen framebuffer (PPF)
+    GPU_PHASE_FILL,         ///< Memory fill clearing the buffers (PSC0)
+    GPU_PHASE_VBLANK,       ///< Waiting for the screen to be updated
+    GPU_PHASE_FRAME,        ///< Submission to submission
+    GPU_PHASE_COUNT
+} gpu_phase;
+
+typedef struct {
+    u32 count;
+    u64 min, max, mean;     ///< In ticks
+    u64 p99;                ///< In ticks, upper bound of the histogram bucket
+} gpu_phase_stats;
+
+void gpuTimingAdd(gpu_phase phase, u64 ticks);
+void gpuTimingReset();
+const char* gpuTimingPhaseName(gpu_phase phase);
+/**
+* @return false if there is no sample for this phase
+*/
+bool gpuTimingGetStats(gpu_phase phase, gpu_phase_stats* stats);
+/**
+* The last sample of a phase, eg. GPU_PHASE_P3D from a frame done callback is the time the GPU took for that frame.
+*/
+u64 gpuTimingLast(gpu_phase phase);
+/**
+* Prints a table of every phase in microseconds, narrow enough for the bottom screen console.
+*/
+void gpuTimingPrint(FILE* f);
@@ -0,0 +1,404 @@
+/**
+ *@file gputrace.c
+ *@author Lectem
+ *@date 17/10/2026
+ */
+#include "gputrace.h"
+#include "gpuframework.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//Recorder state, there is only one submission path so only one trace can be recorded at a time
+static FILE* traceFile = NULL;
+static gpu_trace_header traceHeader;
+static gpu_trace_frame* traceIndex = NULL;
+static u32 traceIndexCapacity = 0;
+static u32 traceOffset = 0;
+static u64 traceWords = 0;
+static u8* encodeBuffer = NULL;
+static u32 encodeBufferSize = 0;
+static u32 encodeShadow[GPU_TRACE_NUM_REGS];
+static u16 encodeLastReg = 0;
+
+
+static inline u8* putVarint(u8* p, u64 v)
+{
+    while(v >= 0x80)
+    {
+        *p++ = (v & 0x7F) | 0x80;
+        v >>= 7;
+    }
+    *p++ = v;
+    return p;
+}
+
+static inline const u8* getVarint(const u8* p, const u8* end, u64* v)
+{
+    u64 res = 0;
+    int shift;
+    for(shift = 0; shift < 64 && p < end; shift += 7)
+    {
+        u8 b = *p++;
+        res |= (u64)(b & 0x7F) << shift;
+        if(!(b & 0x80))
+        {
+            *v = res;
+            return p;
+        }
+    }
+    return NULL;
+}
+
+static inline u32 zigzag(s32 v)
+{
+    return ((u32)v << 1) ^ (u32)(v >> 31);
+}
+
+static inline s32 unzigzag(u32 v)
+{
+    return (s32)(v >> 1) ^ -(s32)(v & 1);
+}
+
+/**
+* Encodes a command list, updating the encoder register values.
+* @return The encoded size, or 0 if the list isn't made of well formed commands.
+*/
+static u32 encodeCommands(const u32* cmds, u32 size, u8* out)
+{
+    u8* p = out;
+    u32 i = 0, k;
+    //Encode against a copy, so that a list we give up on leaves the register values untouched
+    static u32 shadow[GPU_TRACE_NUM_REGS];
+    u16 lastReg = encodeLastReg;
+    memcpy(shadow, encodeShadow, sizeof(shadow));
+
+    while(i < size)
+    {
+        if(i + 2 > size)return 0;
+        u32 header = cmds[i + 1];
+        u32 reg = header & 0xFFFF;
+        u32 mask = (header >> 16) & 0xF;
+        u32 extra = (header >> 20) & 0x7FF;
+        u32 incremental = header >> 31;
+        u32 padded = extra + (extra & 1);
+        if(reg >= GPU_TRACE_NUM_REGS || i + 2 + padded > size)return 0;
+        if((extra & 1) && cmds[i + 2 + extra] != 0)return 0;
+
+        *p++ = mask | (incremental << 4) | ((extra < 7 ? extra : 7) << 5);
+        if(extra >= 7)p = putVarint(p, extra - 7);
+        p = putVarint(p, zigzag((s32)reg - (s32)lastReg));
+        lastReg = reg;
+
+        for(k = 0; k <= extra;)
+        {
+            u32 param = k ? cmds[i + 1 + k] : cmds[i];
+            u32 r = incremental ? (reg + k) % GPU_TRACE_NUM_REGS : reg;
+            if(param == shadow[r])
+            {
+                //Run of unchanged params
+                u32 run = 1;
+                while(k + run <= extra)
+                {
+                    u32 rr = incremental ? (reg + k + run) % GPU_TRACE_NUM_REGS : reg;
+                    if(cmds[i + 1 + k + run] != shadow[rr])break;
+                    run++;
+                }
+                p = putVarint(p, ((u64)(run - 1) << 1) | 1);
+                k += run;
+            }
+            else
+            {
+                p = putVarint(p, (u64)(param ^ shadow[r]) << 1);
+                shadow[r] = param;
+                k++;
+            }
+        }
+        i += 2 + padded;
+    }
+    memcpy(encodeShadow, shadow, sizeof(shadow));
+    encodeLastReg = lastReg;
+    return p - out;
+}
+
+static void recordFrame(const u32* cmds, u32 size)
+{
+    gpu_trace_frame* frame;
+    u32 frameNum = traceHeader.frameCount;
+    //Worst case: 1 byte of command header, 5 per varint
+    u32 needed = size * 6 + 16;
+
+    if(!traceFile)return;
+    if(frameNum == traceIndexCapacity)
+    {
+        u32 capacity = traceIndexCapacity ? traceIndexCapacity * 2 : 256;
+        gpu_trace_frame* index = realloc(traceIndex, capacity * sizeof(gpu_trace_frame));
+        if(!index)return;
+        traceIndex = index;
+        traceIndexCapacity = capacity;
+    }
+    if(needed > encodeBufferSize)
+    {
+        u8* buf = realloc(encodeBuffer, needed);
+        if(!buf)return;
+        encodeBuffer = buf;
+        encodeBufferSize = needed;
+    }
+
+    frame = &traceIndex[frameNum];
+    frame->offset = traceOffset;
+    frame->words = size;
+    frame->flags = 0;
+    if(frameNum % traceHeader.keyframeInterval == 0)
+    {
+        memset(encodeShadow, 0, sizeof(encodeShadow));
+        encodeLastReg = 0;
+        frame->flags |= GPU_TRACE_KEYFRAME;
+    }
+    frame->size = encodeCommands(cmds, size, encodeBuffer);
+    if(!frame->size)
+    {
+        memcpy(encodeBuffer, cmds, size * 4);
+        frame->size = size * 4;
+        frame->flags |= GPU_TRACE_RAW;
+    }
+    if(fwrite(encodeBuffer, 1, frame->size, traceFile) != frame->size)
+    {
+        //Out of space, the trace stops at the previous frame
+        gpuTraceStop();
+        return;
+    }
+
+    traceOffset += frame->size;
+    traceWords += size;
+    if(size > traceHeader.maxFrameWords)traceHeader.maxFrameWords = size;
+    traceHeader.frameCount++;
+}
+
+bool gpuTraceStart(const char* path)
+{
+    if(traceFile)return false;
+    traceFile = fopen(path, "wb");
+    if(!traceFile)return false;
+
+    memset(&traceHeader, 0, sizeof(traceHeader));
+    traceHeader.magic = GPU_TRACE_MAGIC;
+    traceHeader.version = GPU_TRACE_VERSION;
+    traceHeader.headerSize = sizeof(gpu_trace_header);
+    traceHeader.keyframeInterval = GPU_TRACE_KEYFRAME_INTERVAL;
+    traceOffset = sizeof(gpu_trace_header);
+    traceWords = 0;
+    //The real header is written by gpuTraceStop, once the index is known
+    fwrite(&traceHeader, sizeof(traceHeader), 1, traceFile);
+
+    gpuSetSubmitCallback(recordFrame);
+    return true;
+}
+
+void gpuTraceStop()
+{
+    if(!traceFile)return;
+    gpuSetSubmitCallback(NULL);
+
+    //Align the index so that it can be read in place
+    static const u8 padding[4] = {0, 0, 0, 0};
+    fwrite(padding, 1, -traceOffset & 3, traceFile);
+    traceOffset += -traceOffset & 3;
+    traceHeader.indexOffset = traceOffset;
+    fwrite(traceIndex, sizeof(gpu_trace_frame), traceHeader.frameCount, traceFile);
+    fseek(traceFile, 0, SEEK_SET);
+    fwrite(&traceHeader, sizeof(traceHeader), 1, traceFile);
+    fclose(traceFile);
+    traceFile = NULL;
+
+    free(traceIndex);
+    traceIndex = NULL;
+    traceIndexCapacity = 0;
+    free(encodeBuffer);
+    encodeBuffer = NULL;
+    encodeBufferSize = 0;
+}
+
+bool gpuTraceIsRecording()
+{
+    return traceFile != NULL;
+}
+
+void gpuTraceRecordStats(u32* frames, u64* words, u64* bytes)
+{
+    if(frames)*frames = traceHeader.frameCount;
+    if(words)*words = traceWords;
+    if(bytes)*bytes = traceOffset + traceHeader.frameCount * sizeof(gpu_trace_frame);
+}
+
+
+gpu_trace* gpuTraceOpenMemory(const void* data, u32 size)
+{
+    const gpu_trace_header* header = data;
+    u32 i;
+    if(!data || size < sizeof(gpu_trace_header))return NULL;
+    if(header->magic != GPU_TRACE_MAGIC || header->version != GPU_TRACE_VERSION || !header->keyframeInterval)return NULL;
+    if(header->indexOffset > size || (size - header->indexOffset) / sizeof(gpu_trace_frame) < header->frameCount)return NULL;
+    //The index is read in place
+    if(header->indexOffset & 3)return NULL;
+
+    gpu_trace* trace = malloc(sizeof(gpu_trace));
+    if(!trace)return NULL;
+    trace->data = data;
+    trace->size = size;
+    trace->header = header;
+    trace->index = (const gpu_trace_frame*)(trace->data + header->indexOffset);
+    trace->ownsData = false;
+    trace->lastFrame = -1;
+    for(i = 0; i < header->frameCount; ++i)
+    {
+        const gpu_trace_frame* frame = &trace->index[i];
+        if(frame->offset > size || frame->size > size - frame->offset || frame->words > header->maxFrameWords)
+        {
+            free(trace);
+            return NULL;
+        }
+    }
+    return trace;
+}
+
+gpu_trace* gpuTraceLoad(const char* path)
+{
+    FILE* f = fopen(path, "rb");
+    gpu_trace* trace = NULL;
+    u8* data;
+    long size;
+    if(!f)return NULL;
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    data = size > 0 ? malloc(size) : NULL;
+    if(data && fread(data, 1, size, f) == (size_t)size)trace = gpuTraceOpenMemory(data, size);
+    fclose(f);
+    if(!trace)
+    {
+        free(data);
+        return NULL;
+    }
+    trace->ownsData = true;
+    return trace;
+}
+
+void gpuTraceFree(gpu_trace* trace)
+{
+    if(!trace)return;
+    if(trace->ownsData)free((void*)trace->data);
+    free(trace);
+}
+
+u32 gpuTraceFrameCount(const gpu_trace* trace)
+{
+    return trace ? trace->header->frameCount : 0;
+}
+
+/**
+* Decodes one frame on top of the current decoder state.
+*/
+static s32 decodeFrame(gpu_trace* trace, u32 frameNum, u32* out, u32 maxWords)
+{
+    const gpu_trace_frame* frame = &trace->index[frameNum];
+    const u8* p = trace->data + frame->offset;
+    const u8* end = p + frame->size;
+    u32 n = 0, k;
+
+    if(frame->flags & GPU_TRACE_KEYFRAME)
+    {
+        memset(trace->shadow, 0, sizeof(trace->shadow));
+        trace->lastReg = 0;
+    }
+    if(frame->words > maxWords)return -1;
+    if(frame->flags & GPU_TRACE_RAW)
+    {
+        if(frame->size != frame->words * 4)return -1;
+        memcpy(out, p, frame->size);
+        return frame->words;
+    }
+
+    while(p < end)
+    {
+        u8 op = *p++;
+        u32 mask = op & 0xF;
+        u32 incremental = (op >> 4) & 1;
+        u32 extra = op >> 5;
+        u64 extra64, regDelta;
+        if(extra == 7)
+        {
+            if(!(p = getVarint(p, end, &extra64)) || extra64 > 0x7FF - 7)return -1;
+            extra += extra64;
+        }
+        if(!(p = getVarint(p, end, &regDelta)))return -1;
+        u32 reg = (u32)((s32)trace->lastReg + unzigzag(regDelta));
+        if(reg >= GPU_TRACE_NUM_REGS)return -1;
+        trace->lastReg = reg;
+
+        u32 padded = extra + (extra & 1);
+        if(n + 2 + padded > maxWords)return -1;
+        for(k = 0; k <= extra;)
+        {
+            u64 token, run;
+            if(!(p = getVarint(p, end, &token)))return -1;
+            //Either a run of unchanged params or the new value of a single one
+            run = token & 1 ? (token >> 1) + 1 : 1;
+            if(run > extra + 1 - k)return -1;
+            if(!(token & 1))
+            {
+                u32 r = incremental ? (reg + k) % GPU_TRACE_NUM_REGS : reg;
+                trace->shadow[r] ^= (u32)(token >> 1);
+            }
+            for(; run; --run, ++k)
+            {
+                u32 r = incremental ? (reg + k) % GPU_TRACE_NUM_REGS : reg;
+                out[k ? n + 1 + k : n] = trace->shadow[r];
+            }
+        }
+        out[n + 1] = reg | (mask << 16) | (extra << 20) | (incremental << 31);
+        if(extra & 1)out[n + 2 + extra] = 0;
+        n += 2 + padded;
+    }
+    return n == frame->words ? (s32)n : -1;
+}
+
+s32 gpuTraceDecodeFrame(gpu_trace* trace, u32 frame, u32* out, u32 maxWords)
+{
+    u32 f, first;
+    s32 res = -1;
+    if(!trace || frame >= trace->header->frameCount)return -1;
+
+    //Restart from the keyframe unless we're decoding the next frame
+    first = frame - frame % trace->header->keyframeInterval;
+    if(trace->lastFrame >= (s32)first && trace->lastFrame < (s32)frame)first = trace->lastFrame + 1;
+    for(f = first; f <= frame; ++f)
+    {
+        res = decodeFrame(trace, f, out, maxWords);
+        if(res < 0)
+        {
+            trace->lastFrame = -1;
+            return -1;
+        }
+    }
+    trace->lastFrame = frame;
+    return res;
+}
+
+bool gpuTraceReplayFrame(gpu_trace* trace, u32 frame)
+{
+    s32 size;
+    //Start a frame for the clear and the command buffer switch, the recorded list replaces its commands
+    gpuStartFrame();
+    size = gpuTraceDecodeFrame(trace, frame, gpuCmd, GPU_CMD_SIZE);
+    if(size < 0)
+    {
+        GPUCMD_SetBufferOffset(0);
+        return false;
+    }
+    GPUCMD_SetBufferOffset(size);
+    //The recorded list switches shaders behind the back of gpushader
+    gpuShaderInvalidate();
+    gpuSubmitFrame();
+    return true;
+}
@@ -0,0 +1,104 @@
+/**
+ *@file gputrace.h
+ *@author Lectem
+ *@date 17/10/2026
+ *
+ * Capture and replay of the command lists submitted by gpuSubmitFrame().
+ *
+ * Trace file layout (little endian, every offset from the start of the file):
+ *   gpu_trace_header
+ *   the encoded frames, back to back
+ *   gpu_trace_frame index[frameCount], at header.indexOffset
+ *
+ * A frame is stored as its commands (see http://3dbrew.org/wiki/GPU#Command_Buffer), each one being:
+ *   u8      mask | incremental << 4 | min(count-1, 7) << 5
+ *   varint  count-1-7, only if count-1 >= 7
+ *   varint  zigzag(register - previous command register)
+ *   varint  for each param, (param ^ last value written to the same register) << 1,
+ *           or (n-1) << 1 | 1 for a run of n params equal to the last values written
+ * The alignment padding is not stored. Since the lists are rebuilt from scratch every frame, most params are
+ * the same as in the previous frame, most commands take 3 bytes.
+ * The register values are reset every keyframeInterval frames, so that decoding any frame only needs the
+ * frames since the previous keyframe. Lists that can't be parsed as commands are stored raw.
+ */
+#pragma once
+
+#include <3ds.h>
+#include <stdio.h>
+
+#define GPU_TRACE_MAGIC 0x43525447 //"GTRC"
+#define GPU_TRACE_VERSION 1
+#define GPU_TRACE_NUM_REGS 0x400
+#define GPU_TRACE_KEYFRAME_INTERVAL 60
+
+typedef struct {
+    u32 magic;
+    u16 version;
+    u16 headerSize;
+    u32 frameCount;
+    u32 indexOffset;
+    u32 keyframeInterval;
+    u32 maxFrameWords;      ///< Biggest decoded frame, to size the decoding buffers
+    u32 reserved[2];
+} gpu_trace_header;
+
+//gpu_trace_frame flags
+#define GPU_TRACE_KEYFRAME 0x1
+#define GPU_TRACE_RAW      0x2
+
+typedef struct {
+    u32 offset;
+    u32 size;       ///< Encoded size in bytes
+    u32 words;      ///< Decoded size in words
+    u32 flags;
+} gpu_trace_frame;
+
+typedef struct {
+    const u8* data;
+    u32 size;
+    const gpu_trace_header* header;
+    const gpu_trace_frame* index;
+    bool ownsData;
+    //Decoder state, to decode consecutive frames without going back to the keyframe
+    s32 lastFrame;
+    u16 lastReg;
+    u32 shadow[GPU_TRACE_NUM_REGS];
+} gpu_trace;
+
+/**
+* Starts recording every submitted command list to a new trace file.
+* @return false if the file couldn't be created or a trace is already being recorded.
+*/
+bool gpuTraceStart(const char* path);
+/**
+* Writes the index and closes the trace file.
+*/
+void gpuTraceStop();
+bool gpuTraceIsRecording();
+/**
+* Statistics of the trace being (or last) recorded.
+* @param words Sum of the sizes of the recorded command lists, in words
+* @param bytes Size of the trace file
+*/
+void gpuTraceRecordStats(u32* frames, u64* words, u64* bytes);
+
+/**
+* Loads a whole trace file in memory.
+* @return NULL if the file can't be read or is not a valid trace
+*/
+gpu_trace* gpuTraceLoad(const char* path);
+/**
+* Uses a trace already in memory (eg. mapped), data must stay valid until gpuTraceFree.
+*/
+gpu_trace* gpuTraceOpenMemory(const void* data, u32 size);
+void gpuTraceFree(gpu_trace* trace);
+u32 gpuTraceFrameCount(const gpu_trace* trace);
+/**
+* Decodes the command list of a frame.
+* @return Its size in words, or -1 if the trace is corrupted or the list doesn't fit in maxWords.
+*/
+s32 gpuTraceDecodeFrame(gpu_trace* trace, u32 frame, u32* out, u32 maxWords);
+/**
+* Starts a frame and runs the recorded command list of a frame through gpuSubmitFrame().
+*/
+bool gpuTraceReplayFrame(gpu_trace* trace, u32 frame);
@@ -0,0 +1,114 @@
+/**
+ *@file gpuuniform.c
+ *@author Lectem
+ *@date 17/10/2026
+ */
+#include "gpuuniform.h"
+#include <string.h>
+#include "transform.h"
+
+static void markDirty(gpu_uniform_block* block, u32 reg)
+{
+    block->dirty[reg >> 5] |= 1u << (reg & 31);
+    block->valid[reg >> 5] |= 1u << (reg & 31);
+}
+
+static bool isDirty(const gpu_uniform_block* block, u32 reg)
+{
+    return block->dirty[reg >> 5] & (1u << (reg & 31));
+}
+
+static bool isValid(const gpu_uniform_block* block, u32 reg)
+{
+    return block->valid[reg >> 5] & (1u << (reg & 31));
+}
+
+/**
+* Copies one register, only marking it dirty if it changed.
+*/
+static void setReg(gpu_uniform_block* block, u32 reg, const float* value)
+{
+    if(!memcmp(block->regs[reg], value, 4 * sizeof(float)))
+    {
+        //Never uploaded registers still have to be sent once, even if they are 0
+        if(!isValid(block, reg))markDirty(block, reg);
+        return;
+    }
+    memcpy(block->regs[reg], value, 4 * sizeof(float));
+    markDirty(block, reg);
+}
+
+void gpuUniformBlockInit(gpu_uniform_block* block, GPU_SHADER_TYPE type)
+{
+    memset(block, 0, sizeof(*block));
+    block->type = type;
+}
+
+void gpuUniformSetRegs(gpu_uniform_block* block, u32 reg, const float* data, u32 count)
+{
+    u32 i;
+    if(reg + count > GPU_FLOAT_UNIFORMS)return;
+    for(i = 0; i < count; ++i)setReg(block, reg + i, &data[i * 4]);
+}
+
+void gpuUniformSetMatrix(gpu_uniform_block* block, u32 reg, const float* m)
+{
+    float pica[16];
+    mtxToPica(pica, m);
+    gpuUniformSetRegs(block, reg, pica, 4);
+}
+
+void gpuUniformSetVec4(gpu_uniform_block* block, u32 reg, float x, float y, float z, float w)
+{
+    const float value[4] = {w, z, y, x};
+    gpuUniformSetRegs(block, reg, value, 1);
+}
+
+float* gpuUniformGetRegs(gpu_uniform_block* block, u32 reg)
+{
+    if(reg >= GPU_FLOAT_UNIFORMS)return NULL;
+    return block->regs[reg];
+}
+
+void gpuUniformTouch(gpu_uniform_block* block, u32 reg, u32 count)
+{
+    u32 i;
+    for(i = 0; i < count && reg + i < GPU_FLOAT_UNIFORMS; ++i)markDirty(block, reg + i);
+}
+
+u32 gpuUniformBlockUpload(gpu_uniform_block* block)
+{
+    u32 reg = 0, sent = 0;
+    while(reg < GPU_FLOAT_UNIFORMS)
+    {
+        //Skip whole clean words of the mask at once
+        if(!(reg & 31) && !block->dirty[reg >> 5])
+        {
+            reg += 32;
+            continue;
+        }
+        if(!isDirty(block, reg))
+        {
+            reg++;
+            continue;
+        }
+
+        //Extend the burst over small gaps of clean registers, but never over the ones we don't own
+        u32 first = reg, last = reg;
+        for(reg = first + 1; reg < GPU_FLOAT_UNIFORMS && reg <= last + 1 + GPU_UNIFORM_MAX_GAP; ++reg)
+        {
+            if(isDirty(block, reg))last = reg;
+            else if(!isValid(block, reg))break;
+        }
+        GPU_SetFloatUniform(block->type, first, (u32*)block->regs[first], last - first + 1);
+        sent += last - first + 1;
+        reg = last + 1;
+    }
+    memset(block->dirty, 0, sizeof(block->dirty));
+    return sent;
+}
+
+void gpuUniformBlockInvalidate(gpu_uniform_block* block)
+{
+    memcpy(block->dirty, block->valid, sizeof(block->dirty));
+}
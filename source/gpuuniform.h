@@ -0,0 +1,53 @@
+/**
+ *@file gpuuniform.h
+ *@author Lectem
+ *@date 17/10/2026
+ *
+ * Float uniforms kept in the order the PICA registers expect them, so that uploading is a single copy into the
+ * command list. Each register is a vec4 stored as w, z, y, x: a row major matrix row (a, b, c, d) is stored d, c, b, a.
+ *
+ * Setting a register only marks it dirty if its value changed, and gpuUniformBlockUpload() sends the dirty
+ * registers as a few contiguous bursts. Many draws changing one small uniform each then cost a few words each.
+ */
+#pragma once
+
+#include <3ds.h>
+
+//Number of float uniform registers (c0-c95) of the vertex shader
+#define GPU_FLOAT_UNIFORMS 96
+//Clean registers between two dirty ones that are sent anyway, cheaper than starting another burst
+#define GPU_UNIFORM_MAX_GAP 1
+
+typedef struct {
+    GPU_SHADER_TYPE type;
+    float regs[GPU_FLOAT_UNIFORMS][4];  ///< Register order: w, z, y, x
+    u32 dirty[GPU_FLOAT_UNIFORMS / 32]; ///< Registers changed since the last upload
+    u32 valid[GPU_FLOAT_UNIFORMS / 32]; ///< Registers ever set, the others belong to the shader (.constf)
+} gpu_uniform_block;
+
+void gpuUniformBlockInit(gpu_uniform_block* block, GPU_SHADER_TYPE type);
+
+/**
+* Sets count registers from data, which is already in register order (see mtxToPica).
+*/
+void gpuUniformSetRegs(gpu_uniform_block* block, u32 reg, const float* data, u32 count);
+/**
+* Sets the 4 registers of a row major matrix (mmath.h convention), only the rows that changed become dirty.
+*/
+void gpuUniformSetMatrix(gpu_uniform_block* block, u32 reg, const float* m);
+void gpuUniformSetVec4(gpu_uniform_block* block, u32 reg, float x, float y, float z, float w);
+/**
+* Direct access to the registers, to build uniforms in place. They must be marked with gpuUniformTouch.
+*/
+float* gpuUniformGetRegs(gpu_uniform_block* block, u32 reg);
+void gpuUniformTouch(gpu_uniform_block* block, u32 reg, u32 count);
+
+/**
+* Adds the writes of the dirty registers to the current command list, to be called before drawing.
+* @return The number of registers sent
+*/
+u32 gpuUniformBlockUpload(gpu_uniform_block* block);
+/**
+* Marks every register that was set as dirty, eg. after another shader overwrote them.
+*/
+void gpuUniformBlockInvalidate(gpu_uniform_block* block);
@@ -0,0 +1,330 @@
+/**
+ *@file gpuvertex.c
+ *@author Lectem
+ *@date 17/10/2026
+ */
+#include "gpuvertex.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const u8 componentSize[4] = {1, 1, 2, 4}; //GPU_BYTE, GPU_UNSIGNED_BYTE, GPU_SHORT, GPU_FLOAT
+
+void gpuVertexFormatInit(gpu_vertex_format* format)
+{
+    memset(format, 0, sizeof(*format));
+}
+
+static gpu_attribute* addAttribute(gpu_vertex_format* format, u8 reg, u8 count, GPU_FORMATS type)
+{
+    u32 index = format->numAttributes;
+    gpu_attribute* a;
+    if(index >= GPU_MAX_ATTRIBUTES || reg >= GPU_MAX_ATTRIBUTES || count < 1 || count > 4)return NULL;
+    a = &format->attributes[index];
+    memset(a, 0, sizeof(*a));
+    a->reg = reg;
+    a->count = count;
+    a->format = type & 3;
+    a->value[3] = 1.0f;
+    format->formats |= (u64)GPU_ATTRIBFMT(0, count, type) << (4 * index);
+    format->permutation |= (u64)reg << (4 * index);
+    format->numAttributes++;
+    return a;
+}
+
+bool gpuVertexFormatAdd(gpu_vertex_format* format, u8 reg, u8 count, GPU_FORMATS type)
+{
+    u32 size = componentSize[type & 3];
+    u32 index = format->numAttributes;
+    gpu_attribute* a;
+    if(format->stride % size)return false;
+    if(!(a = addAttribute(format, reg, count, type)))return false;
+    a->offset = format->stride;
+    format->stride += size * count;
+    format->loadedMask |= 1 << index;
+    format->bufferPermutation |= (u64)index << (4 * format->numLoaded);
+    format->numLoaded++;
+    return true;
+}
+
+bool gpuVertexFormatAddFixed(gpu_vertex_format* format, u8 reg, float x, float y, float z, float w)
+{
+    gpu_attribute* a = addAttribute(format, reg, 4, GPU_FLOAT);
+    if(!a)return false;
+    a->fixed = true;
+    a->value[0] = x;
+    a->value[1] = y;
+    a->value[2] = z;
+    a->value[3] = w;
+    return true;
+}
+
+void gpuVertexFormatPosCol(gpu_vertex_format* format)
+{
+    gpuVertexFormatInit(format);
+    gpuVertexFormatAdd(format, 0, 3, GPU_FLOAT);
+    gpuVertexFormatAdd(format, 1, 4, GPU_UNSIGNED_BYTE);
+    gpuVertexFormatAdd(format, 2, 2, GPU_FLOAT);
+}
+
+void gpuVertexFormatPosWhite(gpu_vertex_format* format)
+{
+    gpuVertexFormatInit(format);
+    gpuVertexFormatAdd(format, 0, 3, GPU_FLOAT);
+    gpuVertexFormatAddFixed(format, 1, 255.0f, 255.0f, 255.0f, 255.0f);
+    gpuVertexFormatAddFixed(format, 2, 0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+void gpuVertexFormatBind(const gpu_vertex_format* format, const void* vertices)
+{
+    gpuVertexFormatSetBuffer(format, vertices);
+    gpuVertexFormatSetFixed(format);
+}
+
+void gpuVertexFormatSetBuffer(const gpu_vertex_format* format, const void* vertices)
+{
+    //Everything above the last attribute is marked as not loaded as well, like the hand written calls did
+    GPU_SetAttributeBuffers(
+            format->numAttributes,
+            (u32*)osConvertVirtToPhys((u32)vertices),
+            format->formats,
+            0xFFFF & ~format->loadedMask,
+            format->permutation,
+            1,
+            (u32[]) {0x0},
+            (u64[]) {format->bufferPermutation},
+            (u8[]) {format->numLoaded}
+    );
+}
+
+void gpuVertexFormatSetFixed(const gpu_vertex_format* format)
+{
+    u32 i;
+    for(i = 0; i < format->numAttributes; ++i)
+    {
+        const gpu_attribute* a = &format->attributes[i];
+        u32 x, y, z, w, packed[3];
+        if(!a->fixed)continue;
+        //4 float24 components packed in 3 words, w first
+        x = f32tof24(a->value[0]);
+        y = f32tof24(a->value[1]);
+        z = f32tof24(a->value[2]);
+        w = f32tof24(a->value[3]);
+        packed[0] = (w << 8) | (z >> 16);
+        packed[1] = (z << 16) | (y >> 8);
+        packed[2] = (y << 24) | x;
+        GPUCMD_AddWrite(GPUREG_FIXEDATTRIB_INDEX, i);
+        GPUCMD_AddIncrementalWrites(GPUREG_FIXEDATTRIB_DATA0, packed, 3);
+    }
+}
+
+static float readComponent(const u8* p, GPU_FORMATS type)
+{
+    float f;
+    switch(type)
+    {
+        case GPU_BYTE: return (s8)*p;
+        case GPU_UNSIGNED_BYTE: return *p;
+        case GPU_SHORT: { s16 s; memcpy(&s, p, 2); return s; }
+        default: memcpy(&f, p, 4); return f;
+    }
+}
+
+static void writeComponent(u8* p, GPU_FORMATS type, float v)
+{
+    float r = roundf(v);
+    switch(type)
+    {
+        case GPU_BYTE: *p = (s8)(r < -128.0f ? -128.0f : r > 127.0f ? 127.0f : r); break;
+        case GPU_UNSIGNED_BYTE: *p = (u8)(r < 0.0f ? 0.0f : r > 255.0f ? 255.0f : r); break;
+        case GPU_SHORT:
+        {
+            s16 s = (s16)(r < -32768.0f ? -32768.0f : r > 32767.0f ? 32767.0f : r);
+            memcpy(p, &s, 2);
+            break;
+        }
+        default: memcpy(p, &v, 4); break;
+    }
+}
+
+u32 gpuVertexConvert(void* dst, const gpu_vertex_format* dstFormat, const void* src, const gpu_vertex_format* srcFormat, u32 count)
+{
+    //Source attribute of each destination one, looked up once
+    const gpu_attribute* from[GPU_MAX_ATTRIBUTES];
+    u32 i, j, v, c;
+    for(i = 0; i < dstFormat->numAttributes; ++i)
+    {
+        from[i] = NULL;
+        for(j = 0; j < srcFormat->numAttributes; ++j)
+        {
+            if(srcFormat->attributes[j].reg == dstFormat->attributes[i].reg)from[i] = &srcFormat->attributes[j];
+        }
+    }
+
+    for(v = 0; v < count; ++v)
+    {
+        const u8* in = (const u8*)src + v * srcFormat->stride;
+        u8* out = (u8*)dst + v * dstFormat->stride;
+        for(i = 0; i < dstFormat->numAttributes; ++i)
+        {
+            const gpu_attribute* d = &dstFormat->attributes[i];
+            const gpu_attribute* s = from[i];
+            float value[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+            if(d->fixed)continue;
+            if(s && s->fixed)memcpy(value, s->value, sizeof(value));
+            else if(s)
+            {
+                for(c = 0; c < s->count; ++c)value[c] = readComponent(in + s->offset + c * componentSize[s->format], s->format);
+            }
+            for(c = 0; c < d->count; ++c)writeComponent(out + d->offset + c * componentSize[d->format], d->format, value[c]);
+        }
+    }
+    return count * dstFormat->stride;
+}
+
+static u32 hashVertex(const u8* v, u32 stride)
+{
+    u32 h = 2166136261u, i;
+    for(i = 0; i < stride; ++i)h = (h ^ v[i]) * 16777619u;
+    return h;
+}
+
+u32 gpuVertexWeld(void* vertices, u32 stride, u32 count, u16* indices)
+{
+    u8* data = vertices;
+    u32 tableSize = 1, unique = 0, v;
+    u32* table;
+    if(!count || count > 0x10000)return 0;
+    while(tableSize < 2 * count)tableSize <<= 1;
+    //Open addressing on the vertex bytes, a slot holds the welded index + 1
+    table = calloc(tableSize, sizeof(u32));
+    if(!table)return 0;
+    for(v = 0; v < count; ++v)
+    {
+        const u8* vertex = data + v * stride;
+        u32 slot = hashVertex(vertex, stride) & (tableSize - 1);
+        while(table[slot] && memcmp(data + (table[slot] - 1) * stride, vertex, stride))slot = (slot + 1) & (tableSize - 1);
+        if(!table[slot])
+        {
+            //unique <= v, so the vertices still to be read are never overwritten
+            if(unique != v)memmove(data + unique * stride, vertex, stride);
+            table[slot] = ++unique;
+        }
+        indices[v] = table[slot] - 1;
+    }
+    free(table);
+    return unique;
+}
+
+typedef struct {
+    u32 key;
+    u32 triangle;
+} edge_entry;
+
+static u32 edgeKey(u16 a, u16 b)
+{
+    return a < b ? ((u32)a << 16) | b : ((u32)b << 16) | a;
+}
+
+static int compareEdges(const void* a, const void* b)
+{
+    u32 ka = ((const edge_entry*)a)->key, kb = ((const edge_entry*)b)->key;
+    return ka < kb ? -1 : ka > kb;
+}
+
+/**
+* Looks for an unused triangle going through the edge from a to b in that direction, which is what keeps
+* its winding once it follows a and b in the strip.
+* @return The third vertex of the triangle, -1 if there is none
+*/
+static s32 findNext(const edge_entry* edges, u32 numEdges, const u16* triangles, u8* used, u16 a, u16 b)
+{
+    u32 key = edgeKey(a, b), lo = 0, hi = numEdges, i;
+    while(lo < hi)
+    {
+        u32 mid = (lo + hi) / 2;
+        if(edges[mid].key < key)lo = mid + 1;
+        else hi = mid;
+    }
+    for(; lo < numEdges && edges[lo].key == key; ++lo)
+    {
+        u32 t = edges[lo].triangle;
+        const u16* tri = &triangles[3 * t];
+        if(used[t])continue;
+        for(i = 0; i < 3; ++i)
+        {
+            if(tri[i] == a && tri[(i + 1) % 3] == b)
+            {
+                used[t] = 1;
+                return tri[(i + 2) % 3];
+            }
+        }
+    }
+    return -1;
+}
+
+u32 gpuIndexStrip(u16* strip, const u16* triangles, u32 count)
+{
+    u32 numTriangles = count / 3, numEdges = 0, length = 0, t, i, r;
+    edge_entry* edges = malloc(count * sizeof(edge_entry));
+    u8* used = calloc(numTriangles ? numTriangles : 1, 1);
+    if(!edges || !used)
+    {
+        free(edges);
+        free(used);
+        return 0;
+    }
+    for(t = 0; t < numTriangles; ++t)
+    {
+        const u16* tri = &triangles[3 * t];
+        if(tri[0] == tri[1] || tri[1] == tri[2] || tri[2] == tri[0])
+        {
+            used[t] = 1;
+            continue;
+        }
+        for(i = 0; i < 3; ++i)
+        {
+            edges[numEdges].key = edgeKey(tri[i], tri[(i + 1) % 3]);
+            edges[numEdges].triangle = t;
+            numEdges++;
+        }
+    }
+    qsort(edges, numEdges, sizeof(edge_entry), compareEdges);
+
+    for(t = 0; t < numTriangles; ++t)
+    {
+        const u16* tri = &triangles[3 * t];
+        u32 start;
+        s32 next = -1;
+        if(used[t])continue;
+        used[t] = 1;
+        //Start with the rotation that lets the strip go on, the second triangle is odd so its edge is reversed
+        for(r = 0; r < 3 && next < 0; ++r)next = findNext(edges, numEdges, triangles, used, tri[(r + 2) % 3], tri[(r + 1) % 3]);
+        if(next >= 0)r--;
+        else r = 0;
+
+        if(length)
+        {
+            //Degenerate triangles to jump to the new strip, which must start on an even triangle to keep its winding
+            u16 last = strip[length - 1];
+            bool odd = length & 1;
+            strip[length++] = last;
+            strip[length++] = tri[r];
+            if(odd)strip[length++] = tri[r];
+        }
+        start = length;
+        strip[length++] = tri[r];
+        strip[length++] = tri[(r + 1) % 3];
+        strip[length++] = tri[(r + 2) % 3];
+        while(next >= 0)
+        {
+            strip[length++] = next;
+            //Even triangles go through the last two vertices in order, odd ones in reverse
+            if((length - start) & 1)next = findNext(edges, numEdges, triangles, used, strip[length - 1], strip[length - 2]);
+            else next = findNext(edges, numEdges, triangles, used, strip[length - 2], strip[length - 1]);
+        }
+    }
+    free(edges);
+    free(used);
+    return length;
+}
@@ -0,0 +1,94 @@
+/**
+ *@file gpuvertex.h
+ *@author Lectem
+ *@date 17/10/2026
+ *
+ * Vertex layouts described attribute by attribute, from which the formats, masks and permutations of
+ * GPU_SetAttributeBuffers are generated.
+ *
+ * Attributes are either loaded from an interleaved buffer, packed in the order they are added, or fixed:
+ * the same value for every vertex, sent once as a register write and taking no room in the buffer.
+ * The attribute loader doesn't normalize integers: an unsigned byte 255 is 255.0 in the shader.
+ */
+#pragma once
+
+#include <3ds.h>
+
+//Attributes the PICA attribute loader handles
+#define GPU_MAX_ATTRIBUTES 12
+
+typedef struct {
+    u8 reg;             ///< Shader input register (v0-v11)
+    u8 count;           ///< Components (1-4), the missing ones are (0, 0, 0, 1)
+    GPU_FORMATS format;
+    bool fixed;
+    u8 offset;          ///< In the vertex, for the loaded ones
+    float value[4];     ///< For the fixed ones, as the shader sees it
+} gpu_attribute;
+
+typedef struct {
+    u8 numAttributes;
+    u8 numLoaded;
+    u16 stride;
+    gpu_attribute attributes[GPU_MAX_ATTRIBUTES];
+    //What GPU_SetAttributeBuffers takes, kept up to date by the gpuVertexFormatAdd* functions
+    u64 formats;
+    u16 loadedMask;
+    u64 permutation;
+    u64 bufferPermutation;
+} gpu_vertex_format;
+
+void gpuVertexFormatInit(gpu_vertex_format* format);
+/**
+* Adds an attribute read from the vertex buffer. Components must be aligned to their size (floats to 4 bytes...),
+* so add the biggest ones first.
+* @return false if there is no room left or the attribute wouldn't be aligned
+*/
+bool gpuVertexFormatAdd(gpu_vertex_format* format, u8 reg, u8 count, GPU_FORMATS type);
+/**
+* Adds an attribute with the same value for every vertex.
+*/
+bool gpuVertexFormatAddFixed(gpu_vertex_format* format, u8 reg, float x, float y, float z, float w);
+/**
+* The layout of vertex_pos_col: float3 position in v0, u8x4 color in v1, float2 texture coordinates in v2.
+*/
+void gpuVertexFormatPosCol(gpu_vertex_format* format);
+/**
+* Only the float3 position of vertex_pos_col, 12 bytes instead of 24: the color is fixed to white
+* (255 per component, what the u8 color gave) and the texture coordinates to 0.
+*/
+void gpuVertexFormatPosWhite(gpu_vertex_format* format);
+
+/**
+* Sets the attribute buffers and the fixed attributes for vertices laid out as format.
+*/
+void gpuVertexFormatBind(const gpu_vertex_format* format, const void* vertices);
+/**
+* The two halves of gpuVertexFormatBind: the fixed values stay set across draws, so drawing several buffers
+* of the same format only needs gpuVertexFormatSetBuffer for each.
+*/
+void gpuVertexFormatSetBuffer(const gpu_vertex_format* format, const void* vertices);
+void gpuVertexFormatSetFixed(const gpu_vertex_format* format);
+
+/**
+* Converts count vertices from one layout to another, attributes are matched by shader register.
+* Integers are rounded and saturated, attributes missing from src are (0, 0, 0, 1) or its fixed value.
+* Fixed attributes of dst are left out since they aren't in the buffer.
+* @return The size of the converted vertices in bytes
+*/
+u32 gpuVertexConvert(void* dst, const gpu_vertex_format* dstFormat, const void* src, const gpu_vertex_format* srcFormat, u32 count);
+
+/**
+* Merges the identical vertices of a non indexed mesh, compacting them in place, and writes the index of each
+* original vertex to indices (count of them).
+* @return The number of vertices left, 0 if count is over 65536 or memory ran out
+*/
+u32 gpuVertexWeld(void* vertices, u32 stride, u32 count, u16* indices);
+/**
+* Turns an indexed triangle list into a single triangle strip. Strips are joined with degenerate triangles
+* and every triangle keeps its winding, triangles using a vertex twice are dropped.
+* @param strip Room for 6 indices per triangle in the worst case, about 1 per triangle for a mesh in one strip
+* @param count Number of indices in triangles, a multiple of 3
+* @return The number of indices written to strip, 0 if memory ran out
+*/
+u32 gpuIndexStrip(u16* strip, const u16* triangles, u32 count);
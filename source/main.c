@@ -14,6 +14,17 @@
 #include <stdlib.h>
 #include <string.h>
 #include "gpuframework.h"
+#include "tevsweep.h"
+#include "gputrace.h"
+#include "gpustateblock.h"
+#include "gputiming.h"
+#include "gpureadback.h"
+#include "gputexture.h"
+#include "gpuvertex.h"
+#include "gpusprite.h"
+#include "gpulog.h"
+#include "gputest.h"
+#include "testcases.h"
 
 
 
@@ -31,7 +42,15 @@ static const vertex_pos_col test_mesh[] =
         };
 
 static void* test_data = NULL;
-
+//test_mesh is only white, so the GPU gets its positions and a fixed color
+static gpu_vertex_format test_format;
+//test_mesh welded to its 4 corners, drawn as a strip
+static u8* test_indices = NULL;
+static u32 test_index_count = 0;
+
+//Room for more textures than the 3 TEV inputs, for the tests that generate their own
+#define TEST_TEXTURES 16
+static gpu_pool test_texture_pool;
 static u32* test_texture=NULL;
 static u32* test_texture1=NULL;
 static u32* test_texture2=NULL;
@@ -42,26 +61,186 @@ u8 alphasource = 0;
 
 void fill_test_textures(u8 tex,u32 color)
 {
+    //color is a RGBA8() value, converted to the tiled layout and byte order of the PICA
+    u32 image[test_texture_w*test_texture_h];
+    u32* textures[3] = {test_texture, test_texture1, test_texture2};
     int px;
-    for(px=0;px < test_texture_h*test_texture_w;++px)
+    if(tex > 2 || !textures[tex])return;
+    for(px=0;px < test_texture_h*test_texture_w;++px)image[px] = color;
+    gpuTextureTile(textures[tex], image, test_texture_w, test_texture_h, GPU_RGBA8, 0);
+}
+
+//The report and the records are written to the SD card by their own thread, see gpulog.h
+#define LOG_RING_SIZE 0x40000
+static gpu_log report_log;
+static gpu_log record_log;
+static bool records_open = false;
+FILE* reportFile = NULL;
+
+//Sprites of the benchmark, the ring holds 3 times the 16384 sprites of a flush: 2 frames in flight and room to wrap around
+#define SPRITE_BENCH_FRAMES 8
+static gpu_sprite_batch sprite_batch;
+static bool sprite_batch_ready = false;
+
+//Eye separation in stereo with the 3D slider all the way up, for the things at depth 0 (the screen is at depth 1)
+#define STEREO_PARALLAX 12.0f
+
+//Cases written by host/tevfuzz, if the file is next to the application
+static gpu_test_suite fuzz_suite;
+
+static void record_constant_tev(void)
+{
+    //Texture * constant color, to have two setups to switch between
+    GPU_SetTexEnv(0,
+                  GPU_TEVSOURCES(GPU_TEXTURE0, GPU_CONSTANT, 0),
+                  GPU_TEVSOURCES(GPU_TEXTURE0, GPU_CONSTANT, 0),
+                  GPU_TEVOPERANDS(0, 0, 0),
+                  GPU_TEVOPERANDS(0, 0, 0),
+                  GPU_MODULATE, GPU_MODULATE,
+                  0x80C0FFFF);
+}
+
+/**
+* Draws more and more random sprites (3 textures x 2 TEV setups) for SPRITE_BENCH_FRAMES frames each,
+* and prints how many sprites per second the CPU recorded and the whole frames went through.
+*/
+void run_sprite_benchmark(FILE* f)
+{
+    static const u32 counts[] = {1000, 2000, 4000, 8000, 16000};
+    u32 c, frame, i;
+    if(!sprite_batch_ready)
     {
-        switch(tex)
+        printf("couldn't allocate the sprite batch\n");
+        return;
+    }
+    for(c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+    {
+        u64 recordTicks = 0, start;
+        gpuSpriteBatchResetStats(&sprite_batch);
+        gpuWaitIdle();
+        start = svcGetSystemTick();
+        for(frame = 0; frame < SPRITE_BENCH_FRAMES; ++frame)
+        {
+            u64 recordStart;
+            gpuStartFrame();
+            //Nothing tests depth, and the results aren't read
+            gpuClearBuffers(GPU_CLEAR_COLOR);
+            recordStart = svcGetSystemTick();
+            gpuSpriteBatchBegin(&sprite_batch);
+            for(i = 0; i < counts[c]; ++i)
+            {
+                gpu_sprite sprite = {
+                        .x = rand() % GPU_UI_WIDTH, .y = rand() % GPU_UI_HEIGHT,
+                        .w = 8 + rand() % 24, .h = 8 + rand() % 24,
+                        .z = 0.5f, .angle = (rand() % 628) * 0.01f,
+                        .u0 = 0.0f, .v0 = 0.0f, .u1 = 1.0f, .v1 = 1.0f,
+                        .color = RGBA8(rand(), rand(), rand(), 0xFF),
+                        .texture = rand() % 3, .tev = rand() % 2,
+                };
+                gpuSpriteBatchAdd(&sprite_batch, &sprite);
+            }
+            gpuSpriteBatchFlush(&sprite_batch);
+            recordTicks += svcGetSystemTick() - recordStart;
+            gpuEndFrame();
+        }
+        gpuWaitIdle();
+        u64 ticks = svcGetSystemTick() - start;
+        printf("%5lu sprites/frame: %llu/s recorded, %llu/s drawn\n", (unsigned long)counts[c],
+               (unsigned long long)((u64)counts[c] * SPRITE_BENCH_FRAMES * SYSCLOCK_ARM11 / (recordTicks ? recordTicks : 1)),
+               (unsigned long long)((u64)counts[c] * SPRITE_BENCH_FRAMES * SYSCLOCK_ARM11 / (ticks ? ticks : 1)));
+        if(f)
         {
-            case 0:
-            test_texture[px] = color;
-                break;
-            case 1:
-            test_texture1[px] = color;
-                break;
-            case 2:
-            test_texture2[px] = color;
-                break;
-            default:break;
+            fprintf(f, "sprite benchmark, %lu sprites per frame, %d frames:\n", (unsigned long)counts[c], SPRITE_BENCH_FRAMES);
+            gpuSpriteBatchPrint(f, &sprite_batch, ticks);
         }
     }
+    if(f)fflush(f);
 }
 
-FILE* reportFile = NULL;
+//bind_test_state, recorded once
+static gpu_state_block test_state_block;
+//The TEV stage 0 setup and the draw of the interactive test, only the TEV sources change
+static gpu_state_block test_draw_block;
+static s32 test_draw_sources = -1;
+
+/**
+* Binds the vertex buffer and the test textures, shared by the interactive test and the sweeps.
+*/
+void bind_test_state()
+{
+    //Attribute formats, masks and permutations come from the layout, see gpuvertex.h
+    gpuVertexFormatBind(&test_format, test_data);
+
+    GPU_SetTextureEnable(GPU_TEXUNIT0 | GPU_TEXUNIT1 | GPU_TEXUNIT2);
+
+    GPU_SetTexture(
+            GPU_TEXUNIT0,
+            (u32 *)osConvertVirtToPhys((u32) test_texture),
+            // width and height swapped?
+            test_texture_h,
+            test_texture_w,
+            GPU_TEXTURE_MAG_FILTER(GPU_NEAREST) | GPU_TEXTURE_MIN_FILTER(GPU_NEAREST),
+            GPU_RGBA8
+    );
+    GPU_SetTexture(
+            GPU_TEXUNIT1,
+            (u32 *)osConvertVirtToPhys((u32) test_texture1),
+            // width and height swapped?
+            test_texture_h,
+            test_texture_w,
+            GPU_TEXTURE_MAG_FILTER(GPU_NEAREST) | GPU_TEXTURE_MIN_FILTER(GPU_NEAREST),
+            GPU_RGBA8
+    );
+    GPU_SetTexture(
+            GPU_TEXUNIT2,
+            (u32 *)osConvertVirtToPhys((u32) test_texture2),
+            // width and height swapped?
+            test_texture_h,
+            test_texture_w,
+            GPU_TEXTURE_MAG_FILTER(GPU_NEAREST) | GPU_TEXTURE_MIN_FILTER(GPU_NEAREST),
+            GPU_RGBA8
+    );
+}
+
+/**
+* Same as bind_test_state, from the prebaked block when there is one.
+*/
+void append_test_state()
+{
+    if(!test_state_block.cmds || !gpuStateBlockAppend(&test_state_block))bind_test_state();
+}
+
+void draw_test()
+{
+    GPU_SetTexEnv(
+            0,
+            GPU_TEVSOURCES(colorsource, 0, 0),
+            GPU_TEVSOURCES(alphasource, 0, 0),
+            GPU_TEVOPERANDS(0, 0, 0),
+            GPU_TEVOPERANDS(0, 0, 0),
+            GPU_REPLACE, GPU_REPLACE,
+            0xAABBCCDD
+    );
+
+    //Display the buffers data
+    gpuDrawElements(GPU_TRIANGLE_STRIP, test_data, test_indices, test_index_count, GPU_INDEX_U8);
+}
+
+void build_test_blocks()
+{
+    if(gpuStateBlockBegin(&test_state_block, 0x100))
+    {
+        bind_test_state();
+        if(!gpuStateBlockEnd(&test_state_block))gpuStateBlockFree(&test_state_block);
+    }
+    if(gpuStateBlockBegin(&test_draw_block, 0x40))
+    {
+        draw_test();
+        //The sources of the TEV stage 0 are the first param written to 0xC0
+        if(!gpuStateBlockEnd(&test_draw_block))gpuStateBlockFree(&test_draw_block);
+        else test_draw_sources = gpuStateBlockFind(&test_draw_block, 0xC0);
+    }
+}
 
 
 int main(int argc, char** argv)
@@ -79,28 +258,67 @@ int main(int argc, char** argv)
     gpuUIInit();
 
     printf("hello triangle !\n");
-    test_data = linearAlloc(sizeof(test_mesh));     //allocate our vbo on the linear heap
-    memcpy(test_data, test_mesh, sizeof(test_mesh)); //Copy our data
-    //Allocate a RGBA8 texture with dimensions of 1x1
-    test_texture = linearMemAlign(test_texture_w*test_texture_h*sizeof(u32),0x80);
-    test_texture1 = linearMemAlign(test_texture_w*test_texture_h*sizeof(u32),0x80);
-    test_texture2 = linearMemAlign(test_texture_w*test_texture_h*sizeof(u32),0x80);
+    gpu_vertex_format mesh_format;
+    u32 vertices = sizeof(test_mesh) / sizeof(test_mesh[0]);
+    gpuVertexFormatPosCol(&mesh_format);
+    gpuVertexFormatPosWhite(&test_format);
+    test_data = gpuArenaAlloc(&gpuArena, vertices * test_format.stride, 0x10);     //allocate our vbo on the linear heap
+    if(test_data)
+    {
+        u16 welded[sizeof(test_mesh) / sizeof(test_mesh[0])];
+        u16 strip[6 * sizeof(test_mesh) / sizeof(test_mesh[0]) / 3];
+        u32 i;
+        gpuVertexConvert(test_data, &test_format, test_mesh, &mesh_format, vertices); //Copy our data
+        //The indices go after the vertices, where the GPU looks for them
+        if(gpuVertexWeld(test_data, test_format.stride, vertices, welded))
+            test_index_count = gpuIndexStrip(strip, welded, vertices);
+        test_indices = gpuArenaAlloc(&gpuArena, test_index_count, 1);
+        if(!test_indices)test_index_count = 0;
+        for(i = 0; i < test_index_count; ++i)test_indices[i] = strip[i];
+    }
+    //The textures all have the same size, so they come from a pool instead of one heap allocation each
+    if(!gpuPoolInit(&test_texture_pool, &gpuArena, test_texture_w*test_texture_h*sizeof(u32), 0x80, TEST_TEXTURES))
+        printf("couldn't allocate the texture pool\n");
+    test_texture = gpuPoolAlloc(&test_texture_pool);
+    test_texture1 = gpuPoolAlloc(&test_texture_pool);
+    test_texture2 = gpuPoolAlloc(&test_texture_pool);
 
     fill_test_textures(0,RGBA8(0x11, 0x11, 0x11, 0x11));
     fill_test_textures(1,RGBA8(0x22, 0x22, 0x22, 0x22));
     fill_test_textures(2,RGBA8(0x33, 0x33, 0x33, 0x33));
 
-    int i;
-    for(i=0;i<sizeof(test_mesh) / sizeof(test_mesh[0]);++i)
+    build_test_blocks();
+    sprite_batch_ready = gpuSpriteBatchInit(&sprite_batch, 0x4000, 3 * 0x4000 * 4 * sizeof(vertex_pos_col));
+    if(sprite_batch_ready)
     {
-        ((vertex_pos_col*)test_data)[i].color.r=255;
-        ((vertex_pos_col*)test_data)[i].color.g=255;
-        ((vertex_pos_col*)test_data)[i].color.b=255;
-        ((vertex_pos_col*)test_data)[i].color.a=255;
+        u32 filter = GPU_TEXTURE_MAG_FILTER(GPU_NEAREST) | GPU_TEXTURE_MIN_FILTER(GPU_NEAREST);
+        gpuSpriteBatchSetTexture(&sprite_batch, 0, test_texture, test_texture_w, test_texture_h, GPU_RGBA8, filter);
+        gpuSpriteBatchSetTexture(&sprite_batch, 1, test_texture1, test_texture_w, test_texture_h, GPU_RGBA8, filter);
+        gpuSpriteBatchSetTexture(&sprite_batch, 2, test_texture2, test_texture_w, test_texture_h, GPU_RGBA8, filter);
+        gpuSpriteBatchSetTev(&sprite_batch, 1, record_constant_tev);
     }
-    reportFile = fopen("gpuTestReport.txt","w");
+    if(gpuLogOpen(&report_log, "gpuTestReport.txt", LOG_RING_SIZE))reportFile = gpuLogStream(&report_log);
+    records_open = gpuLogOpenRecords(&record_log, "gpuLog.bin", LOG_RING_SIZE);
+    u16 frame_record = records_open ? gpuLogDefine(&record_log, "frame:cSource,aSource,commands,words,filteredWords") : 0;
+    u16 check_record = records_open ? gpuLogDefine(&record_log, "check:cSource,aSource,color:x,colors,crc:x") : 0;
+    if(!tevSweepInit())printf("couldn't allocate the sweep tiles\n");
+    gpuTestInit();
+    testCasesRegister();
+    if(gpuTestLoadSuite(&fuzz_suite, "fuzz", "gpuTestList.txt"))
+    {
+        gpuTestRegister(&fuzz_suite);
+        printf("%lu cases loaded from gpuTestList.txt\n", (unsigned long)fuzz_suite.count);
+    }
+    printf("Press X to run all the TEV sweeps\n");
+    printf("Press Y to start/stop recording a trace, L alone to replay it\n");
+    printf("Press A to check the frame, B to dump it\n");
+    printf("Hold L and press X to benchmark the sprite batch\n");
+    printf("Hold L and press A to run the test cases\n");
+    printf("Hold L and press Select to change the presentation mode\n");
+    printf("Hold L and press R to switch stereo 3D on or off\n");
 
     if(!test_texture)printf("couldn't allocate test_texture\n");
+    bool lModifier = false;
     do{
         hidScanInput();
         u32 keys = keysDown();
@@ -109,100 +327,192 @@ int main(int argc, char** argv)
         if(keys&KEY_UP && alphasource <0xF) { alphasource++; }
         if(keys & KEY_LEFT && colorsource >0) { colorsource--; }
         if(keys&KEY_RIGHT && colorsource<0xF) { colorsource++; }
+        if(keys&KEY_X && keysHeld()&KEY_L)run_sprite_benchmark(reportFile);
+        else if(keys&KEY_X)
+        {
+            //Every case gets its own tile, so this only takes a few frames
+            u32 frames = tevSweepRunAll(reportFile, records_open ? &record_log : NULL, append_test_state);
+            printf("TEV sweeps done in %lu frames\n", (unsigned long)frames);
+        }
+        if(keys&KEY_A && keysHeld()&KEY_L)
+        {
+            gpu_test_summary summary;
+            gpuTestRunAll(reportFile, records_open ? &record_log : NULL, &summary);
+            printf("%lu/%lu tests passed (%lu recorded) in %lu frames, %lu ms\n",
+                   (unsigned long)summary.passed, (unsigned long)(summary.passed + summary.failed),
+                   (unsigned long)summary.recorded, (unsigned long)summary.frames,
+                   (unsigned long)(summary.ticks / TICKS_PER_MSEC));
+        }
+        if(keys&KEY_Y)
+        {
+            if(!gpuTraceIsRecording())
+            {
+                if(gpuTraceStart("gpuTrace.bin"))printf("recording gpuTrace.bin\n");
+                else printf("couldn't create gpuTrace.bin\n");
+            }
+            else
+            {
+                u32 frames;
+                u64 words, bytes;
+                gpuTraceStop();
+                gpuTraceRecordStats(&frames, &words, &bytes);
+                printf("recorded %lu frames, %llu bytes (%llu of commands)\n",
+                       (unsigned long)frames, (unsigned long long)bytes, (unsigned long long)words * 4);
+            }
+        }
+        if(keys&KEY_R && keysHeld()&KEY_L)
+        {
+            bool stereo = !gpuStereoEnabled();
+            if(gpuSetStereo(stereo))printf("stereo %s\n", stereo ? "on" : "off");
+            else printf("couldn't allocate the right eye buffers\n");
+        }
+        else if(keys&KEY_R)
+        {
+            static bool filter = true;
+            const gpu_filter_stats* stats = gpuGetFilterStats();
+            if(filter)printf("last frame: %lu commands (%lu words) -> %lu (%lu words), %lu writes dropped, %lu merged\n",
+                             (unsigned long)stats->inputCommands, (unsigned long)stats->inputWords,
+                             (unsigned long)stats->commands, (unsigned long)stats->words,
+                             (unsigned long)stats->droppedWrites, (unsigned long)stats->mergedCommands);
+            filter = !filter;
+            gpuSetRedundantWriteFilter(filter);
+            printf("redundant write filter %s\n", filter ? "on" : "off");
+        }
+        if(keys&KEY_SELECT && keysHeld()&KEY_L)
+        {
+            static const char* names[] = {"always", "headless", "every 4th frame", "dirty rows"};
+            gpu_present_mode mode = (gpuGetPresentMode(NULL) + 1) % 4;
+            gpuSetPresentMode(mode, 4);
+            printf("presentation: %s\n", names[mode]);
+        }
+        else if(keys&KEY_SELECT)
+        {
+            const gpu_clear_stats* clears = gpuGetClearStats();
+            //Everything since the last press
+            gpuTimingPrint(stdout);
+            gpuPrintArenas(stdout);
+            gpuPoolPrint(stdout, "textures", &test_texture_pool);
+            printf("last clear: %lu fills, %lu color and %lu depth words\n", (unsigned long)clears->fills,
+                   (unsigned long)clears->colorWords, (unsigned long)clears->depthWords);
+            if(reportFile)
+            {
+                fprintf(reportFile, "frame timing:\n");
+                gpuTimingPrint(reportFile);
+                gpuPrintArenas(reportFile);
+                gpuPoolPrint(reportFile, "textures", &test_texture_pool);
+                fprintf(reportFile, "last clear: %lu fills, %lu color and %lu depth words\n", (unsigned long)clears->fills,
+                        (unsigned long)clears->colorWords, (unsigned long)clears->depthWords);
+                fflush(reportFile);
+            }
+            gpuTimingReset();
+        }
+        //L is also the modifier of X, A, R and Select, so the replay waits for it to be released unused
+        if(keys&KEY_L)lModifier = false;
+        if(keysHeld()&KEY_L && keys&(KEY_X|KEY_A|KEY_R|KEY_SELECT))lModifier = true;
+        if(keysUp()&KEY_L && !lModifier && !gpuTraceIsRecording())
+        {
+            gpu_trace* trace = gpuTraceLoad("gpuTrace.bin");
+            if(trace)
+            {
+                u32 f, frames = gpuTraceFrameCount(trace);
+                u64 start = svcGetSystemTick();
+                for(f = 0; f < frames && gpuTraceReplayFrame(trace, f); ++f);
+                gpuWaitIdle();
+                u64 ticks = svcGetSystemTick() - start;
+                printf("replayed %lu/%lu frames in %lu ms\n", (unsigned long)f, (unsigned long)frames,
+                       (unsigned long)(ticks / TICKS_PER_MSEC));
+                gpuTraceFree(trace);
+            }
+            else printf("couldn't load gpuTrace.bin\n");
+        }
 
 
+        //The test quad (at depth 0.5) comes out of the screen as much as the slider says
+        if(gpuStereoEnabled())gpuSetStereoDepth(STEREO_PARALLAX * osGet3DSliderState(), 1.0f);
         gpuStartFrame();
+        //The test quad covers the whole screen with the depth test always passing
+        gpuClearBuffers(GPU_CLEAR_COLOR);
+        gpuMarkDirty(GPU_CLEAR_ALL, 0, 0, GPU_UI_WIDTH, GPU_UI_HEIGHT);
         //Setup the buffers data
-        GPU_SetAttributeBuffers(
-                3, // number of attributes
-                (u32 *) osConvertVirtToPhys((u32) test_data),
-                GPU_ATTRIBFMT(0, 3, GPU_FLOAT)|GPU_ATTRIBFMT(1, 4, GPU_UNSIGNED_BYTE)|GPU_ATTRIBFMT(2, 2, GPU_FLOAT),
-                0xFFF8,//Attribute mask, in our case 0b1110 since we use only the first one
-                0x210,//Attribute permutations (here it is the identity)
-                1, //number of buffers
-                (u32[]) {0x0}, // buffer offsets (placeholders)
-                (u64[]) {0x210}, // attribute permutations for each buffer (identity again)
-                (u8[]) {3} // number of attributes for each buffer
-        );
-
-        GPU_SetTextureEnable(GPU_TEXUNIT0 | GPU_TEXUNIT1 | GPU_TEXUNIT2);
-
-        GPU_SetTexture(
-                GPU_TEXUNIT0,
-                (u32 *)osConvertVirtToPhys((u32) test_texture),
-                // width and height swapped?
-                test_texture_h,
-                test_texture_w,
-                GPU_TEXTURE_MAG_FILTER(GPU_NEAREST) | GPU_TEXTURE_MIN_FILTER(GPU_NEAREST),
-                GPU_RGBA8
-        );
-        GPU_SetTexture(
-                GPU_TEXUNIT1,
-                (u32 *)osConvertVirtToPhys((u32) test_texture1),
-                // width and height swapped?
-                test_texture_h,
-                test_texture_w,
-                GPU_TEXTURE_MAG_FILTER(GPU_NEAREST) | GPU_TEXTURE_MIN_FILTER(GPU_NEAREST),
-                GPU_RGBA8
-        );
-        GPU_SetTexture(
-                GPU_TEXUNIT2,
-                (u32 *)osConvertVirtToPhys((u32) test_texture2),
-                // width and height swapped?
-                test_texture_h,
-                test_texture_w,
-                GPU_TEXTURE_MAG_FILTER(GPU_NEAREST) | GPU_TEXTURE_MIN_FILTER(GPU_NEAREST),
-                GPU_RGBA8
-        );
-        int texenvnum=0;
-        GPU_SetTexEnv(
-                texenvnum,
-                GPU_TEVSOURCES(colorsource, 0, 0),
-                GPU_TEVSOURCES(alphasource, 0, 0),
-                GPU_TEVOPERANDS(0, 0, 0),
-                GPU_TEVOPERANDS(0, 0, 0),
-                GPU_REPLACE, GPU_REPLACE,
-                0xAABBCCDD
-        );
-
-        //Display the buffers data
-        GPU_DrawArray(GPU_TRIANGLES, sizeof(test_mesh) / sizeof(test_mesh[0]));
+        append_test_state();
+        if(test_draw_sources >= 0)
+        {
+            test_draw_block.cmds[test_draw_sources] = (GPU_TEVSOURCES(alphasource, 0, 0) << 16) | GPU_TEVSOURCES(colorsource, 0, 0);
+            gpuStateBlockAppend(&test_draw_block);
+        }
+        else draw_test();
 
         gpuEndFrame();
 
-        if(keysDown()&KEY_A)
+        if(keysDown()&(KEY_A|KEY_B))
         {
-            printf("cSource=%1x aSource=%1x gpuColor=%x\n",colorsource, alphasource,(unsigned int)gpuColorBuffer[0]);
-            fprintf(reportFile,"cSource=%1x aSource=%1x gpuColor=%x\n",colorsource, alphasource,(unsigned int)gpuColorBuffer[0]);
+            u32* image = malloc(GPU_FB_PIXELS * sizeof(u32));
+            gpuWaitIdle();
+            if(image && keysDown()&KEY_A && !(keysHeld()&KEY_L))
+            {
+                //The whole frame should be the color of its first pixel
+                gpu_region_stats stats;
+                gpu_region frame = {0, 0, GPU_FB_WIDTH, GPU_FB_HEIGHT};
+                gpuReadbackColor(image);
+                gpuRegionStats(image, frame, &stats);
+                printf("cSource=%1x aSource=%1x gpuColor=%x colors=%lu crc=%08lx\n",colorsource, alphasource,
+                       (unsigned int)image[0], (unsigned long)stats.uniqueColors, (unsigned long)stats.checksum);
+                if(reportFile)fprintf(reportFile,"cSource=%1x aSource=%1x gpuColor=%x colors=%lu crc=%08lx\n",colorsource, alphasource,
+                                      (unsigned int)image[0], (unsigned long)stats.uniqueColors, (unsigned long)stats.checksum);
+                if(check_record)
+                {
+                    const u32 values[] = {colorsource, alphasource, image[0], stats.uniqueColors, stats.checksum};
+                    gpuLogRecord(&record_log, check_record, values, 5);
+                }
+            }
+            if(image && keysDown()&KEY_B)
+            {
+                static u32 dumps = 0;
+                char path[32];
+                bool ok;
+                gpuReadbackColor(image);
+                sprintf(path, "gpuColor_%04lu.raw", (unsigned long)dumps);
+                ok = gpuReadbackDump(path, image);
+                gpuReadbackDepth(image);
+                sprintf(path, "gpuDepth_%04lu.raw", (unsigned long)dumps);
+                ok = gpuReadbackDump(path, image) && ok;
+                printf("%s dump %lu (%dx%d)\n", ok ? "wrote" : "couldn't write", (unsigned long)dumps, GPU_FB_WIDTH, GPU_FB_HEIGHT);
+                dumps++;
+            }
+            if(!image)printf("couldn't allocate the readback image\n");
+            free(image);
         }
-        if(reportFile)
+        if(frame_record)
         {
-            //fprintf(reportFile,"%x\t%x\n", alphasource,(gpuColorBuffer[0]>>24)&0xFF);
+            //Every frame, the drain thread keeps it off the render loop
+            const gpu_filter_stats* filtered = gpuGetFilterStats();
+            const u32 values[] = {colorsource, alphasource, filtered->inputCommands, filtered->inputWords, filtered->words};
+            gpuLogRecord(&record_log, frame_record, values, 5);
         }
     }while(aptMainLoop() );
 
 
-    if(reportFile)
-    {
-        fclose(reportFile);
-    }
-
-    if(test_data)
-    {
-        linearFree(test_data);
-    }
-    if(test_texture)
-    {
-        linearFree(test_texture);
-    }
-    if(test_texture1)
-    {
-        linearFree(test_texture1);
-    }
-    if(test_texture2)
-    {
-        linearFree(test_texture2);
-    }
+    gpuTraceStop();
+    if(report_log.dropped || record_log.dropped)
+        printf("log rings full: %lu report and %lu record writes dropped\n",
+               (unsigned long)report_log.dropped, (unsigned long)record_log.dropped);
+    gpuLogClose(&report_log);
+    gpuLogClose(&record_log);
+    reportFile = NULL;
+
+    //Its buffers are the last VRAM targets
+    gpuSetStereo(false);
+    tevSweepExit();
+    gpuTestExit();
+    gpuTestFreeSuite(&fuzz_suite);
+    gpuStateBlockFree(&test_state_block);
+    gpuStateBlockFree(&test_draw_block);
+
+    //test_data, the textures and the sprite ring are freed with gpuArena
+    gpuSpriteBatchExit(&sprite_batch);
+    gpuPoolFree(&test_texture_pool, test_texture);
+    gpuPoolFree(&test_texture_pool, test_texture1);
+    gpuPoolFree(&test_texture_pool, test_texture2);
 
     gpuUIExit();
 
@@ -4,6 +4,7 @@
 #include <stdbool.h>
 #include <3ds.h>
 #include "mmath.h"
+#include "transform.h"
 
 void loadIdentity44(float* m)
 {
@@ -20,17 +21,11 @@ void multMatrix44(float* m1, float* m2, float* m) //4x4
 
 }
 
+//The transforms are done in place by transform.c, without building the other matrix
+
 void translateMatrix(float* tm, float x, float y, float z)
 {
-	float rm[16], m[16];
-
-	loadIdentity44(rm);
-	rm[3]=x;
-	rm[7]=y;
-	rm[11]=z;
-	
-	multMatrix44(tm,rm,m);
-	memcpy(tm,m,16*sizeof(float));
+	mtxTranslate(tm, x, y, z);
 }
 
 // 00 01 02 03
@@ -40,54 +35,22 @@ void translateMatrix(float* tm, float x, float y, float z)
 
 void rotateMatrixX(float* tm, float x, bool r)
 {
-	float rm[16], m[16];
-	memset(rm, 0x00, 16*4);
-	rm[0]=1.0f;
-	rm[5]=cos(x);
-	rm[6]=sin(x);
-	rm[9]=-sin(x);
-	rm[10]=cos(x);
-	rm[15]=1.0f;
-	if(!r)multMatrix44(tm,rm,m);
-	else multMatrix44(rm,tm,m);
-	memcpy(tm,m,16*sizeof(float));
+	mtxRotateX(tm, x, r);
 }
 
 void rotateMatrixY(float* tm, float x, bool r)
 {
-	float rm[16], m[16];
-	memset(rm, 0x00, 16*4);
-	rm[0]=cos(x);
-	rm[2]=sin(x);
-	rm[5]=1.0f;
-	rm[8]=-sin(x);
-	rm[10]=cos(x);
-	rm[15]=1.0f;
-	if(!r)multMatrix44(tm,rm,m);
-	else multMatrix44(rm,tm,m);
-	memcpy(tm,m,16*sizeof(float));
+	mtxRotateY(tm, x, r);
 }
 
 void rotateMatrixZ(float* tm, float x, bool r)
 {
-	float rm[16], m[16];
-	memset(rm, 0x00, 16*4);
-	rm[0]=cos(x);
-	rm[1]=sin(x);
-	rm[4]=-sin(x);
-	rm[5]=cos(x);
-	rm[10]=1.0f;
-	rm[15]=1.0f;
-	if(!r)multMatrix44(tm,rm,m);
-	else multMatrix44(rm,tm,m);
-	memcpy(tm,m,16*sizeof(float));
+	mtxRotateZ(tm, x, r);
 }
 
 void scaleMatrix(float* tm, float x, float y, float z)
 {
-	tm[0]*=x; tm[4]*=x; tm[8]*=x; tm[12]*=x;
-	tm[1]*=y; tm[5]*=y; tm[9]*=y; tm[13]*=y;
-	tm[2]*=z; tm[6]*=z; tm[10]*=z; tm[14]*=z;
+	mtxScale(tm, x, y, z);
 }
 
 void initProjectionMatrix(float* m, float fovy, float aspect, float near, float far)
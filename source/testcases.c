@@ -0,0 +1,241 @@
+/**
+ *@file testcases.c
+ *@author Lectem
+ *@date 17/10/2026
+ */
+#include "testcases.h"
+#include "gpuframework.h"
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+
+//Same sources and combiner for rgb and alpha, operands left to 0 (source color/alpha)
+#define STAGE(src0, src1, combine, constant) \
+        {GPU_TEVSOURCES(src0, src1, 0), GPU_TEVSOURCES(src0, src1, 0), 0, 0, combine, combine, constant}
+//A quad covering the whole tile
+#define FULL(z, color) {0.0f, 0.0f, 0.0f, 0.0f, z, color}
+
+//Vertex colors go through the float conversion of the shader, they may be off by one
+#define VERTEX_TOLERANCE 1
+
+static const gpu_test_case tev_cases[] = {
+        {
+                .name = "primary_color",
+                .numQuads = 1, .quads = {FULL(0.5f, RGBA8(0x40, 0x80, 0xC0, 0xFF))},
+                .expected = GPU_TEST_COLOR(0x40, 0x80, 0xC0, 0xFF), .tolerance = VERTEX_TOLERANCE,
+        },
+        {
+                .name = "texture0",
+                .numTextures = 1, .textures = {RGBA8(0x11, 0x22, 0x33, 0x44)},
+                .numStages = 1, .tev = {STAGE(GPU_TEXTURE0, 0, GPU_REPLACE, 0)},
+                .expected = GPU_TEST_COLOR(0x11, 0x22, 0x33, 0x44),
+        },
+        {
+                .name = "texture2",
+                .numTextures = 3, .textures = {0, 0, RGBA8(0x55, 0x66, 0x77, 0x88)},
+                .numStages = 1, .tev = {STAGE(GPU_TEXTURE2, 0, GPU_REPLACE, 0)},
+                .expected = GPU_TEST_COLOR(0x55, 0x66, 0x77, 0x88),
+        },
+        {
+                .name = "constant",
+                .numStages = 1, .tev = {STAGE(GPU_CONSTANT, 0, GPU_REPLACE, RGBA8(0xAA, 0xBB, 0xCC, 0xDD))},
+                .expected = GPU_TEST_COLOR(0xAA, 0xBB, 0xCC, 0xDD),
+        },
+        {
+                .name = "modulate",
+                .numTextures = 1, .textures = {RGBA8(0x80, 0x80, 0x80, 0xFF)},
+                .numStages = 1, .tev = {STAGE(GPU_TEXTURE0, GPU_PRIMARY_COLOR, GPU_MODULATE, 0)},
+                .numQuads = 1, .quads = {FULL(0.5f, RGBA8(0xFF, 0x40, 0x00, 0xFF))},
+                .expected = GPU_TEST_COLOR(0x80, 0x20, 0x00, 0xFF), .tolerance = 2,
+        },
+        {
+                .name = "add",
+                .numTextures = 2, .textures = {RGBA8(0x10, 0x20, 0x30, 0x40), RGBA8(0x01, 0x02, 0x03, 0x04)},
+                .numStages = 1, .tev = {STAGE(GPU_TEXTURE0, GPU_TEXTURE1, GPU_ADD, 0)},
+                .expected = GPU_TEST_COLOR(0x11, 0x22, 0x33, 0x44),
+        },
+        {
+                .name = "add_saturates",
+                .numTextures = 2, .textures = {RGBA8(0xF0, 0x80, 0x10, 0xFF), RGBA8(0x20, 0x80, 0x10, 0x01)},
+                .numStages = 1, .tev = {STAGE(GPU_TEXTURE0, GPU_TEXTURE1, GPU_ADD, 0)},
+                .expected = GPU_TEST_COLOR(0xFF, 0xFF, 0x20, 0xFF),
+        },
+        {
+                .name = "subtract",
+                .numTextures = 2, .textures = {RGBA8(0x80, 0x10, 0x40, 0xFF), RGBA8(0x20, 0x20, 0x40, 0x0F)},
+                .numStages = 1, .tev = {STAGE(GPU_TEXTURE0, GPU_TEXTURE1, GPU_SUBTRACT, 0)},
+                .expected = GPU_TEST_COLOR(0x60, 0x00, 0x00, 0xF0),
+        },
+        {
+                .name = "two_stages",
+                .numTextures = 1, .textures = {RGBA8(0x10, 0x20, 0x30, 0x40)},
+                .numStages = 2, .tev = {
+                        STAGE(GPU_TEXTURE0, 0, GPU_REPLACE, 0),
+                        STAGE(GPU_PREVIOUS, GPU_CONSTANT, GPU_ADD, RGBA8(0x01, 0x02, 0x03, 0x04)),
+                },
+                .expected = GPU_TEST_COLOR(0x11, 0x22, 0x33, 0x44),
+        },
+        {
+                .name = "six_stages",
+                .numStages = 6, .tev = {
+                        STAGE(GPU_CONSTANT, 0, GPU_REPLACE, RGBA8(0x10, 0x10, 0x10, 0x10)),
+                        STAGE(GPU_PREVIOUS, GPU_CONSTANT, GPU_ADD, RGBA8(0x10, 0x10, 0x10, 0x10)),
+                        STAGE(GPU_PREVIOUS, GPU_CONSTANT, GPU_ADD, RGBA8(0x10, 0x10, 0x10, 0x10)),
+                        STAGE(GPU_PREVIOUS, GPU_CONSTANT, GPU_ADD, RGBA8(0x10, 0x10, 0x10, 0x10)),
+                        STAGE(GPU_PREVIOUS, GPU_CONSTANT, GPU_ADD, RGBA8(0x10, 0x10, 0x10, 0x10)),
+                        STAGE(GPU_PREVIOUS, GPU_CONSTANT, GPU_ADD, RGBA8(0x10, 0x10, 0x10, 0x10)),
+                },
+                .expected = GPU_TEST_COLOR(0x60, 0x60, 0x60, 0x60),
+        },
+};
+
+//The first quad is drawn over the cleared buffer (0), the second one is blended with it
+static const gpu_test_case blend_cases[] = {
+        {
+                .name = "dst_only",
+                .blend = {true, GPU_BLEND_ADD, GPU_BLEND_ADD, GPU_ZERO, GPU_ONE, GPU_ZERO, GPU_ONE, 0},
+                .expected = GPU_TEST_COLOR(0, 0, 0, 0),
+        },
+        {
+                .name = "add",
+                .blend = {true, GPU_BLEND_ADD, GPU_BLEND_ADD, GPU_ONE, GPU_ONE, GPU_ONE, GPU_ONE, 0},
+                .numQuads = 2, .quads = {
+                        FULL(0.5f, RGBA8(0x20, 0x40, 0x60, 0x10)),
+                        FULL(0.5f, RGBA8(0x30, 0x30, 0x30, 0x20)),
+                },
+                .expected = GPU_TEST_COLOR(0x50, 0x70, 0x90, 0x30), .tolerance = VERTEX_TOLERANCE,
+        },
+        {
+                .name = "src_alpha",
+                .blend = {true, GPU_BLEND_ADD, GPU_BLEND_ADD, GPU_SRC_ALPHA, GPU_ONE_MINUS_SRC_ALPHA, GPU_ONE, GPU_ZERO, 0},
+                .numQuads = 2, .quads = {
+                        FULL(0.5f, RGBA8(0xFF, 0x00, 0x00, 0xFF)),
+                        FULL(0.5f, RGBA8(0x00, 0x00, 0xFF, 0x80)),
+                },
+                .expected = GPU_TEST_COLOR(0x7F, 0x00, 0x80, 0x80), .tolerance = 2,
+        },
+        {
+                .name = "constant_color",
+                .blend = {true, GPU_BLEND_ADD, GPU_BLEND_ADD, GPU_CONSTANT_COLOR, GPU_ZERO, GPU_ONE, GPU_ZERO,
+                          RGBA8(0x40, 0x40, 0x40, 0x40)},
+                .expected = GPU_TEST_COLOR(0x40, 0x40, 0x40, 0xFF), .tolerance = VERTEX_TOLERANCE,
+        },
+        {
+                .name = "reverse_subtract",
+                .blend = {true, GPU_BLEND_REVERSE_SUBTRACT, GPU_BLEND_ADD, GPU_ONE, GPU_ONE, GPU_ONE, GPU_ZERO, 0},
+                .numQuads = 2, .quads = {
+                        FULL(0.5f, RGBA8(0x80, 0x80, 0x80, 0xFF)),
+                        FULL(0.5f, RGBA8(0x20, 0x30, 0x40, 0xFF)),
+                },
+                .expected = GPU_TEST_COLOR(0x60, 0x50, 0x40, 0xFF), .tolerance = VERTEX_TOLERANCE,
+        },
+        {
+                .name = "max",
+                .blend = {true, GPU_BLEND_MAX, GPU_BLEND_MAX, GPU_ONE, GPU_ONE, GPU_ONE, GPU_ONE, 0},
+                .numQuads = 2, .quads = {
+                        FULL(0.5f, RGBA8(0x80, 0x10, 0x80, 0x10)),
+                        FULL(0.5f, RGBA8(0x10, 0x80, 0x40, 0x80)),
+                },
+                .expected = GPU_TEST_COLOR(0x80, 0x80, 0x80, 0x80), .tolerance = VERTEX_TOLERANCE,
+        },
+};
+
+//Alpha, depth and stencil tests. The depth and stencil buffers are cleared to 0.
+static const gpu_test_case test_cases[] = {
+        {
+                .name = "alpha_fail",
+                .alphaTest = {true, GPU_GREATER, 0x80},
+                .numQuads = 1, .quads = {FULL(0.5f, RGBA8(0x10, 0x20, 0x30, 0x40))},
+                .expected = GPU_TEST_COLOR(0, 0, 0, 0),
+        },
+        {
+                .name = "alpha_pass",
+                .alphaTest = {true, GPU_GREATER, 0x80},
+                .numQuads = 1, .quads = {FULL(0.5f, RGBA8(0x10, 0x20, 0x30, 0xC0))},
+                .expected = GPU_TEST_COLOR(0x10, 0x20, 0x30, 0xC0), .tolerance = VERTEX_TOLERANCE,
+        },
+        {
+                .name = "depth_never",
+                .depth = {true, true, GPU_NEVER, GPU_WRITE_ALL},
+                .expected = GPU_TEST_COLOR(0, 0, 0, 0),
+        },
+        {
+                .name = "depth_only_write",
+                .depth = {true, true, GPU_ALWAYS, GPU_WRITE_DEPTH},
+                .expected = GPU_TEST_COLOR(0, 0, 0, 0),
+        },
+        {
+                .name = "red_only_write",
+                .depth = {true, true, GPU_ALWAYS, GPU_WRITE_RED},
+                .expected = GPU_TEST_COLOR(0xFF, 0, 0, 0), .tolerance = VERTEX_TOLERANCE,
+        },
+        {
+                //Which quad is in front depends on the depth mapping, the result is only recorded
+                .name = "depth_greater",
+                .depth = {true, true, GPU_GREATER, GPU_WRITE_ALL},
+                .numQuads = 2, .quads = {
+                        FULL(0.2f, RGBA8(0xFF, 0x00, 0x00, 0xFF)),
+                        FULL(0.8f, RGBA8(0x00, 0xFF, 0x00, 0xFF)),
+                },
+                .flags = GPU_TEST_RECORD_ONLY,
+        },
+        {
+                .name = "stencil_never",
+                .stencil = {true, GPU_NEVER, 0x00, 0xFF, 0xFF, GPU_KEEP, GPU_KEEP, GPU_KEEP},
+                .expected = GPU_TEST_COLOR(0, 0, 0, 0),
+        },
+        {
+                .name = "stencil_equal",
+                .stencil = {true, GPU_EQUAL, 0x00, 0xFF, 0xFF, GPU_KEEP, GPU_KEEP, GPU_KEEP},
+                .expected = GPU_TEST_COLOR(0xFF, 0xFF, 0xFF, 0xFF), .tolerance = VERTEX_TOLERANCE,
+        },
+        {
+                //The first quad inverts the stencil, so the second one fails the test
+                .name = "stencil_invert",
+                .stencil = {true, GPU_EQUAL, 0x00, 0xFF, 0xFF, GPU_KEEP, GPU_KEEP, GPU_XOR},
+                .numQuads = 2, .quads = {
+                        FULL(0.5f, RGBA8(0xFF, 0x00, 0x00, 0xFF)),
+                        FULL(0.5f, RGBA8(0x00, 0xFF, 0x00, 0xFF)),
+                },
+                .expected = GPU_TEST_COLOR(0xFF, 0x00, 0x00, 0xFF), .tolerance = VERTEX_TOLERANCE,
+        },
+};
+
+const gpu_test_suite testSuiteTev = {"tev", tev_cases, ARRAY_SIZE(tev_cases), NULL};
+const gpu_test_suite testSuiteBlend = {"blend", blend_cases, ARRAY_SIZE(blend_cases), NULL};
+const gpu_test_suite testSuiteTests = {"tests", test_cases, ARRAY_SIZE(test_cases), NULL};
+
+/**
+* Every step of 4 of the red channel, to check that vertex colors are scaled to [0;1] without losing precision.
+*/
+static void generateVertexColor(u32 index, gpu_test_case* out)
+{
+    u32 v = index * 4 + 3;
+    out->numQuads = 1;
+    out->quads[0] = (gpu_test_quad)FULL(0.5f, RGBA8(v, 0xFF - v, v / 2, 0xFF));
+    out->expected = GPU_TEST_COLOR(v, 0xFF - v, v / 2, 0xFF);
+    out->tolerance = VERTEX_TOLERANCE;
+}
+
+const gpu_test_suite testSuiteVertexColor = {"vertex_color", NULL, 64, generateVertexColor};
+
+/**
+* The TEV cases again, with their textures drawn by the GPU earlier in the frame instead of uploaded.
+* The colors of the textures then go through the vertex colors, hence the tolerance.
+*/
+static void generateRenderedTextures(u32 index, gpu_test_case* out)
+{
+    *out = tev_cases[index];
+    out->flags |= GPU_TEST_RENDER_TEXTURES;
+    if(out->numTextures)out->tolerance += VERTEX_TOLERANCE;
+}
+
+const gpu_test_suite testSuiteRenderedTextures = {"rendered_tex", NULL, ARRAY_SIZE(tev_cases), generateRenderedTextures};
+
+void testCasesRegister()
+{
+    gpuTestRegister(&testSuiteTev);
+    gpuTestRegister(&testSuiteBlend);
+    gpuTestRegister(&testSuiteTests);
+    gpuTestRegister(&testSuiteVertexColor);
+    gpuTestRegister(&testSuiteRenderedTextures);
+}
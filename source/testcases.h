@@ -0,0 +1,21 @@
+/**
+ *@file testcases.h
+ *@author Lectem
+ *@date 17/10/2026
+ *
+ * The suites of source/gputest.h run by the test application.
+ */
+#pragma once
+
+#include "gputest.h"
+
+extern const gpu_test_suite testSuiteTev;
+extern const gpu_test_suite testSuiteBlend;
+extern const gpu_test_suite testSuiteTests;
+extern const gpu_test_suite testSuiteVertexColor;
+extern const gpu_test_suite testSuiteRenderedTextures;
+
+/**
+* Registers every suite above.
+*/
+void testCasesRegister();
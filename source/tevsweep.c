@@ -0,0 +1,288 @@
+/**
+ *@file tevsweep.c
+ *@author Lectem
+ *@date 17/10/2026
+ */
+#include "tevsweep.h"
+#include <stdlib.h>
+#include <string.h>
+#include "gpuframework.h"
+#include "gpustateblock.h"
+#include "gputile.h"
+#include "gpuvertex.h"
+
+//Same constant color as the interactive test, every channel is different so that operands can be told apart
+#define SWEEP_CONSTANT_COLOR 0xAABBCCDD
+
+//One quad (2 triangles) per tile
+static vector_3f* tile_vertices = NULL;
+//The tiles are all white, so only the positions are in the buffer
+static gpu_vertex_format tile_format;
+
+//The commands of one tile, only the vertex buffer address and the TEV stage 0 are patched for the others
+static gpu_state_block tile_block;
+static s32 tile_buffer_param = -1;
+static s32 tile_tev_param = -1;
+
+static const char* sweep_names[TEVSWEEP_COUNT] = {
+        "sources",
+        "operands",
+        "combiners",
+};
+
+const char* tevSweepName(tevsweep_kind kind)
+{
+    if(kind >= TEVSWEEP_COUNT)return "unknown";
+    return sweep_names[kind];
+}
+
+u32 tevSweepCaseCount(tevsweep_kind kind)
+{
+    switch(kind)
+    {
+        case TEVSWEEP_SOURCES:   return 16 * 16;
+        case TEVSWEEP_OPERANDS:  return 16 * 8;  // alpha operands are only 3 bits
+        case TEVSWEEP_COMBINERS: return 10 * 10; // GPU_REPLACE to GPU_ADD_MULTIPLY
+        default: return 0;
+    }
+}
+
+void tevSweepGetCase(tevsweep_kind kind, u32 index, tevsweep_case* out)
+{
+    out->rgbSources = GPU_TEVSOURCES(GPU_CONSTANT, GPU_TEXTURE1, GPU_TEXTURE2);
+    out->alphaSources = GPU_TEVSOURCES(GPU_CONSTANT, GPU_TEXTURE1, GPU_TEXTURE2);
+    out->rgbOperands = GPU_TEVOPERANDS(0, 0, 0);
+    out->alphaOperands = GPU_TEVOPERANDS(0, 0, 0);
+    out->rgbCombine = GPU_REPLACE;
+    out->alphaCombine = GPU_REPLACE;
+    out->constantColor = SWEEP_CONSTANT_COLOR;
+
+    switch(kind)
+    {
+        case TEVSWEEP_SOURCES:
+            out->rgbSources = GPU_TEVSOURCES(index % 16, 0, 0);
+            out->alphaSources = GPU_TEVSOURCES(index / 16, 0, 0);
+            break;
+        case TEVSWEEP_OPERANDS:
+            out->rgbOperands = GPU_TEVOPERANDS(index % 16, 0, 0);
+            out->alphaOperands = GPU_TEVOPERANDS(index / 16, 0, 0);
+            break;
+        case TEVSWEEP_COMBINERS:
+            out->rgbCombine = index % 10;
+            out->alphaCombine = index / 10;
+            break;
+        default:break;
+    }
+}
+
+void tevSweepPrintCase(FILE* f, tevsweep_kind kind, const tevsweep_case* c, u32 color)
+{
+    fprintf(f, "%s rgbSrc=%03x aSrc=%03x rgbOp=%03x aOp=%03x rgbComb=%x aComb=%x const=%08x gpuColor=%08x\n",
+            tevSweepName(kind),
+            c->rgbSources, c->alphaSources,
+            c->rgbOperands, c->alphaOperands,
+            c->rgbCombine, c->alphaCombine,
+            (unsigned int)c->constantColor, (unsigned int)color);
+}
+
+static void drawTile(u32 tile, const tevsweep_case* c)
+{
+    //GPU_DrawArray always starts at the first vertex, so point the buffer to this tile's quad.
+    //The fixed attributes are set once per page by recordPage.
+    gpuVertexFormatSetBuffer(&tile_format, &tile_vertices[tile * 6]);
+    GPU_SetTexEnv(0,
+                  c->rgbSources, c->alphaSources,
+                  c->rgbOperands, c->alphaOperands,
+                  c->rgbCombine, c->alphaCombine,
+                  c->constantColor);
+    GPU_DrawArray(GPU_TRIANGLES, 6);
+}
+
+static void buildTileBlock()
+{
+    tevsweep_case c;
+    tevSweepGetCase(TEVSWEEP_SOURCES, 0, &c);
+    if(!gpuStateBlockBegin(&tile_block, 0x80))return;
+    drawTile(0, &c);
+    if(!gpuStateBlockEnd(&tile_block))
+    {
+        gpuStateBlockFree(&tile_block);
+        return;
+    }
+    //Attribute buffers base address, then the first of the 4 TEV stage 0 params (sources, operands, combiners, color)
+    tile_buffer_param = gpuStateBlockFind(&tile_block, GPUREG_ATTRIBBUFFERS_LOC);
+    tile_tev_param = gpuStateBlockFind(&tile_block, 0xC0);
+    if(tile_buffer_param < 0 || tile_tev_param < 0 || gpuStateBlockFind(&tile_block, 0xC3) != tile_tev_param + 3)
+    {
+        gpuStateBlockFree(&tile_block);
+    }
+}
+
+bool tevSweepInit()
+{
+    gpuVertexFormatPosWhite(&tile_format);
+    tile_vertices = linearAlloc(TEVSWEEP_TILES_PER_PAGE * 6 * sizeof(vector_3f));
+    if(!tile_vertices)return false;
+
+    int tile;
+    for(tile = 0; tile < TEVSWEEP_TILES_PER_PAGE; ++tile)
+    {
+        u16 x, y;
+        gpuTileOrigin(tile, &x, &y);
+        float x0 = x, y0 = y;
+        float x1 = x0 + GPU_TILE_W;
+        float y1 = y0 + GPU_TILE_H;
+        const vector_3f quad[6] =
+                {
+                        {x0, y0, 0.5f},
+                        {x1, y0, 0.5f},
+                        {x1, y1, 0.5f},
+                        {x1, y1, 0.5f},
+                        {x0, y1, 0.5f},
+                        {x0, y0, 0.5f}
+                };
+        memcpy(&tile_vertices[tile * 6], quad, sizeof(quad));
+    }
+    buildTileBlock();
+    gpuTileInit();
+    return true;
+}
+
+void tevSweepExit()
+{
+    gpuStateBlockFree(&tile_block);
+    if(tile_vertices)
+    {
+        gpuTileExit();
+        linearFree(tile_vertices);
+        tile_vertices = NULL;
+    }
+}
+
+/**
+* Records the tiles of a page, without submitting the frame.
+*/
+static void recordPage(tevsweep_kind kind, u32 first, u32 count, tevsweep_setup_fn setup)
+{
+    my_assert(tile_vertices != NULL);
+    my_assert(count <= TEVSWEEP_TILES_PER_PAGE);
+
+    gpuStartFrame();
+    //Only the combiners are tested, nothing reads the depth buffer
+    gpuClearBuffers(GPU_CLEAR_COLOR);
+    gpuTileMarkDirty(GPU_CLEAR_ALL, count);
+    if(setup)setup();
+    gpuVertexFormatSetFixed(&tile_format);
+
+    u32 tile;
+    for(tile = 0; tile < count; ++tile)
+    {
+        tevsweep_case c;
+        u32* cmds;
+        tevSweepGetCase(kind, first + tile, &c);
+
+        if(!tile_block.cmds || !(cmds = gpuStateBlockAppend(&tile_block)))
+        {
+            drawTile(tile, &c);
+            continue;
+        }
+        cmds[tile_buffer_param] = osConvertVirtToPhys((u32) &tile_vertices[tile * 6]) >> 3;
+        cmds[tile_tev_param] = (c.alphaSources << 16) | c.rgbSources;
+        cmds[tile_tev_param + 1] = (c.alphaOperands << 12) | c.rgbOperands;
+        cmds[tile_tev_param + 2] = (c.alphaCombine << 16) | c.rgbCombine;
+        cmds[tile_tev_param + 3] = c.constantColor;
+    }
+}
+
+/**
+* Reads the color of each tile.
+* @return The number of tiles that aren't a single color, the results are then their center pixel
+*/
+static u32 readPage(u32 count, u32* results)
+{
+    u32 tile, mixed = 0;
+    gpuTileReadback(false);
+    for(tile = 0; tile < count; ++tile)
+    {
+        gpu_tile_result r;
+        if(!gpuTileRead(tile, &r))mixed++;
+        results[tile] = r.color;
+    }
+    return mixed;
+}
+
+void tevSweepRunPage(tevsweep_kind kind, u32 first, u32 count, tevsweep_setup_fn setup, u32* results)
+{
+    recordPage(kind, first, count, setup);
+    gpuEndFrame();
+    gpuWaitIdle();
+    readPage(count, results);
+}
+
+//A page of tevSweepRunAll waiting for the GPU
+typedef struct {
+    tevsweep_kind kind;
+    u32 first, count;
+    FILE* report;
+    gpu_log* records;
+} sweep_page;
+
+static void pageDone(void* data)
+{
+    const sweep_page* page = data;
+    u32 results[TEVSWEEP_TILES_PER_PAGE];
+    u32 i;
+    u32 mixed = readPage(page->count, results);
+    if(mixed)printf("sweep %s: %lu tiles of page %lu aren't a single color\n", tevSweepName(page->kind),
+                    (unsigned long)mixed, (unsigned long)(page->first / TEVSWEEP_TILES_PER_PAGE));
+    u16 type = page->records ? gpuLogDefine(page->records, "tev_case:kind,index,rgbSources:x,alphaSources:x,"
+                                            "rgbOperands:x,alphaOperands:x,rgbCombine,alphaCombine,constant:x,color:x") : 0;
+    for(i = 0; i < page->count; ++i)
+    {
+        tevsweep_case c;
+        tevSweepGetCase(page->kind, page->first + i, &c);
+        if(page->report)tevSweepPrintCase(page->report, page->kind, &c, results[i]);
+        if(type)
+        {
+            const u32 values[] = {page->kind, page->first + i, c.rgbSources, c.alphaSources, c.rgbOperands, c.alphaOperands,
+                                  c.rgbCombine, c.alphaCombine, c.constantColor, results[i]};
+            gpuLogRecord(page->records, type, values, sizeof(values) / sizeof(values[0]));
+        }
+    }
+}
+
+u32 tevSweepRunAll(FILE* report, gpu_log* records, tevsweep_setup_fn setup)
+{
+    //The page being recorded and the one being rendered
+    sweep_page pages[2];
+    u32 frames = 0, interval;
+    int kind;
+    //Nobody watches the pages, they don't need to wait for the VBlank
+    gpu_present_mode mode = gpuGetPresentMode(&interval);
+    gpuSetPresentMode(GPU_PRESENT_HEADLESS, 1);
+    for(kind = 0; kind < TEVSWEEP_COUNT; ++kind)
+    {
+        u32 total = tevSweepCaseCount(kind);
+        u32 first;
+        for(first = 0; first < total; first += TEVSWEEP_TILES_PER_PAGE)
+        {
+            sweep_page* page = &pages[frames % 2];
+            page->kind = kind;
+            page->first = first;
+            page->count = total - first;
+            if(page->count > TEVSWEEP_TILES_PER_PAGE)page->count = TEVSWEEP_TILES_PER_PAGE;
+            page->report = report;
+            page->records = records;
+
+            //Recorded while the GPU renders the previous page, which is read back when this one is submitted
+            recordPage(kind, first, page->count, setup);
+            gpuTileEndPage(pageDone, page);
+            frames++;
+        }
+        printf("sweep %s: %lu cases\n", tevSweepName(kind), (unsigned long)total);
+    }
+    gpuWaitIdle();
+    gpuSetPresentMode(mode, interval);
+    if(report)fflush(report);
+    return frames;
+}
@@ -0,0 +1,64 @@
+/**
+ *@file tevsweep.h
+ *@author Lectem
+ *@date 17/10/2026
+ *
+ * Exhaustive TEV (texture combiner) sweeps.
+ * Instead of testing one configuration per frame, every case of a sweep gets its own tile of the screen,
+ * so a whole page of cases is recorded in a single command list and read back after a single gpuEndFrame().
+ */
+#pragma once
+
+#include <3ds.h>
+#include <stdio.h>
+#include "gpulog.h"
+#include "gputile.h"
+
+//One case per tile of gputile.h
+#define TEVSWEEP_TILES_PER_PAGE GPU_TILES_PER_PAGE
+
+typedef enum
+{
+    TEVSWEEP_SOURCES,   ///< rgb source 0 x alpha source 0 (16x16)
+    TEVSWEEP_OPERANDS,  ///< rgb operand 0 x alpha operand 0 (16x8) on the constant color
+    TEVSWEEP_COMBINERS, ///< rgb combiner x alpha combiner (10x10) on constant/texture1/texture2
+    TEVSWEEP_COUNT
+} tevsweep_kind;
+
+/**
+* A single configuration of the TEV stage 0, with the same meaning as the parameters of GPU_SetTexEnv.
+*/
+typedef struct
+{
+    u16 rgbSources, alphaSources;
+    u16 rgbOperands, alphaOperands;
+    u8 rgbCombine, alphaCombine;
+    u32 constantColor;
+} tevsweep_case;
+
+/**
+* Callback used to setup the state shared by all the tiles (textures...), called right after gpuStartFrame().
+*/
+typedef void (*tevsweep_setup_fn)(void);
+
+const char* tevSweepName(tevsweep_kind kind);
+u32 tevSweepCaseCount(tevsweep_kind kind);
+void tevSweepGetCase(tevsweep_kind kind, u32 index, tevsweep_case* out);
+/**
+* Writes a case and its result in the same format for the device report and the host reference model.
+*/
+void tevSweepPrintCase(FILE* f, tevsweep_kind kind, const tevsweep_case* c, u32 color);
+
+bool tevSweepInit();
+void tevSweepExit();
+/**
+* Renders the cases [first;first+count[ of a sweep in one frame, and reads back the color of each tile.
+* count must not exceed TEVSWEEP_TILES_PER_PAGE.
+*/
+void tevSweepRunPage(tevsweep_kind kind, u32 first, u32 count, tevsweep_setup_fn setup, u32* results);
+/**
+* Runs every case of every sweep and writes the table to the report file, and each case as a "tev_case" record
+* to records if it isn't NULL.
+* @return The number of frames used.
+*/
+u32 tevSweepRunAll(FILE* report, gpu_log* records, tevsweep_setup_fn setup);
@@ -0,0 +1,234 @@
+/**
+ *@file transform.c
+ *@author Lectem
+ *@date 17/10/2026
+ */
+#include "transform.h"
+#include <string.h>
+
+//The range reduction of sinCos relies on the order of the subtractions, which -ffast-math would fold together
+#pragma GCC optimize("no-associative-math")
+
+// 00 01 02 03
+// 04 05 06 07
+// 08 09 10 11
+// 12 13 14 15
+
+//pi/2 in 3 parts, the first one has 8 significant bits so that q * PIO2_A is exact for q < 2^16
+#define PIO2_A 1.5703125f
+#define PIO2_B 4.837512969970703125e-4f
+#define PIO2_C 7.54978995489188216e-8f
+#define TWO_OVER_PI 0.636619772367581343f
+
+static inline void sinCos(float a, float* s, float* c)
+{
+    //Reduce to [-pi/4;pi/4] and the quadrant
+    s32 q = (s32)(a * TWO_OVER_PI + (a < 0.0f ? -0.5f : 0.5f));
+    float fq = (float)q;
+    float r = ((a - fq * PIO2_A) - fq * PIO2_B) - fq * PIO2_C;
+    float z = r * r;
+
+    //Minimax polynomials of the cephes library
+    float sr = r + r * z * (-1.6666654611e-1f + z * (8.3321608736e-3f + z * -1.9515295891e-4f));
+    float cr = 1.0f - 0.5f * z + z * z * (4.166664568298827e-2f + z * (-1.388731625493765e-3f + z * 2.443315711809948e-5f));
+
+    //sin(r + q*pi/2): q=0 (sr, cr), q=1 (cr, -sr), q=2 (-sr, -cr), q=3 (-cr, sr)
+    float vs = (q & 1) ? cr : sr;
+    float vc = (q & 1) ? sr : cr;
+    *s = (q & 2) ? -vs : vs;
+    *c = ((q + 1) & 2) ? -vc : vc;
+}
+
+void mtxSinCos(float a, float* s, float* c)
+{
+    sinCos(a, s, c);
+}
+
+void mtxIdentity(float* m)
+{
+    memset(m, 0, 16 * sizeof(float));
+    m[0] = m[5] = m[10] = m[15] = 1.0f;
+}
+
+void mtxMultiply(float* restrict out, const float* restrict a, const float* restrict b)
+{
+    int i, j;
+    for(j = 0; j < 4; ++j)
+    {
+        const float* ra = &a[j * 4];
+        for(i = 0; i < 4; ++i)
+        {
+            out[j * 4 + i] = ra[0] * b[i] + ra[1] * b[4 + i] + ra[2] * b[8 + i] + ra[3] * b[12 + i];
+        }
+    }
+}
+
+void mtxToPica(float* restrict out, const float* restrict m)
+{
+    int j;
+    for(j = 0; j < 16; j += 4)
+    {
+        out[j] = m[j + 3];
+        out[j + 1] = m[j + 2];
+        out[j + 2] = m[j + 1];
+        out[j + 3] = m[j];
+    }
+}
+
+void mtxMultiplyPica(float* restrict out, const float* restrict a, const float* restrict b)
+{
+    int i, j;
+    for(j = 0; j < 4; ++j)
+    {
+        const float* ra = &a[j * 4];
+        for(i = 0; i < 4; ++i)
+        {
+            out[j * 4 + 3 - i] = ra[0] * b[i] + ra[1] * b[4 + i] + ra[2] * b[8 + i] + ra[3] * b[12 + i];
+        }
+    }
+}
+
+void mtxTranslate(float* m, float x, float y, float z)
+{
+    //Only the last column changes
+    int j;
+    for(j = 0; j < 16; j += 4)
+    {
+        m[j + 3] += m[j] * x + m[j + 1] * y + m[j + 2] * z;
+    }
+}
+
+void mtxScale(float* m, float x, float y, float z)
+{
+    int j;
+    for(j = 0; j < 16; j += 4)
+    {
+        m[j] *= x;
+        m[j + 1] *= y;
+        m[j + 2] *= z;
+    }
+}
+
+/**
+* The rotations only mix 2 axes a < b, with R[a][a] = R[b][b] = c, R[a][b] = s and R[b][a] = -s.
+* m * R mixes the columns a and b, R * m mixes the rows.
+*/
+static void rotate(float* m, int a, int b, float angle, bool before)
+{
+    float s, c;
+    int k;
+    sinCos(angle, &s, &c);
+    if(!before)
+    {
+        for(k = 0; k < 16; k += 4)
+        {
+            float ma = m[k + a], mb = m[k + b];
+            m[k + a] = c * ma - s * mb;
+            m[k + b] = s * ma + c * mb;
+        }
+    }
+    else
+    {
+        float* ra = &m[a * 4];
+        float* rb = &m[b * 4];
+        for(k = 0; k < 4; ++k)
+        {
+            float ma = ra[k], mb = rb[k];
+            ra[k] = c * ma + s * mb;
+            rb[k] = c * mb - s * ma;
+        }
+    }
+}
+
+void mtxRotateX(float* m, float angle, bool before)
+{
+    rotate(m, 1, 2, angle, before);
+}
+
+void mtxRotateY(float* m, float angle, bool before)
+{
+    rotate(m, 0, 2, angle, before);
+}
+
+void mtxRotateZ(float* m, float angle, bool before)
+{
+    rotate(m, 0, 1, angle, before);
+}
+
+void mtxBatchSprites(float* restrict out, const float* restrict base, const mtx_sprites* sprites, u32 count)
+{
+    static const float identity[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+    const float* restrict px = sprites->x;
+    const float* restrict py = sprites->y;
+    const float* restrict pz = sprites->z;
+    const float* restrict pa = sprites->angle;
+    const float* restrict psx = sprites->scaleX;
+    const float* restrict psy = sprites->scaleY;
+    u32 i;
+    int j;
+    if(!base)base = identity;
+
+    for(i = 0; i < count; ++i, out += 16)
+    {
+        float s, c;
+        float x = px[i], y = py[i], z = pz ? pz[i] : 0.0f;
+        float sx = psx ? psx[i] : 1.0f, sy = psy ? psy[i] : 1.0f;
+        sinCos(pa ? pa[i] : 0.0f, &s, &c);
+
+        //T * Rz * S is [c*sx s*sy 0 x] [-s*sx c*sy 0 y] [0 0 1 z] [0 0 0 1], then each row of base is applied to it
+        for(j = 0; j < 16; j += 4)
+        {
+            float b0 = base[j], b1 = base[j + 1], b2 = base[j + 2], b3 = base[j + 3];
+            out[j] = (b0 * c - b1 * s) * sx;
+            out[j + 1] = (b0 * s + b1 * c) * sy;
+            out[j + 2] = b2;
+            out[j + 3] = b0 * x + b1 * y + b2 * z + b3;
+        }
+    }
+}
+
+void mtxBatchMultiply(float* out, const float* restrict a, const float* m, u32 count)
+{
+    u32 i;
+    for(i = 0; i < count; ++i, m += 16, out += 16)
+    {
+        //m may be out, so the whole product is computed before storing it
+        float r[16];
+        mtxMultiply(r, a, m);
+        memcpy(out, r, sizeof(r));
+    }
+}
+
+void mtxBatchTransform(const float* restrict m,
+                       const float* restrict x, const float* restrict y, const float* restrict z, const float* restrict w,
+                       float* restrict outX, float* restrict outY, float* restrict outZ, float* restrict outW,
+                       u32 count)
+{
+    //Matrix in locals, so that the loops only load the vectors
+    const float m0 = m[0], m1 = m[1], m2 = m[2], m3 = m[3];
+    const float m4 = m[4], m5 = m[5], m6 = m[6], m7 = m[7];
+    const float m8 = m[8], m9 = m[9], m10 = m[10], m11 = m[11];
+    const float m12 = m[12], m13 = m[13], m14 = m[14], m15 = m[15];
+    u32 i;
+
+    if(!w)
+    {
+        for(i = 0; i < count; ++i)
+        {
+            outX[i] = m0 * x[i] + m1 * y[i] + m2 * z[i] + m3;
+            outY[i] = m4 * x[i] + m5 * y[i] + m6 * z[i] + m7;
+            outZ[i] = m8 * x[i] + m9 * y[i] + m10 * z[i] + m11;
+        }
+        if(outW)for(i = 0; i < count; ++i)outW[i] = m12 * x[i] + m13 * y[i] + m14 * z[i] + m15;
+    }
+    else
+    {
+        for(i = 0; i < count; ++i)
+        {
+            outX[i] = m0 * x[i] + m1 * y[i] + m2 * z[i] + m3 * w[i];
+            outY[i] = m4 * x[i] + m5 * y[i] + m6 * z[i] + m7 * w[i];
+            outZ[i] = m8 * x[i] + m9 * y[i] + m10 * z[i] + m11 * w[i];
+        }
+        if(outW)for(i = 0; i < count; ++i)outW[i] = m12 * x[i] + m13 * y[i] + m14 * z[i] + m15 * w[i];
+    }
+}
@@ -0,0 +1,82 @@
+/**
+ *@file transform.h
+ *@author Lectem
+ *@date 17/10/2026
+ *
+ * Matrix and vector transforms, for the CPU side of scenes with a lot of moving objects.
+ * Matrices are 16 floats, row major, with the same conventions as mmath.h (m[3], m[7], m[11] hold the translation).
+ *
+ * The single matrix functions update the matrix in place with the closed form of the product, which only touches
+ * the rows or columns that change. The batch functions work on arrays (one array per component) and are plain loops
+ * without aliasing so that the compiler can schedule them on the VFP or vectorize them on the host.
+ */
+#pragma once
+
+#include <3ds/types.h>
+
+/**
+* Sine and cosine of the same angle, in single precision, sharing the range reduction.
+* Accurate to a few ulps for |a| < 10^5 radians.
+*/
+void mtxSinCos(float a, float* s, float* c);
+
+void mtxIdentity(float* m);
+/**
+* out = a * b, out may not be a or b.
+*/
+void mtxMultiply(float* restrict out, const float* restrict a, const float* restrict b);
+
+/**
+* Stores m in the order of the float uniform registers: each row (a, b, c, d) becomes (d, c, b, a).
+* out may not be m. See gpuuniform.h.
+*/
+void mtxToPica(float* restrict out, const float* restrict m);
+/**
+* Same as mtxMultiply, with out in register order.
+*/
+void mtxMultiplyPica(float* restrict out, const float* restrict a, const float* restrict b);
+
+/**
+* m = m * T(x, y, z)
+*/
+void mtxTranslate(float* m, float x, float y, float z);
+/**
+* m = m * S(x, y, z)
+*/
+void mtxScale(float* m, float x, float y, float z);
+/**
+* m = m * R(angle), or R(angle) * m if before is true. Same rotations as rotateMatrixX/Y/Z.
+*/
+void mtxRotateX(float* m, float angle, bool before);
+void mtxRotateY(float* m, float angle, bool before);
+void mtxRotateZ(float* m, float angle, bool before);
+
+/**
+* Position, rotation around Z and scale of count 2D objects (sprites...), one array per component.
+*/
+typedef struct {
+    const float* x;
+    const float* y;
+    const float* z;
+    const float* angle;
+    const float* scaleX;
+    const float* scaleY;
+} mtx_sprites;
+
+/**
+* out[i] = base * T(x, y, z) * Rz(angle) * S(scaleX, scaleY, 1) for each of the count objects.
+* out holds count matrices. base may be NULL for the identity.
+*/
+void mtxBatchSprites(float* restrict out, const float* restrict base, const mtx_sprites* sprites, u32 count);
+/**
+* out[i] = a * m[i], m and out hold count matrices and may be the same array.
+*/
+void mtxBatchMultiply(float* out, const float* restrict a, const float* m, u32 count);
+/**
+* (outX, outY, outZ, outW)[i] = m * (x, y, z, w)[i]. w may be NULL for points (w = 1), outW may be NULL if not needed.
+* The outputs must not overlap the inputs.
+*/
+void mtxBatchTransform(const float* restrict m,
+                       const float* restrict x, const float* restrict y, const float* restrict z, const float* restrict w,
+                       float* restrict outX, float* restrict outY, float* restrict outZ, float* restrict outW,
+                       u32 count);